@@ -0,0 +1,94 @@
+// Times the string hash used by the text measurement cache, from the short strings most UIs show up to long paragraphs,
+// and for long strings each of the paths that hash them: scalar, SIMD and, where the CPU has it, AVX2.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define REPEAT_COUNT 7
+#define BYTES_PER_REPEAT 100000000
+
+static const size_t lengths[] = { 4, 8, 12, 16, 24, 32, 48, 64, 96, 128, 256, 1024, 4096 };
+static uint8_t data[8192];
+
+static double Now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+static void AccumulateScalar(uint64_t *accumulators, const uint8_t *data, size_t length) {
+    Clay__HashAccumulateScalar(accumulators, data, length);
+}
+
+#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64) || defined(__aarch64__))
+static void AccumulateSIMD(uint64_t *accumulators, const uint8_t *data, size_t length) {
+    Clay__HashAccumulateSIMD(accumulators, data, length);
+}
+#endif
+
+#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64))
+static void AccumulateAVX2(uint64_t *accumulators, const uint8_t *data, size_t length) {
+    Clay__HashAccumulateAVX2(accumulators, data, length);
+}
+#endif
+
+// Starts at a different offset each time, so that the strings aren't all aligned the same way
+static void TimeHash(size_t length) {
+    long iterations = BYTES_PER_REPEAT / (long)(length + 32);
+    volatile uint64_t sink = 0;
+    double best = 1e9;
+    for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+        double start = Now();
+        for (long i = 0; i < iterations; i++) {
+            sink += Clay__HashData(data + (i & 255), length);
+        }
+        double time = (Now() - start) / (double)iterations;
+        best = time < best ? time : best;
+    }
+    printf("Clay__HashData     %5zu bytes %8.2fns %6.2f GB/s\n", length, best * 1e9, (double)length / (best * 1e9));
+}
+
+static void TimeAccumulate(const char *name, void (*accumulate)(uint64_t *accumulators, const uint8_t *data, size_t length), size_t length) {
+    long iterations = BYTES_PER_REPEAT / (long)length;
+    uint64_t accumulators[4] = { 0 };
+    double best = 1e9;
+    for (int repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+        double start = Now();
+        for (long i = 0; i < iterations; i++) {
+            accumulate(accumulators, data + (i & 255), length);
+        }
+        double time = (Now() - start) / (double)iterations;
+        best = time < best ? time : best;
+    }
+    printf("%-18s %5zu bytes %8.2fns %6.2f GB/s (%llx)\n", name, length, best * 1e9, (double)length / (best * 1e9), (unsigned long long)accumulators[0]);
+}
+
+int main(void) {
+    uint32_t state = 12345;
+    for (size_t i = 0; i < sizeof(data); i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        data[i] = (uint8_t)('a' + state % 26);
+    }
+    printf("Best of %d runs:\n", REPEAT_COUNT);
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        TimeHash(lengths[i]);
+    }
+    for (size_t length = 256; length <= 4096; length *= 4) {
+        TimeAccumulate("scalar", AccumulateScalar, length);
+#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64) || defined(__aarch64__))
+        TimeAccumulate("SIMD", AccumulateSIMD, length);
+#endif
+#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64))
+        if (Clay__CPUSupportsAVX2()) {
+            TimeAccumulate("AVX2", AccumulateAVX2, length);
+        }
+#endif
+    }
+    return 0;
+}
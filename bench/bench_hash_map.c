@@ -0,0 +1,91 @@
+// Times the element hash map on a UI of about 50,000 elements: 200 rows of 250 cells, each with its own id, plus two
+// floating tips per row attached to cells by id. Every element is added to the map while it's declared, floating tips
+// look up their parent in Clay_EndLayout, Clay_PointerOver looks up the elements under the pointer, and the last timing
+// looks up every cell by id with Clay_GetElementData, as an application reading back its layout would.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define ROW_COUNT 200
+#define CELL_COUNT 250
+#define TIP_COUNT 2
+#define FRAME_COUNT 30
+#define WIDTH 3840
+#define HEIGHT 2160
+
+static double Now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+static void HandleError(Clay_ErrorData error) {
+    fprintf(stderr, "bench_hash_map: clay error: %.*s\n", error.errorText.length, error.errorText.chars);
+    exit(1);
+}
+
+static void Declare(void) {
+    CLAY(CLAY_ID("Root"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM } }) {
+        for (int row = 0; row < ROW_COUNT; row++) {
+            CLAY(CLAY_IDI("Row", row), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) } } }) {
+                for (int cell = 0; cell < CELL_COUNT; cell++) {
+                    CLAY(CLAY_IDI("Cell", row * CELL_COUNT + cell), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) } }, .backgroundColor = { 40, 40, (float)(cell % 200), 255 } }) {}
+                }
+                for (int tip = 0; tip < TIP_COUNT; tip++) {
+                    uint32_t parentId = CLAY_IDI("Cell", row * CELL_COUNT + (row * 37 + tip * 101) % CELL_COUNT).id;
+                    CLAY(CLAY_IDI("Tip", row * TIP_COUNT + tip), { .layout = { .sizing = { CLAY_SIZING_FIXED(40), CLAY_SIZING_FIXED(12) } }, .backgroundColor = { 200, 200, 80, 255 },
+                        .floating = { .attachTo = CLAY_ATTACH_TO_ELEMENT_WITH_ID, .parentId = parentId, .attachPoints = { .parent = CLAY_ATTACH_POINT_CENTER_BOTTOM } } }) {}
+                }
+            }
+        }
+    }
+}
+
+int main(void) {
+    Clay_SetMaxElementCount(65536);
+    uint32_t size = Clay_MinMemorySize();
+    void *memory = malloc(size);
+    Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, memory), (Clay_Dimensions) { WIDTH, HEIGHT }, (Clay_ErrorHandler) { HandleError, NULL });
+    double declareTime = 0, endLayoutTime = 0, pointerTime = 0, lookupTime = 0;
+    int32_t found = 0, hovered = 0;
+    // One frame to fill the map, which isn't counted
+    for (int frame = -1; frame < FRAME_COUNT; frame++) {
+        double start = Now();
+        Clay_BeginLayout();
+        Declare();
+        double declared = Now();
+        Clay_EndLayout();
+        double laidOut = Now();
+        Clay_SetPointerState((Clay_Vector2) { (float)((frame + 1) * 997 % WIDTH), (float)((frame + 1) * 389 % HEIGHT) }, false);
+        bool overRoot = Clay_PointerOver(CLAY_ID("Root"));
+        double pointed = Now();
+        for (int cell = 0; cell < ROW_COUNT * CELL_COUNT; cell++) {
+            found += Clay_GetElementData(CLAY_IDI("Cell", cell)).found;
+        }
+        double end = Now();
+        if (frame >= 0) {
+            declareTime += declared - start;
+            endLayoutTime += laidOut - declared;
+            pointerTime += pointed - laidOut;
+            lookupTime += end - pointed;
+            hovered += overRoot;
+        }
+    }
+    if (found != (FRAME_COUNT + 1) * ROW_COUNT * CELL_COUNT) {
+        fprintf(stderr, "bench_hash_map: only %d of the cell lookups found their cell\n", found);
+        return 1;
+    }
+    printf("%d elements, %d frames, average per frame:\n", 1 + ROW_COUNT * (1 + CELL_COUNT + TIP_COUNT), FRAME_COUNT);
+    printf("declare                     %8.1fus\n", declareTime * 1e6 / FRAME_COUNT);
+    printf("Clay_EndLayout              %8.1fus\n", endLayoutTime * 1e6 / FRAME_COUNT);
+    // Floating tips capture the pointer, so it's over the root only when it misses them
+    printf("Clay_PointerOver            %8.1fus (over the root in %d frames)\n", pointerTime * 1e6 / FRAME_COUNT, hovered);
+    printf("%dk Clay_GetElementData     %8.1fus\n", ROW_COUNT * CELL_COUNT / 1000, lookupTime * 1e6 / FRAME_COUNT);
+    Clay_SetCurrentContext(NULL);
+    free(memory);
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Times Clay_EndLayout on a UI of about 5,000 elements: 50 panels of 49 text rows, plus a status line. Compares a full
+// layout every frame with retained layout, where only the subtrees that changed since the last frame are laid out again,
+// and where a frame declared exactly as the last one gets the last frame's render commands back.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PANEL_COUNT 50
+#define ROW_COUNT 49
+#define PANELS_PER_LINE 10
+#define FRAME_COUNT 1000
+#define WIDTH 3840
+#define HEIGHT 2160
+
+static char rowText[PANEL_COUNT][ROW_COUNT][32];
+static char statusText[64];
+
+static double Now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+static Clay_Dimensions MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
+    (void)userData;
+    return (Clay_Dimensions) { (float)text.length * (float)config->fontSize * 0.5f, (float)config->fontSize };
+}
+
+static void HandleError(Clay_ErrorData error) {
+    fprintf(stderr, "bench_retained: clay error: %.*s\n", error.errorText.length, error.errorText.chars);
+    exit(1);
+}
+
+static void DeclareText(const char *text) {
+    CLAY_TEXT(((Clay_String) { .length = (int32_t)strlen(text), .chars = text }), CLAY_TEXT_CONFIG({ .fontSize = 12, .textColor = { 220, 220, 220, 255 } }));
+}
+
+// statusChange is how often, in frames, the status line changes, or 0 for never
+static void Declare(int frame, int statusChange) {
+    snprintf(statusText, sizeof(statusText), "Status %d", statusChange ? frame / statusChange : 0);
+    CLAY(CLAY_ID("Root"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM, .childGap = 4 } }) {
+        DeclareText(statusText);
+        for (int line = 0; line < PANEL_COUNT / PANELS_PER_LINE; line++) {
+            CLAY(CLAY_IDI("Line", line), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_FIT(0) }, .childGap = 4 } }) {
+                for (int column = 0; column < PANELS_PER_LINE; column++) {
+                    int panel = line * PANELS_PER_LINE + column;
+                    CLAY(CLAY_IDI("Panel", panel), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_FIT(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM, .padding = CLAY_PADDING_ALL(4) }, .backgroundColor = { 40, 40, 60, 255 } }) {
+                        for (int row = 0; row < ROW_COUNT; row++) {
+                            CLAY(CLAY_IDI("Row", panel * ROW_COUNT + row), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_FIT(0) } } }) {
+                                DeclareText(rowText[panel][row]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void Run(const char *name, bool retained, int statusChange) {
+    Clay_SetMaxElementCount(8192);
+    Clay_SetMaxMeasureTextCacheWordCount(32768);
+    uint32_t size = Clay_MinMemorySize();
+    void *memory = malloc(size);
+    Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, memory), (Clay_Dimensions) { WIDTH, HEIGHT }, (Clay_ErrorHandler) { HandleError, NULL });
+    Clay_SetMeasureTextFunction(MeasureText, NULL);
+    Clay_SetRetainedLayoutEnabled(retained);
+    double declareTime = 0, endLayoutTime = 0;
+    // One frame to warm the measure cache, which isn't counted
+    for (int frame = -1; frame < FRAME_COUNT; frame++) {
+        double start = Now();
+        Clay_BeginLayout();
+        Declare(frame < 0 ? 0 : frame, statusChange);
+        double declared = Now();
+        Clay_EndLayout();
+        double end = Now();
+        if (frame >= 0) {
+            declareTime += declared - start;
+            endLayoutTime += end - declared;
+        }
+    }
+    printf("%-36s declare %7.1fus  EndLayout %7.1fus\n", name, declareTime * 1e6 / FRAME_COUNT, endLayoutTime * 1e6 / FRAME_COUNT);
+    Clay_SetCurrentContext(NULL);
+    free(memory);
+}
+
+int main(void) {
+    for (int panel = 0; panel < PANEL_COUNT; panel++) {
+        for (int row = 0; row < ROW_COUNT; row++) {
+            snprintf(rowText[panel][row], sizeof(rowText[panel][row]), "Panel %d row %d", panel, row);
+        }
+    }
+    printf("%d elements, %d frames, average per frame:\n", 2 + PANEL_COUNT / PANELS_PER_LINE + PANEL_COUNT * (1 + ROW_COUNT * 2), FRAME_COUNT);
+    Run("full layout, status changes 1/1", false, 1);
+    Run("retained, status changes 1/1", true, 1);
+    Run("retained, status changes 1/10", true, 10);
+    Run("retained, static", true, 0);
+    return 0;
+}
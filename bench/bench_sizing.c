@@ -0,0 +1,213 @@
+// Times Clay_EndLayout on a single wide row, where sizing dominates: a row of GROW and FIT children that has space left
+// over to grow into, and rows of wrapping text children that are too narrow and have to be compressed. In the last row
+// nearly every child has a different size, which is the worst case for distributing the space a step at a time. The row's
+// sizes, limits and space to distribute are also captured as the sizing loop sees them, and Clay__SizingBlock_Distribute
+// is timed on them against the loop it replaced, after checking that both give the widths the layout did.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+#include "../tests/sizing_reference.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_COUNT 55
+
+static const int childCounts[] = { 1000, 5000, 10000 };
+
+static double Now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+static Clay_Dimensions MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
+    (void)userData;
+    return (Clay_Dimensions) { (float)text.length * (float)config->fontSize * 0.5f, (float)config->fontSize };
+}
+
+static void HandleError(Clay_ErrorData error) {
+    fprintf(stderr, "bench_sizing: clay error: %.*s\n", error.errorText.length, error.errorText.chars);
+    exit(1);
+}
+
+// Every other child grows, each with its own min and max size, so that they reach their limits at different points
+static void DeclareGrowRow(int childCount) {
+    CLAY(CLAY_ID("Row"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_FIXED(40) }, .childGap = 1 } }) {
+        for (int i = 0; i < childCount; i++) {
+            if (i % 2 == 0) {
+                CLAY(CLAY_IDI("Grow", i), { .layout = { .sizing = { CLAY_SIZING_GROW((float)(i % 13) * 2, 20 + (float)(i % 17) * 5), CLAY_SIZING_GROW(0) } }, .backgroundColor = { 60, 60, 90, 255 } }) {}
+            } else {
+                CLAY(CLAY_IDI("Fit", i), { .layout = { .sizing = { CLAY_SIZING_FIT(0), CLAY_SIZING_GROW(0) }, .padding = { (uint16_t)(2 + i % 5), (uint16_t)(2 + i % 3), 0, 0 } }, .backgroundColor = { 90, 60, 60, 255 } }) {}
+            }
+        }
+    }
+}
+
+static void DeclareCompressRow(int childCount) {
+    CLAY(CLAY_ID("Row"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .childGap = 1 } }) {
+        for (int i = 0; i < childCount; i++) {
+            CLAY(CLAY_IDI("Cell", i), { .layout = { .sizing = { CLAY_SIZING_FIT(0), CLAY_SIZING_FIT(0) } } }) {
+                CLAY_TEXT(i % 3 == 0 ? CLAY_STRING("a few words to wrap") : i % 3 == 1 ? CLAY_STRING("wrap me") : CLAY_STRING("some longer text that wraps onto lines"),
+                    CLAY_TEXT_CONFIG({ .fontSize = 8, .textColor = { 220, 220, 220, 255 } }));
+            }
+        }
+    }
+}
+
+static void DeclareCompressDistinctRow(int childCount) {
+    static const char words[] = "word word word word word word word";
+    CLAY(CLAY_ID("Row"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .childGap = 1 } }) {
+        for (int i = 0; i < childCount; i++) {
+            CLAY(CLAY_IDI("Cell", i), { .layout = { .sizing = { CLAY_SIZING_FIT(0), CLAY_SIZING_FIT(0) } } }) {
+                CLAY_TEXT(((Clay_String) { .length = 4 + (i % 7) * 5, .chars = words }), CLAY_TEXT_CONFIG({ .fontSize = (uint16_t)(6 + i % 257), .textColor = { 220, 220, 220, 255 } }));
+            }
+        }
+    }
+}
+
+typedef struct {
+    int32_t length;
+    int32_t *elementIndexes;
+    float *sizes;
+    float *minSizes;
+    float *maxSizes;
+    float *expected;
+    float sizeToDistribute;
+} SizingInputs;
+
+// Reads the row's children after they're declared and before Clay_EndLayout sizes them, in the order the sizing loop
+// loads them, and drops the children that can't grow when there's space to grow into as it does
+static void CaptureInputs(SizingInputs *inputs) {
+    Clay_Context *context = Clay_GetCurrentContext();
+    Clay_LayoutElement *row = Clay__GetHashMapItem(CLAY_ID("Row").id)->layoutElement;
+    float childGap = row->layoutConfig->childGap;
+    inputs->length = 0;
+    inputs->sizeToDistribute = 0;
+    for (int32_t i = 0; i < row->childrenOrTextContent.children.length; i++) {
+        int32_t elementIndex = row->childrenOrTextContent.children.elements[i];
+        Clay_LayoutElement *child = Clay_LayoutElementArray_Get(&context->layoutElements, elementIndex);
+        inputs->sizeToDistribute += child->dimensions.width;
+        if (i > 0) {
+            inputs->sizeToDistribute += childGap;
+        }
+        inputs->elementIndexes[inputs->length] = elementIndex;
+        inputs->sizes[inputs->length] = child->dimensions.width;
+        inputs->minSizes[inputs->length] = child->minDimensions.width;
+        inputs->maxSizes[inputs->length++] = child->layoutConfig->sizing.width.size.minMax.max;
+    }
+}
+
+// Once the row itself has been sized, works out what was left to distribute and reads the widths its children ended up with
+static void CaptureResults(SizingInputs *inputs) {
+    Clay_Context *context = Clay_GetCurrentContext();
+    Clay_LayoutElement *row = Clay__GetHashMapItem(CLAY_ID("Row").id)->layoutElement;
+    inputs->sizeToDistribute = row->dimensions.width - (float)(row->layoutConfig->padding.left + row->layoutConfig->padding.right) - inputs->sizeToDistribute;
+    for (int32_t i = 0; i < inputs->length && inputs->sizeToDistribute > 0; i++) {
+        Clay_LayoutElement *child = Clay_LayoutElementArray_Get(&context->layoutElements, inputs->elementIndexes[i]);
+        if (child->layoutConfig->sizing.width.type != CLAY__SIZING_TYPE_GROW) {
+            int32_t last = --inputs->length;
+            inputs->elementIndexes[i] = inputs->elementIndexes[last];
+            inputs->sizes[i] = inputs->sizes[last];
+            inputs->minSizes[i] = inputs->minSizes[last];
+            inputs->maxSizes[i--] = inputs->maxSizes[last];
+        }
+    }
+    for (int32_t i = 0; i < inputs->length; i++) {
+        inputs->expected[i] = Clay_LayoutElementArray_Get(&context->layoutElements, inputs->elementIndexes[i])->dimensions.width;
+    }
+}
+
+static double TimeDistribute(const char *name, const SizingInputs *inputs, bool reference) {
+    int32_t length = inputs->length;
+    float *sizes = malloc((size_t)length * sizeof(float));
+    float *minSizes = malloc((size_t)length * sizeof(float));
+    float *maxSizes = malloc((size_t)length * sizeof(float));
+    int32_t *scratch = malloc((size_t)length * 4 * sizeof(int32_t));
+    uint32_t *bits = malloc((size_t)length * sizeof(uint32_t));
+    Clay__SizingBlock block = { .sizes = sizes, .minSizes = minSizes, .maxSizes = maxSizes, .order = scratch, .buffer = scratch + length,
+        .positions = scratch + length * 2, .limitOrder = scratch + length * 3, .bits = bits, .length = length };
+    double best = 1e9;
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        // The block moves rows around in its limit columns, so every run starts from fresh copies
+        memcpy(sizes, inputs->sizes, (size_t)length * sizeof(float));
+        memcpy(minSizes, inputs->minSizes, (size_t)length * sizeof(float));
+        memcpy(maxSizes, inputs->maxSizes, (size_t)length * sizeof(float));
+        block.length = length;
+        double start = Now();
+        if (reference) {
+            SizingReference_Distribute(sizes, minSizes, maxSizes, scratch, length, inputs->sizeToDistribute);
+        } else {
+            Clay__SizingBlock_Distribute(&block, inputs->sizeToDistribute);
+        }
+        double time = Now() - start;
+        best = time < best ? time : best;
+    }
+    if (memcmp(sizes, inputs->expected, (size_t)length * sizeof(float)) != 0) {
+        fprintf(stderr, "bench_sizing: %s: %s didn't give the widths the layout did\n", name, reference ? "the old loop" : "Clay__SizingBlock_Distribute");
+        exit(1);
+    }
+    free(sizes);
+    free(minSizes);
+    free(maxSizes);
+    free(scratch);
+    free(bits);
+    return best;
+}
+
+static void Run(const char *name, void (*declare)(int childCount), int childCount, float width) {
+    uint32_t size = Clay_MinMemorySize();
+    void *memory = malloc(size);
+    Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, memory), (Clay_Dimensions) { width, 1000 }, (Clay_ErrorHandler) { HandleError, NULL });
+    Clay_SetMeasureTextFunction(MeasureText, NULL);
+    SizingInputs inputs = {
+        .elementIndexes = malloc((size_t)childCount * sizeof(int32_t)),
+        .sizes = malloc((size_t)childCount * sizeof(float)),
+        .minSizes = malloc((size_t)childCount * sizeof(float)),
+        .maxSizes = malloc((size_t)childCount * sizeof(float)),
+        .expected = malloc((size_t)childCount * sizeof(float)),
+    };
+    double best = 1e9;
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        Clay_BeginLayout();
+        declare(childCount);
+        if (frame == 0) {
+            CaptureInputs(&inputs);
+        }
+        double start = Now();
+        Clay_EndLayout();
+        double time = Now() - start;
+        best = time < best ? time : best;
+        if (frame == 0) {
+            CaptureResults(&inputs);
+        }
+    }
+    double distribute = TimeDistribute(name, &inputs, false);
+    double reference = TimeDistribute(name, &inputs, true);
+    printf("%-18s %6d children  EndLayout %8.1fus  Distribute %8.1fus  old loop %9.1fus\n", name, childCount, best * 1e6, distribute * 1e6, reference * 1e6);
+    Clay_SetCurrentContext(NULL);
+    free(inputs.elementIndexes);
+    free(inputs.sizes);
+    free(inputs.minSizes);
+    free(inputs.maxSizes);
+    free(inputs.expected);
+    free(memory);
+}
+
+int main(void) {
+    Clay_SetMaxElementCount(65536);
+    Clay_SetMaxMeasureTextCacheWordCount(65536);
+    printf("Best of %d frames:\n", FRAME_COUNT);
+    for (size_t i = 0; i < sizeof(childCounts) / sizeof(childCounts[0]); i++) {
+        Run("grow", DeclareGrowRow, childCounts[i], (float)childCounts[i] * 30);
+    }
+    for (size_t i = 0; i < sizeof(childCounts) / sizeof(childCounts[0]); i++) {
+        Run("compress", DeclareCompressRow, childCounts[i], (float)childCounts[i] * 20);
+    }
+    for (size_t i = 0; i < sizeof(childCounts) / sizeof(childCounts[0]); i++) {
+        Run("compress distinct", DeclareCompressDistinctRow, childCounts[i], (float)childCounts[i] * 20);
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Times a frame of text that isn't in the measure cache yet, where finding word boundaries dominates: 200 text elements
+// per frame, with the cache reset before every frame and a measure function that does next to nothing. Paragraphs of
+// short words are the common case; log lines with long tokens have the longest runs between boundaries.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TEXT_COUNT 200
+#define FRAME_COUNT 200
+#define PARAGRAPH_LENGTH 3000
+
+typedef struct {
+    const char *name;
+    char *texts[TEXT_COUNT];
+    int32_t lengths[TEXT_COUNT];
+} Corpus;
+
+static uint32_t randomState = 12345;
+
+static uint32_t NextRandom(void) {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static double Now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+static Clay_Dimensions MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
+    (void)userData;
+    return (Clay_Dimensions) { (float)text.length * (float)config->fontSize * 0.5f, (float)config->fontSize };
+}
+
+static void HandleError(Clay_ErrorData error) {
+    fprintf(stderr, "bench_words: clay error: %.*s\n", error.errorText.length, error.errorText.chars);
+    exit(1);
+}
+
+// Words of 1 to 9 letters, with a line break now and then
+static void MakeParagraphs(Corpus *corpus) {
+    corpus->name = "paragraphs";
+    for (int i = 0; i < TEXT_COUNT; i++) {
+        char *text = malloc(PARAGRAPH_LENGTH + 16);
+        int32_t length = 0;
+        while (length < PARAGRAPH_LENGTH) {
+            int32_t wordLength = 1 + (int32_t)(NextRandom() % 9);
+            for (int32_t j = 0; j < wordLength; j++) {
+                text[length++] = (char)('a' + NextRandom() % 26);
+            }
+            text[length++] = NextRandom() % 40 == 0 ? '\n' : ' ';
+        }
+        corpus->texts[i] = text;
+        corpus->lengths[i] = length;
+    }
+}
+
+// A few lines of timestamps, paths and hex ids, which leave long stretches without a space
+static void MakeLogLines(Corpus *corpus) {
+    corpus->name = "log lines";
+    for (int i = 0; i < TEXT_COUNT; i++) {
+        char *text = malloc(1024);
+        int32_t length = 0;
+        for (int line = 0; line < 4; line++) {
+            length += snprintf(text + length, (size_t)(1024 - length),
+                "2024-05-%02u:%02u:%02u.%06u [worker-%u] /var/lib/service/shards/%08x/segments/%016llx.log status=ok\n",
+                NextRandom() % 28 + 1, NextRandom() % 24, NextRandom() % 60, NextRandom() % 1000000, NextRandom() % 64,
+                NextRandom(), (unsigned long long)NextRandom() << 32 | NextRandom());
+        }
+        corpus->texts[i] = text;
+        corpus->lengths[i] = length;
+    }
+}
+
+static void Run(Corpus *corpus) {
+    uint32_t size = Clay_MinMemorySize();
+    void *memory = malloc(size);
+    Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, memory), (Clay_Dimensions) { 1920, 1080 }, (Clay_ErrorHandler) { HandleError, NULL });
+    Clay_SetMeasureTextFunction(MeasureText, NULL);
+    int64_t bytes = 0;
+    for (int i = 0; i < TEXT_COUNT; i++) {
+        bytes += corpus->lengths[i];
+    }
+    double best = 1e9;
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        Clay_ResetMeasureTextCache();
+        double start = Now();
+        Clay_BeginLayout();
+        CLAY(CLAY_ID("Root"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM } }) {
+            for (int i = 0; i < TEXT_COUNT; i++) {
+                Clay_String text = { .length = corpus->lengths[i], .chars = corpus->texts[i] };
+                CLAY_TEXT(text, CLAY_TEXT_CONFIG({ .fontSize = 8, .textColor = { 220, 220, 220, 255 } }));
+            }
+        }
+        Clay_EndLayout();
+        double time = Now() - start;
+        best = time < best ? time : best;
+    }
+    printf("%-12s %7.1f KB  frame %8.1fus\n", corpus->name, (double)bytes / 1024, best * 1e6);
+    Clay_SetCurrentContext(NULL);
+    free(memory);
+}
+
+int main(void) {
+    Clay_SetMaxMeasureTextCacheWordCount(262144);
+    static Corpus paragraphs, logLines;
+    MakeParagraphs(&paragraphs);
+    MakeLogLines(&logLines);
+    printf("%d texts, measure cache reset every frame, best of %d frames:\n", TEXT_COUNT, FRAME_COUNT);
+    Run(&paragraphs);
+    Run(&logLines);
+    return 0;
+}
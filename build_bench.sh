@@ -0,0 +1,25 @@
+#!/bin/bash
+set -e
+
+# Builds and runs every benchmark in bench/, or only the ones named on the
+# command line, e.g. ./build_bench.sh bench_retained
+
+cd "$(dirname "$0")"
+mkdir -p build/bench
+
+flags="-O2 -g -Wall -Wextra -std=gnu99 -pthread"
+
+if [ $# -gt 0 ]; then
+    benches=("$@")
+else
+    benches=()
+    for bench in bench/*.c; do
+        benches+=("$(basename "$bench" .c)")
+    done
+fi
+
+for name in "${benches[@]}"; do
+    echo "Building $name..."
+    gcc $flags -o "build/bench/$name" "bench/$name.c" -lm
+    "./build/bench/$name"
+done
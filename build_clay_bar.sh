@@ -9,7 +9,7 @@ if [ ! -f "clay_bar.c" ]; then
 fi
 
 # Compile
-gcc -O2 -Wall -Wextra -std=gnu99 \
+gcc -O2 -Wall -Wextra -std=gnu99 -pthread \
     -D_POSIX_C_SOURCE=200809L -D_GNU_SOURCE \
     -o clay_bar \
     clay_bar.c \
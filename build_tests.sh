@@ -0,0 +1,31 @@
+#!/bin/bash
+set -e
+
+# Builds and runs every test in tests/, .c files as C99 and .cpp files as
+# C++20. Set SANITIZE to build them with a sanitizer, e.g.
+# SANITIZE=thread ./build_tests.sh
+
+cd "$(dirname "$0")"
+mkdir -p build/tests
+
+flags="-O2 -g -Wall -Wextra -pthread"
+if [ -n "$SANITIZE" ]; then
+    flags="$flags -fsanitize=$SANITIZE -fno-sanitize-recover=all"
+fi
+
+for test in tests/*.c; do
+    name=$(basename "$test" .c)
+    echo "Building $name..."
+    gcc $flags -std=gnu99 -o "build/tests/$name" "$test" -lm
+    "./build/tests/$name"
+done
+
+# Clay leaves struct members to be zero initialized, which C++ warns about
+for test in tests/*.cpp; do
+    name=$(basename "$test" .cpp)_cpp
+    echo "Building $name..."
+    g++ $flags -std=c++20 -Wno-missing-field-initializers -o "build/tests/$name" "$test" -lm
+    "./build/tests/$name"
+done
+
+echo "All tests passed."
@@ -16,10 +16,13 @@
 
 // SIMD includes on supported platforms
 #if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64))
-#include <emmintrin.h>
+#include <immintrin.h>
 #elif !defined(CLAY_DISABLE_SIMD) && defined(__aarch64__)
 #include <arm_neon.h>
 #endif
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+#include <intrin.h> // _umul128 and __cpuid
+#endif
 
 // -----------------------------------------
 // HEADER DECLARATIONS ---------------------
@@ -49,6 +52,20 @@
 #define CLAY_DLL_EXPORT
 #endif
 
+// The current context and the CLAY() macro's latch are per thread, so that separate contexts can be laid out on
+// separate threads at the same time. Define CLAY_DISABLE_THREAD_LOCAL to share them between all threads instead.
+#if defined(CLAY_DISABLE_THREAD_LOCAL) || defined(CLAY_WASM)
+#define CLAY__THREAD_LOCAL
+#elif defined(__cplusplus)
+#define CLAY__THREAD_LOCAL thread_local
+#elif defined(_MSC_VER) && !defined(__clang__)
+#define CLAY__THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define CLAY__THREAD_LOCAL _Thread_local
+#else
+#define CLAY__THREAD_LOCAL __thread
+#endif
+
 // Public Macro API ------------------------
 
 #define CLAY__MAX(x, y) (((x) > (y)) ? (x) : (y))
@@ -73,12 +90,12 @@
 #define CLAY_SIZING_PERCENT(percentOfParent) (CLAY__INIT(Clay_SizingAxis) { .size = { .percent = (percentOfParent) }, .type = CLAY__SIZING_TYPE_PERCENT })
 
 // Note: If a compile error led you here, you might be trying to use CLAY_ID with something other than a string literal. To construct an ID with a dynamic string, use CLAY_SID instead.
-#define CLAY_ID(label) CLAY_SID(CLAY_STRING(label))
+#define CLAY_ID(label) Clay__HashStringPrecomputed(CLAY_STRING(label), CLAY__HASH_STRING_LITERAL(label))
 
 #define CLAY_SID(label) Clay__HashString(label, 0)
 
 // Note: If a compile error led you here, you might be trying to use CLAY_IDI with something other than a string literal. To construct an ID with a dynamic string, use CLAY_SIDI instead.
-#define CLAY_IDI(label, index) CLAY_SIDI(CLAY_STRING(label), index)
+#define CLAY_IDI(label, index) Clay__HashStringWithOffsetPrecomputed(CLAY_STRING(label), index, CLAY__HASH_STRING_LITERAL(label))
 
 #define CLAY_SIDI(label, index) Clay__HashStringWithOffset(label, index, 0)
 
@@ -101,7 +118,7 @@
 
 #define CLAY_STRING_CONST(string) { .isStaticallyAllocated = true, .length = CLAY__STRING_LENGTH(CLAY__ENSURE_STRING_LITERAL(string)), .chars = (string) }
 
-static uint8_t CLAY__ELEMENT_DEFINITION_LATCH;
+static CLAY__THREAD_LOCAL uint8_t CLAY__ELEMENT_DEFINITION_LATCH;
 
 // GCC marks the above CLAY__ELEMENT_DEFINITION_LATCH as an unused variable for files that include clay.h but don't declare any layout
 // This is to suppress that warning
@@ -147,6 +164,26 @@ static inline void Clay__SuppressUnusedLatchDefinitionVariableWarning(void) { (v
         CLAY__ELEMENT_DEFINITION_LATCH=1, Clay__CloseElement()                                                                                                      \
     )
 
+/* CLAY_VIRTUAL_LIST declares the items of a long list inside a clip element, but only those that are currently visible in it:
+
+  CLAY(CLAY_ID("Log"), { .layout = { .layoutDirection = CLAY_TOP_TO_BOTTOM }, .clip = { .vertical = true, .childOffset = Clay_GetScrollOffset() } }) {
+      CLAY_VIRTUAL_LIST(rows, { .itemCount = lineCount, .itemSize = 20 }) {
+          for (int32_t i = rows.startIndex; i < rows.endIndex; ++i) {
+              ...declare line i, exactly itemSize high
+          }
+      }
+  }
+
+  The space taken by the items that aren't declared is filled in by empty elements, so the scroll container's content size and
+  the positions of the declared items are the same as if the whole list had been declared.
+*/
+#define CLAY_VIRTUAL_LIST(range, ...)                                                                                                                                     \
+    for (                                                                                                                                                                 \
+        Clay_VirtualListRange range = (CLAY__ELEMENT_DEFINITION_LATCH = 0, Clay_BeginVirtualList(CLAY__CONFIG_WRAPPER(Clay_VirtualListConfig, __VA_ARGS__)));           \
+        CLAY__ELEMENT_DEFINITION_LATCH < 1;                                                                                                                               \
+        CLAY__ELEMENT_DEFINITION_LATCH=1, Clay_EndVirtualList(range)                                                                                                      \
+    )
+
 // These macros exist to allow the CLAY() macro to be called both with an inline struct definition, such as
 // CLAY({ .id = something... });
 // As well as by passing a predefined declaration struct
@@ -184,6 +221,37 @@ static inline void Clay__SuppressUnusedLatchDefinitionVariableWarning(void) { (v
 
 #endif // __cplusplus
 
+// Hashes the characters of a string literal ID, the part of Clay__HashString that doesn't depend on anything known only at
+// runtime, so that CLAY_ID and CLAY_IDI do no per character work when elements are declared. It's evaluated at compile time
+// in C++, and in C the loop is fully unrolled for GCC and Clang to fold into a constant.
+#ifdef __cplusplus
+template <size_t length>
+consteval uint32_t Clay__HashStringLiteral(const char (&chars)[length]) {
+    uint32_t hash = 0;
+    for (size_t i = 0; i + 1 < length; i++) {
+        hash += chars[i];
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+    return hash;
+}
+#define CLAY__HASH_STRING_LITERAL(label) Clay__HashStringLiteral(CLAY__ENSURE_STRING_LITERAL(label))
+#else
+static inline uint32_t Clay__HashStringLiteral(const char *chars, int32_t length) {
+    uint32_t hash = 0;
+#if defined(__GNUC__) || defined(__clang__)
+    #pragma GCC unroll 128
+#endif
+    for (int32_t i = 0; i < length; i++) {
+        hash += chars[i];
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+    return hash;
+}
+#define CLAY__HASH_STRING_LITERAL(label) Clay__HashStringLiteral(CLAY__ENSURE_STRING_LITERAL(label), CLAY__STRING_LENGTH(CLAY__ENSURE_STRING_LITERAL(label)))
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -535,6 +603,29 @@ typedef struct Clay_ClipElementConfig {
 
 CLAY__WRAPPER_STRUCT(Clay_ClipElementConfig);
 
+// Virtual List -----------------------------
+
+// Describes the items of a virtual list, see CLAY_VIRTUAL_LIST.
+typedef struct Clay_VirtualListConfig {
+    int32_t itemCount; // The number of items in the whole list.
+    float itemSize; // The size of every item along the list's layout direction. Used when getItemOffset is NULL.
+    // For items that differ in size, returns the total size of the items before itemIndex, not including childGap.
+    // Called with itemIndex == itemCount for the whole list, and binary searched, so it should be answered from something like
+    // a running total kept by the application rather than by measuring items.
+    float (*getItemOffset)(int32_t itemIndex, void *userData);
+    void *userData; // Passed through to getItemOffset.
+    float overscan; // Items this far outside the visible area are declared too, so that fast scrolling doesn't show gaps.
+} Clay_VirtualListConfig;
+
+CLAY__WRAPPER_STRUCT(Clay_VirtualListConfig);
+
+// The items of a virtual list to declare this frame, from startIndex up to but not including endIndex.
+typedef struct Clay_VirtualListRange {
+    int32_t startIndex;
+    int32_t endIndex;
+    float trailingSize; // Internal, the space Clay_EndVirtualList leaves for the items after endIndex, negative if there are none.
+} Clay_VirtualListRange;
+
 // Border -----------------------------
 
 // Controls the widths of individual element borders.
@@ -645,6 +736,36 @@ typedef union Clay_RenderData {
 
 // Miscellaneous Structs & Enums ---------------------------------
 
+// The words of one text to be measured together, see Clay_SetMeasureTextBatchFunction.
+typedef struct Clay_MeasureTextBatch {
+    Clay_StringSlice text; // The whole text, for shapers that want context around each word.
+    const int32_t *wordStarts; // The offset in text of each word.
+    const int32_t *wordLengths; // The length of each word, which never includes the space or newline that ends it.
+    int32_t wordCount;
+    Clay_Dimensions *wordDimensions; // Filled in by the batch function with the size of each word.
+    Clay_Dimensions spaceDimensions; // Filled in by the batch function with the size of a single space character.
+} Clay_MeasureTextBatch;
+
+// The advances of a font's glyphs, so that Clay can measure text in it without calling out, see Clay_SetFontMetrics.
+typedef struct Clay_FontMetrics {
+    uint16_t fontId; // Matched against Clay_TextElementConfig.fontId.
+    uint16_t fontSize; // Matched against Clay_TextElementConfig.fontSize.
+    float lineHeight; // The height of measured text.
+    float monospaceAdvance; // If above zero, every UTF-8 character advances this far and advances is ignored.
+    // Otherwise 256 advances indexed by byte. Text containing a byte with a negative advance, such as the first byte of a
+    // multi-byte UTF-8 character, is measured by the measure function instead. Copied by Clay_SetFontMetrics.
+    const float *advances;
+} Clay_FontMetrics;
+
+// Counters for Clay's internal text measurement cache, see Clay_GetMeasureTextCacheStats.
+typedef struct Clay_MeasureTextCacheStats {
+    uint64_t hits; // Text elements whose measurements were found in the cache, since Clay_Initialize.
+    uint64_t misses; // Text elements that had to be measured, since Clay_Initialize.
+    uint64_t evictions; // Measurements dropped to make room for others or because they hadn't been used for a few frames.
+    int32_t wordsUsed; // Measured words currently stored, with each cached wrapped line counting as one.
+    int32_t wordCapacity; // The most measured words that can be stored, see Clay_SetMaxMeasureTextCacheWordCount.
+} Clay_MeasureTextCacheStats;
+
 // Data representing the current internal state of a scrolling element.
 typedef struct Clay_ScrollContainerData {
     // Note: This is a pointer to the real internal scroll position, mutating it may cause a change in final layout.
@@ -803,7 +924,7 @@ typedef struct Clay_ErrorData {
     // CLAY_ERROR_TYPE_TEXT_MEASUREMENT_FUNCTION_NOT_PROVIDED - A text measurement function wasn't provided using Clay_SetMeasureTextFunction(), or the provided function was null.
     // CLAY_ERROR_TYPE_ARENA_CAPACITY_EXCEEDED - Clay attempted to allocate its internal data structures but ran out of space. The arena passed to Clay_Initialize was created with a capacity smaller than that required by Clay_MinMemorySize().
     // CLAY_ERROR_TYPE_ELEMENTS_CAPACITY_EXCEEDED - Clay ran out of capacity in its internal array for storing elements. This limit can be increased with Clay_SetMaxElementCount().
-    // CLAY_ERROR_TYPE_TEXT_MEASUREMENT_CAPACITY_EXCEEDED - Clay ran out of capacity in its internal array for storing elements. This limit can be increased with Clay_SetMaxMeasureTextCacheWordCount().
+    // CLAY_ERROR_TYPE_TEXT_MEASUREMENT_CAPACITY_EXCEEDED - A single text element has more words than Clay's internal text measurement cache can hold, even after evicting everything else. This limit can be increased with Clay_SetMaxMeasureTextCacheWordCount().
     // CLAY_ERROR_TYPE_DUPLICATE_ID - Two elements were declared with exactly the same ID within one layout.
     // CLAY_ERROR_TYPE_FLOATING_CONTAINER_PARENT_NOT_FOUND - A floating element was declared using CLAY_ATTACH_TO_ELEMENT_ID and either an invalid .parentId was provided or no element with the provided .parentId was found.
     // CLAY_ERROR_TYPE_PERCENTAGE_OVER_1 - An element was declared that using CLAY_SIZING_PERCENT but the percentage value was over 1. Percentage values are expected to be in the 0-1 range.
@@ -836,6 +957,8 @@ CLAY_DLL_EXPORT uint32_t Clay_MinMemorySize(void);
 CLAY_DLL_EXPORT Clay_Arena Clay_CreateArenaWithCapacityAndMemory(size_t capacity, void *memory);
 // Sets the state of the "pointer" (i.e. the mouse or touch) in Clay's internal data. Used for detecting and responding to mouse events in the debug view,
 // as well as for Clay_Hovered() and scroll element handling.
+// Elements under the pointer are only found once something asks for them, from the second query after a layout onwards
+// using an index over it, so this is cheap to call on every pointer move unless hover functions were registered with Clay_OnHover().
 CLAY_DLL_EXPORT void Clay_SetPointerState(Clay_Vector2 position, bool pointerDown);
 // Initialize Clay's internal arena and setup required data before layout can begin. Only needs to be called once.
 // - arena can be created using Clay_CreateArenaWithCapacityAndMemory()
@@ -855,6 +978,11 @@ CLAY_DLL_EXPORT void Clay_UpdateScrollContainers(bool enableDragScrolling, Clay_
 // Returns the internally stored scroll offset for the currently open element.
 // Generally intended for use with clip elements to create scrolling containers.
 CLAY_DLL_EXPORT Clay_Vector2 Clay_GetScrollOffset(void);
+// Starts a virtual list in the currently open clip element, returning the range of items that are visible in it this frame.
+// Usually called through CLAY_VIRTUAL_LIST, which also calls Clay_EndVirtualList once the items have been declared.
+CLAY_DLL_EXPORT Clay_VirtualListRange Clay_BeginVirtualList(Clay_VirtualListConfig config);
+// Ends a virtual list started by Clay_BeginVirtualList, after the items in its range have been declared.
+CLAY_DLL_EXPORT void Clay_EndVirtualList(Clay_VirtualListRange range);
 // Updates the layout dimensions in response to the window or outer container being resized.
 CLAY_DLL_EXPORT void Clay_SetLayoutDimensions(Clay_Dimensions dimensions);
 // Called before starting any layout declarations.
@@ -894,9 +1022,24 @@ CLAY_DLL_EXPORT Clay_ScrollContainerData Clay_GetScrollContainerData(Clay_Elemen
 // - measureTextFunction is a user provided function that adheres to the interface Clay_Dimensions (Clay_StringSlice text, Clay_TextElementConfig *config, void *userData);
 // - userData is a pointer that will be transparently passed through when the measureTextFunction is called.
 CLAY_DLL_EXPORT void Clay_SetMeasureTextFunction(Clay_Dimensions (*measureTextFunction)(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData), void *userData);
+// Optionally measure every word of a text in one call rather than one call per word, for text shapers with a high cost per call.
+// When set it is used in place of the function from Clay_SetMeasureTextFunction, which may then be left unset.
+// - userData is a pointer that will be transparently passed through when the measureTextBatchFunction is called.
+CLAY_DLL_EXPORT void Clay_SetMeasureTextBatchFunction(void (*measureTextBatchFunction)(Clay_MeasureTextBatch *batch, Clay_TextElementConfig *config, void *userData), void *userData);
+// Lets Clay measure text in a font and size itself, by adding up glyph advances (each plus letterSpacing) rather than calling
+// the measure function. Replaces any metrics already set for the same fontId and fontSize, and clears them if both
+// monospaceAdvance and advances are unset. Metrics beyond the first 16 fonts are ignored, and their text is measured by
+// the measure function as before. Metrics belong to the current context, like its cached measurements, which are reset
+// when metrics change.
+CLAY_DLL_EXPORT void Clay_SetFontMetrics(Clay_FontMetrics metrics);
 // Experimental - Used in cases where Clay needs to integrate with a system that manages its own scrolling containers externally.
 // Please reach out if you plan to use this function, as it may be subject to change.
 CLAY_DLL_EXPORT void Clay_SetQueryScrollOffsetFunction(Clay_Vector2 (*queryScrollOffsetFunction)(uint32_t elementId, void *userData), void *userData);
+// Opt in to laying out independent floating elements (tooltips, dropdowns etc) and their children in parallel. Off by default.
+// - parallelForFunction must call task(index, taskData) once for every index from 0 to count - 1, on any threads, and only return once they have all finished.
+// - userData is a pointer that will be transparently passed through when the parallelForFunction is called.
+// The render commands are the same as without it. Pass NULL to lay out serially again.
+CLAY_DLL_EXPORT void Clay_SetParallelForFunction(void (*parallelForFunction)(int32_t count, void (*task)(int32_t index, void *taskData), void *taskData, void *userData), void *userData);
 // A bounds-checked "get" function for the Clay_RenderCommandArray returned from Clay_EndLayout().
 CLAY_DLL_EXPORT Clay_RenderCommand * Clay_RenderCommandArray_Get(Clay_RenderCommandArray* array, int32_t index);
 // Enables and disables Clay's internal debug tools.
@@ -906,6 +1049,11 @@ CLAY_DLL_EXPORT void Clay_SetDebugModeEnabled(bool enabled);
 CLAY_DLL_EXPORT bool Clay_IsDebugModeEnabled(void);
 // Enables and disables visibility culling. By default, Clay will not generate render commands for elements whose bounding box is entirely outside the screen.
 CLAY_DLL_EXPORT void Clay_SetCullingEnabled(bool enabled);
+// Enables and disables retained layout. When enabled, Clay hashes each element's declaration together with its children,
+// and reuses last frame's sizes, wrapped text lines and render commands for any subtree whose hash and available space
+// haven't changed. If the whole frame was declared exactly as the last one, Clay_EndLayout returns the last frame's render
+// commands as they were. Disabled by default. Subtrees containing elements with duplicate IDs are always laid out again.
+CLAY_DLL_EXPORT void Clay_SetRetainedLayoutEnabled(bool enabled);
 // Returns the maximum number of UI elements supported by Clay's current configuration.
 CLAY_DLL_EXPORT int32_t Clay_GetMaxElementCount(void);
 // Modifies the maximum number of UI elements supported by Clay's current configuration.
@@ -914,10 +1062,63 @@ CLAY_DLL_EXPORT void Clay_SetMaxElementCount(int32_t maxElementCount);
 // Returns the maximum number of measured "words" (whitespace seperated runs of characters) that Clay can store in its internal text measurement cache.
 CLAY_DLL_EXPORT int32_t Clay_GetMaxMeasureTextCacheWordCount(void);
 // Modifies the maximum number of measured "words" (whitespace seperated runs of characters) that Clay can store in its internal text measurement cache.
+// The lines that text was last wrapped into are cached in the same space, one unit per line.
 // This may require reallocating additional memory, and re-calling Clay_Initialize();
 CLAY_DLL_EXPORT void Clay_SetMaxMeasureTextCacheWordCount(int32_t maxMeasureTextCacheWordCount);
 // Resets Clay's internal text measurement cache. Useful if font mappings have changed or fonts have been reloaded.
 CLAY_DLL_EXPORT void Clay_ResetMeasureTextCache(void);
+// Returns hit, miss and eviction counts for the text measurement cache along with how full it is.
+// Useful for choosing a value for Clay_SetMaxMeasureTextCacheWordCount. Once full, the least recently used measurements are
+// evicted to make room, which costs re-measuring text but is not an error.
+CLAY_DLL_EXPORT Clay_MeasureTextCacheStats Clay_GetMeasureTextCacheStats(void);
+// Writes the measurements of non-static strings in the text measurement cache into buffer, so that a later run can load
+// them with Clay_LoadMeasureTextCache rather than measuring every string again. Returns the size in bytes of the data,
+// and only writes it if that is no more than bufferSize, so passing NULL and 0 returns the size to allocate.
+// - fontKey identifies the fonts the text was measured with, for example a hash of their names, sizes and versions.
+CLAY_DLL_EXPORT int32_t Clay_SaveMeasureTextCache(void *buffer, int32_t bufferSize, uint64_t fontKey);
+// Adds measurements written by Clay_SaveMeasureTextCache to the cache, for example straight from a read-only memory mapped
+// file. Nothing is loaded unless the data was saved with the same fontKey by the same version of Clay, and only as many
+// strings as fit without evicting are loaded. Returns how many strings were loaded. Measurements that aren't used within
+// a couple of layouts are evicted like any other.
+CLAY_DLL_EXPORT int32_t Clay_LoadMeasureTextCache(const void *data, int32_t dataSize, uint64_t fontKey);
+// Measures texts ahead of the layout that first shows them, such as the next page of a list, writing the results and a
+// copy of each text into buffer for Clay_MergePrewarmedText. Returns the size in bytes of the data, and only measures and
+// writes it if that is no more than bufferSize, so passing NULL and 0 returns the size to allocate. buffer must be
+// aligned as malloc aligns memory.
+// Nothing in the context is modified, so Clay_PrewarmTextCtx can be called on another thread while layouts run, as long as
+// the measure functions are safe to call from that thread and aren't changed meanwhile. Handing the buffer back to the
+// layout thread is left to the caller.
+CLAY_DLL_EXPORT int32_t Clay_PrewarmText(const Clay_String *texts, const Clay_TextElementConfig *configs, int32_t count, void *buffer, int32_t bufferSize);
+// Adds texts measured by Clay_PrewarmText to the text measurement cache, without calling any measure function. Call it
+// between layouts, for example just before Clay_BeginLayout. Merged texts are kept for 60 layouts even if they aren't shown,
+// unless the cache has no other room for the text being laid out, and after that like any other. Returns how many of the
+// texts are now cached. Stops at the first record that doesn't fit in the data.
+CLAY_DLL_EXPORT int32_t Clay_MergePrewarmedText(const void *data, int32_t dataSize);
+
+// Explicit context API --------------------
+// Variants of the functions above that work on the given context rather than the current one. The current context is
+// per thread, so each thread can lay out its own context without affecting the others. A context must only be used by
+// one thread at a time.
+// Clay_BeginLayoutCtx also makes the context current on the calling thread, so the CLAY() macros declare into it.
+CLAY_DLL_EXPORT void Clay_SetLayoutDimensionsCtx(Clay_Context *context, Clay_Dimensions dimensions);
+CLAY_DLL_EXPORT void Clay_SetPointerStateCtx(Clay_Context *context, Clay_Vector2 position, bool pointerDown);
+CLAY_DLL_EXPORT void Clay_UpdateScrollContainersCtx(Clay_Context *context, bool enableDragScrolling, Clay_Vector2 scrollDelta, float deltaTime);
+CLAY_DLL_EXPORT void Clay_BeginLayoutCtx(Clay_Context *context);
+CLAY_DLL_EXPORT Clay_RenderCommandArray Clay_EndLayoutCtx(Clay_Context *context);
+CLAY_DLL_EXPORT Clay_ElementData Clay_GetElementDataCtx(Clay_Context *context, Clay_ElementId id);
+CLAY_DLL_EXPORT bool Clay_PointerOverCtx(Clay_Context *context, Clay_ElementId elementId);
+CLAY_DLL_EXPORT Clay_ScrollContainerData Clay_GetScrollContainerDataCtx(Clay_Context *context, Clay_ElementId id);
+CLAY_DLL_EXPORT void Clay_SetMeasureTextFunctionCtx(Clay_Context *context, Clay_Dimensions (*measureTextFunction)(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData), void *userData);
+CLAY_DLL_EXPORT void Clay_SetFontMetricsCtx(Clay_Context *context, Clay_FontMetrics metrics);
+CLAY_DLL_EXPORT void Clay_SetMeasureTextBatchFunctionCtx(Clay_Context *context, void (*measureTextBatchFunction)(Clay_MeasureTextBatch *batch, Clay_TextElementConfig *config, void *userData), void *userData);
+CLAY_DLL_EXPORT void Clay_SetQueryScrollOffsetFunctionCtx(Clay_Context *context, Clay_Vector2 (*queryScrollOffsetFunction)(uint32_t elementId, void *userData), void *userData);
+CLAY_DLL_EXPORT void Clay_SetParallelForFunctionCtx(Clay_Context *context, void (*parallelForFunction)(int32_t count, void (*task)(int32_t index, void *taskData), void *taskData, void *userData), void *userData);
+CLAY_DLL_EXPORT void Clay_ResetMeasureTextCacheCtx(Clay_Context *context);
+CLAY_DLL_EXPORT Clay_MeasureTextCacheStats Clay_GetMeasureTextCacheStatsCtx(Clay_Context *context);
+CLAY_DLL_EXPORT int32_t Clay_SaveMeasureTextCacheCtx(Clay_Context *context, void *buffer, int32_t bufferSize, uint64_t fontKey);
+CLAY_DLL_EXPORT int32_t Clay_LoadMeasureTextCacheCtx(Clay_Context *context, const void *data, int32_t dataSize, uint64_t fontKey);
+CLAY_DLL_EXPORT int32_t Clay_PrewarmTextCtx(Clay_Context *context, const Clay_String *texts, const Clay_TextElementConfig *configs, int32_t count, void *buffer, int32_t bufferSize);
+CLAY_DLL_EXPORT int32_t Clay_MergePrewarmedTextCtx(Clay_Context *context, const void *data, int32_t dataSize);
 
 // Internal API functions required by macros ----------------------
 
@@ -928,6 +1129,8 @@ CLAY_DLL_EXPORT void Clay__ConfigureOpenElementPtr(const Clay_ElementDeclaration
 CLAY_DLL_EXPORT void Clay__CloseElement(void);
 CLAY_DLL_EXPORT Clay_ElementId Clay__HashString(Clay_String key, uint32_t seed);
 CLAY_DLL_EXPORT Clay_ElementId Clay__HashStringWithOffset(Clay_String key, uint32_t offset, uint32_t seed);
+CLAY_DLL_EXPORT Clay_ElementId Clay__HashStringPrecomputed(Clay_String key, uint32_t hash);
+CLAY_DLL_EXPORT Clay_ElementId Clay__HashStringWithOffsetPrecomputed(Clay_String key, uint32_t offset, uint32_t base);
 CLAY_DLL_EXPORT void Clay__OpenTextElement(Clay_String text, Clay_TextElementConfig *textConfig);
 CLAY_DLL_EXPORT Clay_TextElementConfig *Clay__StoreTextElementConfig(Clay_TextElementConfig config);
 CLAY_DLL_EXPORT uint32_t Clay__GetParentElementId(void);
@@ -1024,7 +1227,7 @@ typedef struct                                      \
                                                     \
 CLAY__ARRAY_DEFINE_FUNCTIONS(typeName, arrayName)   \
 
-Clay_Context *Clay__currentContext;
+CLAY__THREAD_LOCAL Clay_Context *Clay__currentContext;
 int32_t Clay__defaultMaxElementCount = 8192;
 int32_t Clay__defaultMaxMeasureTextWordCacheCount = 16384;
 
@@ -1070,8 +1273,12 @@ bool Clay__Array_RangeCheck(int32_t index, int32_t length);
 bool Clay__Array_AddCapacityCheck(int32_t length, int32_t capacity);
 
 CLAY__ARRAY_DEFINE(bool, Clay__boolArray)
+CLAY__ARRAY_DEFINE(uint8_t, Clay__uint8_tArray)
 CLAY__ARRAY_DEFINE(int32_t, Clay__int32_tArray)
 CLAY__ARRAY_DEFINE(char, Clay__charArray)
+CLAY__ARRAY_DEFINE(float, Clay__floatArray)
+CLAY__ARRAY_DEFINE(Clay_Dimensions, Clay__DimensionsArray)
+CLAY__ARRAY_DEFINE(Clay__SizingType, Clay__SizingTypeArray)
 CLAY__ARRAY_DEFINE_FUNCTIONS(Clay_ElementId, Clay_ElementIdArray)
 CLAY__ARRAY_DEFINE(Clay_LayoutConfig, Clay__LayoutConfigArray)
 CLAY__ARRAY_DEFINE(Clay_TextElementConfig, Clay__TextElementConfigArray)
@@ -1127,10 +1334,39 @@ typedef struct {
     Clay_Dimensions preferredDimensions;
     int32_t elementIndex;
     Clay__WrappedTextLineArraySlice wrappedLines;
+    // The measure text cache item found when the text was declared, or 0 if it couldn't be measured
+    int32_t measureTextCacheItemIndex;
+    uint32_t measureTextCacheItemId;
 } Clay__TextElementData;
 
 CLAY__ARRAY_DEFINE(Clay__TextElementData, Clay__TextElementDataArray)
 
+// What an element looked like at the end of the last frame's layout, kept only when retained layout is enabled
+typedef struct {
+    uint32_t structureHash;
+    uint32_t generation;
+    Clay_Dimensions sizingInput; // Dimensions when the element's children were sized along the x axis
+    float sizingInputHeight; // Height when the element's children were sized along the y axis
+    Clay_Dimensions sizedDimensions; // After the x axis pass
+    Clay_Dimensions finalDimensions; // After the y axis pass
+    int32_t wrappedLinesStart;
+    int32_t wrappedLinesCount;
+    Clay_BoundingBox boundingBox;
+    uint32_t renderCommandsGeneration;
+    int32_t renderCommandsStart;
+    int32_t renderCommandsCount;
+    int16_t zIndex;
+    uint16_t rootChildCount;
+} Clay__RetainedElementData;
+
+CLAY__ARRAY_DEFINE(Clay__RetainedElementData, Clay__RetainedElementDataArray)
+
+typedef CLAY_PACKED_ENUM {
+    CLAY__RETAINED_STATE_NONE,
+    CLAY__RETAINED_STATE_SIZED_X, // Dimensions restored after the x axis pass
+    CLAY__RETAINED_STATE_SIZED_Y, // Dimensions restored after both passes
+} Clay__RetainedState;
+
 typedef struct {
     int32_t *elements;
     uint16_t length;
@@ -1145,8 +1381,17 @@ typedef struct {
     Clay_Dimensions minDimensions;
     Clay_LayoutConfig *layoutConfig;
     Clay__ElementConfigArraySlice elementConfigs;
+    uint16_t configTypes; // Bit (1 << type) is set for each Clay__ElementConfigType in elementConfigs
+    // Direct references to the configs the layout passes look up most, NULL if the element doesn't have one
+    Clay_TextElementConfig *textConfig;
+    Clay_ClipElementConfig *clipConfig;
+    Clay_FloatingElementConfig *floatingConfig;
     uint32_t id;
     uint16_t floatingChildrenCount;
+    // Only used with retained layout, see Clay_SetRetainedLayoutEnabled
+    uint32_t structureHash; // Zero if the subtree can't be retained
+    Clay__RetainedElementData *retainedData;
+    Clay__RetainedState retainedState;
 } Clay_LayoutElement;
 
 CLAY__ARRAY_DEFINE(Clay_LayoutElement, Clay_LayoutElementArray)
@@ -1175,41 +1420,63 @@ typedef struct {
 
 CLAY__ARRAY_DEFINE(Clay__DebugElementData, Clay__DebugElementDataArray)
 
-typedef struct { // todo get this struct into a single cache line
+// The fields of a layout element hash map entry read by lookups during layout and pointer tests.
+// 32 bytes on 64 bit targets, so two entries share a cache line.
+typedef struct {
     Clay_BoundingBox boundingBox;
-    Clay_ElementId elementId;
-    Clay_LayoutElement* layoutElement;
-    void (*onHoverFunction)(Clay_ElementId elementId, Clay_PointerData pointerInfo, void *userData);
-    void *hoverFunctionUserData;
-    int32_t nextIndex;
+    uint32_t id;
     uint32_t generation;
-    Clay__DebugElementData *debugData;
+    Clay_LayoutElement* layoutElement;
 } Clay_LayoutElementHashMapItem;
 
 CLAY__ARRAY_DEFINE(Clay_LayoutElementHashMapItem, Clay__LayoutElementHashMapItemArray)
 
+// Rarely touched per-element data, stored in a side table at the same index as its Clay_LayoutElementHashMapItem
 typedef struct {
-    int32_t startOffset;
-    int32_t length;
-    float width;
-    int32_t next;
-} Clay__MeasuredWord;
+    Clay_ElementId elementId;
+    void (*onHoverFunction)(Clay_ElementId elementId, Clay_PointerData pointerInfo, void *userData);
+    void *hoverFunctionUserData;
+    Clay__DebugElementData *debugData;
+    Clay__RetainedElementData *retainedData;
+} Clay__LayoutElementHashMapColdItem;
 
-CLAY__ARRAY_DEFINE(Clay__MeasuredWord, Clay__MeasuredWordArray)
+CLAY__ARRAY_DEFINE(Clay__LayoutElementHashMapColdItem, Clay__LayoutElementHashMapColdItemArray)
 
 typedef struct {
     Clay_Dimensions unwrappedDimensions;
-    int32_t measuredWordsStartIndex;
+    // The item's words are a contiguous span of the measured word arrays, see Clay__AddMeasuredWord
+    int32_t measuredWordsStart;
+    int32_t measuredWordsCount;
+    // The lines the text was last wrapped into at wrappedWidth, as a second span of the same arrays, see Clay__CacheWrappedLines
+    int32_t wrappedLinesStart;
+    int32_t wrappedLinesCount;
+    float wrappedWidth;
     float minWidth;
+    float spaceWidth;
     bool containsNewlines;
+    bool contentHashed; // The id was hashed from the text's contents rather than its address, so it's valid in another run
+    int32_t textLength;
     // Hash map data
     uint32_t id;
     int32_t nextIndex;
     uint32_t generation;
+    bool referenced; // Used since the clock hand last passed, see Clay__SweepMeasureTextCacheBucket
 } Clay__MeasureTextCacheItem;
 
 CLAY__ARRAY_DEFINE(Clay__MeasureTextCacheItem, Clay__MeasureTextCacheItemArray)
 
+#define CLAY__MAX_FONT_METRICS 16
+
+typedef struct {
+    uint16_t fontId;
+    uint16_t fontSize;
+    float lineHeight;
+    float monospaceAdvance;
+    float advances[256];
+} Clay__FontMetrics;
+
+CLAY__ARRAY_DEFINE(Clay__FontMetrics, Clay__FontMetricsArray)
+
 typedef struct {
     Clay_LayoutElement *layoutElement;
     Clay_Vector2 position;
@@ -1224,10 +1491,37 @@ typedef struct {
     uint32_t clipElementId; // This can be zero if there is no clip element
     int16_t zIndex;
     Clay_Vector2 pointerOffset; // Only used when scroll containers are managed externally
+    // Only used when laying out tree roots in parallel, see Clay_SetParallelForFunction
+    int32_t declarationIndex;
+    int32_t wave;
+    int32_t elementOffset;
+    int32_t elementCount;
+    int32_t renderCommandOffset;
+    int32_t renderCommandCount;
+    // Only used with retained layout, the boxes of the parent and clip elements when this root was positioned
+    Clay_BoundingBox parentBoundingBox;
+    Clay_BoundingBox clipBoundingBox;
 } Clay__LayoutElementTreeRoot;
 
 CLAY__ARRAY_DEFINE(Clay__LayoutElementTreeRoot, Clay__LayoutElementTreeRootArray)
 
+// One element of the pointer hit test index, stored in the depth first order Clay_SetPointerState reports elements in.
+// min and max are the area the pointer can hit, already offset by the root's pointerOffset and cut to the clip element.
+// subtreeMin and subtreeMax also cover every descendant, which children can overflow, so a query can skip the whole
+// subtree, up to subtreeEnd, when the pointer is outside them.
+typedef struct {
+    Clay_Vector2 min;
+    Clay_Vector2 max;
+    Clay_Vector2 subtreeMin;
+    Clay_Vector2 subtreeMax;
+    int32_t subtreeEnd;
+    int32_t parent;
+    int32_t hashMapItemIndex;
+    int32_t rootIndex;
+} Clay__PointerHitTestEntry;
+
+CLAY__ARRAY_DEFINE(Clay__PointerHitTestEntry, Clay__PointerHitTestEntryArray)
+
 struct Clay_Context {
     int32_t maxElementCount;
     int32_t maxMeasureTextCacheWordCount;
@@ -1237,17 +1531,32 @@ struct Clay_Context {
     Clay__WarningArray warnings;
 
     Clay_PointerData pointerInfo;
+    bool pointerOverIdsStale; // The pointer has moved since pointerOverIds was updated, see Clay__UpdatePointerOverIds
+    int32_t pointerHitTestQueries; // Since the last layout, the first walks the tree and the second builds pointerHitTestEntries
+    int32_t hoverFunctionCount; // Clay_OnHover calls this frame
     Clay_Dimensions layoutDimensions;
     Clay_ElementId dynamicElementIndexBaseHash;
     uint32_t dynamicElementIndex;
     bool debugModeEnabled;
     bool disableCulling;
     bool externalScrollHandlingEnabled;
+    bool retainedLayoutEnabled;
     uint32_t debugSelectedElementId;
     uint32_t generation;
+    uint32_t retainedGeneration;
+    Clay_Dimensions retainedLayoutDimensions;
+    uint32_t declarationHash; // Every element closed so far this frame, zero if any of them can't be retained
+    uint32_t previousDeclarationHash; // As of the last frame that was laid out
+    uint32_t previousDeclarationGeneration;
     uintptr_t arenaResetOffset;
+    Clay_Dimensions (*measureTextFunction)(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData);
+    void (*measureTextBatchFunction)(Clay_MeasureTextBatch *batch, Clay_TextElementConfig *config, void *userData);
+    Clay_Vector2 (*queryScrollOffsetFunction)(uint32_t elementId, void *userData);
+    void (*parallelForFunction)(int32_t count, void (*task)(int32_t index, void *taskData), void *taskData, void *userData);
     void *measureTextUserData;
+    void *measureTextBatchUserData;
     void *queryScrollOffsetUserData;
+    void *parallelForUserData;
     Clay_Arena internalArena;
     // Layout Elements / Render Commands
     Clay_LayoutElementArray layoutElements;
@@ -1275,19 +1584,49 @@ struct Clay_Context {
     Clay__WrappedTextLineArray wrappedTextLines;
     Clay__LayoutElementTreeNodeArray layoutElementTreeNodeArray1;
     Clay__LayoutElementTreeRootArray layoutElementTreeRoots;
+    Clay__int32_tArray treeRootWave;
+    Clay__floatArray sizingBlockSizes;
+    Clay__floatArray sizingBlockMinSizes;
+    Clay__floatArray sizingBlockMaxSizes;
+    Clay__SizingTypeArray sizingBlockTypes;
+    Clay__int32_tArray sizingBlockOrder;
+    Clay__int32_tArray sizingBlockBuffer;
+    Clay__int32_tArray sizingBlockPositions;
+    Clay__int32_tArray sizingBlockLimitOrder;
+    Clay__int32_tArray sizingBlockBits;
+    Clay__PointerHitTestEntryArray pointerHitTestEntries;
+    Clay__int32_tArray pointerHitTestEntryStack;
     Clay__LayoutElementHashMapItemArray layoutElementsHashMapInternal;
+    Clay__LayoutElementHashMapColdItemArray layoutElementsHashMapCold;
+    Clay__uint8_tArray layoutElementsHashMapTags;
     Clay__int32_tArray layoutElementsHashMap;
     Clay__MeasureTextCacheItemArray measureTextHashMapInternal;
     Clay__int32_tArray measureTextHashMapInternalFreeList;
     Clay__int32_tArray measureTextHashMap;
-    Clay__MeasuredWordArray measuredWords;
-    Clay__int32_tArray measuredWordsFreeList;
+    // Measured words as parallel arrays, in one contiguous span per cache item
+    Clay__int32_tArray measuredWordStartOffsets;
+    Clay__int32_tArray measuredWordLengths;
+    Clay__floatArray measuredWordWidths;
+    Clay__int32_tArray measuredWordSpans; // At the first word of a span, its cache item * 2 + 1 if it holds wrapped lines, or minus its length once freed
+    int32_t measuredWordsTop;
+    int32_t measuredWordsFreed; // Words in freed spans below measuredWordsTop
+    Clay__int32_tArray measureTextBatchWordStarts;
+    Clay__int32_tArray measureTextBatchWordLengths;
+    Clay__DimensionsArray measureTextBatchWordDimensions;
+    Clay__FontMetricsArray fontMetrics;
+    int32_t measureTextCacheClockBucket;
+    int32_t measureTextCacheSweepBucket;
+    Clay_MeasureTextCacheStats measureTextCacheStats;
     Clay__int32_tArray openClipElementStack;
     Clay_ElementIdArray pointerOverIds;
     Clay__ScrollContainerDataInternalArray scrollContainerDatas;
     Clay__boolArray treeNodeVisited;
     Clay__charArray dynamicStringData;
     Clay__DebugElementDataArray debugElementData;
+    // Retained layout
+    Clay__RetainedElementDataArray retainedElementData;
+    Clay__WrappedTextLineArray previousWrappedTextLines;
+    Clay_RenderCommandArray previousRenderCommands;
 };
 
 Clay_Context* Clay__Context_Allocate_Arena(Clay_Arena *arena) {
@@ -1312,8 +1651,13 @@ Clay_String Clay__WriteStringToCharBuffer(Clay__charArray *buffer, Clay_String s
     __attribute__((import_module("clay"), import_name("measureTextFunction"))) Clay_Dimensions Clay__MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData);
     __attribute__((import_module("clay"), import_name("queryScrollOffsetFunction"))) Clay_Vector2 Clay__QueryScrollOffset(uint32_t elementId, void *userData);
 #else
-    Clay_Dimensions (*Clay__MeasureText)(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData);
-    Clay_Vector2 (*Clay__QueryScrollOffset)(uint32_t elementId, void *userData);
+    // The callbacks are stored per context, so contexts on different threads can measure and scroll independently
+    static inline Clay_Dimensions Clay__MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
+        return Clay_GetCurrentContext()->measureTextFunction(text, config, userData);
+    }
+    static inline Clay_Vector2 Clay__QueryScrollOffset(uint32_t elementId, void *userData) {
+        return Clay_GetCurrentContext()->queryScrollOffsetFunction(elementId, userData);
+    }
 #endif
 
 Clay_LayoutElement* Clay__GetOpenLayoutElement(void) {
@@ -1343,10 +1687,25 @@ Clay_ElementConfig Clay__AttachElementConfig(Clay_ElementConfigUnion config, Cla
     }
     Clay_LayoutElement *openLayoutElement = Clay__GetOpenLayoutElement();
     openLayoutElement->elementConfigs.length++;
+    openLayoutElement->configTypes |= 1 << type;
+    switch (type) {
+        case CLAY__ELEMENT_CONFIG_TYPE_CLIP: openLayoutElement->clipConfig = config.clipElementConfig; break;
+        case CLAY__ELEMENT_CONFIG_TYPE_FLOATING: openLayoutElement->floatingConfig = config.floatingElementConfig; break;
+        default: break;
+    }
     return *Clay__ElementConfigArray_Add(&context->elementConfigs, CLAY__INIT(Clay_ElementConfig) { .type = type, .config = config });
 }
 
 Clay_ElementConfigUnion Clay__FindElementConfigWithType(Clay_LayoutElement *element, Clay__ElementConfigType type) {
+    if (!(element->configTypes & (1 << type))) {
+        return CLAY__INIT(Clay_ElementConfigUnion) { NULL };
+    }
+    switch (type) {
+        case CLAY__ELEMENT_CONFIG_TYPE_TEXT: return CLAY__INIT(Clay_ElementConfigUnion) { .textElementConfig = element->textConfig };
+        case CLAY__ELEMENT_CONFIG_TYPE_CLIP: return CLAY__INIT(Clay_ElementConfigUnion) { .clipElementConfig = element->clipConfig };
+        case CLAY__ELEMENT_CONFIG_TYPE_FLOATING: return CLAY__INIT(Clay_ElementConfigUnion) { .floatingElementConfig = element->floatingConfig };
+        default: break;
+    }
     for (int32_t i = 0; i < element->elementConfigs.length; i++) {
         Clay_ElementConfig *config = Clay__ElementConfigArraySlice_Get(&element->elementConfigs, i);
         if (config->type == type) {
@@ -1368,6 +1727,14 @@ Clay_ElementId Clay__HashNumber(const uint32_t offset, const uint32_t seed) {
     return CLAY__INIT(Clay_ElementId) { .id = hash + 1, .offset = offset, .baseId = seed, .stringId = CLAY__STRING_DEFAULT }; // Reserve the hash result of zero as "null id"
 }
 
+// Finishes the hash of a string ID whose characters have already been hashed, see Clay__HashStringLiteral
+Clay_ElementId Clay__HashStringPrecomputed(Clay_String key, uint32_t hash) {
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+    return CLAY__INIT(Clay_ElementId) { .id = hash + 1, .offset = 0, .baseId = hash + 1, .stringId = key }; // Reserve the hash result of zero as "null id"
+}
+
 Clay_ElementId Clay__HashString(Clay_String key, const uint32_t seed) {
     uint32_t hash = seed;
 
@@ -1376,15 +1743,10 @@ Clay_ElementId Clay__HashString(Clay_String key, const uint32_t seed) {
         hash += (hash << 10);
         hash ^= (hash >> 6);
     }
-
-    hash += (hash << 3);
-    hash ^= (hash >> 11);
-    hash += (hash << 15);
-    return CLAY__INIT(Clay_ElementId) { .id = hash + 1, .offset = 0, .baseId = hash + 1, .stringId = key }; // Reserve the hash result of zero as "null id"
+    return Clay__HashStringPrecomputed(key, hash);
 }
 
 Clay_ElementId Clay__HashStringWithOffset(Clay_String key, const uint32_t offset, const uint32_t seed) {
-    uint32_t hash = 0;
     uint32_t base = seed;
 
     for (int32_t i = 0; i < key.length; i++) {
@@ -1392,7 +1754,12 @@ Clay_ElementId Clay__HashStringWithOffset(Clay_String key, const uint32_t offset
         base += (base << 10);
         base ^= (base >> 6);
     }
-    hash = base;
+    return Clay__HashStringWithOffsetPrecomputed(key, offset, base);
+}
+
+// Finishes the hash of an indexed string ID whose characters have already been hashed into base
+Clay_ElementId Clay__HashStringWithOffsetPrecomputed(Clay_String key, const uint32_t offset, uint32_t base) {
+    uint32_t hash = base;
     hash += offset;
     hash += (hash << 10);
     hash ^= (hash >> 6);
@@ -1406,126 +1773,242 @@ Clay_ElementId Clay__HashStringWithOffset(Clay_String key, const uint32_t offset
     return CLAY__INIT(Clay_ElementId) { .id = hash + 1, .offset = offset, .baseId = base + 1, .stringId = key }; // Reserve the hash result of zero as "null id"
 }
 
-#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64))
-static inline __m128i Clay__SIMDRotateLeft(__m128i x, int r) {
-    return _mm_or_si128(_mm_slli_epi64(x, r), _mm_srli_epi64(x, 64 - r));
+// Clay__HashData hashes the contents of dynamic strings every frame, and checksums saved measurement caches. Inputs of up
+// to 128 bytes, which covers most UI text, are read 8 bytes at a time with overlapping loads and mixed with independent
+// 64x64 -> 128 bit multiplies. Longer inputs are accumulated in 32 byte stripes across four 64 bit lanes, which map onto one
+// AVX2 register, two SSE2 or NEON registers, or four scalar variables. Every path computes the same hash, so the AVX2 path
+// can be chosen at runtime, and hashes saved on one machine are still valid on another.
+#define CLAY__HASH_MEDIUM_MAX 128
+#define CLAY__HASH_STRIPE_SIZE 32
+#define CLAY__HASH_KEY_STEP 0x9E3779B97F4A7C15ULL
+
+// Pinched these constants from the BLAKE implementation. The first four are the stripe keys, the last four the initial lanes.
+static const uint64_t Clay__hashSecret[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL,
+};
+
+static inline uint64_t Clay__HashRead64(const uint8_t *data) {
+    return (uint64_t)data[0] | ((uint64_t)data[1] << 8) | ((uint64_t)data[2] << 16) | ((uint64_t)data[3] << 24)
+        | ((uint64_t)data[4] << 32) | ((uint64_t)data[5] << 40) | ((uint64_t)data[6] << 48) | ((uint64_t)data[7] << 56);
 }
 
-static inline void Clay__SIMDARXMix(__m128i* a, __m128i* b) {
-    *a = _mm_add_epi64(*a, *b);
-    *b = _mm_xor_si128(Clay__SIMDRotateLeft(*b, 17), *a);
+static inline uint64_t Clay__HashRead32(const uint8_t *data) {
+    return (uint64_t)data[0] | ((uint64_t)data[1] << 8) | ((uint64_t)data[2] << 16) | ((uint64_t)data[3] << 24);
 }
 
-uint64_t Clay__HashData(const uint8_t* data, size_t length) {
-    // Pinched these constants from the BLAKE implementation
-    __m128i v0 = _mm_set1_epi64x(0x6a09e667f3bcc908ULL);
-    __m128i v1 = _mm_set1_epi64x(0xbb67ae8584caa73bULL);
-    __m128i v2 = _mm_set1_epi64x(0x3c6ef372fe94f82bULL);
-    __m128i v3 = _mm_set1_epi64x(0xa54ff53a5f1d36f1ULL);
-
-    uint8_t overflowBuffer[16] = { 0 };  // Temporary buffer for small inputs
-
-    while (length > 0) {
-        __m128i msg;
-        if (length >= 16) {
-            msg = _mm_loadu_si128((const __m128i*)data);
-            data += 16;
-            length -= 16;
-        }
-        else {
-            for (size_t i = 0; i < length; i++) {
-                overflowBuffer[i] = data[i];
-            }
-            msg = _mm_loadu_si128((const __m128i*)overflowBuffer);
-            length = 0;
-        }
+// Multiplies to 128 bits and xors the halves together
+static inline uint64_t Clay__HashMultiplyFold(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+    uint64_t high;
+    uint64_t low = _umul128(a, b, &high);
+    return low ^ high;
+#else
+    uint64_t lowLow = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    uint64_t highLow = (a >> 32) * (b & 0xFFFFFFFF);
+    uint64_t lowHigh = (a & 0xFFFFFFFF) * (b >> 32);
+    uint64_t cross = (lowLow >> 32) + (highLow & 0xFFFFFFFF) + lowHigh;
+    uint64_t high = (highLow >> 32) + (cross >> 32) + (a >> 32) * (b >> 32);
+    uint64_t low = (cross << 32) | (lowLow & 0xFFFFFFFF);
+    return low ^ high;
+#endif
+}
 
-        v0 = _mm_xor_si128(v0, msg);
-        Clay__SIMDARXMix(&v0, &v1);
-        Clay__SIMDARXMix(&v2, &v3);
+static inline uint64_t Clay__HashAvalanche(uint64_t hash) {
+    hash ^= hash >> 37;
+    hash *= 0x165667919E3779F9ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
 
-        v0 = _mm_add_epi64(v0, v2);
-        v1 = _mm_add_epi64(v1, v3);
+uint64_t Clay__HashDataShort(const uint8_t *data, size_t length) {
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (length >= 8) {
+        a = Clay__HashRead64(data);
+        b = Clay__HashRead64(data + length - 8);
+    } else if (length >= 4) {
+        a = Clay__HashRead32(data);
+        b = Clay__HashRead32(data + length - 4);
+    } else if (length > 0) {
+        a = ((uint64_t)data[0] << 16) | ((uint64_t)data[length >> 1] << 8) | data[length - 1];
     }
-
-    Clay__SIMDARXMix(&v0, &v1);
-    Clay__SIMDARXMix(&v2, &v3);
-    v0 = _mm_add_epi64(v0, v2);
-    v1 = _mm_add_epi64(v1, v3);
-    v0 = _mm_add_epi64(v0, v1);
-
-    uint64_t result[2];
-    _mm_storeu_si128((__m128i*)result, v0);
-
-    return result[0] ^ result[1];
+    return Clay__HashMultiplyFold(Clay__HashMultiplyFold(a ^ Clay__hashSecret[2], b ^ Clay__hashSecret[3]) ^ Clay__hashSecret[4], length ^ Clay__hashSecret[5]);
 }
-#elif !defined(CLAY_DISABLE_SIMD) && defined(__aarch64__)
-static inline void Clay__SIMDARXMix(uint64x2_t* a, uint64x2_t* b) {
-    *a = vaddq_u64(*a, *b);
-    *b = veorq_u64(vorrq_u64(vshlq_n_u64(*b, 17), vshrq_n_u64(*b, 64 - 17)), *a);
+
+// 16 byte blocks are taken in pairs from both ends until they meet, overlapping in the middle unless the length is a
+// multiple of 32. Every block position has its own keys so that swapping blocks changes the hash.
+uint64_t Clay__HashDataMedium(const uint8_t *data, size_t length) {
+    uint64_t hash = length * CLAY__HASH_KEY_STEP;
+    size_t pairs = (length + 31) / 32;
+    for (size_t pair = 0; pair < pairs; pair++) {
+        const uint8_t *front = data + pair * 16;
+        const uint8_t *back = data + length - 16 - pair * 16;
+        uint64_t keyOffset = pair * CLAY__HASH_KEY_STEP;
+        hash += Clay__HashMultiplyFold(Clay__HashRead64(front) ^ (Clay__hashSecret[0] + keyOffset), Clay__HashRead64(front + 8) ^ (Clay__hashSecret[1] + keyOffset));
+        hash += Clay__HashMultiplyFold(Clay__HashRead64(back) ^ (Clay__hashSecret[2] + keyOffset), Clay__HashRead64(back + 8) ^ (Clay__hashSecret[3] + keyOffset));
+    }
+    return Clay__HashAvalanche(hash);
 }
 
-uint64_t Clay__HashData(const uint8_t* data, size_t length) {
-    // Pinched these constants from the BLAKE implementation
-    uint64x2_t v0 = vdupq_n_u64(0x6a09e667f3bcc908ULL);
-    uint64x2_t v1 = vdupq_n_u64(0xbb67ae8584caa73bULL);
-    uint64x2_t v2 = vdupq_n_u64(0x3c6ef372fe94f82bULL);
-    uint64x2_t v3 = vdupq_n_u64(0xa54ff53a5f1d36f1ULL);
-
-    uint8_t overflowBuffer[8] = { 0 };
-
-    while (length > 0) {
-        uint64x2_t msg;
-        if (length > 16) {
-            msg = vld1q_u64((const uint64_t*)data);
-            data += 16;
-            length -= 16;
+// Each lane adds the product of the low and high halves of its keyed input, plus its neighbour's unkeyed input so that no
+// bits are lost when a half is zero. The keys change every stripe so that reordering stripes changes the hash. The last
+// stripe is the final 32 bytes of the input, overlapping the one before it unless the length is a multiple of 32.
+void Clay__HashAccumulateScalar(uint64_t *accumulators, const uint8_t *data, size_t length) {
+    uint64_t keys[4] = { Clay__hashSecret[0], Clay__hashSecret[1], Clay__hashSecret[2], Clay__hashSecret[3] };
+    size_t fullStripes = (length - 1) / CLAY__HASH_STRIPE_SIZE;
+    for (size_t stripe = 0; stripe <= fullStripes; stripe++) {
+        const uint8_t *stripeData = stripe < fullStripes ? data + stripe * CLAY__HASH_STRIPE_SIZE : data + length - CLAY__HASH_STRIPE_SIZE;
+        uint64_t words[4];
+        for (int32_t lane = 0; lane < 4; lane++) {
+            words[lane] = Clay__HashRead64(stripeData + lane * 8);
         }
-        else if (length > 8) {
-            msg = vcombine_u64(vld1_u64((const uint64_t*)data), vdup_n_u64(0));
-            data += 8;
-            length -= 8;
-        }
-        else {
-            for (size_t i = 0; i < length; i++) {
-                overflowBuffer[i] = data[i];
-            }
-            uint8x8_t lower = vld1_u8(overflowBuffer);
-            msg = vreinterpretq_u64_u8(vcombine_u8(lower, vdup_n_u8(0)));
-            length = 0;
+        for (int32_t lane = 0; lane < 4; lane++) {
+            uint64_t keyed = words[lane] ^ keys[lane];
+            accumulators[lane] += (keyed & 0xFFFFFFFF) * (keyed >> 32) + words[lane ^ 1];
+            keys[lane] += CLAY__HASH_KEY_STEP;
         }
-        v0 = veorq_u64(v0, msg);
-        Clay__SIMDARXMix(&v0, &v1);
-        Clay__SIMDARXMix(&v2, &v3);
+    }
+}
 
-        v0 = vaddq_u64(v0, v2);
-        v1 = vaddq_u64(v1, v3);
+#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64))
+void Clay__HashAccumulateSIMD(uint64_t *accumulators, const uint8_t *data, size_t length) {
+    __m128i accumulator0 = _mm_loadu_si128((const __m128i *)accumulators);
+    __m128i accumulator1 = _mm_loadu_si128((const __m128i *)(accumulators + 2));
+    __m128i key0 = _mm_loadu_si128((const __m128i *)Clay__hashSecret);
+    __m128i key1 = _mm_loadu_si128((const __m128i *)(Clay__hashSecret + 2));
+    const __m128i step = _mm_set1_epi64x((int64_t)CLAY__HASH_KEY_STEP);
+    size_t fullStripes = (length - 1) / CLAY__HASH_STRIPE_SIZE;
+    for (size_t stripe = 0; stripe <= fullStripes; stripe++) {
+        const uint8_t *stripeData = stripe < fullStripes ? data + stripe * CLAY__HASH_STRIPE_SIZE : data + length - CLAY__HASH_STRIPE_SIZE;
+        __m128i words0 = _mm_loadu_si128((const __m128i *)stripeData);
+        __m128i words1 = _mm_loadu_si128((const __m128i *)(stripeData + 16));
+        __m128i keyed0 = _mm_xor_si128(words0, key0);
+        __m128i keyed1 = _mm_xor_si128(words1, key1);
+        accumulator0 = _mm_add_epi64(accumulator0, _mm_add_epi64(_mm_mul_epu32(keyed0, _mm_srli_epi64(keyed0, 32)), _mm_shuffle_epi32(words0, _MM_SHUFFLE(1, 0, 3, 2))));
+        accumulator1 = _mm_add_epi64(accumulator1, _mm_add_epi64(_mm_mul_epu32(keyed1, _mm_srli_epi64(keyed1, 32)), _mm_shuffle_epi32(words1, _MM_SHUFFLE(1, 0, 3, 2))));
+        key0 = _mm_add_epi64(key0, step);
+        key1 = _mm_add_epi64(key1, step);
     }
+    _mm_storeu_si128((__m128i *)accumulators, accumulator0);
+    _mm_storeu_si128((__m128i *)(accumulators + 2), accumulator1);
+}
 
-    Clay__SIMDARXMix(&v0, &v1);
-    Clay__SIMDARXMix(&v2, &v3);
-    v0 = vaddq_u64(v0, v2);
-    v1 = vaddq_u64(v1, v3);
-    v0 = vaddq_u64(v0, v1);
+// AVX2 is picked at runtime, since Clay is rarely compiled with it enabled
+#if defined(_MSC_VER) && !defined(__clang__)
+#define CLAY__TARGET_AVX2
+#else
+#define CLAY__TARGET_AVX2 __attribute__((target("avx2")))
+#endif
 
-    uint64_t result[2];
-    vst1q_u64(result, v0);
+// Relaxed loads and stores of an int32_t, for state that any thread may fill in and where every thread fills in the same
+#if defined(_MSC_VER) && !defined(__clang__)
+#define CLAY__LOAD_RELAXED(pointer) __iso_volatile_load32((const volatile __int32 *)(pointer))
+#define CLAY__STORE_RELAXED(pointer, value) __iso_volatile_store32((volatile __int32 *)(pointer), (value))
+#else
+#define CLAY__LOAD_RELAXED(pointer) __atomic_load_n((pointer), __ATOMIC_RELAXED)
+#define CLAY__STORE_RELAXED(pointer, value) __atomic_store_n((pointer), (value), __ATOMIC_RELAXED)
+#endif
 
-    return result[0] ^ result[1];
-}
+bool Clay__CPUSupportsAVX2(void) {
+#if defined(__AVX2__)
+    return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // The OS has to save the upper halves of the registers (OSXSAVE, then XCR0) as well as the CPU supporting AVX
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
 #else
-uint64_t Clay__HashData(const uint8_t* data, size_t length) {
-    uint64_t hash = 0;
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
 
-    for (size_t i = 0; i < length; i++) {
-        hash += data[i];
-        hash += (hash << 10);
-        hash ^= (hash >> 6);
+// 0 until the first long string is hashed, then 2 if the CPU supports AVX2 and 1 if not
+int32_t Clay__hashDataAVX2State = 0;
+
+bool Clay__HashDataUseAVX2(void) {
+    int32_t state = CLAY__LOAD_RELAXED(&Clay__hashDataAVX2State);
+    if (state == 0) {
+        state = Clay__CPUSupportsAVX2() ? 2 : 1;
+        CLAY__STORE_RELAXED(&Clay__hashDataAVX2State, state);
     }
-    return hash;
+    return state == 2;
+}
+
+CLAY__TARGET_AVX2 void Clay__HashAccumulateAVX2(uint64_t *accumulators, const uint8_t *data, size_t length) {
+    __m256i accumulator = _mm256_loadu_si256((const __m256i *)accumulators);
+    __m256i key = _mm256_loadu_si256((const __m256i *)Clay__hashSecret);
+    const __m256i step = _mm256_set1_epi64x((int64_t)CLAY__HASH_KEY_STEP);
+    size_t fullStripes = (length - 1) / CLAY__HASH_STRIPE_SIZE;
+    for (size_t stripe = 0; stripe <= fullStripes; stripe++) {
+        const uint8_t *stripeData = stripe < fullStripes ? data + stripe * CLAY__HASH_STRIPE_SIZE : data + length - CLAY__HASH_STRIPE_SIZE;
+        __m256i words = _mm256_loadu_si256((const __m256i *)stripeData);
+        __m256i keyed = _mm256_xor_si256(words, key);
+        accumulator = _mm256_add_epi64(accumulator, _mm256_add_epi64(_mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32)), _mm256_shuffle_epi32(words, _MM_SHUFFLE(1, 0, 3, 2))));
+        key = _mm256_add_epi64(key, step);
+    }
+    _mm256_storeu_si256((__m256i *)accumulators, accumulator);
+}
+#elif !defined(CLAY_DISABLE_SIMD) && defined(__aarch64__)
+void Clay__HashAccumulateSIMD(uint64_t *accumulators, const uint8_t *data, size_t length) {
+    uint64x2_t accumulator0 = vld1q_u64(accumulators);
+    uint64x2_t accumulator1 = vld1q_u64(accumulators + 2);
+    uint64x2_t key0 = vld1q_u64(Clay__hashSecret);
+    uint64x2_t key1 = vld1q_u64(Clay__hashSecret + 2);
+    const uint64x2_t step = vdupq_n_u64(CLAY__HASH_KEY_STEP);
+    size_t fullStripes = (length - 1) / CLAY__HASH_STRIPE_SIZE;
+    for (size_t stripe = 0; stripe <= fullStripes; stripe++) {
+        const uint8_t *stripeData = stripe < fullStripes ? data + stripe * CLAY__HASH_STRIPE_SIZE : data + length - CLAY__HASH_STRIPE_SIZE;
+        uint64x2_t words0 = vreinterpretq_u64_u8(vld1q_u8(stripeData));
+        uint64x2_t words1 = vreinterpretq_u64_u8(vld1q_u8(stripeData + 16));
+        uint64x2_t keyed0 = veorq_u64(words0, key0);
+        uint64x2_t keyed1 = veorq_u64(words1, key1);
+        accumulator0 = vaddq_u64(accumulator0, vaddq_u64(vmull_u32(vmovn_u64(keyed0), vshrn_n_u64(keyed0, 32)), vextq_u64(words0, words0, 1)));
+        accumulator1 = vaddq_u64(accumulator1, vaddq_u64(vmull_u32(vmovn_u64(keyed1), vshrn_n_u64(keyed1, 32)), vextq_u64(words1, words1, 1)));
+        key0 = vaddq_u64(key0, step);
+        key1 = vaddq_u64(key1, step);
+    }
+    vst1q_u64(accumulators, accumulator0);
+    vst1q_u64(accumulators + 2, accumulator1);
 }
 #endif
 
+uint64_t Clay__HashData(const uint8_t* data, size_t length) {
+    if (length <= 16) {
+        return Clay__HashDataShort(data, length);
+    } else if (length <= CLAY__HASH_MEDIUM_MAX) {
+        return Clay__HashDataMedium(data, length);
+    }
+    uint64_t accumulators[4] = { Clay__hashSecret[4], Clay__hashSecret[5], Clay__hashSecret[6], Clay__hashSecret[7] };
+#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64))
+    if (Clay__HashDataUseAVX2()) {
+        Clay__HashAccumulateAVX2(accumulators, data, length);
+    } else {
+        Clay__HashAccumulateSIMD(accumulators, data, length);
+    }
+#elif !defined(CLAY_DISABLE_SIMD) && defined(__aarch64__)
+    Clay__HashAccumulateSIMD(accumulators, data, length);
+#else
+    Clay__HashAccumulateScalar(accumulators, data, length);
+#endif
+    uint64_t hash = length * CLAY__HASH_KEY_STEP;
+    hash += Clay__HashMultiplyFold(accumulators[0] ^ Clay__hashSecret[0], accumulators[1] ^ Clay__hashSecret[1]);
+    hash += Clay__HashMultiplyFold(accumulators[2] ^ Clay__hashSecret[2], accumulators[3] ^ Clay__hashSecret[3]);
+    return Clay__HashAvalanche(hash);
+}
+
 uint32_t Clay__HashStringContentsWithConfig(Clay_String *text, Clay_TextElementConfig *config) {
     uint32_t hash = 0;
     if (text->isStaticallyAllocated) {
@@ -1536,7 +2019,8 @@ uint32_t Clay__HashStringContentsWithConfig(Clay_String *text, Clay_TextElementC
         hash += (hash << 10);
         hash ^= (hash >> 6);
     } else {
-        hash = Clay__HashData((const uint8_t *)text->chars, text->length) % UINT32_MAX;
+        uint64_t contentHash = Clay__HashData((const uint8_t *)text->chars, text->length);
+        hash = (uint32_t)(contentHash ^ (contentHash >> 32));
     }
 
     hash += config->fontId;
@@ -1557,221 +2041,561 @@ uint32_t Clay__HashStringContentsWithConfig(Clay_String *text, Clay_TextElementC
     return hash + 1; // Reserve the hash result of zero as "null id"
 }
 
-Clay__MeasuredWord *Clay__AddMeasuredWord(Clay__MeasuredWord word, Clay__MeasuredWord *previousWord) {
-    Clay_Context* context = Clay_GetCurrentContext();
-    if (context->measuredWordsFreeList.length > 0) {
-        uint32_t newItemIndex = Clay__int32_tArray_GetValue(&context->measuredWordsFreeList, (int)context->measuredWordsFreeList.length - 1);
-        context->measuredWordsFreeList.length--;
-        Clay__MeasuredWordArray_Set(&context->measuredWords, (int)newItemIndex, word);
-        previousWord->next = (int32_t)newItemIndex;
-        return Clay__MeasuredWordArray_Get(&context->measuredWords, (int)newItemIndex);
+// Slides every live span of measured words down over the freed ones, in place and in order, so that the free words are
+// all above measuredWordsTop again. A span still being added to is always the highest, so it stays contiguous.
+void Clay__CompactMeasuredWords(Clay_Context *context) {
+    int32_t *spans = context->measuredWordSpans.internalArray;
+    int32_t writeIndex = 0;
+    for (int32_t readIndex = 0; readIndex < context->measuredWordsTop;) {
+        if (spans[readIndex] < 0) {
+            readIndex -= spans[readIndex];
+            continue;
+        }
+        Clay__MeasureTextCacheItem *item = &context->measureTextHashMapInternal.internalArray[spans[readIndex] / 2];
+        bool wrappedLines = spans[readIndex] % 2;
+        int32_t count = wrappedLines ? item->wrappedLinesCount : item->measuredWordsCount;
+        if (writeIndex != readIndex) {
+            for (int32_t i = 0; i < count; ++i) {
+                context->measuredWordStartOffsets.internalArray[writeIndex + i] = context->measuredWordStartOffsets.internalArray[readIndex + i];
+                context->measuredWordLengths.internalArray[writeIndex + i] = context->measuredWordLengths.internalArray[readIndex + i];
+                context->measuredWordWidths.internalArray[writeIndex + i] = context->measuredWordWidths.internalArray[readIndex + i];
+            }
+            spans[writeIndex] = spans[readIndex];
+            *(wrappedLines ? &item->wrappedLinesStart : &item->measuredWordsStart) = writeIndex;
+        }
+        writeIndex += count;
+        readIndex += count;
+    }
+    context->measuredWordsTop = writeIndex;
+    context->measuredWordsFreed = 0;
+}
+
+// Appends a word to the span of the item at itemIndex, which must be the last span started. Callers make sure there's a
+// free word first, see Clay__MakeMeasureTextCacheSpace, and if it's below freed spans they're compacted away.
+void Clay__AddMeasuredWord(Clay_Context *context, Clay__MeasureTextCacheItem *item, int32_t itemIndex, int32_t startOffset, int32_t length, float width) {
+    if (context->measuredWordsTop == context->measuredWordStartOffsets.capacity) {
+        Clay__CompactMeasuredWords(context);
+    }
+    int32_t wordIndex = context->measuredWordsTop++;
+    if (item->measuredWordsCount == 0) {
+        item->measuredWordsStart = wordIndex;
+        context->measuredWordSpans.internalArray[wordIndex] = itemIndex * 2;
+    }
+    item->measuredWordsCount++;
+    context->measuredWordStartOffsets.internalArray[wordIndex] = startOffset;
+    context->measuredWordLengths.internalArray[wordIndex] = length;
+    context->measuredWordWidths.internalArray[wordIndex] = width;
+}
+
+#define CLAY__MEASURE_TEXT_CACHE_SWEEP_BUCKETS 16
+
+int32_t Clay__MeasureTextCacheBucketCount(Clay_Context *context) {
+    return context->maxMeasureTextCacheWordCount / 32;
+}
+
+bool Clay__MeasureTextCacheHasSpace(Clay_Context *context, bool needsItem) {
+    bool hasItem = context->measureTextHashMapInternalFreeList.length > 0 || context->measureTextHashMapInternal.length < context->measureTextHashMapInternal.capacity - 1;
+    // A newline following a word adds two measured words at once
+    int32_t freeWords = context->measuredWordStartOffsets.capacity - (context->measuredWordsTop - context->measuredWordsFreed);
+    return freeWords >= 2 && (hasItem || !needsItem);
+}
+
+void Clay__FreeMeasuredWordSpan(Clay_Context *context, int32_t start, int32_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (start + count == context->measuredWordsTop) {
+        context->measuredWordsTop = start;
     } else {
-        previousWord->next = (int32_t)context->measuredWords.length;
-        return Clay__MeasuredWordArray_Add(&context->measuredWords, word);
+        context->measuredWordSpans.internalArray[start] = -count;
+        context->measuredWordsFreed += count;
     }
 }
 
-Clay__MeasureTextCacheItem *Clay__MeasureTextCached(Clay_String *text, Clay_TextElementConfig *config) {
-    Clay_Context* context = Clay_GetCurrentContext();
-    #ifndef CLAY_WASM
-    if (!Clay__MeasureText) {
-        if (!context->booleanWarnings.textMeasurementFunctionNotSet) {
-            context->booleanWarnings.textMeasurementFunctionNotSet = true;
-            context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
-                    .errorType = CLAY_ERROR_TYPE_TEXT_MEASUREMENT_FUNCTION_NOT_PROVIDED,
-                    .errorText = CLAY_STRING("Clay's internal MeasureText function is null. You may have forgotten to call Clay_SetMeasureTextFunction(), or passed a NULL function pointer by mistake."),
-                    .userData = context->errorHandler.userData });
-        }
-        return &Clay__MeasureTextCacheItem_DEFAULT;
+void Clay__FreeMeasuredWords(Clay_Context *context, Clay__MeasureTextCacheItem *item) {
+    Clay__FreeMeasuredWordSpan(context, item->wrappedLinesStart, item->wrappedLinesCount);
+    Clay__FreeMeasuredWordSpan(context, item->measuredWordsStart, item->measuredWordsCount);
+}
+
+// Keeps the lines the text of the item at itemIndex was just wrapped into, replacing any kept for another width. Lines are
+// only worth keeping if there's free space for them, so nothing is evicted to make room.
+void Clay__CacheWrappedLines(Clay_Context *context, int32_t itemIndex, Clay_String *text, Clay__WrappedTextLineArraySlice lines, float width) {
+    Clay__MeasureTextCacheItem *item = &context->measureTextHashMapInternal.internalArray[itemIndex];
+    Clay__FreeMeasuredWordSpan(context, item->wrappedLinesStart, item->wrappedLinesCount);
+    item->wrappedLinesCount = 0;
+    int32_t capacity = context->measuredWordStartOffsets.capacity;
+    if (lines.length == 0 || lines.length > capacity - (context->measuredWordsTop - context->measuredWordsFreed)) {
+        return;
     }
-    #endif
-    uint32_t id = Clay__HashStringContentsWithConfig(text, config);
-    uint32_t hashBucket = id % (context->maxMeasureTextCacheWordCount / 32);
+    if (context->measuredWordsTop + lines.length > capacity) {
+        Clay__CompactMeasuredWords(context);
+    }
+    int32_t start = context->measuredWordsTop;
+    context->measuredWordsTop += lines.length;
+    context->measuredWordSpans.internalArray[start] = itemIndex * 2 + 1;
+    for (int32_t i = 0; i < lines.length; ++i) {
+        context->measuredWordStartOffsets.internalArray[start + i] = (int32_t)(lines.internalArray[i].line.chars - text->chars);
+        context->measuredWordLengths.internalArray[start + i] = lines.internalArray[i].line.length;
+        context->measuredWordWidths.internalArray[start + i] = lines.internalArray[i].dimensions.width;
+    }
+    item->wrappedLinesStart = start;
+    item->wrappedLinesCount = lines.length;
+    item->wrappedWidth = width;
+}
+
+// Evicts entries from one bucket of the measure text cache. The per frame sweep evicts those that haven't been used for a few frames.
+// As a clock hand it evicts those that haven't been used since it last passed, and marks the rest to be evicted next time
+// unless they're used again before then, which approximates evicting the least recently used. Prewarmed entries are given
+// a generation in the future (see Clay_MergePrewarmedText), and the clock hand passes over them until then if keepPrewarmed is set.
+void Clay__SweepMeasureTextCacheBucket(Clay_Context *context, int32_t hashBucket, bool clockHand, bool keepPrewarmed) {
     int32_t elementIndexPrevious = 0;
     int32_t elementIndex = context->measureTextHashMap.internalArray[hashBucket];
     while (elementIndex != 0) {
         Clay__MeasureTextCacheItem *hashEntry = Clay__MeasureTextCacheItemArray_Get(&context->measureTextHashMapInternal, elementIndex);
-        if (hashEntry->id == id) {
-            hashEntry->generation = context->generation;
-            return hashEntry;
-        }
-        // This element hasn't been seen in a few frames, delete the hash map item
-        if (context->generation - hashEntry->generation > 2) {
-            // Add all the measured words that were included in this measurement to the freelist
-            int32_t nextWordIndex = hashEntry->measuredWordsStartIndex;
-            while (nextWordIndex != -1) {
-                Clay__MeasuredWord *measuredWord = Clay__MeasuredWordArray_Get(&context->measuredWords, nextWordIndex);
-                Clay__int32_tArray_Add(&context->measuredWordsFreeList, nextWordIndex);
-                nextWordIndex = measuredWord->next;
-            }
-
-            int32_t nextIndex = hashEntry->nextIndex;
-            Clay__MeasureTextCacheItemArray_Set(&context->measureTextHashMapInternal, elementIndex, CLAY__INIT(Clay__MeasureTextCacheItem) { .measuredWordsStartIndex = -1 });
-            Clay__int32_tArray_Add(&context->measureTextHashMapInternalFreeList, elementIndex);
-            if (elementIndexPrevious == 0) {
-                context->measureTextHashMap.internalArray[hashBucket] = nextIndex;
-            } else {
-                Clay__MeasureTextCacheItem *previousHashEntry = Clay__MeasureTextCacheItemArray_Get(&context->measureTextHashMapInternal, elementIndexPrevious);
-                previousHashEntry->nextIndex = nextIndex;
-            }
+        int32_t nextIndex = hashEntry->nextIndex;
+        int32_t age = (int32_t)(context->generation - hashEntry->generation);
+        if (clockHand ? hashEntry->referenced || (keepPrewarmed && age < 0) : age <= 2) {
+            hashEntry->referenced = hashEntry->referenced && !clockHand;
+            elementIndexPrevious = elementIndex;
             elementIndex = nextIndex;
+            continue;
+        }
+        Clay__FreeMeasuredWords(context, hashEntry);
+        Clay__MeasureTextCacheItemArray_Set(&context->measureTextHashMapInternal, elementIndex, CLAY__INIT(Clay__MeasureTextCacheItem) CLAY__DEFAULT_STRUCT);
+        Clay__int32_tArray_Add(&context->measureTextHashMapInternalFreeList, elementIndex);
+        if (elementIndexPrevious == 0) {
+            context->measureTextHashMap.internalArray[hashBucket] = nextIndex;
         } else {
-            elementIndexPrevious = elementIndex;
-            elementIndex = hashEntry->nextIndex;
+            Clay__MeasureTextCacheItemArray_Get(&context->measureTextHashMapInternal, elementIndexPrevious)->nextIndex = nextIndex;
         }
+        context->measureTextCacheStats.evictions++;
+        elementIndex = nextIndex;
     }
+}
 
-    int32_t newItemIndex = 0;
-    Clay__MeasureTextCacheItem newCacheItem = { .measuredWordsStartIndex = -1, .id = id, .generation = context->generation };
-    Clay__MeasureTextCacheItem *measured = NULL;
-    if (context->measureTextHashMapInternalFreeList.length > 0) {
-        newItemIndex = Clay__int32_tArray_GetValue(&context->measureTextHashMapInternalFreeList, context->measureTextHashMapInternalFreeList.length - 1);
-        context->measureTextHashMapInternalFreeList.length--;
-        Clay__MeasureTextCacheItemArray_Set(&context->measureTextHashMapInternal, newItemIndex, newCacheItem);
-        measured = Clay__MeasureTextCacheItemArray_Get(&context->measureTextHashMapInternal, newItemIndex);
-    } else {
-        if (context->measureTextHashMapInternal.length == context->measureTextHashMapInternal.capacity - 1) {
-            if (!context->booleanWarnings.maxTextMeasureCacheExceeded) {
-                context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
-                        .errorType = CLAY_ERROR_TYPE_ELEMENTS_CAPACITY_EXCEEDED,
-                        .errorText = CLAY_STRING("Clay ran out of capacity while attempting to measure text elements. Try using Clay_SetMaxElementCount() with a higher value."),
-                        .userData = context->errorHandler.userData });
-                context->booleanWarnings.maxTextMeasureCacheExceeded = true;
-            }
-            return &Clay__MeasureTextCacheItem_DEFAULT;
-        }
-        measured = Clay__MeasureTextCacheItemArray_Add(&context->measureTextHashMapInternal, newCacheItem);
-        newItemIndex = context->measureTextHashMapInternal.length - 1;
+// Moves the clock hand on until there is room for another couple of measured words, and a new entry if needsItem is set.
+// Prewarmed entries are only evicted early on the second turn, which will have evicted everything, so returns false if
+// there's still no room after that.
+bool Clay__MakeMeasureTextCacheSpace(Clay_Context *context, bool needsItem) {
+    int32_t bucketCount = Clay__MeasureTextCacheBucketCount(context);
+    for (int32_t i = 0; i < bucketCount * 2 && !Clay__MeasureTextCacheHasSpace(context, needsItem); ++i) {
+        Clay__SweepMeasureTextCacheBucket(context, context->measureTextCacheClockBucket, true, i < bucketCount);
+        context->measureTextCacheClockBucket = (context->measureTextCacheClockBucket + 1) % bucketCount;
     }
+    return Clay__MeasureTextCacheHasSpace(context, needsItem);
+}
 
-    int32_t start = 0;
-    int32_t end = 0;
-    float lineWidth = 0;
-    float measuredWidth = 0;
-    float measuredHeight = 0;
-    float spaceWidth = Clay__MeasureText(CLAY__INIT(Clay_StringSlice) { .length = 1, .chars = CLAY__SPACECHAR.chars, .baseChars = CLAY__SPACECHAR.chars }, config, context->measureTextUserData).width;
-    Clay__MeasuredWord tempWord = { .next = -1 };
-    Clay__MeasuredWord *previousWord = &tempWord;
-    while (end < text->length) {
-        if (context->measuredWords.length == context->measuredWords.capacity - 1) {
-            if (!context->booleanWarnings.maxTextMeasureCacheExceeded) {
-                context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
-                    .errorType = CLAY_ERROR_TYPE_TEXT_MEASUREMENT_CAPACITY_EXCEEDED,
-                    .errorText = CLAY_STRING("Clay has run out of space in it's internal text measurement cache. Try using Clay_SetMaxMeasureTextCacheWordCount() (default 16384, with 1 unit storing 1 measured word)."),
-                    .userData = context->errorHandler.userData });
-                context->booleanWarnings.maxTextMeasureCacheExceeded = true;
-            }
-            return &Clay__MeasureTextCacheItem_DEFAULT;
+// Called once per frame, so that entries for text that is no longer displayed are freed a few buckets at a time
+// rather than all waiting for the clock hand.
+void Clay__SweepMeasureTextCache(Clay_Context *context) {
+    int32_t bucketCount = Clay__MeasureTextCacheBucketCount(context);
+    for (int32_t i = 0; i < CLAY__MEASURE_TEXT_CACHE_SWEEP_BUCKETS && i < bucketCount; ++i) {
+        Clay__SweepMeasureTextCacheBucket(context, context->measureTextCacheSweepBucket, false, false);
+        context->measureTextCacheSweepBucket = (context->measureTextCacheSweepBucket + 1) % bucketCount;
+    }
+}
+
+// Returns the metrics for config's font if every byte of text can be measured with them, otherwise NULL
+Clay__FontMetrics *Clay__FindFontMetrics(Clay_Context *context, Clay_String *text, Clay_TextElementConfig *config) {
+    for (int32_t i = 0; i < context->fontMetrics.length; ++i) {
+        Clay__FontMetrics *fontMetrics = &context->fontMetrics.internalArray[i];
+        if (fontMetrics->fontId != config->fontId || fontMetrics->fontSize != config->fontSize) {
+            continue;
         }
-        char current = text->chars[end];
-        if (current == ' ' || current == '\n') {
-            int32_t length = end - start;
-            Clay_Dimensions dimensions = CLAY__DEFAULT_STRUCT;
-            if (length > 0) {
-                dimensions = Clay__MeasureText(CLAY__INIT(Clay_StringSlice) {.length = length, .chars = &text->chars[start], .baseChars = text->chars}, config, context->measureTextUserData);
-            }
-            measured->minWidth = CLAY__MAX(dimensions.width, measured->minWidth);
-            measuredHeight = CLAY__MAX(measuredHeight, dimensions.height);
-            if (current == ' ') {
-                dimensions.width += spaceWidth;
-                previousWord = Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = start, .length = length + 1, .width = dimensions.width, .next = -1 }, previousWord);
-                lineWidth += dimensions.width;
-            }
-            if (current == '\n') {
-                if (length > 0) {
-                    previousWord = Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = start, .length = length, .width = dimensions.width, .next = -1 }, previousWord);
-                }
-                previousWord = Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = end + 1, .length = 0, .width = 0, .next = -1 }, previousWord);
-                lineWidth += dimensions.width;
-                measuredWidth = CLAY__MAX(lineWidth, measuredWidth);
-                measured->containsNewlines = true;
-                lineWidth = 0;
+        if (fontMetrics->monospaceAdvance > 0) {
+            return fontMetrics;
+        }
+        for (int32_t j = 0; j < text->length; ++j) {
+            if (fontMetrics->advances[(uint8_t)text->chars[j]] < 0) {
+                return NULL;
             }
-            start = end + 1;
         }
-        end++;
-    }
-    if (end - start > 0) {
-        Clay_Dimensions dimensions = Clay__MeasureText(CLAY__INIT(Clay_StringSlice) { .length = end - start, .chars = &text->chars[start], .baseChars = text->chars }, config, context->measureTextUserData);
-        Clay__AddMeasuredWord(CLAY__INIT(Clay__MeasuredWord) { .startOffset = start, .length = end - start, .width = dimensions.width, .next = -1 }, previousWord);
-        lineWidth += dimensions.width;
-        measuredHeight = CLAY__MAX(measuredHeight, dimensions.height);
-        measured->minWidth = CLAY__MAX(dimensions.width, measured->minWidth);
-    }
-    measuredWidth = CLAY__MAX(lineWidth, measuredWidth) - config->letterSpacing;
-
-    measured->measuredWordsStartIndex = tempWord.next;
-    measured->unwrappedDimensions.width = measuredWidth;
-    measured->unwrappedDimensions.height = measuredHeight;
-
-    if (elementIndexPrevious != 0) {
-        Clay__MeasureTextCacheItemArray_Get(&context->measureTextHashMapInternal, elementIndexPrevious)->nextIndex = newItemIndex;
-    } else {
-        context->measureTextHashMap.internalArray[hashBucket] = newItemIndex;
+        return fontMetrics;
     }
-    return measured;
+    return NULL;
 }
 
-bool Clay__PointIsInsideRect(Clay_Vector2 point, Clay_BoundingBox rect) {
-    return point.x >= rect.x && point.x <= rect.x + rect.width && point.y >= rect.y && point.y <= rect.y + rect.height;
+// Adds up the advances of a word, with letterSpacing after each character rather than each byte
+Clay_Dimensions Clay__MeasureWordWithFontMetrics(Clay__FontMetrics *fontMetrics, Clay_StringSlice word, float letterSpacing) {
+    const uint8_t *bytes = (const uint8_t *)word.chars;
+    int32_t characters = 0;
+    for (int32_t i = 0; i < word.length; ++i) {
+        characters += (bytes[i] & 0xC0) != 0x80;
+    }
+    float width;
+    if (fontMetrics->monospaceAdvance > 0) {
+        width = (float)characters * fontMetrics->monospaceAdvance;
+    } else {
+        // Separate sums so the loads aren't serialised behind one chain of additions
+        float sums[4] = { 0, 0, 0, 0 };
+        int32_t i = 0;
+        for (; i + 4 <= word.length; i += 4) {
+            sums[0] += fontMetrics->advances[bytes[i]];
+            sums[1] += fontMetrics->advances[bytes[i + 1]];
+            sums[2] += fontMetrics->advances[bytes[i + 2]];
+            sums[3] += fontMetrics->advances[bytes[i + 3]];
+        }
+        for (; i < word.length; ++i) {
+            sums[0] += fontMetrics->advances[bytes[i]];
+        }
+        width = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    }
+    return CLAY__INIT(Clay_Dimensions) { width + (float)characters * letterSpacing, fontMetrics->lineHeight };
 }
 
-Clay_LayoutElementHashMapItem* Clay__AddHashMapItem(Clay_ElementId elementId, Clay_LayoutElement* layoutElement) {
+// Returns the index of the first ' ' or '\n' in chars at or after index, or length if there isn't one. Text is scanned 16
+// bytes at a time, so long words and log lines with few separators cost a compare per block rather than per byte.
+#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64))
+#define CLAY__WORD_BOUNDARY_MASK_STRIDE 1
+static inline uint64_t Clay__WordBoundaryMask(const char *chars) {
+    __m128i block = _mm_loadu_si128((const __m128i *)chars);
+    __m128i separators = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+    return (uint64_t)_mm_movemask_epi8(separators);
+}
+#elif !defined(CLAY_DISABLE_SIMD) && defined(__aarch64__)
+#define CLAY__WORD_BOUNDARY_MASK_STRIDE 4
+static inline uint64_t Clay__WordBoundaryMask(const char *chars) {
+    uint8x16_t block = vld1q_u8((const uint8_t *)chars);
+    uint8x16_t separators = vorrq_u8(vceqq_u8(block, vdupq_n_u8(' ')), vceqq_u8(block, vdupq_n_u8('\n')));
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(separators), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+}
+#endif
+
+static inline int32_t Clay__FindWordBoundary(const char *chars, int32_t index, int32_t length) {
+#ifdef CLAY__WORD_BOUNDARY_MASK_STRIDE
+    for (; index + 16 <= length; index += 16) {
+        uint64_t mask = Clay__WordBoundaryMask(chars + index);
+        if (mask) {
+#if defined(__GNUC__) || defined(__clang__)
+            return index + __builtin_ctzll(mask) / CLAY__WORD_BOUNDARY_MASK_STRIDE;
+#else
+            while (!(mask & 1)) {
+                mask >>= CLAY__WORD_BOUNDARY_MASK_STRIDE;
+                index++;
+            }
+            return index;
+#endif
+        }
+    }
+#endif
+    while (index < length && chars[index] != ' ' && chars[index] != '\n') {
+        index++;
+    }
+    return index;
+}
+
+// Hands every word of text to the batch measure function at once, in the order Clay__MeasureTextCached will ask for them.
+// The word arrays hold as many words as the measured word cache, so a text with more than that fails to cache before running out.
+Clay_MeasureTextBatch Clay__MeasureTextBatched(Clay_Context *context, Clay_String *text, Clay_TextElementConfig *config) {
+    Clay_MeasureTextBatch batch = {
+        .text = { .length = text->length, .chars = text->chars, .baseChars = text->chars },
+        .wordStarts = context->measureTextBatchWordStarts.internalArray,
+        .wordLengths = context->measureTextBatchWordLengths.internalArray,
+        .wordDimensions = context->measureTextBatchWordDimensions.internalArray,
+    };
+    for (int32_t start = 0; start <= text->length && batch.wordCount < context->measureTextBatchWordDimensions.capacity;) {
+        int32_t end = Clay__FindWordBoundary(text->chars, start, text->length);
+        if (end > start) {
+            context->measureTextBatchWordStarts.internalArray[batch.wordCount] = start;
+            context->measureTextBatchWordLengths.internalArray[batch.wordCount] = end - start;
+            context->measureTextBatchWordDimensions.internalArray[batch.wordCount] = CLAY__INIT(Clay_Dimensions) CLAY__DEFAULT_STRUCT;
+            batch.wordCount++;
+        }
+        start = end + 1;
+    }
+    context->measureTextBatchFunction(&batch, config, context->measureTextBatchUserData);
+    return batch;
+}
+
+// Measures the next word of a text, from the font's metrics if it has them, or from the batch if there was a batch measure
+// function to fill one in
+Clay_Dimensions Clay__MeasureWord(Clay__FontMetrics *fontMetrics, Clay_MeasureTextBatch *batch, int32_t *batchWordIndex, Clay_StringSlice word, Clay_TextElementConfig *config) {
+    if (fontMetrics) {
+        return Clay__MeasureWordWithFontMetrics(fontMetrics, word, (float)config->letterSpacing);
+    }
+    if (batch->wordDimensions) {
+        return *batchWordIndex < batch->wordCount ? batch->wordDimensions[(*batchWordIndex)++] : CLAY__INIT(Clay_Dimensions) CLAY__DEFAULT_STRUCT;
+    }
+    return Clay__MeasureText(word, config, Clay_GetCurrentContext()->measureTextUserData);
+}
+
+// Looks text up in the measure text cache, measuring and adding it on a miss. If prewarmed is set, it holds the text's word
+// and space sizes as measured by Clay_PrewarmText, and is used in place of measuring.
+Clay__MeasureTextCacheItem *Clay__MeasureTextCachedWithBatch(Clay_String *text, Clay_TextElementConfig *config, Clay_MeasureTextBatch *prewarmed) {
     Clay_Context* context = Clay_GetCurrentContext();
-    if (context->layoutElementsHashMapInternal.length == context->layoutElementsHashMapInternal.capacity - 1) {
-        return NULL;
+    uint32_t id = Clay__HashStringContentsWithConfig(text, config);
+    uint32_t hashBucket = id % Clay__MeasureTextCacheBucketCount(context);
+    int32_t elementIndex = context->measureTextHashMap.internalArray[hashBucket];
+    while (elementIndex != 0) {
+        Clay__MeasureTextCacheItem *hashEntry = Clay__MeasureTextCacheItemArray_Get(&context->measureTextHashMapInternal, elementIndex);
+        if (hashEntry->id == id && hashEntry->textLength == text->length) {
+            hashEntry->generation = context->generation;
+            hashEntry->referenced = true;
+            context->measureTextCacheStats.hits++;
+            return hashEntry;
+        }
+        elementIndex = hashEntry->nextIndex;
+    }
+    context->measureTextCacheStats.misses++;
+
+    Clay__FontMetrics *fontMetrics = prewarmed ? NULL : Clay__FindFontMetrics(context, text, config);
+    #ifndef CLAY_WASM
+    if (!prewarmed && !fontMetrics && !context->measureTextFunction && !context->measureTextBatchFunction) {
+        if (!context->booleanWarnings.textMeasurementFunctionNotSet) {
+            context->booleanWarnings.textMeasurementFunctionNotSet = true;
+            context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+                    .errorType = CLAY_ERROR_TYPE_TEXT_MEASUREMENT_FUNCTION_NOT_PROVIDED,
+                    .errorText = CLAY_STRING("Clay's internal MeasureText function is null. You may have forgotten to call Clay_SetMeasureTextFunction(), or passed a NULL function pointer by mistake."),
+                    .userData = context->errorHandler.userData });
+        }
+        return &Clay__MeasureTextCacheItem_DEFAULT;
+    }
+    #endif
+
+    if (!Clay__MakeMeasureTextCacheSpace(context, true)) {
+        if (!context->booleanWarnings.maxTextMeasureCacheExceeded) {
+            context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+                    .errorType = CLAY_ERROR_TYPE_ELEMENTS_CAPACITY_EXCEEDED,
+                    .errorText = CLAY_STRING("Clay ran out of capacity while attempting to measure text elements. Try using Clay_SetMaxElementCount() with a higher value."),
+                    .userData = context->errorHandler.userData });
+            context->booleanWarnings.maxTextMeasureCacheExceeded = true;
+        }
+        return &Clay__MeasureTextCacheItem_DEFAULT;
+    }
+    int32_t newItemIndex = 0;
+    Clay__MeasureTextCacheItem newCacheItem = { .contentHashed = !text->isStaticallyAllocated, .textLength = text->length, .id = id, .generation = context->generation, .referenced = true };
+    Clay__MeasureTextCacheItem *measured = NULL;
+    if (context->measureTextHashMapInternalFreeList.length > 0) {
+        newItemIndex = Clay__int32_tArray_GetValue(&context->measureTextHashMapInternalFreeList, context->measureTextHashMapInternalFreeList.length - 1);
+        context->measureTextHashMapInternalFreeList.length--;
+        Clay__MeasureTextCacheItemArray_Set(&context->measureTextHashMapInternal, newItemIndex, newCacheItem);
+        measured = Clay__MeasureTextCacheItemArray_Get(&context->measureTextHashMapInternal, newItemIndex);
+    } else {
+        measured = Clay__MeasureTextCacheItemArray_Add(&context->measureTextHashMapInternal, newCacheItem);
+        newItemIndex = context->measureTextHashMapInternal.length - 1;
+    }
+
+    int32_t start = 0;
+    int32_t end = 0;
+    float lineWidth = 0;
+    float measuredWidth = 0;
+    float measuredHeight = 0;
+    Clay_MeasureTextBatch batch = CLAY__DEFAULT_STRUCT;
+    int32_t batchWordIndex = 0;
+    float spaceWidth;
+    if (prewarmed) {
+        batch = *prewarmed;
+        spaceWidth = batch.spaceDimensions.width;
+    } else if (fontMetrics) {
+        spaceWidth = Clay__MeasureWordWithFontMetrics(fontMetrics, CLAY__INIT(Clay_StringSlice) { .length = 1, .chars = CLAY__SPACECHAR.chars, .baseChars = CLAY__SPACECHAR.chars }, (float)config->letterSpacing).width;
+    } else if (context->measureTextBatchFunction) {
+        batch = Clay__MeasureTextBatched(context, text, config);
+        spaceWidth = batch.spaceDimensions.width;
+    } else {
+        spaceWidth = Clay__MeasureText(CLAY__INIT(Clay_StringSlice) { .length = 1, .chars = CLAY__SPACECHAR.chars, .baseChars = CLAY__SPACECHAR.chars }, config, context->measureTextUserData).width;
     }
-    Clay_LayoutElementHashMapItem item = { .elementId = elementId, .layoutElement = layoutElement, .nextIndex = -1, .generation = context->generation + 1 };
-    uint32_t hashBucket = elementId.id % context->layoutElementsHashMap.capacity;
-    int32_t hashItemPrevious = -1;
-    int32_t hashItemIndex = context->layoutElementsHashMap.internalArray[hashBucket];
-    while (hashItemIndex != -1) { // Just replace collision, not a big deal - leave it up to the end user
-        Clay_LayoutElementHashMapItem *hashItem = Clay__LayoutElementHashMapItemArray_Get(&context->layoutElementsHashMapInternal, hashItemIndex);
-        if (hashItem->elementId.id == elementId.id) { // Collision - resolve based on generation
-            item.nextIndex = hashItem->nextIndex;
-            if (hashItem->generation <= context->generation) { // First collision - assume this is the "same" element
-                hashItem->elementId = elementId; // Make sure to copy this across. If the stringId reference has changed, we should update the hash item to use the new one.
-                hashItem->generation = context->generation + 1;
-                hashItem->layoutElement = layoutElement;
-                hashItem->debugData->collision = false;
-                hashItem->onHoverFunction = NULL;
-                hashItem->hoverFunctionUserData = 0;
-            } else { // Multiple collisions this frame - two elements have the same ID
+    measured->spaceWidth = spaceWidth;
+    while (end < text->length) {
+        // The new entry isn't in its bucket until it's finished, so the clock hand can't evict it while its words are added
+        if (!Clay__MakeMeasureTextCacheSpace(context, false)) {
+            if (!context->booleanWarnings.maxTextMeasureCacheExceeded) {
                 context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
-                    .errorType = CLAY_ERROR_TYPE_DUPLICATE_ID,
-                    .errorText = CLAY_STRING("An element with this ID was already previously declared during this layout."),
+                    .errorType = CLAY_ERROR_TYPE_TEXT_MEASUREMENT_CAPACITY_EXCEEDED,
+                    .errorText = CLAY_STRING("A single text element has more words than fit in Clay's internal text measurement cache. Try using Clay_SetMaxMeasureTextCacheWordCount() (default 16384, with 1 unit storing 1 measured word)."),
                     .userData = context->errorHandler.userData });
-                if (context->debugModeEnabled) {
-                    hashItem->debugData->collision = true;
-                }
+                context->booleanWarnings.maxTextMeasureCacheExceeded = true;
+            }
+            Clay__FreeMeasuredWords(context, measured);
+            Clay__MeasureTextCacheItemArray_Set(&context->measureTextHashMapInternal, newItemIndex, CLAY__INIT(Clay__MeasureTextCacheItem) CLAY__DEFAULT_STRUCT);
+            Clay__int32_tArray_Add(&context->measureTextHashMapInternalFreeList, newItemIndex);
+            return &Clay__MeasureTextCacheItem_DEFAULT;
+        }
+        end = Clay__FindWordBoundary(text->chars, end, text->length);
+        if (end == text->length) {
+            break;
+        }
+        char current = text->chars[end];
+        int32_t length = end - start;
+        Clay_Dimensions dimensions = CLAY__DEFAULT_STRUCT;
+        if (length > 0) {
+            dimensions = Clay__MeasureWord(fontMetrics, &batch, &batchWordIndex, CLAY__INIT(Clay_StringSlice) {.length = length, .chars = &text->chars[start], .baseChars = text->chars}, config);
+        }
+        measured->minWidth = CLAY__MAX(dimensions.width, measured->minWidth);
+        measuredHeight = CLAY__MAX(measuredHeight, dimensions.height);
+        if (current == ' ') {
+            dimensions.width += spaceWidth;
+            Clay__AddMeasuredWord(context, measured, newItemIndex, start, length + 1, dimensions.width);
+            lineWidth += dimensions.width;
+        }
+        if (current == '\n') {
+            if (length > 0) {
+                Clay__AddMeasuredWord(context, measured, newItemIndex, start, length, dimensions.width);
             }
-            return hashItem;
+            Clay__AddMeasuredWord(context, measured, newItemIndex, end + 1, 0, 0);
+            lineWidth += dimensions.width;
+            measuredWidth = CLAY__MAX(lineWidth, measuredWidth);
+            measured->containsNewlines = true;
+            lineWidth = 0;
         }
-        hashItemPrevious = hashItemIndex;
-        hashItemIndex = hashItem->nextIndex;
+        start = end + 1;
+        end++;
     }
-    Clay_LayoutElementHashMapItem *hashItem = Clay__LayoutElementHashMapItemArray_Add(&context->layoutElementsHashMapInternal, item);
-    hashItem->debugData = Clay__DebugElementDataArray_Add(&context->debugElementData, CLAY__INIT(Clay__DebugElementData) CLAY__DEFAULT_STRUCT);
-    if (hashItemPrevious != -1) {
-        Clay__LayoutElementHashMapItemArray_Get(&context->layoutElementsHashMapInternal, hashItemPrevious)->nextIndex = (int32_t)context->layoutElementsHashMapInternal.length - 1;
-    } else {
-        context->layoutElementsHashMap.internalArray[hashBucket] = (int32_t)context->layoutElementsHashMapInternal.length - 1;
+    if (end - start > 0) {
+        Clay_Dimensions dimensions = Clay__MeasureWord(fontMetrics, &batch, &batchWordIndex, CLAY__INIT(Clay_StringSlice) { .length = end - start, .chars = &text->chars[start], .baseChars = text->chars }, config);
+        Clay__AddMeasuredWord(context, measured, newItemIndex, start, end - start, dimensions.width);
+        lineWidth += dimensions.width;
+        measuredHeight = CLAY__MAX(measuredHeight, dimensions.height);
+        measured->minWidth = CLAY__MAX(dimensions.width, measured->minWidth);
+    }
+    measuredWidth = CLAY__MAX(lineWidth, measuredWidth) - config->letterSpacing;
+
+    measured->unwrappedDimensions.width = measuredWidth;
+    measured->unwrappedDimensions.height = measuredHeight;
+
+    measured->nextIndex = context->measureTextHashMap.internalArray[hashBucket];
+    context->measureTextHashMap.internalArray[hashBucket] = newItemIndex;
+    return measured;
+}
+
+Clay__MeasureTextCacheItem *Clay__MeasureTextCached(Clay_String *text, Clay_TextElementConfig *config) {
+    return Clay__MeasureTextCachedWithBatch(text, config, NULL);
+}
+
+bool Clay__PointIsInsideRect(Clay_Vector2 point, Clay_BoundingBox rect) {
+    return point.x >= rect.x && point.x <= rect.x + rect.width && point.y >= rect.y && point.y <= rect.y + rect.height;
+}
+
+// The layout element hash map is a power of two open addressing table of indexes into layoutElementsHashMapInternal,
+// probed a group of 16 slots at a time. Each slot has a tag byte holding 7 bits of its hash, or CLAY__HASH_MAP_EMPTY_TAG.
+// Entries are never removed, so there are no tombstones, and the entries themselves stay in declaration order, which
+// keeps lookups made while walking the tree close together in memory.
+#define CLAY__HASH_MAP_GROUP_SIZE 16
+#define CLAY__HASH_MAP_EMPTY_TAG 0x80
+
+// Returns a mask of the slots in a group whose tag equals the given one, CLAY__HASH_MAP_MASK_STRIDE bits per slot
+#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64))
+#define CLAY__HASH_MAP_MASK_STRIDE 1
+static inline uint64_t Clay__HashMapGroupMatch(const uint8_t *tags, uint8_t tag) {
+    __m128i group = _mm_loadu_si128((const __m128i *)tags);
+    return (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+}
+#elif !defined(CLAY_DISABLE_SIMD) && defined(__aarch64__)
+#define CLAY__HASH_MAP_MASK_STRIDE 4
+static inline uint64_t Clay__HashMapGroupMatch(const uint8_t *tags, uint8_t tag) {
+    // No movemask on NEON, so narrow each comparison byte to a nibble and keep one bit of it
+    uint8x16_t equal = vceqq_u8(vld1q_u8(tags), vdupq_n_u8(tag));
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(equal), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+}
+#else
+#define CLAY__HASH_MAP_MASK_STRIDE 1
+static inline uint64_t Clay__HashMapGroupMatch(const uint8_t *tags, uint8_t tag) {
+    uint64_t mask = 0;
+    for (int32_t i = 0; i < CLAY__HASH_MAP_GROUP_SIZE; i++) {
+        mask |= (uint64_t)(tags[i] == tag) << i;
+    }
+    return mask;
+}
+#endif
+
+static inline int32_t Clay__HashMapGroupMaskFirstSlot(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(mask) / CLAY__HASH_MAP_MASK_STRIDE;
+#else
+    int32_t bit = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit / CLAY__HASH_MAP_MASK_STRIDE;
+#endif
+}
+
+// Returns the slot holding id, or if there isn't one, the empty slot it should be inserted into
+int32_t Clay__FindHashMapSlot(Clay_Context *context, uint32_t id, uint8_t *tagOut) {
+    // Ids are already hashes, a multiply is enough to separate the group index in the low bits from the tag in the top
+    uint32_t hash = id * 0x9E3779B1u;
+    uint8_t tag = (uint8_t)(hash >> 25);
+    uint8_t *tags = context->layoutElementsHashMapTags.internalArray;
+    int32_t groupMask = context->layoutElementsHashMapTags.capacity / CLAY__HASH_MAP_GROUP_SIZE - 1;
+    int32_t group = (int32_t)(hash & (uint32_t)groupMask);
+    *tagOut = tag;
+    // Triangular probing visits every group of a power of two table
+    for (int32_t probe = 1; ; probe++) {
+        uint8_t *groupTags = tags + group * CLAY__HASH_MAP_GROUP_SIZE;
+        uint64_t matches = Clay__HashMapGroupMatch(groupTags, tag);
+        while (matches) {
+            int32_t slot = group * CLAY__HASH_MAP_GROUP_SIZE + Clay__HashMapGroupMaskFirstSlot(matches);
+            if (context->layoutElementsHashMapInternal.internalArray[context->layoutElementsHashMap.internalArray[slot]].id == id) {
+                return slot;
+            }
+            matches &= matches - 1;
+        }
+        uint64_t empty = Clay__HashMapGroupMatch(groupTags, CLAY__HASH_MAP_EMPTY_TAG);
+        if (empty) {
+            return group * CLAY__HASH_MAP_GROUP_SIZE + Clay__HashMapGroupMaskFirstSlot(empty);
+        }
+        group = (group + probe) & groupMask;
+    }
+}
+
+Clay_LayoutElementHashMapItem* Clay__AddHashMapItem(Clay_ElementId elementId, Clay_LayoutElement* layoutElement) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    uint8_t tag;
+    int32_t slot = Clay__FindHashMapSlot(context, elementId.id, &tag);
+    if (context->layoutElementsHashMapTags.internalArray[slot] != CLAY__HASH_MAP_EMPTY_TAG) { // Collision - resolve based on generation
+        int32_t itemIndex = context->layoutElementsHashMap.internalArray[slot];
+        Clay_LayoutElementHashMapItem *hashItem = &context->layoutElementsHashMapInternal.internalArray[itemIndex];
+        Clay__LayoutElementHashMapColdItem *coldItem = &context->layoutElementsHashMapCold.internalArray[itemIndex];
+        if (hashItem->generation <= context->generation) { // First collision - assume this is the "same" element
+            coldItem->elementId = elementId; // Make sure to copy this across. If the stringId reference has changed, we should update the hash item to use the new one.
+            hashItem->generation = context->generation + 1;
+            hashItem->layoutElement = layoutElement;
+            coldItem->debugData->collision = false;
+            layoutElement->retainedData = coldItem->retainedData;
+            coldItem->onHoverFunction = NULL;
+            coldItem->hoverFunctionUserData = 0;
+        } else { // Multiple collisions this frame - two elements have the same ID
+            context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+                .errorType = CLAY_ERROR_TYPE_DUPLICATE_ID,
+                .errorText = CLAY_STRING("An element with this ID was already previously declared during this layout."),
+                .userData = context->errorHandler.userData });
+            if (context->debugModeEnabled) {
+                coldItem->debugData->collision = true;
+            }
+        }
+        return hashItem;
+    }
+    if (context->layoutElementsHashMapInternal.length == context->layoutElementsHashMapInternal.capacity - 1) {
+        return NULL;
     }
+    context->layoutElementsHashMapTags.internalArray[slot] = tag;
+    context->layoutElementsHashMap.internalArray[slot] = context->layoutElementsHashMapInternal.length;
+    Clay_LayoutElementHashMapItem *hashItem = Clay__LayoutElementHashMapItemArray_Add(&context->layoutElementsHashMapInternal, CLAY__INIT(Clay_LayoutElementHashMapItem) { .id = elementId.id, .generation = context->generation + 1, .layoutElement = layoutElement });
+    Clay__LayoutElementHashMapColdItem *coldItem = Clay__LayoutElementHashMapColdItemArray_Add(&context->layoutElementsHashMapCold, CLAY__INIT(Clay__LayoutElementHashMapColdItem) { .elementId = elementId });
+    coldItem->debugData = Clay__DebugElementDataArray_Add(&context->debugElementData, CLAY__INIT(Clay__DebugElementData) CLAY__DEFAULT_STRUCT);
+    coldItem->retainedData = Clay__RetainedElementDataArray_Add(&context->retainedElementData, CLAY__INIT(Clay__RetainedElementData) CLAY__DEFAULT_STRUCT);
+    layoutElement->retainedData = coldItem->retainedData;
     return hashItem;
 }
 
 Clay_LayoutElementHashMapItem *Clay__GetHashMapItem(uint32_t id) {
     Clay_Context* context = Clay_GetCurrentContext();
-    uint32_t hashBucket = id % context->layoutElementsHashMap.capacity;
-    int32_t elementIndex = context->layoutElementsHashMap.internalArray[hashBucket];
-    while (elementIndex != -1) {
-        Clay_LayoutElementHashMapItem *hashEntry = Clay__LayoutElementHashMapItemArray_Get(&context->layoutElementsHashMapInternal, elementIndex);
-        if (hashEntry->elementId.id == id) {
-            return hashEntry;
-        }
-        elementIndex = hashEntry->nextIndex;
+    uint8_t tag;
+    int32_t slot = Clay__FindHashMapSlot(context, id, &tag);
+    if (context->layoutElementsHashMapTags.internalArray[slot] == CLAY__HASH_MAP_EMPTY_TAG) {
+        return &Clay_LayoutElementHashMapItem_DEFAULT;
+    }
+    return &context->layoutElementsHashMapInternal.internalArray[context->layoutElementsHashMap.internalArray[slot]];
+}
+
+Clay__LayoutElementHashMapColdItem *Clay__GetHashMapColdItem(Clay_LayoutElementHashMapItem *hashItem) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    if (hashItem == &Clay_LayoutElementHashMapItem_DEFAULT) {
+        return &Clay__LayoutElementHashMapColdItem_DEFAULT;
     }
-    return &Clay_LayoutElementHashMapItem_DEFAULT;
+    return &context->layoutElementsHashMapCold.internalArray[hashItem - context->layoutElementsHashMapInternal.internalArray];
 }
 
 Clay_ElementId Clay__GenerateIdForAnonymousElement(Clay_LayoutElement *openLayoutElement) {
@@ -1786,15 +2610,13 @@ Clay_ElementId Clay__GenerateIdForAnonymousElement(Clay_LayoutElement *openLayou
 }
 
 bool Clay__ElementHasConfig(Clay_LayoutElement *layoutElement, Clay__ElementConfigType type) {
-    for (int32_t i = 0; i < layoutElement->elementConfigs.length; i++) {
-        if (Clay__ElementConfigArraySlice_Get(&layoutElement->elementConfigs, i)->type == type) {
-            return true;
-        }
-    }
-    return false;
+    return (layoutElement->configTypes & (1 << type)) != 0;
 }
 
 void Clay__UpdateAspectRatioBox(Clay_LayoutElement *layoutElement) {
+    if (!Clay__ElementHasConfig(layoutElement, CLAY__ELEMENT_CONFIG_TYPE_ASPECT)) {
+        return;
+    }
     for (int32_t j = 0; j < layoutElement->elementConfigs.length; j++) {
         Clay_ElementConfig *config = Clay__ElementConfigArraySlice_Get(&layoutElement->elementConfigs, j);
         if (config->type == CLAY__ELEMENT_CONFIG_TYPE_ASPECT) {
@@ -1812,6 +2634,136 @@ void Clay__UpdateAspectRatioBox(Clay_LayoutElement *layoutElement) {
     }
 }
 
+// Retained layout ---------------------------------
+uint32_t Clay__HashRetainedWord(uint32_t hash, uint32_t word) {
+    hash += word;
+    hash += (hash << 10);
+    hash ^= (hash >> 6);
+    return hash;
+}
+
+uint32_t Clay__HashRetainedFloat(uint32_t hash, float value) {
+    union { float value; uint32_t word; } bits = { value };
+    return Clay__HashRetainedWord(hash, bits.word);
+}
+
+uint32_t Clay__HashRetainedPointer(uint32_t hash, const void *pointer) {
+    uint64_t bits = (uint64_t)(uintptr_t)pointer;
+    return Clay__HashRetainedWord(Clay__HashRetainedWord(hash, (uint32_t)bits), (uint32_t)(bits >> 32));
+}
+
+uint32_t Clay__HashRetainedColor(uint32_t hash, Clay_Color color) {
+    hash = Clay__HashRetainedFloat(hash, color.r);
+    hash = Clay__HashRetainedFloat(hash, color.g);
+    hash = Clay__HashRetainedFloat(hash, color.b);
+    return Clay__HashRetainedFloat(hash, color.a);
+}
+
+// Hashes everything in an element's own declaration that can change the layout or render commands of its subtree
+uint32_t Clay__HashElementDeclaration(Clay_LayoutElement *element) {
+    uint32_t hash = Clay__HashRetainedWord(0, element->id);
+    Clay_LayoutConfig *layoutConfig = element->layoutConfig;
+    Clay_SizingAxis axes[2] = { layoutConfig->sizing.width, layoutConfig->sizing.height };
+    for (int32_t i = 0; i < 2; ++i) {
+        hash = Clay__HashRetainedWord(hash, axes[i].type);
+        if (axes[i].type == CLAY__SIZING_TYPE_PERCENT) {
+            hash = Clay__HashRetainedFloat(hash, axes[i].size.percent);
+        } else {
+            hash = Clay__HashRetainedFloat(hash, axes[i].size.minMax.min);
+            hash = Clay__HashRetainedFloat(hash, axes[i].size.minMax.max);
+        }
+    }
+    hash = Clay__HashRetainedWord(hash, layoutConfig->padding.left | (uint32_t)layoutConfig->padding.right << 16);
+    hash = Clay__HashRetainedWord(hash, layoutConfig->padding.top | (uint32_t)layoutConfig->padding.bottom << 16);
+    hash = Clay__HashRetainedWord(hash, layoutConfig->childGap | (uint32_t)layoutConfig->childAlignment.x << 16 | (uint32_t)layoutConfig->childAlignment.y << 24);
+    hash = Clay__HashRetainedWord(hash, layoutConfig->layoutDirection);
+    for (int32_t i = 0; i < element->elementConfigs.length; i++) {
+        Clay_ElementConfig *config = Clay__ElementConfigArraySlice_Get(&element->elementConfigs, i);
+        hash = Clay__HashRetainedWord(hash, config->type);
+        switch (config->type) {
+            case CLAY__ELEMENT_CONFIG_TYPE_TEXT: {
+                Clay_TextElementConfig *textConfig = config->config.textElementConfig;
+                Clay_String text = element->childrenOrTextContent.textElementData->text;
+                hash = Clay__HashRetainedPointer(hash, text.chars);
+                hash = Clay__HashRetainedWord(hash, (uint32_t)text.length);
+                hash = Clay__HashRetainedPointer(hash, textConfig->userData);
+                hash = Clay__HashRetainedColor(hash, textConfig->textColor);
+                hash = Clay__HashRetainedWord(hash, textConfig->fontId | (uint32_t)textConfig->fontSize << 16);
+                hash = Clay__HashRetainedWord(hash, textConfig->letterSpacing | (uint32_t)textConfig->lineHeight << 16);
+                hash = Clay__HashRetainedWord(hash, textConfig->wrapMode | (uint32_t)textConfig->textAlignment << 8);
+                break;
+            }
+            case CLAY__ELEMENT_CONFIG_TYPE_SHARED: {
+                Clay_SharedElementConfig *sharedConfig = config->config.sharedElementConfig;
+                hash = Clay__HashRetainedColor(hash, sharedConfig->backgroundColor);
+                hash = Clay__HashRetainedFloat(hash, sharedConfig->cornerRadius.topLeft);
+                hash = Clay__HashRetainedFloat(hash, sharedConfig->cornerRadius.topRight);
+                hash = Clay__HashRetainedFloat(hash, sharedConfig->cornerRadius.bottomLeft);
+                hash = Clay__HashRetainedFloat(hash, sharedConfig->cornerRadius.bottomRight);
+                hash = Clay__HashRetainedPointer(hash, sharedConfig->userData);
+                break;
+            }
+            case CLAY__ELEMENT_CONFIG_TYPE_ASPECT: hash = Clay__HashRetainedFloat(hash, config->config.aspectRatioElementConfig->aspectRatio); break;
+            case CLAY__ELEMENT_CONFIG_TYPE_IMAGE: hash = Clay__HashRetainedPointer(hash, config->config.imageElementConfig->imageData); break;
+            case CLAY__ELEMENT_CONFIG_TYPE_CUSTOM: hash = Clay__HashRetainedPointer(hash, config->config.customElementConfig->customData); break;
+            case CLAY__ELEMENT_CONFIG_TYPE_FLOATING: {
+                Clay_FloatingElementConfig *floatingConfig = config->config.floatingElementConfig;
+                hash = Clay__HashRetainedFloat(hash, floatingConfig->offset.x);
+                hash = Clay__HashRetainedFloat(hash, floatingConfig->offset.y);
+                hash = Clay__HashRetainedFloat(hash, floatingConfig->expand.width);
+                hash = Clay__HashRetainedFloat(hash, floatingConfig->expand.height);
+                hash = Clay__HashRetainedWord(hash, floatingConfig->parentId);
+                hash = Clay__HashRetainedWord(hash, (uint16_t)floatingConfig->zIndex | (uint32_t)floatingConfig->attachPoints.element << 16 | (uint32_t)floatingConfig->attachPoints.parent << 24);
+                hash = Clay__HashRetainedWord(hash, floatingConfig->pointerCaptureMode | (uint32_t)floatingConfig->attachTo << 8 | (uint32_t)floatingConfig->clipTo << 16);
+                break;
+            }
+            case CLAY__ELEMENT_CONFIG_TYPE_CLIP: {
+                Clay_ClipElementConfig *clipConfig = config->config.clipElementConfig;
+                hash = Clay__HashRetainedWord(hash, clipConfig->horizontal | (uint32_t)clipConfig->vertical << 1);
+                hash = Clay__HashRetainedFloat(hash, clipConfig->childOffset.x);
+                hash = Clay__HashRetainedFloat(hash, clipConfig->childOffset.y);
+                break;
+            }
+            case CLAY__ELEMENT_CONFIG_TYPE_BORDER: {
+                Clay_BorderElementConfig *borderConfig = config->config.borderElementConfig;
+                hash = Clay__HashRetainedColor(hash, borderConfig->color);
+                hash = Clay__HashRetainedWord(hash, borderConfig->width.left | (uint32_t)borderConfig->width.right << 16);
+                hash = Clay__HashRetainedWord(hash, borderConfig->width.top | (uint32_t)borderConfig->width.bottom << 16);
+                hash = Clay__HashRetainedWord(hash, borderConfig->width.betweenChildren);
+                break;
+            }
+            default: break;
+        }
+    }
+    return hash;
+}
+
+// Zero is reserved for subtrees that can't be retained
+uint32_t Clay__FinishStructureHash(uint32_t hash) {
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+    return hash ? hash : 1;
+}
+
+// Called when an element is closed, so its children already have their hashes
+void Clay__UpdateStructureHash(Clay_LayoutElement *layoutElement) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    layoutElement->structureHash = 0;
+    if (!layoutElement->retainedData) {
+        return;
+    }
+    uint32_t hash = Clay__HashElementDeclaration(layoutElement);
+    for (int32_t i = 0; i < layoutElement->childrenOrTextContent.children.length; i++) {
+        Clay_LayoutElement *child = Clay_LayoutElementArray_Get(&context->layoutElements, layoutElement->childrenOrTextContent.children.elements[i]);
+        if (!child->structureHash) {
+            return;
+        }
+        hash = Clay__HashRetainedWord(hash, child->structureHash);
+    }
+    layoutElement->structureHash = Clay__FinishStructureHash(Clay__HashRetainedWord(hash, layoutElement->childrenOrTextContent.children.length));
+}
+
 void Clay__CloseElement(void) {
     Clay_Context* context = Clay_GetCurrentContext();
     if (context->booleanWarnings.maxElementsExceeded) {
@@ -1825,16 +2777,13 @@ void Clay__CloseElement(void) {
     }
     bool elementHasClipHorizontal = false;
     bool elementHasClipVertical = false;
-    for (int32_t i = 0; i < openLayoutElement->elementConfigs.length; i++) {
-        Clay_ElementConfig *config = Clay__ElementConfigArraySlice_Get(&openLayoutElement->elementConfigs, i);
-        if (config->type == CLAY__ELEMENT_CONFIG_TYPE_CLIP) {
-            elementHasClipHorizontal = config->config.clipElementConfig->horizontal;
-            elementHasClipVertical = config->config.clipElementConfig->vertical;
-            context->openClipElementStack.length--;
-            break;
-        } else if (config->type == CLAY__ELEMENT_CONFIG_TYPE_FLOATING) {
-            context->openClipElementStack.length--;
-        }
+    if (openLayoutElement->floatingConfig) {
+        context->openClipElementStack.length--;
+    }
+    if (openLayoutElement->clipConfig) {
+        elementHasClipHorizontal = openLayoutElement->clipConfig->horizontal;
+        elementHasClipVertical = openLayoutElement->clipConfig->vertical;
+        context->openClipElementStack.length--;
     }
 
     float leftRightPadding = (float)(layoutConfig->padding.left + layoutConfig->padding.right);
@@ -1915,6 +2864,13 @@ void Clay__CloseElement(void) {
 
     Clay__UpdateAspectRatioBox(openLayoutElement);
 
+    if (context->retainedLayoutEnabled) {
+        Clay__UpdateStructureHash(openLayoutElement);
+        if (context->declarationHash) {
+            context->declarationHash = openLayoutElement->structureHash ? Clay__FinishStructureHash(Clay__HashRetainedWord(context->declarationHash, openLayoutElement->structureHash)) : 0;
+        }
+    }
+
     bool elementIsFloating = Clay__ElementHasConfig(openLayoutElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING);
 
     // Close the currently open element
@@ -2059,12 +3015,18 @@ void Clay__OpenTextElement(Clay_String text, Clay_TextElementConfig *textConfig)
     Clay_Dimensions textDimensions = { .width = textMeasured->unwrappedDimensions.width, .height = textConfig->lineHeight > 0 ? (float)textConfig->lineHeight : textMeasured->unwrappedDimensions.height };
     textElement->dimensions = textDimensions;
     textElement->minDimensions = CLAY__INIT(Clay_Dimensions) { .width = textMeasured->minWidth, .height = textDimensions.height };
-    textElement->childrenOrTextContent.textElementData = Clay__TextElementDataArray_Add(&context->textElementData, CLAY__INIT(Clay__TextElementData) { .text = text, .preferredDimensions = textMeasured->unwrappedDimensions, .elementIndex = context->layoutElements.length - 1 });
+    int32_t measureTextCacheItemIndex = textMeasured == &Clay__MeasureTextCacheItem_DEFAULT ? 0 : (int32_t)(textMeasured - context->measureTextHashMapInternal.internalArray);
+    textElement->childrenOrTextContent.textElementData = Clay__TextElementDataArray_Add(&context->textElementData, CLAY__INIT(Clay__TextElementData) { .text = text, .preferredDimensions = textMeasured->unwrappedDimensions, .elementIndex = context->layoutElements.length - 1, .measureTextCacheItemIndex = measureTextCacheItemIndex, .measureTextCacheItemId = textMeasured->id });
     textElement->elementConfigs = CLAY__INIT(Clay__ElementConfigArraySlice) {
             .length = 1,
             .internalArray = Clay__ElementConfigArray_Add(&context->elementConfigs, CLAY__INIT(Clay_ElementConfig) { .type = CLAY__ELEMENT_CONFIG_TYPE_TEXT, .config = { .textElementConfig = textConfig }})
     };
+    textElement->configTypes = 1 << CLAY__ELEMENT_CONFIG_TYPE_TEXT;
+    textElement->textConfig = textConfig;
     textElement->layoutConfig = &CLAY_LAYOUT_DEFAULT;
+    if (context->retainedLayoutEnabled && textElement->retainedData && textMeasured != &Clay__MeasureTextCacheItem_DEFAULT) {
+        textElement->structureHash = Clay__FinishStructureHash(Clay__HashRetainedWord(Clay__HashElementDeclaration(textElement), textMeasured->id));
+    }
     parentElement->childrenOrTextContent.children.length++;
 }
 
@@ -2131,7 +3093,7 @@ void Clay__ConfigureOpenElementPtr(const Clay_ElementDeclaration *declaration) {
                     clipElementId = Clay__int32_tArray_GetValue(&context->layoutElementClipElementIds, (int32_t)(parentItem->layoutElement - context->layoutElements.internalArray));
                 }
             } else if (declaration->floating.attachTo == CLAY_ATTACH_TO_ROOT) {
-                floatingConfig.parentId = Clay__HashString(CLAY_STRING("Clay__RootContainer"), 0).id;
+                floatingConfig.parentId = CLAY_ID("Clay__RootContainer").id;
             }
             if (declaration->floating.clipTo == CLAY_CLIP_TO_NONE) {
                 clipElementId = 0;
@@ -2163,6 +3125,7 @@ void Clay__ConfigureOpenElementPtr(const Clay_ElementDeclaration *declaration) {
                 scrollOffset = mapping;
                 scrollOffset->layoutElement = openLayoutElement;
                 scrollOffset->openThisFrame = true;
+                break;
             }
         }
         if (!scrollOffset) {
@@ -2203,14 +3166,26 @@ void Clay__InitializeEphemeralMemory(Clay_Context* context) {
     context->sharedElementConfigs = Clay__SharedElementConfigArray_Allocate_Arena(maxElementCount, arena);
 
     context->layoutElementIdStrings = Clay__StringArray_Allocate_Arena(maxElementCount, arena);
-    context->wrappedTextLines = Clay__WrappedTextLineArray_Allocate_Arena(maxElementCount, arena);
+    context->wrappedTextLines.length = 0;
     context->layoutElementTreeNodeArray1 = Clay__LayoutElementTreeNodeArray_Allocate_Arena(maxElementCount, arena);
     context->layoutElementTreeRoots = Clay__LayoutElementTreeRootArray_Allocate_Arena(maxElementCount, arena);
+    context->treeRootWave = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
+    context->sizingBlockSizes = Clay__floatArray_Allocate_Arena(maxElementCount, arena);
+    context->sizingBlockMinSizes = Clay__floatArray_Allocate_Arena(maxElementCount, arena);
+    context->sizingBlockMaxSizes = Clay__floatArray_Allocate_Arena(maxElementCount, arena);
+    context->sizingBlockTypes = Clay__SizingTypeArray_Allocate_Arena(maxElementCount, arena);
+    context->sizingBlockOrder = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
+    context->sizingBlockBuffer = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
+    context->sizingBlockPositions = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
+    context->sizingBlockLimitOrder = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
+    context->sizingBlockBits = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
+    context->pointerHitTestEntries = Clay__PointerHitTestEntryArray_Allocate_Arena(maxElementCount, arena);
+    context->pointerHitTestEntryStack = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
     context->layoutElementChildren = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
     context->openLayoutElementStack = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
     context->textElementData = Clay__TextElementDataArray_Allocate_Arena(maxElementCount, arena);
     context->aspectRatioElementIndexes = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
-    context->renderCommands = Clay_RenderCommandArray_Allocate_Arena(maxElementCount, arena);
+    context->renderCommands.length = 0;
     context->treeNodeVisited = Clay__boolArray_Allocate_Arena(maxElementCount, arena);
     context->treeNodeVisited.length = context->treeNodeVisited.capacity; // This array is accessed directly rather than behaving as a list
     context->openClipElementStack = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
@@ -2227,14 +3202,33 @@ void Clay__InitializePersistentMemory(Clay_Context* context) {
 
     context->scrollContainerDatas = Clay__ScrollContainerDataInternalArray_Allocate_Arena(100, arena);
     context->layoutElementsHashMapInternal = Clay__LayoutElementHashMapItemArray_Allocate_Arena(maxElementCount, arena);
-    context->layoutElementsHashMap = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
+    context->layoutElementsHashMapCold = Clay__LayoutElementHashMapColdItemArray_Allocate_Arena(maxElementCount, arena);
+    // Entries are capped at maxElementCount - 1, so this keeps at least an eighth of the slots empty to end probes
+    int32_t hashMapCapacity = CLAY__HASH_MAP_GROUP_SIZE;
+    while (hashMapCapacity < maxElementCount + maxElementCount / 7) {
+        hashMapCapacity *= 2;
+    }
+    context->layoutElementsHashMapTags = Clay__uint8_tArray_Allocate_Arena(hashMapCapacity, arena);
+    context->layoutElementsHashMap = Clay__int32_tArray_Allocate_Arena(hashMapCapacity, arena);
     context->measureTextHashMapInternal = Clay__MeasureTextCacheItemArray_Allocate_Arena(maxElementCount, arena);
     context->measureTextHashMapInternalFreeList = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
-    context->measuredWordsFreeList = Clay__int32_tArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
     context->measureTextHashMap = Clay__int32_tArray_Allocate_Arena(maxElementCount, arena);
-    context->measuredWords = Clay__MeasuredWordArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
+    context->measuredWordStartOffsets = Clay__int32_tArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
+    context->measuredWordLengths = Clay__int32_tArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
+    context->measuredWordWidths = Clay__floatArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
+    context->measuredWordSpans = Clay__int32_tArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
+    context->measureTextBatchWordStarts = Clay__int32_tArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
+    context->measureTextBatchWordLengths = Clay__int32_tArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
+    context->measureTextBatchWordDimensions = Clay__DimensionsArray_Allocate_Arena(maxMeasureTextCacheWordCount, arena);
+    context->fontMetrics = Clay__FontMetricsArray_Allocate_Arena(CLAY__MAX_FONT_METRICS, arena);
     context->pointerOverIds = Clay_ElementIdArray_Allocate_Arena(maxElementCount, arena);
     context->debugElementData = Clay__DebugElementDataArray_Allocate_Arena(maxElementCount, arena);
+    // These outlive the frame so that retained layout can copy from last frame's, see Clay_SetRetainedLayoutEnabled
+    context->retainedElementData = Clay__RetainedElementDataArray_Allocate_Arena(maxElementCount, arena);
+    context->wrappedTextLines = Clay__WrappedTextLineArray_Allocate_Arena(maxElementCount, arena);
+    context->previousWrappedTextLines = Clay__WrappedTextLineArray_Allocate_Arena(maxElementCount, arena);
+    context->renderCommands = Clay_RenderCommandArray_Allocate_Arena(maxElementCount, arena);
+    context->previousRenderCommands = Clay_RenderCommandArray_Allocate_Arena(maxElementCount, arena);
     context->arenaResetOffset = arena->nextAllocation;
 }
 
@@ -2245,293 +3239,1511 @@ bool Clay__FloatEqual(float left, float right) {
     return subtracted < CLAY__EPSILON && subtracted > -CLAY__EPSILON;
 }
 
-void Clay__SizeContainersAlongAxis(bool xAxis) {
+// If an element's subtree and the space it was given are the same as last frame, restores the sizes its children ended up
+// with along this axis rather than sizing them again. The rest of the subtree is restored as the BFS reaches it.
+bool Clay__RetainChildSizes(Clay_LayoutElement *parent, bool xAxis, Clay__int32_tArray *bfsBuffer) {
     Clay_Context* context = Clay_GetCurrentContext();
-    Clay__int32_tArray bfsBuffer = context->layoutElementChildrenBuffer;
-    Clay__int32_tArray resizableContainerBuffer = context->openLayoutElementStack;
-    for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
-        bfsBuffer.length = 0;
-        Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex);
-        Clay_LayoutElement *rootElement = Clay_LayoutElementArray_Get(&context->layoutElements, (int)root->layoutElementIndex);
-        Clay__int32_tArray_Add(&bfsBuffer, (int32_t)root->layoutElementIndex);
-
-        // Size floating containers to their parents
-        if (Clay__ElementHasConfig(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING)) {
-            Clay_FloatingElementConfig *floatingElementConfig = Clay__FindElementConfigWithType(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig;
-            Clay_LayoutElementHashMapItem *parentItem = Clay__GetHashMapItem(floatingElementConfig->parentId);
-            if (parentItem && parentItem != &Clay_LayoutElementHashMapItem_DEFAULT) {
-                Clay_LayoutElement *parentLayoutElement = parentItem->layoutElement;
-                switch (rootElement->layoutConfig->sizing.width.type) {
-                    case CLAY__SIZING_TYPE_GROW: {
-                        rootElement->dimensions.width = parentLayoutElement->dimensions.width;
-                        break;
-                    }
-                    case CLAY__SIZING_TYPE_PERCENT: {
-                        rootElement->dimensions.width = parentLayoutElement->dimensions.width * rootElement->layoutConfig->sizing.width.size.percent;
-                        break;
-                    }
-                    default: break;
-                }
-                switch (rootElement->layoutConfig->sizing.height.type) {
-                    case CLAY__SIZING_TYPE_GROW: {
-                        rootElement->dimensions.height = parentLayoutElement->dimensions.height;
-                        break;
-                    }
-                    case CLAY__SIZING_TYPE_PERCENT: {
-                        rootElement->dimensions.height = parentLayoutElement->dimensions.height * rootElement->layoutConfig->sizing.height.size.percent;
-                        break;
-                    }
-                    default: break;
-                }
-            }
+    Clay__RetainedState sizedState = xAxis ? CLAY__RETAINED_STATE_SIZED_X : CLAY__RETAINED_STATE_SIZED_Y;
+    if (parent->retainedState != sizedState) {
+        Clay__RetainedElementData *retainedData = parent->retainedData;
+        if (!retainedData) {
+            return false;
         }
-
-        if (rootElement->layoutConfig->sizing.width.type != CLAY__SIZING_TYPE_PERCENT) {
-            rootElement->dimensions.width = CLAY__MIN(CLAY__MAX(rootElement->dimensions.width, rootElement->layoutConfig->sizing.width.size.minMax.min), rootElement->layoutConfig->sizing.width.size.minMax.max);
+        bool sameSpace = xAxis
+            ? retainedData->sizingInput.width == parent->dimensions.width && retainedData->sizingInput.height == parent->dimensions.height
+            : retainedData->sizingInputHeight == parent->dimensions.height && parent->retainedState == CLAY__RETAINED_STATE_SIZED_X;
+        if (!sameSpace || !parent->structureHash || retainedData->structureHash != parent->structureHash || retainedData->generation != context->retainedGeneration - 1) {
+            if (xAxis) {
+                retainedData->sizingInput = parent->dimensions;
+            } else {
+                retainedData->sizingInputHeight = parent->dimensions.height;
+            }
+            return false;
         }
-        if (rootElement->layoutConfig->sizing.height.type != CLAY__SIZING_TYPE_PERCENT) {
-            rootElement->dimensions.height = CLAY__MIN(CLAY__MAX(rootElement->dimensions.height, rootElement->layoutConfig->sizing.height.size.minMax.min), rootElement->layoutConfig->sizing.height.size.minMax.max);
+        parent->retainedState = sizedState;
+    }
+    for (int32_t i = 0; i < parent->childrenOrTextContent.children.length; i++) {
+        int32_t childElementIndex = parent->childrenOrTextContent.children.elements[i];
+        Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, childElementIndex);
+        childElement->dimensions = xAxis ? childElement->retainedData->sizedDimensions : childElement->retainedData->finalDimensions;
+        childElement->retainedState = sizedState;
+        if (!Clay__ElementHasConfig(childElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT) && childElement->childrenOrTextContent.children.length > 0) {
+            Clay__int32_tArray_Add(bfsBuffer, childElementIndex);
         }
+    }
+    return true;
+}
 
-        for (int32_t i = 0; i < bfsBuffer.length; ++i) {
-            int32_t parentIndex = Clay__int32_tArray_GetValue(&bfsBuffer, i);
-            Clay_LayoutElement *parent = Clay_LayoutElementArray_Get(&context->layoutElements, parentIndex);
-            Clay_LayoutConfig *parentStyleConfig = parent->layoutConfig;
-            int32_t growContainerCount = 0;
-            float parentSize = xAxis ? parent->dimensions.width : parent->dimensions.height;
-            float parentPadding = (float)(xAxis ? (parent->layoutConfig->padding.left + parent->layoutConfig->padding.right) : (parent->layoutConfig->padding.top + parent->layoutConfig->padding.bottom));
-            float innerContentSize = 0, totalPaddingAndChildGaps = parentPadding;
-            bool sizingAlongAxis = (xAxis && parentStyleConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) || (!xAxis && parentStyleConfig->layoutDirection == CLAY_TOP_TO_BOTTOM);
-            resizableContainerBuffer.length = 0;
-            float parentChildGap = parentStyleConfig->childGap;
+// The resizable children of the parent currently being sized. Before the grow and compress loops run, their sizes and
+// limits are loaded one column per field, so that each pass walks contiguous floats instead of chasing every child's
+// layout element and config. Sizes are written back to the elements when a row leaves the block or the loops finish.
+// Every row shares the parent, so there's no column for it: the sizing loop holds it in a local.
+typedef struct {
+    Clay_LayoutElement *elements;
+    int32_t *elementIndexes;
+    float *sizes;
+    float *minSizes;
+    float *maxSizes;
+    Clay__SizingType *types;
+    // Scratch space for Clay__SizingBlock_Distribute
+    int32_t *order;
+    int32_t *buffer;
+    int32_t *positions;
+    int32_t *limitOrder;
+    uint32_t *bits;
+    int32_t length;
+} Clay__SizingBlock;
 
-            for (int32_t childOffset = 0; childOffset < parent->childrenOrTextContent.children.length; childOffset++) {
-                int32_t childElementIndex = parent->childrenOrTextContent.children.elements[childOffset];
-                Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, childElementIndex);
-                Clay_SizingAxis childSizing = xAxis ? childElement->layoutConfig->sizing.width : childElement->layoutConfig->sizing.height;
-                float childSize = xAxis ? childElement->dimensions.width : childElement->dimensions.height;
+Clay__SizingBlock Clay__SizingBlockAt(int32_t offset) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    return CLAY__INIT(Clay__SizingBlock) {
+        .elements = context->layoutElements.internalArray,
+        .elementIndexes = context->openLayoutElementStack.internalArray + offset,
+        .sizes = context->sizingBlockSizes.internalArray + offset,
+        .minSizes = context->sizingBlockMinSizes.internalArray + offset,
+        .maxSizes = context->sizingBlockMaxSizes.internalArray + offset,
+        .types = context->sizingBlockTypes.internalArray + offset,
+        .order = context->sizingBlockOrder.internalArray + offset,
+        .buffer = context->sizingBlockBuffer.internalArray + offset,
+        .positions = context->sizingBlockPositions.internalArray + offset,
+        .limitOrder = context->sizingBlockLimitOrder.internalArray + offset,
+        .bits = (uint32_t *)(context->sizingBlockBits.internalArray + offset),
+        .length = 0,
+    };
+}
 
-                if (!Clay__ElementHasConfig(childElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT) && childElement->childrenOrTextContent.children.length > 0) {
-                    Clay__int32_tArray_Add(&bfsBuffer, childElementIndex);
-                }
+void Clay__SizingBlock_Load(Clay__SizingBlock *block, bool xAxis) {
+    for (int32_t row = 0; row < block->length; row++) {
+        Clay_LayoutElement *element = &block->elements[block->elementIndexes[row]];
+        Clay_SizingAxis sizing = xAxis ? element->layoutConfig->sizing.width : element->layoutConfig->sizing.height;
+        block->sizes[row] = xAxis ? element->dimensions.width : element->dimensions.height;
+        block->minSizes[row] = xAxis ? element->minDimensions.width : element->minDimensions.height;
+        block->maxSizes[row] = sizing.size.minMax.max;
+        block->types[row] = sizing.type;
+    }
+}
 
-                if (childSizing.type != CLAY__SIZING_TYPE_PERCENT
-                    && childSizing.type != CLAY__SIZING_TYPE_FIXED
-                    && (!Clay__ElementHasConfig(childElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT) || (Clay__FindElementConfigWithType(childElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT).textElementConfig->wrapMode == CLAY_TEXT_WRAP_WORDS)) // todo too many loops
-//                    && (xAxis || !Clay__ElementHasConfig(childElement, CLAY__ELEMENT_CONFIG_TYPE_ASPECT))
-                ) {
-                    Clay__int32_tArray_Add(&resizableContainerBuffer, childElementIndex);
-                }
+void Clay__SizingBlock_StoreSize(Clay__SizingBlock *block, int32_t row, bool xAxis) {
+    Clay_LayoutElement *element = &block->elements[block->elementIndexes[row]];
+    *(xAxis ? &element->dimensions.width : &element->dimensions.height) = block->sizes[row];
+}
 
-                if (sizingAlongAxis) {
-                    innerContentSize += (childSizing.type == CLAY__SIZING_TYPE_PERCENT ? 0 : childSize);
-                    if (childSizing.type == CLAY__SIZING_TYPE_GROW) {
-                        growContainerCount++;
-                    }
-                    if (childOffset > 0) {
-                        innerContentSize += parentChildGap; // For children after index 0, the childAxisOffset is the gap from the previous child
-                        totalPaddingAndChildGaps += parentChildGap;
+void Clay__SizingBlock_Store(Clay__SizingBlock *block, bool xAxis) {
+    for (int32_t row = 0; row < block->length; row++) {
+        Clay__SizingBlock_StoreSize(block, row, xAxis);
+    }
+}
+
+void Clay__SizingBlock_RemoveSwapback(Clay__SizingBlock *block, int32_t row, bool xAxis) {
+    Clay__SizingBlock_StoreSize(block, row, xAxis);
+    int32_t last = --block->length;
+    block->elementIndexes[row] = block->elementIndexes[last];
+    block->sizes[row] = block->sizes[last];
+    block->minSizes[row] = block->minSizes[last];
+    block->maxSizes[row] = block->maxSizes[last];
+    block->types[row] = block->types[last];
+}
+
+// Restores the binary heap property below heap[index], where the top of the heap is the row with the lowest keys[row] * sign
+void Clay__SizingBlock_SiftDown(int32_t *heap, int32_t count, int32_t index, float *keys, float sign) {
+    while (true) {
+        int32_t top = index;
+        int32_t left = index * 2 + 1;
+        int32_t right = left + 1;
+        if (left < count && keys[heap[left]] * sign < keys[heap[top]] * sign) {
+            top = left;
+        }
+        if (right < count && keys[heap[right]] * sign < keys[heap[top]] * sign) {
+            top = right;
+        }
+        if (top == index) {
+            return;
+        }
+        int32_t swap = heap[index];
+        heap[index] = heap[top];
+        heap[top] = swap;
+        index = top;
+    }
+}
+
+void Clay__SizingBlock_HeapSort(int32_t *order, int32_t count, float *keys, float sign) {
+    for (int32_t index = count / 2 - 1; index >= 0; index--) {
+        Clay__SizingBlock_SiftDown(order, count, index, keys, -sign);
+    }
+    for (int32_t end = count - 1; end > 0; end--) {
+        int32_t swap = order[0];
+        order[0] = order[end];
+        order[end] = swap;
+        Clay__SizingBlock_SiftDown(order, end, 0, keys, -sign);
+    }
+}
+
+// Sorts order from the lowest to the highest keys[row] * sign. Rows often share a size, so a three way partition puts
+// every row equal to the pivot in place at once, which makes a block of equal rows a single pass. Partitions that keep
+// splitting badly fall back to a heap sort once depthLimit runs out, and short ones are finished by insertion sort.
+void Clay__SizingBlock_Sort(int32_t *order, int32_t count, float *keys, float sign, int32_t depthLimit) {
+    while (count > 16) {
+        if (depthLimit-- == 0) {
+            Clay__SizingBlock_HeapSort(order, count, keys, sign);
+            return;
+        }
+        float first = keys[order[0]] * sign, middle = keys[order[count / 2]] * sign, last = keys[order[count - 1]] * sign;
+        float pivot = CLAY__MAX(CLAY__MIN(first, middle), CLAY__MIN(CLAY__MAX(first, middle), last));
+        // order[0, less) < pivot, order[less, index) == pivot, order(greater, count) > pivot
+        int32_t less = 0, index = 0, greater = count - 1;
+        while (index <= greater) {
+            float key = keys[order[index]] * sign;
+            int32_t swap = order[index];
+            if (key < pivot) {
+                order[index++] = order[less];
+                order[less++] = swap;
+            } else if (key > pivot) {
+                order[index] = order[greater];
+                order[greater--] = swap;
+            } else {
+                index++;
+            }
+        }
+        // Recurse into the shorter side and loop on the longer one, so the stack stays logarithmic
+        int32_t greaterCount = count - greater - 1;
+        if (less < greaterCount) {
+            Clay__SizingBlock_Sort(order, less, keys, sign, depthLimit);
+            order += greater + 1;
+            count = greaterCount;
+        } else {
+            Clay__SizingBlock_Sort(order + greater + 1, greaterCount, keys, sign, depthLimit);
+            count = less;
+        }
+    }
+    for (int32_t index = 1; index < count; index++) {
+        int32_t row = order[index];
+        float key = keys[row] * sign;
+        int32_t insert = index;
+        for (; insert > 0 && keys[order[insert - 1]] * sign > key; insert--) {
+            order[insert] = order[insert - 1];
+        }
+        order[insert] = row;
+    }
+}
+
+int32_t Clay__PopCount(uint32_t word) {
+    word -= word >> 1 & 0x55555555u;
+    word = (word & 0x33333333u) + (word >> 2 & 0x33333333u);
+    return (int32_t)(((word + (word >> 4)) & 0x0f0f0f0fu) * 0x01010101u >> 24);
+}
+
+bool Clay__Bits_Get(const uint32_t *bits, int32_t index) {
+    return bits[index >> 5] >> (index & 31) & 1;
+}
+
+void Clay__Bits_Set(uint32_t *bits, int32_t index) {
+    bits[index >> 5] |= 1u << (index & 31);
+}
+
+void Clay__Bits_Clear(uint32_t *bits, int32_t index) {
+    bits[index >> 5] &= ~(1u << (index & 31));
+}
+
+// Counts the bits set in [from, to)
+int32_t Clay__Bits_Count(const uint32_t *bits, int32_t from, int32_t to) {
+    if (from >= to) {
+        return 0;
+    }
+    int32_t first = from >> 5, last = (to - 1) >> 5;
+    uint32_t firstMask = ~0u << (from & 31), lastMask = ~0u >> (31 - ((to - 1) & 31));
+    if (first == last) {
+        return Clay__PopCount(bits[first] & firstMask & lastMask);
+    }
+    int32_t count = Clay__PopCount(bits[first] & firstMask) + Clay__PopCount(bits[last] & lastMask);
+    for (int32_t word = first + 1; word < last; word++) {
+        count += Clay__PopCount(bits[word]);
+    }
+    return count;
+}
+
+// The first bit set in [from, to), or to if there isn't one
+int32_t Clay__Bits_Next(const uint32_t *bits, int32_t from, int32_t to) {
+    if (from >= to) {
+        return to;
+    }
+    int32_t word = from >> 5, last = (to - 1) >> 5;
+    uint32_t masked = bits[word] & (~0u << (from & 31));
+    while (masked == 0) {
+        if (++word > last) {
+            return to;
+        }
+        masked = bits[word];
+    }
+    int32_t index = word * 32 + Clay__PopCount((masked & (0u - masked)) - 1);
+    return CLAY__MIN(index, to);
+}
+
+// Returns value after amount has been subtracted from it count times, rounding after each subtraction like a loop would.
+// While value stays within one power of two its float spacing, the quantum, is fixed, and every subtraction takes the
+// same whole number of quanta off its magnitude (or adds them, if amount has the opposite sign to value), so whole runs
+// of subtractions are done at once. The rounding only varies when amount ends exactly half way between two quanta, and
+// then only on the first subtraction, which leaves value an even number of quanta for round half to even to keep.
+float Clay__SubtractRepeated(float value, float amount, int32_t count) {
+    while (count > 0 && amount != 0) {
+        union { float value; uint32_t word; } bits = { value };
+        int32_t exponent = (int32_t)(bits.word >> 23 & 0xff);
+        // Values too small for their quantum to be a normal float, infinities and NaNs are stepped one at a time
+        if (exponent <= 23 || exponent == 0xff || amount != amount) {
+            value -= amount;
+            count--;
+            continue;
+        }
+        union { uint32_t word; float value; } quantumBits = { (uint32_t)(exponent - 23) << 23 };
+        double quantum = (double)quantumBits.value;
+        double quanta = (value < 0 ? -(double)value : (double)value) / quantum; // Between 2^23 and 2^24
+        double steps = (value < 0 ? -(double)amount : (double)amount) / quantum; // How far each subtraction shrinks the magnitude
+        bool shrinking = steps > 0;
+        steps = shrinking ? steps : -steps;
+        if (steps >= 16777216.0) {
+            value -= amount;
+            count--;
+            continue;
+        }
+        double whole = (double)(int64_t)steps;
+        double stride = steps - whole < 0.5 ? whole : whole + 1;
+        if (steps - whole == 0.5) {
+            if ((int64_t)quanta & 1) {
+                value -= amount;
+                count--;
+                continue;
+            }
+            stride = whole + (double)((int64_t)whole & 1);
+        }
+        // Runs while the exact difference can't leave the power of two, so the quantum can't change part way
+        double room = shrinking ? quanta - whole - 1 - 8388608.0 : 16777216.0 - 2 - whole - quanta;
+        if (room < 0) {
+            value -= amount;
+            count--;
+            continue;
+        }
+        if (stride == 0) {
+            return value;
+        }
+        double runLength = (double)(int64_t)(room / stride) + 1;
+        runLength = runLength < (double)count ? runLength : (double)count;
+        quanta += shrinking ? -runLength * stride : runLength * stride;
+        value = (float)(value < 0 ? -quanta * quantum : quanta * quantum);
+        count -= (int32_t)runLength;
+    }
+    return value;
+}
+
+// One pass of the loops that sized rows before the block existed, which Clay__SizingBlock_Distribute reproduces exactly,
+// over the rows in buffer[0, *length). Both directions are handled as growth by working on sizes multiplied by sign: a scan
+// picks the lowest row and the next size up, skipping rows within CLAY__EPSILON of the lowest one found so far, and then
+// every row within CLAY__EPSILON of the lowest moves up to that size, or by an equal share of what's remaining if that's
+// less. Rows that reach their limit stop there and leave the buffer. Returns false if the pass changed nothing, which left
+// the old loop repeating it forever.
+bool Clay__SizingBlock_Step(Clay__SizingBlock *block, float *limits, float sign, int32_t *length, float *remaining) {
+    float *sizes = block->sizes;
+    int32_t *buffer = block->buffer;
+    float smallest = sign > 0 ? CLAY__MAXFLOAT : 0;
+    float secondSmallest = smallest;
+    float widthToAdd = *remaining;
+    for (int32_t index = 0; index < *length; index++) {
+        float size = sizes[buffer[index]] * sign;
+        if (Clay__FloatEqual(size, smallest)) { continue; }
+        if (size < smallest) {
+            secondSmallest = smallest;
+            smallest = size;
+        }
+        if (size > smallest) {
+            secondSmallest = CLAY__MIN(secondSmallest, size);
+            widthToAdd = secondSmallest - smallest;
+        }
+    }
+    widthToAdd = CLAY__MIN(widthToAdd, *remaining / (float)*length);
+    bool changed = false;
+    for (int32_t index = 0; index < *length; index++) {
+        int32_t row = buffer[index];
+        float previousSize = sizes[row];
+        if (Clay__FloatEqual(previousSize * sign, smallest)) {
+            sizes[row] += widthToAdd * sign;
+            bool reachedLimit = sizes[row] * sign >= limits[row] * sign;
+            if (reachedLimit) {
+                sizes[row] = limits[row];
+            }
+            *remaining -= (sizes[row] - previousSize) * sign;
+            changed = changed || reachedLimit || sizes[row] != previousSize;
+            if (reachedLimit) {
+                buffer[index--] = buffer[--*length];
+            }
+        }
+    }
+    return changed;
+}
+
+#define CLAY__SIZING_BLOCK_LEVEL_MIN_LENGTH 32
+// Sorting the block costs about as much as this many passes, and rows with only a few different sizes settle within them
+#define CLAY__SIZING_BLOCK_LEVEL_PASSES 16
+
+// Runs passes of Clay__SizingBlock_Step over buffer[0, *length) without visiting every row in each, for blocks long
+// enough for that to matter. Rows that are moving all have the same size, the level, so they're kept as a set of buffer
+// positions, and the rest are sorted by size so that the next rows the level reaches are at the front. A second order,
+// sorted by limit, finds the rows that stop as the level rises. Whenever the rows a scan would compare are more than
+// CLAY__EPSILON apart, what it finds follows from the sorted rows and from where the first moving row is in the buffer,
+// and the subtractions from what's remaining are done a run at a time. As soon as anything doesn't fit, such as rows
+// that reach the level at a slightly different size, this stops at the start of a pass with the level written back to
+// the moving rows, and Clay__SizingBlock_Step finishes.
+void Clay__SizingBlock_DistributeLevel(Clay__SizingBlock *block, float *limits, float sign, int32_t *length, float *remaining) {
+    float *sizes = block->sizes;
+    int32_t *order = block->order, *buffer = block->buffer, *positions = block->positions, *limitOrder = block->limitOrder;
+    int32_t rowCount = *length;
+    int32_t wordCount = rowCount / 32 + 1;
+    uint32_t *moving = block->bits, *stopping = block->bits + wordCount;
+    for (int32_t word = 0; word < wordCount * 2; word++) {
+        block->bits[word] = 0;
+    }
+    int32_t depthLimit = 0;
+    for (int32_t position = 0; position < rowCount; position++) {
+        order[position] = buffer[position];
+        positions[buffer[position]] = position;
+        limitOrder[position] = buffer[position];
+    }
+    for (int32_t count = rowCount; count > 1; count >>= 1) {
+        depthLimit += 2;
+    }
+    Clay__SizingBlock_Sort(order, rowCount, sizes, sign, depthLimit);
+    Clay__SizingBlock_Sort(limitOrder, rowCount, limits, sign, depthLimit);
+    // What a scan starts from, and how far it's got through the rows before the first moving one
+    float firstSize = sign > 0 ? CLAY__MAXFLOAT : 0;
+    int32_t scannedEnd = 0;
+    float scannedSmallest = firstSize, scannedSecondSmallest = firstSize, scannedWidth = 0;
+    bool scannedWidthSet = false;
+    // The rows the level reaches next: order[nextRow, nextEnd) are within CLAY__EPSILON of the lowest of them
+    int32_t nextRow = 0, nextStart = -1, nextEnd = 0;
+    bool nextUniform = false, nextSeparated = false, nextAtFirstSize = false;
+    float level = 0;
+    int32_t movingCount = 0, firstMoving = rowCount, nextLimit = 0;
+    while (*remaining > CLAY__EPSILON && *length > 0) {
+        if (movingCount == 0) {
+            level = sizes[order[nextRow]];
+        }
+        float levelSize = level * sign;
+        int32_t stoppingCount = 0;
+        while (nextRow < rowCount && sizes[order[nextRow]] * sign - levelSize < CLAY__EPSILON && sizes[order[nextRow]] == level) {
+            int32_t row = order[nextRow++];
+            Clay__Bits_Set(moving, positions[row]);
+            movingCount++;
+            firstMoving = CLAY__MIN(firstMoving, positions[row]);
+            // A row already past its limit when the level reaches it stops on this pass
+            if (nextLimit > 0 && limits[row] * sign <= limits[limitOrder[nextLimit - 1]] * sign) {
+                Clay__Bits_Set(stopping, positions[row]);
+                stoppingCount++;
+            }
+        }
+        if ((nextRow < rowCount && sizes[order[nextRow]] * sign - levelSize < CLAY__EPSILON) || Clay__FloatEqual(levelSize, firstSize)) {
+            break;
+        }
+        if (nextStart != nextRow && nextRow < rowCount) {
+            float lowest = sizes[order[nextRow]] * sign;
+            nextStart = nextRow;
+            for (nextEnd = nextRow + 1; nextEnd < rowCount && sizes[order[nextEnd]] * sign - lowest < CLAY__EPSILON; nextEnd++) {}
+            float highest = sizes[order[nextEnd - 1]] * sign;
+            nextUniform = highest == lowest;
+            nextAtFirstSize = Clay__FloatEqual(lowest, firstSize);
+            nextSeparated = (nextEnd == rowCount || !(sizes[order[nextEnd]] * sign - highest < CLAY__EPSILON)) && nextAtFirstSize == Clay__FloatEqual(highest, firstSize);
+        }
+
+        firstMoving = Clay__Bits_Next(moving, firstMoving, *length);
+        // Every moving row is at or after the first one
+        int32_t othersAfterFirst = *length - firstMoving - movingCount;
+        float widthToAdd;
+        if (othersAfterFirst > 0) {
+            // The scan finds the level at the first moving row, and every row after it that isn't moving is a next size up
+            // for it to compare. The lowest rows the level hasn't reached come after it, or the first of them comes before
+            // it and was the lowest found until then, unless it was skipped for being within CLAY__EPSILON of firstSize.
+            if (!nextSeparated) {
+                break;
+            }
+            float secondSmallest = sizes[order[nextRow]] * sign;
+            if (!nextUniform || nextAtFirstSize) {
+                int32_t firstBefore = -1;
+                bool foundAfter = false;
+                for (int32_t index = nextRow; index < nextEnd; index++) {
+                    int32_t row = order[index];
+                    if (positions[row] < firstMoving) {
+                        firstBefore = firstBefore < 0 || positions[row] < positions[firstBefore] ? row : firstBefore;
+                    } else {
+                        secondSmallest = foundAfter ? CLAY__MIN(secondSmallest, sizes[row] * sign) : sizes[row] * sign;
+                        foundAfter = true;
                     }
-                } else {
-                    innerContentSize = CLAY__MAX(childSize, innerContentSize);
                 }
+                if (firstBefore >= 0 && !nextAtFirstSize) {
+                    secondSmallest = foundAfter ? CLAY__MIN(sizes[firstBefore] * sign, secondSmallest) : sizes[firstBefore] * sign;
+                } else if (!foundAfter) {
+                    break;
+                }
+            }
+            widthToAdd = secondSmallest - levelSize;
+        } else {
+            // Nothing after the first moving row is compared, so the width is whatever the scan had before reaching it
+            if (scannedEnd > firstMoving) {
+                scannedEnd = 0;
+                scannedSmallest = scannedSecondSmallest = firstSize;
+                scannedWidthSet = false;
+            }
+            for (; scannedEnd < firstMoving; scannedEnd++) {
+                float size = sizes[buffer[scannedEnd]] * sign;
+                if (Clay__FloatEqual(size, scannedSmallest)) { continue; }
+                if (size < scannedSmallest) {
+                    scannedSecondSmallest = scannedSmallest;
+                    scannedSmallest = size;
+                }
+                if (size > scannedSmallest) {
+                    scannedSecondSmallest = CLAY__MIN(scannedSecondSmallest, size);
+                    scannedWidth = scannedSecondSmallest - scannedSmallest;
+                    scannedWidthSet = true;
+                }
+            }
+            if (!(levelSize < scannedSmallest) || Clay__FloatEqual(levelSize, scannedSmallest)) {
+                break;
+            }
+            widthToAdd = scannedWidthSet ? scannedWidth : *remaining;
+        }
+        widthToAdd = CLAY__MIN(widthToAdd, *remaining / (float)*length);
+        float nextLevel = level + widthToAdd * sign;
+        float moved = (nextLevel - level) * sign;
+        for (; nextLimit < rowCount && limits[limitOrder[nextLimit]] * sign <= nextLevel * sign; nextLimit++) {
+            int32_t position = positions[limitOrder[nextLimit]];
+            if (Clay__Bits_Get(moving, position)) {
+                Clay__Bits_Set(stopping, position);
+                stoppingCount++;
+            }
+        }
+        if (stoppingCount == 0 && moved == 0) {
+            break;
+        }
+
+        // The pass moves the rows in buffer order, and each row that stops is replaced by the last row in the buffer
+        int32_t cursor = firstMoving;
+        int32_t movedCount = movingCount - stoppingCount;
+        for (int32_t position = Clay__Bits_Next(stopping, cursor, *length); position < *length; position = Clay__Bits_Next(stopping, cursor, *length)) {
+            int32_t runLength = Clay__Bits_Count(moving, cursor, position);
+            *remaining = Clay__SubtractRepeated(*remaining, moved, runLength);
+            movedCount -= runLength;
+            int32_t row = buffer[position];
+            sizes[row] = limits[row];
+            *remaining -= (limits[row] - level) * sign;
+            Clay__Bits_Clear(moving, position);
+            Clay__Bits_Clear(stopping, position);
+            movingCount--;
+            int32_t last = --*length;
+            if (last != position) {
+                buffer[position] = buffer[last];
+                positions[buffer[position]] = position;
+                if (Clay__Bits_Get(moving, last)) {
+                    Clay__Bits_Clear(moving, last);
+                    Clay__Bits_Set(moving, position);
+                }
+                if (Clay__Bits_Get(stopping, last)) {
+                    Clay__Bits_Clear(stopping, last);
+                    Clay__Bits_Set(stopping, position);
+                }
+            }
+            if (position < scannedEnd) {
+                scannedEnd = rowCount + 1;
+            }
+            cursor = position;
+        }
+        *remaining = Clay__SubtractRepeated(*remaining, moved, movedCount);
+        level = nextLevel;
+    }
+    for (int32_t position = Clay__Bits_Next(moving, 0, *length); position < *length; position = Clay__Bits_Next(moving, position + 1, *length)) {
+        sizes[buffer[position]] = level;
+    }
+}
+
+// Grows (sizeToDistribute > 0) or compresses (sizeToDistribute < 0) the block's rows with the same results, to the bit,
+// as the loops this replaced, which repeatedly moved the smallest rows up to the next size (or the largest down) until
+// what was remaining came within CLAY__EPSILON of zero, except that this stops where they would have repeated a pass that
+// changed nothing forever. Those loops scanned every row on every pass, so a row of thousands of children with distinct
+// sizes took millions of steps. Long blocks that are still moving after CLAY__SIZING_BLOCK_LEVEL_PASSES passes run the
+// rest through Clay__SizingBlock_DistributeLevel instead.
+void Clay__SizingBlock_Distribute(Clay__SizingBlock *block, float sizeToDistribute) {
+    float sign = sizeToDistribute > 0 ? 1 : -1;
+    float *limits = sizeToDistribute > 0 ? block->maxSizes : block->minSizes;
+    float remaining = sizeToDistribute * sign;
+    int32_t length = block->length;
+    for (int32_t row = 0; row < length; row++) {
+        block->buffer[row] = row;
+    }
+    for (int32_t pass = 0; remaining > CLAY__EPSILON && length > 0; pass++) {
+        if (pass == CLAY__SIZING_BLOCK_LEVEL_PASSES && length >= CLAY__SIZING_BLOCK_LEVEL_MIN_LENGTH) {
+            Clay__SizingBlock_DistributeLevel(block, limits, sign, &length, &remaining);
+        } else if (!Clay__SizingBlock_Step(block, limits, sign, &length, &remaining)) {
+            break;
+        }
+    }
+}
+
+void Clay__SizeTreeRootAlongAxis(Clay__LayoutElementTreeRoot *root, bool xAxis, Clay__int32_tArray bfsBuffer, Clay__SizingBlock sizingBlock) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    bfsBuffer.length = 0;
+    Clay_LayoutElement *rootElement = Clay_LayoutElementArray_Get(&context->layoutElements, (int)root->layoutElementIndex);
+    Clay__int32_tArray_Add(&bfsBuffer, (int32_t)root->layoutElementIndex);
+
+    // Size floating containers to their parents
+    if (Clay__ElementHasConfig(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING)) {
+        Clay_FloatingElementConfig *floatingElementConfig = Clay__FindElementConfigWithType(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig;
+        Clay_LayoutElementHashMapItem *parentItem = Clay__GetHashMapItem(floatingElementConfig->parentId);
+        if (parentItem && parentItem != &Clay_LayoutElementHashMapItem_DEFAULT) {
+            Clay_LayoutElement *parentLayoutElement = parentItem->layoutElement;
+            switch (rootElement->layoutConfig->sizing.width.type) {
+                case CLAY__SIZING_TYPE_GROW: {
+                    rootElement->dimensions.width = parentLayoutElement->dimensions.width;
+                    break;
+                }
+                case CLAY__SIZING_TYPE_PERCENT: {
+                    rootElement->dimensions.width = parentLayoutElement->dimensions.width * rootElement->layoutConfig->sizing.width.size.percent;
+                    break;
+                }
+                default: break;
+            }
+            switch (rootElement->layoutConfig->sizing.height.type) {
+                case CLAY__SIZING_TYPE_GROW: {
+                    rootElement->dimensions.height = parentLayoutElement->dimensions.height;
+                    break;
+                }
+                case CLAY__SIZING_TYPE_PERCENT: {
+                    rootElement->dimensions.height = parentLayoutElement->dimensions.height * rootElement->layoutConfig->sizing.height.size.percent;
+                    break;
+                }
+                default: break;
+            }
+        }
+    }
+
+    if (rootElement->layoutConfig->sizing.width.type != CLAY__SIZING_TYPE_PERCENT) {
+        rootElement->dimensions.width = CLAY__MIN(CLAY__MAX(rootElement->dimensions.width, rootElement->layoutConfig->sizing.width.size.minMax.min), rootElement->layoutConfig->sizing.width.size.minMax.max);
+    }
+    if (rootElement->layoutConfig->sizing.height.type != CLAY__SIZING_TYPE_PERCENT) {
+        rootElement->dimensions.height = CLAY__MIN(CLAY__MAX(rootElement->dimensions.height, rootElement->layoutConfig->sizing.height.size.minMax.min), rootElement->layoutConfig->sizing.height.size.minMax.max);
+    }
+
+    for (int32_t i = 0; i < bfsBuffer.length; ++i) {
+        int32_t parentIndex = Clay__int32_tArray_GetValue(&bfsBuffer, i);
+        Clay_LayoutElement *parent = Clay_LayoutElementArray_Get(&context->layoutElements, parentIndex);
+        if (context->retainedLayoutEnabled && Clay__RetainChildSizes(parent, xAxis, &bfsBuffer)) {
+            continue;
+        }
+        Clay_LayoutConfig *parentStyleConfig = parent->layoutConfig;
+        int32_t growContainerCount = 0;
+        float parentSize = xAxis ? parent->dimensions.width : parent->dimensions.height;
+        float parentPadding = (float)(xAxis ? (parent->layoutConfig->padding.left + parent->layoutConfig->padding.right) : (parent->layoutConfig->padding.top + parent->layoutConfig->padding.bottom));
+        float innerContentSize = 0, totalPaddingAndChildGaps = parentPadding;
+        bool sizingAlongAxis = (xAxis && parentStyleConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) || (!xAxis && parentStyleConfig->layoutDirection == CLAY_TOP_TO_BOTTOM);
+        sizingBlock.length = 0;
+        float parentChildGap = parentStyleConfig->childGap;
+
+        for (int32_t childOffset = 0; childOffset < parent->childrenOrTextContent.children.length; childOffset++) {
+            int32_t childElementIndex = parent->childrenOrTextContent.children.elements[childOffset];
+            Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, childElementIndex);
+            Clay_SizingAxis childSizing = xAxis ? childElement->layoutConfig->sizing.width : childElement->layoutConfig->sizing.height;
+            float childSize = xAxis ? childElement->dimensions.width : childElement->dimensions.height;
+
+            if (!Clay__ElementHasConfig(childElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT) && childElement->childrenOrTextContent.children.length > 0) {
+                Clay__int32_tArray_Add(&bfsBuffer, childElementIndex);
+            }
+
+            if (childSizing.type != CLAY__SIZING_TYPE_PERCENT
+                && childSizing.type != CLAY__SIZING_TYPE_FIXED
+                && (!childElement->textConfig || childElement->textConfig->wrapMode == CLAY_TEXT_WRAP_WORDS)
+//                    && (xAxis || !Clay__ElementHasConfig(childElement, CLAY__ELEMENT_CONFIG_TYPE_ASPECT))
+            ) {
+                sizingBlock.elementIndexes[sizingBlock.length++] = childElementIndex;
+            }
+
+            if (sizingAlongAxis) {
+                innerContentSize += (childSizing.type == CLAY__SIZING_TYPE_PERCENT ? 0 : childSize);
+                if (childSizing.type == CLAY__SIZING_TYPE_GROW) {
+                    growContainerCount++;
+                }
+                if (childOffset > 0) {
+                    innerContentSize += parentChildGap; // For children after index 0, the childAxisOffset is the gap from the previous child
+                    totalPaddingAndChildGaps += parentChildGap;
+                }
+            } else {
+                innerContentSize = CLAY__MAX(childSize, innerContentSize);
+            }
+        }
+
+        // Expand percentage containers to size
+        for (int32_t childOffset = 0; childOffset < parent->childrenOrTextContent.children.length; childOffset++) {
+            int32_t childElementIndex = parent->childrenOrTextContent.children.elements[childOffset];
+            Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, childElementIndex);
+            Clay_SizingAxis childSizing = xAxis ? childElement->layoutConfig->sizing.width : childElement->layoutConfig->sizing.height;
+            float *childSize = xAxis ? &childElement->dimensions.width : &childElement->dimensions.height;
+            if (childSizing.type == CLAY__SIZING_TYPE_PERCENT) {
+                *childSize = (parentSize - totalPaddingAndChildGaps) * childSizing.size.percent;
+                if (sizingAlongAxis) {
+                    innerContentSize += *childSize;
+                }
+                Clay__UpdateAspectRatioBox(childElement);
             }
+        }
 
-            // Expand percentage containers to size
-            for (int32_t childOffset = 0; childOffset < parent->childrenOrTextContent.children.length; childOffset++) {
-                int32_t childElementIndex = parent->childrenOrTextContent.children.elements[childOffset];
-                Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, childElementIndex);
+        if (sizingAlongAxis) {
+            float sizeToDistribute = parentSize - parentPadding - innerContentSize;
+            // The content is too large, compress the children as much as possible
+            if (sizeToDistribute < -CLAY__EPSILON) {
+                // If the parent clips content in this axis direction, don't compress children, just leave them alone
+                Clay_ClipElementConfig *clipElementConfig = Clay__FindElementConfigWithType(parent, CLAY__ELEMENT_CONFIG_TYPE_CLIP).clipElementConfig;
+                if (clipElementConfig) {
+                    if (((xAxis && clipElementConfig->horizontal) || (!xAxis && clipElementConfig->vertical))) {
+                        continue;
+                    }
+                }
+                Clay__SizingBlock_Load(&sizingBlock, xAxis);
+                // Scrolling containers preferentially compress before others
+                Clay__SizingBlock_Distribute(&sizingBlock, sizeToDistribute);
+                Clay__SizingBlock_Store(&sizingBlock, xAxis);
+            // The content is too small, allow SIZING_GROW containers to expand
+            } else if (sizeToDistribute > CLAY__EPSILON && growContainerCount > 0) {
+                Clay__SizingBlock_Load(&sizingBlock, xAxis);
+                for (int childIndex = 0; childIndex < sizingBlock.length; childIndex++) {
+                    if (sizingBlock.types[childIndex] != CLAY__SIZING_TYPE_GROW) {
+                        Clay__SizingBlock_RemoveSwapback(&sizingBlock, childIndex--, xAxis);
+                    }
+                }
+                Clay__SizingBlock_Distribute(&sizingBlock, sizeToDistribute);
+                Clay__SizingBlock_Store(&sizingBlock, xAxis);
+            }
+        // Sizing along the non layout axis ("off axis")
+        } else {
+            // A single clamp per child, so there's nothing to gain from loading the block's columns here
+            for (int32_t childOffset = 0; childOffset < sizingBlock.length; childOffset++) {
+                Clay_LayoutElement *childElement = &sizingBlock.elements[sizingBlock.elementIndexes[childOffset]];
                 Clay_SizingAxis childSizing = xAxis ? childElement->layoutConfig->sizing.width : childElement->layoutConfig->sizing.height;
+                float minSize = xAxis ? childElement->minDimensions.width : childElement->minDimensions.height;
                 float *childSize = xAxis ? &childElement->dimensions.width : &childElement->dimensions.height;
-                if (childSizing.type == CLAY__SIZING_TYPE_PERCENT) {
-                    *childSize = (parentSize - totalPaddingAndChildGaps) * childSizing.size.percent;
-                    if (sizingAlongAxis) {
-                        innerContentSize += *childSize;
+
+                float maxSize = parentSize - parentPadding;
+                // If we're laying out the children of a scroll panel, grow containers expand to the size of the inner content, not the outer container
+                if (Clay__ElementHasConfig(parent, CLAY__ELEMENT_CONFIG_TYPE_CLIP)) {
+                    Clay_ClipElementConfig *clipElementConfig = Clay__FindElementConfigWithType(parent, CLAY__ELEMENT_CONFIG_TYPE_CLIP).clipElementConfig;
+                    if (((xAxis && clipElementConfig->horizontal) || (!xAxis && clipElementConfig->vertical))) {
+                        maxSize = CLAY__MAX(maxSize, innerContentSize);
                     }
-                    Clay__UpdateAspectRatioBox(childElement);
                 }
+                if (childSizing.type == CLAY__SIZING_TYPE_GROW) {
+                    *childSize = CLAY__MIN(maxSize, childSizing.size.minMax.max);
+                }
+                *childSize = CLAY__MAX(minSize, CLAY__MIN(*childSize, maxSize));
             }
+        }
+    }
+}
 
-            if (sizingAlongAxis) {
-                float sizeToDistribute = parentSize - parentPadding - innerContentSize;
-                // The content is too large, compress the children as much as possible
-                if (sizeToDistribute < 0) {
-                    // If the parent clips content in this axis direction, don't compress children, just leave them alone
-                    Clay_ClipElementConfig *clipElementConfig = Clay__FindElementConfigWithType(parent, CLAY__ELEMENT_CONFIG_TYPE_CLIP).clipElementConfig;
-                    if (clipElementConfig) {
-                        if (((xAxis && clipElementConfig->horizontal) || (!xAxis && clipElementConfig->vertical))) {
-                            continue;
+Clay_String Clay__IntToString(int32_t integer) {
+    if (integer == 0) {
+        return CLAY__INIT(Clay_String) { .length = 1, .chars = "0" };
+    }
+    Clay_Context* context = Clay_GetCurrentContext();
+    char *chars = (char *)(context->dynamicStringData.internalArray + context->dynamicStringData.length);
+    int32_t length = 0;
+    int32_t sign = integer;
+
+    if (integer < 0) {
+        integer = -integer;
+    }
+    while (integer > 0) {
+        chars[length++] = (char)(integer % 10 + '0');
+        integer /= 10;
+    }
+
+    if (sign < 0) {
+        chars[length++] = '-';
+    }
+
+    // Reverse the string to get the correct order
+    for (int32_t j = 0, k = length - 1; j < k; j++, k--) {
+        char temp = chars[j];
+        chars[j] = chars[k];
+        chars[k] = temp;
+    }
+    context->dynamicStringData.length += length;
+    return CLAY__INIT(Clay_String) { .length = length, .chars = chars };
+}
+
+void Clay__AddRenderCommand(Clay_RenderCommandArray *renderCommands, Clay_RenderCommand renderCommand) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    if (renderCommands->length < renderCommands->capacity - 1) {
+        Clay_RenderCommandArray_Add(renderCommands, renderCommand);
+    } else {
+        if (!context->booleanWarnings.maxRenderCommandsExceeded) {
+            context->booleanWarnings.maxRenderCommandsExceeded = true;
+            context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
+                .errorType = CLAY_ERROR_TYPE_ELEMENTS_CAPACITY_EXCEEDED,
+                .errorText = CLAY_STRING("Clay ran out of capacity while attempting to create render commands. This is usually caused by a large amount of wrapping text elements while close to the max element capacity. Try using Clay_SetMaxElementCount() with a higher value."),
+                .userData = context->errorHandler.userData });
+        }
+    }
+}
+
+bool Clay__ElementIsOffscreen(Clay_BoundingBox *boundingBox) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    if (context->disableCulling) {
+        return false;
+    }
+
+    return (boundingBox->x > (float)context->layoutDimensions.width) ||
+           (boundingBox->y > (float)context->layoutDimensions.height) ||
+           (boundingBox->x + boundingBox->width < 0) ||
+           (boundingBox->y + boundingBox->height < 0);
+}
+
+bool Clay__BoundingBoxEqual(Clay_BoundingBox left, Clay_BoundingBox right) {
+    return left.x == right.x && left.y == right.y && left.width == right.width && left.height == right.height;
+}
+
+// If an element's sizes were restored in both passes and it has landed in the same place as last frame, copies last frame's
+// render commands for its whole subtree instead of generating them again
+bool Clay__RetainRenderCommands(Clay_LayoutElement *layoutElement, Clay_BoundingBox boundingBox, Clay__LayoutElementTreeRoot *root, Clay_LayoutElement *rootElement, Clay_RenderCommandArray *renderCommands) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__RetainedElementData *retainedData = layoutElement->retainedData;
+    if (layoutElement->retainedState != CLAY__RETAINED_STATE_SIZED_Y
+        || retainedData->renderCommandsGeneration != context->retainedGeneration - 1
+        || retainedData->zIndex != root->zIndex
+        || retainedData->rootChildCount != rootElement->childrenOrTextContent.children.length
+        || !Clay__BoundingBoxEqual(retainedData->boundingBox, boundingBox)
+        || context->retainedLayoutDimensions.width != context->layoutDimensions.width || context->retainedLayoutDimensions.height != context->layoutDimensions.height
+        || renderCommands->length + retainedData->renderCommandsCount > renderCommands->capacity - 1) {
+        return false;
+    }
+    int32_t commandOffset = renderCommands->length - retainedData->renderCommandsStart;
+    for (int32_t i = 0; i < retainedData->renderCommandsCount; ++i) {
+        renderCommands->internalArray[renderCommands->length++] = context->previousRenderCommands.internalArray[retainedData->renderCommandsStart + i];
+    }
+    // The subtree won't be visited, so move its ranges to where the commands are now
+    Clay__int32_tArray stack = context->layoutElementChildrenBuffer;
+    stack.length = 0;
+    Clay_LayoutElement *currentElement = layoutElement;
+    while (true) {
+        currentElement->retainedData->renderCommandsStart += commandOffset;
+        currentElement->retainedData->renderCommandsGeneration = context->retainedGeneration;
+        if (!Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
+            for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
+                Clay__int32_tArray_Add(&stack, currentElement->childrenOrTextContent.children.elements[i]);
+            }
+        }
+        if (stack.length == 0) {
+            break;
+        }
+        currentElement = Clay_LayoutElementArray_Get(&context->layoutElements, stack.internalArray[--stack.length]);
+    }
+    return true;
+}
+
+void Clay__PositionTreeRoot(Clay__LayoutElementTreeRoot *root, Clay__LayoutElementTreeNodeArray dfsBuffer, bool *treeNodeVisited, Clay_RenderCommandArray *renderCommands) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    // Commands are only recorded for reuse when generated straight into the final array
+    bool retainCommands = context->retainedLayoutEnabled && !context->booleanWarnings.maxElementsExceeded && renderCommands == &context->renderCommands;
+    dfsBuffer.length = 0;
+    Clay_LayoutElement *rootElement = Clay_LayoutElementArray_Get(&context->layoutElements, (int)root->layoutElementIndex);
+    Clay_Vector2 rootPosition = CLAY__DEFAULT_STRUCT;
+    Clay_LayoutElementHashMapItem *parentHashMapItem = Clay__GetHashMapItem(root->parentId);
+    // Position root floating containers
+    if (Clay__ElementHasConfig(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING) && parentHashMapItem) {
+        Clay_FloatingElementConfig *config = Clay__FindElementConfigWithType(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig;
+        Clay_Dimensions rootDimensions = rootElement->dimensions;
+        Clay_BoundingBox parentBoundingBox = parentHashMapItem->boundingBox;
+        root->parentBoundingBox = parentBoundingBox;
+        // Set X position
+        Clay_Vector2 targetAttachPosition = CLAY__DEFAULT_STRUCT;
+        switch (config->attachPoints.parent) {
+            case CLAY_ATTACH_POINT_LEFT_TOP:
+            case CLAY_ATTACH_POINT_LEFT_CENTER:
+            case CLAY_ATTACH_POINT_LEFT_BOTTOM: targetAttachPosition.x = parentBoundingBox.x; break;
+            case CLAY_ATTACH_POINT_CENTER_TOP:
+            case CLAY_ATTACH_POINT_CENTER_CENTER:
+            case CLAY_ATTACH_POINT_CENTER_BOTTOM: targetAttachPosition.x = parentBoundingBox.x + (parentBoundingBox.width / 2); break;
+            case CLAY_ATTACH_POINT_RIGHT_TOP:
+            case CLAY_ATTACH_POINT_RIGHT_CENTER:
+            case CLAY_ATTACH_POINT_RIGHT_BOTTOM: targetAttachPosition.x = parentBoundingBox.x + parentBoundingBox.width; break;
+        }
+        switch (config->attachPoints.element) {
+            case CLAY_ATTACH_POINT_LEFT_TOP:
+            case CLAY_ATTACH_POINT_LEFT_CENTER:
+            case CLAY_ATTACH_POINT_LEFT_BOTTOM: break;
+            case CLAY_ATTACH_POINT_CENTER_TOP:
+            case CLAY_ATTACH_POINT_CENTER_CENTER:
+            case CLAY_ATTACH_POINT_CENTER_BOTTOM: targetAttachPosition.x -= (rootDimensions.width / 2); break;
+            case CLAY_ATTACH_POINT_RIGHT_TOP:
+            case CLAY_ATTACH_POINT_RIGHT_CENTER:
+            case CLAY_ATTACH_POINT_RIGHT_BOTTOM: targetAttachPosition.x -= rootDimensions.width; break;
+        }
+        switch (config->attachPoints.parent) { // I know I could merge the x and y switch statements, but this is easier to read
+            case CLAY_ATTACH_POINT_LEFT_TOP:
+            case CLAY_ATTACH_POINT_RIGHT_TOP:
+            case CLAY_ATTACH_POINT_CENTER_TOP: targetAttachPosition.y = parentBoundingBox.y; break;
+            case CLAY_ATTACH_POINT_LEFT_CENTER:
+            case CLAY_ATTACH_POINT_CENTER_CENTER:
+            case CLAY_ATTACH_POINT_RIGHT_CENTER: targetAttachPosition.y = parentBoundingBox.y + (parentBoundingBox.height / 2); break;
+            case CLAY_ATTACH_POINT_LEFT_BOTTOM:
+            case CLAY_ATTACH_POINT_CENTER_BOTTOM:
+            case CLAY_ATTACH_POINT_RIGHT_BOTTOM: targetAttachPosition.y = parentBoundingBox.y + parentBoundingBox.height; break;
+        }
+        switch (config->attachPoints.element) {
+            case CLAY_ATTACH_POINT_LEFT_TOP:
+            case CLAY_ATTACH_POINT_RIGHT_TOP:
+            case CLAY_ATTACH_POINT_CENTER_TOP: break;
+            case CLAY_ATTACH_POINT_LEFT_CENTER:
+            case CLAY_ATTACH_POINT_CENTER_CENTER:
+            case CLAY_ATTACH_POINT_RIGHT_CENTER: targetAttachPosition.y -= (rootDimensions.height / 2); break;
+            case CLAY_ATTACH_POINT_LEFT_BOTTOM:
+            case CLAY_ATTACH_POINT_CENTER_BOTTOM:
+            case CLAY_ATTACH_POINT_RIGHT_BOTTOM: targetAttachPosition.y -= rootDimensions.height; break;
+        }
+        targetAttachPosition.x += config->offset.x;
+        targetAttachPosition.y += config->offset.y;
+        rootPosition = targetAttachPosition;
+    }
+    if (root->clipElementId) {
+        Clay_LayoutElementHashMapItem *clipHashMapItem = Clay__GetHashMapItem(root->clipElementId);
+        if (clipHashMapItem) {
+            root->clipBoundingBox = clipHashMapItem->boundingBox;
+            // Floating elements that are attached to scrolling contents won't be correctly positioned if external scroll handling is enabled, fix here
+            if (context->externalScrollHandlingEnabled) {
+                Clay_ClipElementConfig *clipConfig = Clay__FindElementConfigWithType(clipHashMapItem->layoutElement, CLAY__ELEMENT_CONFIG_TYPE_CLIP).clipElementConfig;
+                if (clipConfig->horizontal) {
+                    rootPosition.x += clipConfig->childOffset.x;
+                }
+                if (clipConfig->vertical) {
+                    rootPosition.y += clipConfig->childOffset.y;
+                }
+            }
+            Clay__AddRenderCommand(renderCommands, CLAY__INIT(Clay_RenderCommand) {
+                .boundingBox = clipHashMapItem->boundingBox,
+                .userData = 0,
+                .id = Clay__HashNumber(rootElement->id, rootElement->childrenOrTextContent.children.length + 10).id, // TODO need a better strategy for managing derived ids
+                .zIndex = root->zIndex,
+                .commandType = CLAY_RENDER_COMMAND_TYPE_SCISSOR_START,
+            });
+        }
+    }
+    Clay__LayoutElementTreeNodeArray_Add(&dfsBuffer, CLAY__INIT(Clay__LayoutElementTreeNode) { .layoutElement = rootElement, .position = rootPosition, .nextChildOffset = { .x = (float)rootElement->layoutConfig->padding.left, .y = (float)rootElement->layoutConfig->padding.top } });
+
+    treeNodeVisited[0] = false;
+    while (dfsBuffer.length > 0) {
+        Clay__LayoutElementTreeNode *currentElementTreeNode = Clay__LayoutElementTreeNodeArray_Get(&dfsBuffer, (int)dfsBuffer.length - 1);
+        Clay_LayoutElement *currentElement = currentElementTreeNode->layoutElement;
+        Clay_LayoutConfig *layoutConfig = currentElement->layoutConfig;
+        Clay_Vector2 scrollOffset = CLAY__DEFAULT_STRUCT;
+
+        // This will only be run a single time for each element in downwards DFS order
+        if (!treeNodeVisited[dfsBuffer.length - 1]) {
+            treeNodeVisited[dfsBuffer.length - 1] = true;
+
+            Clay_BoundingBox currentElementBoundingBox = { currentElementTreeNode->position.x, currentElementTreeNode->position.y, currentElement->dimensions.width, currentElement->dimensions.height };
+            if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING)) {
+                Clay_FloatingElementConfig *floatingElementConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig;
+                Clay_Dimensions expand = floatingElementConfig->expand;
+                currentElementBoundingBox.x -= expand.width;
+                currentElementBoundingBox.width += expand.width * 2;
+                currentElementBoundingBox.y -= expand.height;
+                currentElementBoundingBox.height += expand.height * 2;
+            }
+
+            if (retainCommands && currentElement->retainedData) {
+                if (Clay__RetainRenderCommands(currentElement, currentElementBoundingBox, root, rootElement, renderCommands)) {
+                    dfsBuffer.length--;
+                    continue;
+                }
+                currentElement->retainedData->renderCommandsStart = renderCommands->length;
+                currentElement->retainedData->boundingBox = currentElementBoundingBox;
+            }
+
+            Clay__ScrollContainerDataInternal *scrollContainerData = CLAY__NULL;
+            // Apply scroll offsets to container
+            if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_CLIP)) {
+                Clay_ClipElementConfig *clipConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_CLIP).clipElementConfig;
+
+                // This linear scan could theoretically be slow under very strange conditions, but I can't imagine a real UI with more than a few 10's of scroll containers
+                for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
+                    Clay__ScrollContainerDataInternal *mapping = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
+                    if (mapping->layoutElement == currentElement) {
+                        scrollContainerData = mapping;
+                        mapping->boundingBox = currentElementBoundingBox;
+                        scrollOffset = clipConfig->childOffset;
+                        if (context->externalScrollHandlingEnabled) {
+                            scrollOffset = CLAY__INIT(Clay_Vector2) CLAY__DEFAULT_STRUCT;
                         }
+                        break;
                     }
-                    // Scrolling containers preferentially compress before others
-                    while (sizeToDistribute < -CLAY__EPSILON && resizableContainerBuffer.length > 0) {
-                        float largest = 0;
-                        float secondLargest = 0;
-                        float widthToAdd = sizeToDistribute;
-                        for (int childIndex = 0; childIndex < resizableContainerBuffer.length; childIndex++) {
-                            Clay_LayoutElement *child = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&resizableContainerBuffer, childIndex));
-                            float childSize = xAxis ? child->dimensions.width : child->dimensions.height;
-                            if (Clay__FloatEqual(childSize, largest)) { continue; }
-                            if (childSize > largest) {
-                                secondLargest = largest;
-                                largest = childSize;
-                            }
-                            if (childSize < largest) {
-                                secondLargest = CLAY__MAX(secondLargest, childSize);
-                                widthToAdd = secondLargest - largest;
-                            }
-                        }
+                }
+            }
 
-                        widthToAdd = CLAY__MAX(widthToAdd, sizeToDistribute / resizableContainerBuffer.length);
-
-                        for (int childIndex = 0; childIndex < resizableContainerBuffer.length; childIndex++) {
-                            Clay_LayoutElement *child = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&resizableContainerBuffer, childIndex));
-                            float *childSize = xAxis ? &child->dimensions.width : &child->dimensions.height;
-                            float minSize = xAxis ? child->minDimensions.width : child->minDimensions.height;
-                            float previousWidth = *childSize;
-                            if (Clay__FloatEqual(*childSize, largest)) {
-                                *childSize += widthToAdd;
-                                if (*childSize <= minSize) {
-                                    *childSize = minSize;
-                                    Clay__int32_tArray_RemoveSwapback(&resizableContainerBuffer, childIndex--);
-                                }
-                                sizeToDistribute -= (*childSize - previousWidth);
+            Clay_LayoutElementHashMapItem *hashMapItem = Clay__GetHashMapItem(currentElement->id);
+            if (hashMapItem) {
+                hashMapItem->boundingBox = currentElementBoundingBox;
+            }
+
+            // Scissor commands open before anything else the element draws, and borders draw over everything else.
+            // The remaining configs keep the order they were declared in.
+            int32_t sortedConfigIndexes[20];
+            int32_t sortedConfigCount = 0;
+            Clay_ElementConfig *elementConfigs = currentElement->elementConfigs.internalArray;
+            if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_CLIP)) {
+                for (int32_t elementConfigIndex = 0; elementConfigIndex < currentElement->elementConfigs.length; ++elementConfigIndex) {
+                    if (elementConfigs[elementConfigIndex].type == CLAY__ELEMENT_CONFIG_TYPE_CLIP) {
+                        sortedConfigIndexes[sortedConfigCount++] = elementConfigIndex;
+                    }
+                }
+            }
+            for (int32_t elementConfigIndex = 0; elementConfigIndex < currentElement->elementConfigs.length; ++elementConfigIndex) {
+                if (elementConfigs[elementConfigIndex].type != CLAY__ELEMENT_CONFIG_TYPE_CLIP && elementConfigs[elementConfigIndex].type != CLAY__ELEMENT_CONFIG_TYPE_BORDER) {
+                    sortedConfigIndexes[sortedConfigCount++] = elementConfigIndex;
+                }
+            }
+            if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_BORDER)) {
+                for (int32_t elementConfigIndex = 0; elementConfigIndex < currentElement->elementConfigs.length; ++elementConfigIndex) {
+                    if (elementConfigs[elementConfigIndex].type == CLAY__ELEMENT_CONFIG_TYPE_BORDER) {
+                        sortedConfigIndexes[sortedConfigCount++] = elementConfigIndex;
+                    }
+                }
+            }
+
+            bool emitRectangle = false;
+            // Create the render commands for this element
+            Clay_SharedElementConfig *sharedConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SHARED).sharedElementConfig;
+            if (sharedConfig && sharedConfig->backgroundColor.a > 0) {
+               emitRectangle = true;
+            }
+            else if (!sharedConfig) {
+                emitRectangle = false;
+                sharedConfig = &Clay_SharedElementConfig_DEFAULT;
+            }
+            for (int32_t elementConfigIndex = 0; elementConfigIndex < currentElement->elementConfigs.length; ++elementConfigIndex) {
+                Clay_ElementConfig *elementConfig = Clay__ElementConfigArraySlice_Get(&currentElement->elementConfigs, sortedConfigIndexes[elementConfigIndex]);
+                Clay_RenderCommand renderCommand = {
+                    .boundingBox = currentElementBoundingBox,
+                    .userData = sharedConfig->userData,
+                    .id = currentElement->id,
+                };
+
+                bool offscreen = Clay__ElementIsOffscreen(&currentElementBoundingBox);
+                // Culling - Don't bother to generate render commands for rectangles entirely outside the screen - this won't stop their children from being rendered if they overflow
+                bool shouldRender = !offscreen;
+                switch (elementConfig->type) {
+                    case CLAY__ELEMENT_CONFIG_TYPE_ASPECT:
+                    case CLAY__ELEMENT_CONFIG_TYPE_FLOATING:
+                    case CLAY__ELEMENT_CONFIG_TYPE_SHARED:
+                    case CLAY__ELEMENT_CONFIG_TYPE_BORDER: {
+                        shouldRender = false;
+                        break;
+                    }
+                    case CLAY__ELEMENT_CONFIG_TYPE_CLIP: {
+                        renderCommand.commandType = CLAY_RENDER_COMMAND_TYPE_SCISSOR_START;
+                        renderCommand.renderData = CLAY__INIT(Clay_RenderData) {
+                            .clip = {
+                                .horizontal = elementConfig->config.clipElementConfig->horizontal,
+                                .vertical = elementConfig->config.clipElementConfig->vertical,
                             }
-                        }
+                        };
+                        break;
                     }
-                // The content is too small, allow SIZING_GROW containers to expand
-                } else if (sizeToDistribute > 0 && growContainerCount > 0) {
-                    for (int childIndex = 0; childIndex < resizableContainerBuffer.length; childIndex++) {
-                        Clay_LayoutElement *child = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&resizableContainerBuffer, childIndex));
-                        Clay__SizingType childSizing = xAxis ? child->layoutConfig->sizing.width.type : child->layoutConfig->sizing.height.type;
-                        if (childSizing != CLAY__SIZING_TYPE_GROW) {
-                            Clay__int32_tArray_RemoveSwapback(&resizableContainerBuffer, childIndex--);
-                        }
+                    case CLAY__ELEMENT_CONFIG_TYPE_IMAGE: {
+                        renderCommand.commandType = CLAY_RENDER_COMMAND_TYPE_IMAGE;
+                        renderCommand.renderData = CLAY__INIT(Clay_RenderData) {
+                            .image = {
+                                .backgroundColor = sharedConfig->backgroundColor,
+                                .cornerRadius = sharedConfig->cornerRadius,
+                                .imageData = elementConfig->config.imageElementConfig->imageData,
+                           }
+                        };
+                        emitRectangle = false;
+                        break;
                     }
-                    while (sizeToDistribute > CLAY__EPSILON && resizableContainerBuffer.length > 0) {
-                        float smallest = CLAY__MAXFLOAT;
-                        float secondSmallest = CLAY__MAXFLOAT;
-                        float widthToAdd = sizeToDistribute;
-                        for (int childIndex = 0; childIndex < resizableContainerBuffer.length; childIndex++) {
-                            Clay_LayoutElement *child = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&resizableContainerBuffer, childIndex));
-                            float childSize = xAxis ? child->dimensions.width : child->dimensions.height;
-                            if (Clay__FloatEqual(childSize, smallest)) { continue; }
-                            if (childSize < smallest) {
-                                secondSmallest = smallest;
-                                smallest = childSize;
+                    case CLAY__ELEMENT_CONFIG_TYPE_TEXT: {
+                        if (!shouldRender) {
+                            break;
+                        }
+                        shouldRender = false;
+                        Clay_ElementConfigUnion configUnion = elementConfig->config;
+                        Clay_TextElementConfig *textElementConfig = configUnion.textElementConfig;
+                        float naturalLineHeight = currentElement->childrenOrTextContent.textElementData->preferredDimensions.height;
+                        float finalLineHeight = textElementConfig->lineHeight > 0 ? (float)textElementConfig->lineHeight : naturalLineHeight;
+                        float lineHeightOffset = (finalLineHeight - naturalLineHeight) / 2;
+                        float yPosition = lineHeightOffset;
+                        for (int32_t lineIndex = 0; lineIndex < currentElement->childrenOrTextContent.textElementData->wrappedLines.length; ++lineIndex) {
+                            Clay__WrappedTextLine *wrappedLine = Clay__WrappedTextLineArraySlice_Get(&currentElement->childrenOrTextContent.textElementData->wrappedLines, lineIndex);
+                            if (wrappedLine->line.length == 0) {
+                                yPosition += finalLineHeight;
+                                continue;
+                            }
+                            float offset = (currentElementBoundingBox.width - wrappedLine->dimensions.width);
+                            if (textElementConfig->textAlignment == CLAY_TEXT_ALIGN_LEFT) {
+                                offset = 0;
+                            }
+                            if (textElementConfig->textAlignment == CLAY_TEXT_ALIGN_CENTER) {
+                                offset /= 2;
                             }
-                            if (childSize > smallest) {
-                                secondSmallest = CLAY__MIN(secondSmallest, childSize);
-                                widthToAdd = secondSmallest - smallest;
+                            Clay__AddRenderCommand(renderCommands, CLAY__INIT(Clay_RenderCommand) {
+                                .boundingBox = { currentElementBoundingBox.x + offset, currentElementBoundingBox.y + yPosition, wrappedLine->dimensions.width, wrappedLine->dimensions.height },
+                                .renderData = { .text = {
+                                    .stringContents = CLAY__INIT(Clay_StringSlice) { .length = wrappedLine->line.length, .chars = wrappedLine->line.chars, .baseChars = currentElement->childrenOrTextContent.textElementData->text.chars },
+                                    .textColor = textElementConfig->textColor,
+                                    .fontId = textElementConfig->fontId,
+                                    .fontSize = textElementConfig->fontSize,
+                                    .letterSpacing = textElementConfig->letterSpacing,
+                                    .lineHeight = textElementConfig->lineHeight,
+                                }},
+                                .userData = textElementConfig->userData,
+                                .id = Clay__HashNumber(lineIndex, currentElement->id).id,
+                                .zIndex = root->zIndex,
+                                .commandType = CLAY_RENDER_COMMAND_TYPE_TEXT,
+                            });
+                            yPosition += finalLineHeight;
+
+                            if (!context->disableCulling && (currentElementBoundingBox.y + yPosition > context->layoutDimensions.height)) {
+                                break;
                             }
                         }
+                        break;
+                    }
+                    case CLAY__ELEMENT_CONFIG_TYPE_CUSTOM: {
+                        renderCommand.commandType = CLAY_RENDER_COMMAND_TYPE_CUSTOM;
+                        renderCommand.renderData = CLAY__INIT(Clay_RenderData) {
+                            .custom = {
+                                .backgroundColor = sharedConfig->backgroundColor,
+                                .cornerRadius = sharedConfig->cornerRadius,
+                                .customData = elementConfig->config.customElementConfig->customData,
+                            }
+                        };
+                        emitRectangle = false;
+                        break;
+                    }
+                    default: break;
+                }
+                if (shouldRender) {
+                    Clay__AddRenderCommand(renderCommands, renderCommand);
+                }
+                if (offscreen) {
+                    // NOTE: You may be tempted to try an early return / continue if an element is off screen. Why bother calculating layout for its children, right?
+                    // Unfortunately, a FLOATING_CONTAINER may be defined that attaches to a child or grandchild of this element, which is large enough to still
+                    // be on screen, even if this element isn't. That depends on this element and it's children being laid out correctly (even if they are entirely off screen)
+                }
+            }
+
+            if (emitRectangle) {
+                Clay__AddRenderCommand(renderCommands, CLAY__INIT(Clay_RenderCommand) {
+                    .boundingBox = currentElementBoundingBox,
+                    .renderData = { .rectangle = {
+                            .backgroundColor = sharedConfig->backgroundColor,
+                            .cornerRadius = sharedConfig->cornerRadius,
+                    }},
+                    .userData = sharedConfig->userData,
+                    .id = currentElement->id,
+                    .zIndex = root->zIndex,
+                    .commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE,
+                });
+            }
+
+            // Setup initial on-axis alignment
+            if (!Clay__ElementHasConfig(currentElementTreeNode->layoutElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
+                Clay_Dimensions contentSize = {0,0};
+                if (layoutConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) {
+                    for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
+                        Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
+                        contentSize.width += childElement->dimensions.width;
+                        contentSize.height = CLAY__MAX(contentSize.height, childElement->dimensions.height);
+                    }
+                    contentSize.width += (float)(CLAY__MAX(currentElement->childrenOrTextContent.children.length - 1, 0) * layoutConfig->childGap);
+                    float extraSpace = currentElement->dimensions.width - (float)(layoutConfig->padding.left + layoutConfig->padding.right) - contentSize.width;
+                    switch (layoutConfig->childAlignment.x) {
+                        case CLAY_ALIGN_X_LEFT: extraSpace = 0; break;
+                        case CLAY_ALIGN_X_CENTER: extraSpace /= 2; break;
+                        default: break;
+                    }
+                    currentElementTreeNode->nextChildOffset.x += extraSpace;
+                    extraSpace = CLAY__MAX(0, extraSpace);
+                } else {
+                    for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
+                        Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
+                        contentSize.width = CLAY__MAX(contentSize.width, childElement->dimensions.width);
+                        contentSize.height += childElement->dimensions.height;
+                    }
+                    contentSize.height += (float)(CLAY__MAX(currentElement->childrenOrTextContent.children.length - 1, 0) * layoutConfig->childGap);
+                    float extraSpace = currentElement->dimensions.height - (float)(layoutConfig->padding.top + layoutConfig->padding.bottom) - contentSize.height;
+                    switch (layoutConfig->childAlignment.y) {
+                        case CLAY_ALIGN_Y_TOP: extraSpace = 0; break;
+                        case CLAY_ALIGN_Y_CENTER: extraSpace /= 2; break;
+                        default: break;
+                    }
+                    extraSpace = CLAY__MAX(0, extraSpace);
+                    currentElementTreeNode->nextChildOffset.y += extraSpace;
+                }
+
+                if (scrollContainerData) {
+                    scrollContainerData->contentSize = CLAY__INIT(Clay_Dimensions) { contentSize.width + (float)(layoutConfig->padding.left + layoutConfig->padding.right), contentSize.height + (float)(layoutConfig->padding.top + layoutConfig->padding.bottom) };
+                }
+            }
+        }
+        else {
+            // DFS is returning upwards backwards
+            bool closeClipElement = false;
+            Clay_ClipElementConfig *clipConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_CLIP).clipElementConfig;
+            if (clipConfig) {
+                closeClipElement = true;
+                for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
+                    Clay__ScrollContainerDataInternal *mapping = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
+                    if (mapping->layoutElement == currentElement) {
+                        scrollOffset = clipConfig->childOffset;
+                        if (context->externalScrollHandlingEnabled) {
+                            scrollOffset = CLAY__INIT(Clay_Vector2) CLAY__DEFAULT_STRUCT;
+                        }
+                        break;
+                    }
+                }
+            }
+
+            if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_BORDER)) {
+                Clay_LayoutElementHashMapItem *currentElementData = Clay__GetHashMapItem(currentElement->id);
+                Clay_BoundingBox currentElementBoundingBox = currentElementData->boundingBox;
 
-                        widthToAdd = CLAY__MIN(widthToAdd, sizeToDistribute / resizableContainerBuffer.length);
-
-                        for (int childIndex = 0; childIndex < resizableContainerBuffer.length; childIndex++) {
-                            Clay_LayoutElement *child = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&resizableContainerBuffer, childIndex));
-                            float *childSize = xAxis ? &child->dimensions.width : &child->dimensions.height;
-                            float maxSize = xAxis ? child->layoutConfig->sizing.width.size.minMax.max : child->layoutConfig->sizing.height.size.minMax.max;
-                            float previousWidth = *childSize;
-                            if (Clay__FloatEqual(*childSize, smallest)) {
-                                *childSize += widthToAdd;
-                                if (*childSize >= maxSize) {
-                                    *childSize = maxSize;
-                                    Clay__int32_tArray_RemoveSwapback(&resizableContainerBuffer, childIndex--);
+                // Culling - Don't bother to generate render commands for rectangles entirely outside the screen - this won't stop their children from being rendered if they overflow
+                if (!Clay__ElementIsOffscreen(&currentElementBoundingBox)) {
+                    Clay_SharedElementConfig *sharedConfig = Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SHARED) ? Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SHARED).sharedElementConfig : &Clay_SharedElementConfig_DEFAULT;
+                    Clay_BorderElementConfig *borderConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_BORDER).borderElementConfig;
+                    Clay_RenderCommand renderCommand = {
+                            .boundingBox = currentElementBoundingBox,
+                            .renderData = { .border = {
+                                .color = borderConfig->color,
+                                .cornerRadius = sharedConfig->cornerRadius,
+                                .width = borderConfig->width
+                            }},
+                            .userData = sharedConfig->userData,
+                            .id = Clay__HashNumber(currentElement->id, currentElement->childrenOrTextContent.children.length).id,
+                            .commandType = CLAY_RENDER_COMMAND_TYPE_BORDER,
+                    };
+                    Clay__AddRenderCommand(renderCommands, renderCommand);
+                    if (borderConfig->width.betweenChildren > 0 && borderConfig->color.a > 0) {
+                        float halfGap = layoutConfig->childGap / 2;
+                        Clay_Vector2 borderOffset = { (float)layoutConfig->padding.left - halfGap, (float)layoutConfig->padding.top - halfGap };
+                        if (layoutConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) {
+                            for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
+                                Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
+                                if (i > 0) {
+                                    Clay__AddRenderCommand(renderCommands, CLAY__INIT(Clay_RenderCommand) {
+                                        .boundingBox = { currentElementBoundingBox.x + borderOffset.x + scrollOffset.x, currentElementBoundingBox.y + scrollOffset.y, (float)borderConfig->width.betweenChildren, currentElement->dimensions.height },
+                                        .renderData = { .rectangle = {
+                                            .backgroundColor = borderConfig->color,
+                                        } },
+                                        .userData = sharedConfig->userData,
+                                        .id = Clay__HashNumber(currentElement->id, currentElement->childrenOrTextContent.children.length + 1 + i).id,
+                                        .commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE,
+                                    });
+                                }
+                                borderOffset.x += (childElement->dimensions.width + (float)layoutConfig->childGap);
+                            }
+                        } else {
+                            for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
+                                Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
+                                if (i > 0) {
+                                    Clay__AddRenderCommand(renderCommands, CLAY__INIT(Clay_RenderCommand) {
+                                        .boundingBox = { currentElementBoundingBox.x + scrollOffset.x, currentElementBoundingBox.y + borderOffset.y + scrollOffset.y, currentElement->dimensions.width, (float)borderConfig->width.betweenChildren },
+                                        .renderData = { .rectangle = {
+                                                .backgroundColor = borderConfig->color,
+                                        } },
+                                        .userData = sharedConfig->userData,
+                                        .id = Clay__HashNumber(currentElement->id, currentElement->childrenOrTextContent.children.length + 1 + i).id,
+                                        .commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE,
+                                    });
                                 }
-                                sizeToDistribute -= (*childSize - previousWidth);
+                                borderOffset.y += (childElement->dimensions.height + (float)layoutConfig->childGap);
                             }
                         }
                     }
                 }
-            // Sizing along the non layout axis ("off axis")
-            } else {
-                for (int32_t childOffset = 0; childOffset < resizableContainerBuffer.length; childOffset++) {
-                    Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&resizableContainerBuffer, childOffset));
-                    Clay_SizingAxis childSizing = xAxis ? childElement->layoutConfig->sizing.width : childElement->layoutConfig->sizing.height;
-                    float minSize = xAxis ? childElement->minDimensions.width : childElement->minDimensions.height;
-                    float *childSize = xAxis ? &childElement->dimensions.width : &childElement->dimensions.height;
-
-                    float maxSize = parentSize - parentPadding;
-                    // If we're laying out the children of a scroll panel, grow containers expand to the size of the inner content, not the outer container
-                    if (Clay__ElementHasConfig(parent, CLAY__ELEMENT_CONFIG_TYPE_CLIP)) {
-                        Clay_ClipElementConfig *clipElementConfig = Clay__FindElementConfigWithType(parent, CLAY__ELEMENT_CONFIG_TYPE_CLIP).clipElementConfig;
-                        if (((xAxis && clipElementConfig->horizontal) || (!xAxis && clipElementConfig->vertical))) {
-                            maxSize = CLAY__MAX(maxSize, innerContentSize);
-                        }
+            }
+            // This exists because the scissor needs to end _after_ borders between elements
+            if (closeClipElement) {
+                Clay__AddRenderCommand(renderCommands, CLAY__INIT(Clay_RenderCommand) {
+                    .id = Clay__HashNumber(currentElement->id, rootElement->childrenOrTextContent.children.length + 11).id,
+                    .commandType = CLAY_RENDER_COMMAND_TYPE_SCISSOR_END,
+                });
+            }
+
+            if (retainCommands && currentElement->retainedData) {
+                Clay__RetainedElementData *retainedData = currentElement->retainedData;
+                retainedData->renderCommandsCount = renderCommands->length - retainedData->renderCommandsStart;
+                retainedData->renderCommandsGeneration = context->retainedGeneration;
+                retainedData->zIndex = root->zIndex;
+                retainedData->rootChildCount = rootElement->childrenOrTextContent.children.length;
+            }
+
+            dfsBuffer.length--;
+            continue;
+        }
+
+        // Add children to the DFS buffer
+        if (!Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
+            dfsBuffer.length += currentElement->childrenOrTextContent.children.length;
+            for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
+                Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
+                // Alignment along non layout axis
+                if (layoutConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) {
+                    currentElementTreeNode->nextChildOffset.y = currentElement->layoutConfig->padding.top;
+                    float whiteSpaceAroundChild = currentElement->dimensions.height - (float)(layoutConfig->padding.top + layoutConfig->padding.bottom) - childElement->dimensions.height;
+                    switch (layoutConfig->childAlignment.y) {
+                        case CLAY_ALIGN_Y_TOP: break;
+                        case CLAY_ALIGN_Y_CENTER: currentElementTreeNode->nextChildOffset.y += whiteSpaceAroundChild / 2; break;
+                        case CLAY_ALIGN_Y_BOTTOM: currentElementTreeNode->nextChildOffset.y += whiteSpaceAroundChild; break;
                     }
-                    if (childSizing.type == CLAY__SIZING_TYPE_GROW) {
-                        *childSize = CLAY__MIN(maxSize, childSizing.size.minMax.max);
+                } else {
+                    currentElementTreeNode->nextChildOffset.x = currentElement->layoutConfig->padding.left;
+                    float whiteSpaceAroundChild = currentElement->dimensions.width - (float)(layoutConfig->padding.left + layoutConfig->padding.right) - childElement->dimensions.width;
+                    switch (layoutConfig->childAlignment.x) {
+                        case CLAY_ALIGN_X_LEFT: break;
+                        case CLAY_ALIGN_X_CENTER: currentElementTreeNode->nextChildOffset.x += whiteSpaceAroundChild / 2; break;
+                        case CLAY_ALIGN_X_RIGHT: currentElementTreeNode->nextChildOffset.x += whiteSpaceAroundChild; break;
                     }
-                    *childSize = CLAY__MAX(minSize, CLAY__MIN(*childSize, maxSize));
+                }
+
+                Clay_Vector2 childPosition = {
+                    currentElementTreeNode->position.x + currentElementTreeNode->nextChildOffset.x + scrollOffset.x,
+                    currentElementTreeNode->position.y + currentElementTreeNode->nextChildOffset.y + scrollOffset.y,
+                };
+
+                // DFS buffer elements need to be added in reverse because stack traversal happens backwards
+                uint32_t newNodeIndex = dfsBuffer.length - 1 - i;
+                dfsBuffer.internalArray[newNodeIndex] = CLAY__INIT(Clay__LayoutElementTreeNode) {
+                    .layoutElement = childElement,
+                    .position = { childPosition.x, childPosition.y },
+                    .nextChildOffset = { .x = (float)childElement->layoutConfig->padding.left, .y = (float)childElement->layoutConfig->padding.top },
+                };
+                treeNodeVisited[newNodeIndex] = false;
+
+                // Update parent offsets
+                if (layoutConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) {
+                    currentElementTreeNode->nextChildOffset.x += childElement->dimensions.width + (float)layoutConfig->childGap;
+                } else {
+                    currentElementTreeNode->nextChildOffset.y += childElement->dimensions.height + (float)layoutConfig->childGap;
                 }
             }
         }
     }
+
+    if (root->clipElementId) {
+        Clay__AddRenderCommand(renderCommands, CLAY__INIT(Clay_RenderCommand) { .id = Clay__HashNumber(rootElement->id, rootElement->childrenOrTextContent.children.length + 11).id, .commandType = CLAY_RENDER_COMMAND_TYPE_SCISSOR_END });
+    }
 }
 
-Clay_String Clay__IntToString(int32_t integer) {
-    if (integer == 0) {
-        return CLAY__INIT(Clay_String) { .length = 1, .chars = "0" };
+// Parallel tree roots ---------------------
+// With a parallel for function set, the sizing and positioning passes run the independent tree roots (floating
+// tooltips, menus etc) of a layout at the same time. A root only ever writes to its own elements, so the one thing that
+// orders two roots is a floating root reading the element it is attached to (or clipped by) in another root. Roots are
+// grouped into waves that keep every such read on the same side of the write as the serial pass, and the waves run one
+// after another. Every root gets its own slice of the scratch buffers and of the render command array, so the result is
+// identical to the serial path.
+
+typedef struct {
+    Clay_Context *context;
+    int32_t *rootIndexes;
+    bool positioning;
+    bool xAxis;
+} Clay__TreeRootTask;
+
+int32_t Clay__ElementRenderCommandBound(Clay_LayoutElement *element) {
+    int32_t bound = 1; // Background rectangle
+    for (int32_t i = 0; i < element->elementConfigs.length; ++i) {
+        Clay_ElementConfig *config = Clay__ElementConfigArraySlice_Get(&element->elementConfigs, i);
+        switch (config->type) {
+            case CLAY__ELEMENT_CONFIG_TYPE_CLIP: bound += 2; break;
+            case CLAY__ELEMENT_CONFIG_TYPE_IMAGE:
+            case CLAY__ELEMENT_CONFIG_TYPE_CUSTOM: bound += 1; break;
+            case CLAY__ELEMENT_CONFIG_TYPE_TEXT: bound += element->childrenOrTextContent.textElementData->wrappedLines.length; break;
+            case CLAY__ELEMENT_CONFIG_TYPE_BORDER: bound += CLAY__MAX(element->childrenOrTextContent.children.length, 1); break;
+            default: break;
+        }
     }
+    return bound;
+}
+
+// Returns the index in layoutElementTreeRoots of the root that contains the element with this id, or -1
+int32_t Clay__TreeRootContainingElement(uint32_t id, int32_t *rootPositions) {
     Clay_Context* context = Clay_GetCurrentContext();
-    char *chars = (char *)(context->dynamicStringData.internalArray + context->dynamicStringData.length);
-    int32_t length = 0;
-    int32_t sign = integer;
+    Clay_LayoutElement *element = Clay__GetHashMapItem(id)->layoutElement;
+    if (!element) {
+        return -1;
+    }
+    int32_t rootIndex = context->reusableElementIndexBuffer.internalArray[element - context->layoutElements.internalArray];
+    return rootIndex < 0 || !rootPositions ? rootIndex : rootPositions[rootIndex];
+}
 
-    if (integer < 0) {
-        integer = -integer;
+// Assigns each root to a wave for the sizing pass (in declaration order) or the positioning pass (in z order).
+// For positioning this also lays out the render command slices, and returns false if they wouldn't fit.
+bool Clay__ScheduleTreeRoots(bool positioning) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    int32_t *rootPositions = CLAY__NULL;
+    if (positioning) {
+        // Roots have been sorted by z index since they were numbered, map declaration order to the new positions
+        rootPositions = context->layoutElementChildrenBuffer.internalArray;
+        for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+            rootPositions[Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex)->declarationIndex] = rootIndex;
+        }
+        for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+            Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex)->renderCommandCount = 2; // Root clip scissor start and end
+        }
+        for (int32_t i = 0; i < context->layoutElements.length; ++i) {
+            int32_t rootIndex = context->reusableElementIndexBuffer.internalArray[i];
+            if (rootIndex >= 0) {
+                Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootPositions[rootIndex])->renderCommandCount += Clay__ElementRenderCommandBound(Clay_LayoutElementArray_Get(&context->layoutElements, i));
+            }
+        }
     }
-    while (integer > 0) {
-        chars[length++] = (char)(integer % 10 + '0');
-        integer /= 10;
+    int32_t renderCommandOffset = 0;
+    for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+        Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex)->wave = 0;
     }
+    for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+        Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex);
+        Clay_LayoutElement *rootElement = Clay_LayoutElementArray_Get(&context->layoutElements, root->layoutElementIndex);
+        int32_t dependencies[2] = { -1, -1 };
+        if (Clay__ElementHasConfig(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING)) {
+            uint32_t parentId = positioning ? root->parentId : Clay__FindElementConfigWithType(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig->parentId;
+            dependencies[0] = Clay__TreeRootContainingElement(parentId, rootPositions);
+        }
+        if (positioning && root->clipElementId) {
+            dependencies[1] = Clay__TreeRootContainingElement(root->clipElementId, rootPositions);
+        }
+        // Roots earlier in the pass have already written what this one reads, so it has to come after them
+        for (int32_t i = 0; i < 2; ++i) {
+            if (dependencies[i] >= 0 && dependencies[i] < rootIndex) {
+                root->wave = CLAY__MAX(root->wave, Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, dependencies[i])->wave + 1);
+            }
+        }
+        // Roots later in the pass haven't yet, so they have to wait for this one
+        for (int32_t i = 0; i < 2; ++i) {
+            if (dependencies[i] > rootIndex) {
+                Clay__LayoutElementTreeRoot *dependency = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, dependencies[i]);
+                dependency->wave = CLAY__MAX(dependency->wave, root->wave + 1);
+            }
+        }
+        if (positioning) {
+            root->renderCommandOffset = renderCommandOffset;
+            renderCommandOffset += root->renderCommandCount;
+        }
+    }
+    return renderCommandOffset < context->renderCommands.capacity;
+}
 
-    if (sign < 0) {
-        chars[length++] = '-';
+// Records which root each element belongs to and gives each root a slice of the scratch buffers.
+// Returns false if two elements share a hash map item, as both roots would write its bounding box.
+bool Clay__PrepareParallelTreeRoots(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    int32_t *elementRoots = context->reusableElementIndexBuffer.internalArray;
+    for (int32_t i = 0; i < context->layoutElements.length; ++i) {
+        elementRoots[i] = -1;
     }
+    Clay__int32_tArray stack = context->layoutElementChildrenBuffer;
+    int32_t elementOffset = 0;
+    for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+        Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex);
+        root->declarationIndex = rootIndex;
+        root->elementOffset = elementOffset;
+        stack.length = 0;
+        Clay__int32_tArray_Add(&stack, root->layoutElementIndex);
+        while (stack.length > 0) {
+            int32_t elementIndex = stack.internalArray[--stack.length];
+            Clay_LayoutElement *element = Clay_LayoutElementArray_Get(&context->layoutElements, elementIndex);
+            if (Clay__GetHashMapItem(element->id)->layoutElement != element) {
+                return false;
+            }
+            elementRoots[elementIndex] = rootIndex;
+            elementOffset++;
+            if (!Clay__ElementHasConfig(element, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
+                for (int32_t i = 0; i < element->childrenOrTextContent.children.length; ++i) {
+                    Clay__int32_tArray_Add(&stack, element->childrenOrTextContent.children.elements[i]);
+                }
+            }
+        }
+        root->elementCount = elementOffset - root->elementOffset;
+    }
+    return Clay__ScheduleTreeRoots(false);
+}
 
-    // Reverse the string to get the correct order
-    for (int32_t j = 0, k = length - 1; j < k; j++, k--) {
-        char temp = chars[j];
-        chars[j] = chars[k];
-        chars[k] = temp;
+void Clay__RunTreeRootTask(int32_t index, void *taskData) {
+    Clay__TreeRootTask *task = (Clay__TreeRootTask *)taskData;
+    Clay_Context* context = task->context;
+    Clay_Context* previousContext = Clay_GetCurrentContext();
+    if (previousContext != context) {
+        Clay_SetCurrentContext(context);
+    }
+    Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, task->rootIndexes[index]);
+    if (task->positioning) {
+        Clay__LayoutElementTreeNodeArray dfsBuffer = { .capacity = root->elementCount, .length = 0, .internalArray = context->layoutElementTreeNodeArray1.internalArray + root->elementOffset };
+        Clay_RenderCommandArray renderCommands = { .capacity = root->renderCommandCount + 1, .length = 0, .internalArray = context->renderCommands.internalArray + root->renderCommandOffset };
+        Clay__PositionTreeRoot(root, dfsBuffer, context->treeNodeVisited.internalArray + root->elementOffset, &renderCommands);
+        root->renderCommandCount = renderCommands.length;
+    } else {
+        Clay__int32_tArray bfsBuffer = { .capacity = root->elementCount, .length = 0, .internalArray = context->layoutElementChildrenBuffer.internalArray + root->elementOffset };
+        Clay__SizeTreeRootAlongAxis(root, task->xAxis, bfsBuffer, Clay__SizingBlockAt(root->elementOffset));
+    }
+    if (previousContext != context) {
+        Clay_SetCurrentContext(previousContext);
     }
-    context->dynamicStringData.length += length;
-    return CLAY__INIT(Clay_String) { .length = length, .chars = chars };
 }
 
-void Clay__AddRenderCommand(Clay_RenderCommand renderCommand) {
+void Clay__RunTreeRootWaves(bool positioning, bool xAxis) {
     Clay_Context* context = Clay_GetCurrentContext();
-    if (context->renderCommands.length < context->renderCommands.capacity - 1) {
-        Clay_RenderCommandArray_Add(&context->renderCommands, renderCommand);
-    } else {
-        if (!context->booleanWarnings.maxRenderCommandsExceeded) {
-            context->booleanWarnings.maxRenderCommandsExceeded = true;
-            context->errorHandler.errorHandlerFunction(CLAY__INIT(Clay_ErrorData) {
-                .errorType = CLAY_ERROR_TYPE_ELEMENTS_CAPACITY_EXCEEDED,
-                .errorText = CLAY_STRING("Clay ran out of capacity while attempting to create render commands. This is usually caused by a large amount of wrapping text elements while close to the max element capacity. Try using Clay_SetMaxElementCount() with a higher value."),
-                .userData = context->errorHandler.userData });
+    Clay__TreeRootTask task = { .context = context, .rootIndexes = context->treeRootWave.internalArray, .positioning = positioning, .xAxis = xAxis };
+    bool remaining = true;
+    for (int32_t wave = 0; remaining; ++wave) {
+        int32_t count = 0;
+        remaining = false;
+        for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+            int32_t rootWave = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex)->wave;
+            if (rootWave == wave) {
+                task.rootIndexes[count++] = rootIndex;
+            }
+            remaining = remaining || rootWave > wave;
+        }
+        if (count == 1) {
+            Clay__RunTreeRootTask(0, &task);
+        } else if (count > 1) {
+            context->parallelForFunction(count, Clay__RunTreeRootTask, &task, context->parallelForUserData);
         }
     }
 }
 
-bool Clay__ElementIsOffscreen(Clay_BoundingBox *boundingBox) {
+void Clay__SizeContainersAlongAxis(bool xAxis, bool parallel) {
     Clay_Context* context = Clay_GetCurrentContext();
-    if (context->disableCulling) {
-        return false;
+    if (parallel) {
+        Clay__RunTreeRootWaves(false, xAxis);
+        return;
+    }
+    for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+        Clay__SizeTreeRootAlongAxis(Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex), xAxis, context->layoutElementChildrenBuffer, Clay__SizingBlockAt(0));
     }
-
-    return (boundingBox->x > (float)context->layoutDimensions.width) ||
-           (boundingBox->y > (float)context->layoutDimensions.height) ||
-           (boundingBox->x + boundingBox->width < 0) ||
-           (boundingBox->y + boundingBox->height < 0);
 }
 
 void Clay__CalculateFinalLayout(void) {
     Clay_Context* context = Clay_GetCurrentContext();
+    bool parallel = context->parallelForFunction && context->layoutElementTreeRoots.length > 1 && Clay__PrepareParallelTreeRoots();
+    bool captureRetainedLayout = false;
+    if (context->retainedLayoutEnabled) {
+        // A frame that ran out of elements neither reuses nor records anything
+        context->retainedGeneration += context->booleanWarnings.maxElementsExceeded ? 2 : 1;
+        captureRetainedLayout = !context->booleanWarnings.maxElementsExceeded;
+    }
     // Calculate sizing along the X axis
-    Clay__SizeContainersAlongAxis(true);
+    Clay__SizeContainersAlongAxis(true, parallel);
+
+    if (captureRetainedLayout) {
+        for (int32_t i = 0; i < context->layoutElements.length; ++i) {
+            Clay_LayoutElement *layoutElement = Clay_LayoutElementArray_Get(&context->layoutElements, i);
+            if (layoutElement->retainedData) {
+                layoutElement->retainedData->sizedDimensions = layoutElement->dimensions;
+            }
+        }
+    }
 
     // Wrap text
     for (int32_t textElementIndex = 0; textElementIndex < context->textElementData.length; ++textElementIndex) {
@@ -2539,7 +4751,24 @@ void Clay__CalculateFinalLayout(void) {
         textElementData->wrappedLines = CLAY__INIT(Clay__WrappedTextLineArraySlice) { .length = 0, .internalArray = &context->wrappedTextLines.internalArray[context->wrappedTextLines.length] };
         Clay_LayoutElement *containerElement = Clay_LayoutElementArray_Get(&context->layoutElements, (int)textElementData->elementIndex);
         Clay_TextElementConfig *textConfig = Clay__FindElementConfigWithType(containerElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT).textElementConfig;
-        Clay__MeasureTextCacheItem *measureTextCacheItem = Clay__MeasureTextCached(&textElementData->text, textConfig);
+        if (containerElement->retainedState == CLAY__RETAINED_STATE_SIZED_X) { // Same text and width as last frame, so the same lines
+            Clay__RetainedElementData *retainedData = containerElement->retainedData;
+            for (int32_t i = 0; i < retainedData->wrappedLinesCount && context->wrappedTextLines.length < context->wrappedTextLines.capacity; ++i) {
+                Clay__WrappedTextLineArray_Add(&context->wrappedTextLines, context->previousWrappedTextLines.internalArray[retainedData->wrappedLinesStart + i]);
+                textElementData->wrappedLines.length++;
+            }
+            containerElement->dimensions.height = (textConfig->lineHeight > 0 ? (float)textConfig->lineHeight : textElementData->preferredDimensions.height) * (float)textElementData->wrappedLines.length;
+            continue;
+        }
+        // Texts declared later may have evicted the item found at declaration, in which case it's measured again
+        int32_t measureTextCacheItemIndex = textElementData->measureTextCacheItemIndex;
+        Clay__MeasureTextCacheItem *measureTextCacheItem = &context->measureTextHashMapInternal.internalArray[measureTextCacheItemIndex];
+        if (measureTextCacheItemIndex == 0) {
+            measureTextCacheItem = &Clay__MeasureTextCacheItem_DEFAULT;
+        } else if (measureTextCacheItem->id != textElementData->measureTextCacheItemId) {
+            measureTextCacheItem = Clay__MeasureTextCached(&textElementData->text, textConfig);
+            measureTextCacheItemIndex = measureTextCacheItem == &Clay__MeasureTextCacheItem_DEFAULT ? 0 : (int32_t)(measureTextCacheItem - context->measureTextHashMapInternal.internalArray);
+        }
         float lineWidth = 0;
         float lineHeight = textConfig->lineHeight > 0 ? (float)textConfig->lineHeight : textElementData->preferredDimensions.height;
         int32_t lineLengthChars = 0;
@@ -2549,45 +4778,76 @@ void Clay__CalculateFinalLayout(void) {
             textElementData->wrappedLines.length++;
             continue;
         }
-        float spaceWidth = Clay__MeasureText(CLAY__INIT(Clay_StringSlice) { .length = 1, .chars = CLAY__SPACECHAR.chars, .baseChars = CLAY__SPACECHAR.chars }, textConfig, context->measureTextUserData).width;
-        int32_t wordIndex = measureTextCacheItem->measuredWordsStartIndex;
-        while (wordIndex != -1) {
+        if (measureTextCacheItem->wrappedLinesCount > 0 && measureTextCacheItem->wrappedWidth == containerElement->dimensions.width) {
+            for (int32_t i = 0; i < measureTextCacheItem->wrappedLinesCount && context->wrappedTextLines.length < context->wrappedTextLines.capacity; ++i) {
+                int32_t lineIndex = measureTextCacheItem->wrappedLinesStart + i;
+                Clay_String line = { .length = context->measuredWordLengths.internalArray[lineIndex], .chars = &textElementData->text.chars[context->measuredWordStartOffsets.internalArray[lineIndex]] };
+                Clay__WrappedTextLineArray_Add(&context->wrappedTextLines, CLAY__INIT(Clay__WrappedTextLine) { { context->measuredWordWidths.internalArray[lineIndex], lineHeight }, line });
+                textElementData->wrappedLines.length++;
+            }
+            containerElement->dimensions.height = lineHeight * (float)textElementData->wrappedLines.length;
+            continue;
+        }
+        float spaceWidth = measureTextCacheItem->spaceWidth;
+        // The words are contiguous, so wrapping is a linear scan of three arrays
+        const int32_t *wordStartOffsets = &context->measuredWordStartOffsets.internalArray[measureTextCacheItem->measuredWordsStart];
+        const int32_t *wordLengths = &context->measuredWordLengths.internalArray[measureTextCacheItem->measuredWordsStart];
+        const float *wordWidths = &context->measuredWordWidths.internalArray[measureTextCacheItem->measuredWordsStart];
+        int32_t wordIndex = 0;
+        while (wordIndex < measureTextCacheItem->measuredWordsCount) {
             if (context->wrappedTextLines.length > context->wrappedTextLines.capacity - 1) {
                 break;
             }
-            Clay__MeasuredWord *measuredWord = Clay__MeasuredWordArray_Get(&context->measuredWords, wordIndex);
+            int32_t wordStartOffset = wordStartOffsets[wordIndex];
+            int32_t wordLength = wordLengths[wordIndex];
+            float wordWidth = wordWidths[wordIndex];
             // Only word on the line is too large, just render it anyway
-            if (lineLengthChars == 0 && lineWidth + measuredWord->width > containerElement->dimensions.width) {
-                Clay__WrappedTextLineArray_Add(&context->wrappedTextLines, CLAY__INIT(Clay__WrappedTextLine) { { measuredWord->width, lineHeight }, { .length = measuredWord->length, .chars = &textElementData->text.chars[measuredWord->startOffset] } });
+            if (lineLengthChars == 0 && lineWidth + wordWidth > containerElement->dimensions.width) {
+                Clay__WrappedTextLineArray_Add(&context->wrappedTextLines, CLAY__INIT(Clay__WrappedTextLine) { { wordWidth, lineHeight }, { .length = wordLength, .chars = &textElementData->text.chars[wordStartOffset] } });
                 textElementData->wrappedLines.length++;
-                wordIndex = measuredWord->next;
-                lineStartOffset = measuredWord->startOffset + measuredWord->length;
+                wordIndex++;
+                lineStartOffset = wordStartOffset + wordLength;
             }
-            // measuredWord->length == 0 means a newline character
-            else if (measuredWord->length == 0 || lineWidth + measuredWord->width > containerElement->dimensions.width) {
+            // wordLength == 0 means a newline character
+            else if (wordLength == 0 || lineWidth + wordWidth > containerElement->dimensions.width) {
                 // Wrapped text lines list has overflowed, just render out the line
                 bool finalCharIsSpace = textElementData->text.chars[CLAY__MAX(lineStartOffset + lineLengthChars - 1, 0)] == ' ';
                 Clay__WrappedTextLineArray_Add(&context->wrappedTextLines, CLAY__INIT(Clay__WrappedTextLine) { { lineWidth + (finalCharIsSpace ? -spaceWidth : 0), lineHeight }, { .length = lineLengthChars + (finalCharIsSpace ? -1 : 0), .chars = &textElementData->text.chars[lineStartOffset] } });
                 textElementData->wrappedLines.length++;
-                if (lineLengthChars == 0 || measuredWord->length == 0) {
-                    wordIndex = measuredWord->next;
+                if (lineLengthChars == 0 || wordLength == 0) {
+                    wordIndex++;
                 }
                 lineWidth = 0;
                 lineLengthChars = 0;
-                lineStartOffset = measuredWord->startOffset;
+                lineStartOffset = wordStartOffset;
             } else {
-                lineWidth += measuredWord->width + textConfig->letterSpacing;
-                lineLengthChars += measuredWord->length;
-                wordIndex = measuredWord->next;
+                lineWidth += wordWidth + textConfig->letterSpacing;
+                lineLengthChars += wordLength;
+                wordIndex++;
             }
         }
         if (lineLengthChars > 0) {
             Clay__WrappedTextLineArray_Add(&context->wrappedTextLines, CLAY__INIT(Clay__WrappedTextLine) { { lineWidth - textConfig->letterSpacing, lineHeight }, {.length = lineLengthChars, .chars = &textElementData->text.chars[lineStartOffset] } });
             textElementData->wrappedLines.length++;
         }
+        // Lines cut short by a full wrappedTextLines array aren't kept
+        if (measureTextCacheItemIndex != 0 && context->wrappedTextLines.length < context->wrappedTextLines.capacity) {
+            Clay__CacheWrappedLines(context, measureTextCacheItemIndex, &textElementData->text, textElementData->wrappedLines, containerElement->dimensions.width);
+        }
         containerElement->dimensions.height = lineHeight * (float)textElementData->wrappedLines.length;
     }
 
+    if (captureRetainedLayout) {
+        for (int32_t i = 0; i < context->textElementData.length; ++i) {
+            Clay__TextElementData *textElementData = Clay__TextElementDataArray_Get(&context->textElementData, i);
+            Clay__RetainedElementData *retainedData = Clay_LayoutElementArray_Get(&context->layoutElements, textElementData->elementIndex)->retainedData;
+            if (retainedData) {
+                retainedData->wrappedLinesStart = (int32_t)(textElementData->wrappedLines.internalArray - context->wrappedTextLines.internalArray);
+                retainedData->wrappedLinesCount = textElementData->wrappedLines.length;
+            }
+        }
+    }
+
     // Scale vertical heights according to aspect ratio
     for (int32_t i = 0; i < context->aspectRatioElementIndexes.length; ++i) {
         Clay_LayoutElement* aspectElement = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&context->aspectRatioElementIndexes, i));
@@ -2645,7 +4905,18 @@ void Clay__CalculateFinalLayout(void) {
     }
 
     // Calculate sizing along the Y axis
-    Clay__SizeContainersAlongAxis(false);
+    Clay__SizeContainersAlongAxis(false, parallel);
+
+    if (captureRetainedLayout) {
+        for (int32_t i = 0; i < context->layoutElements.length; ++i) {
+            Clay_LayoutElement *layoutElement = Clay_LayoutElementArray_Get(&context->layoutElements, i);
+            if (layoutElement->retainedData) {
+                layoutElement->retainedData->finalDimensions = layoutElement->dimensions;
+                layoutElement->retainedData->structureHash = layoutElement->structureHash;
+                layoutElement->retainedData->generation = context->retainedGeneration;
+            }
+        }
+    }
 
     // Scale horizontal widths according to aspect ratio
     for (int32_t i = 0; i < context->aspectRatioElementIndexes.length; ++i) {
@@ -2670,479 +4941,248 @@ void Clay__CalculateFinalLayout(void) {
 
     // Calculate final positions and generate render commands
     context->renderCommands.length = 0;
-    dfsBuffer.length = 0;
-    for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+    if (parallel && Clay__ScheduleTreeRoots(true)) {
+        Clay__RunTreeRootWaves(true, false);
+        // Each root wrote into its own slice of the render command array, close the gaps between them in z order
+        for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+            Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex);
+            for (int32_t i = 0; i < root->renderCommandCount; ++i) {
+                context->renderCommands.internalArray[context->renderCommands.length++] = context->renderCommands.internalArray[root->renderCommandOffset + i];
+            }
+        }
+    } else {
+        for (int32_t rootIndex = 0; rootIndex < context->layoutElementTreeRoots.length; ++rootIndex) {
+            Clay__PositionTreeRoot(Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex), context->layoutElementTreeNodeArray1, context->treeNodeVisited.internalArray, &context->renderCommands);
+        }
+    }
+    if (context->retainedLayoutEnabled) {
+        if (context->booleanWarnings.maxRenderCommandsExceeded) { // Recorded command ranges are missing whatever didn't fit
+            context->retainedGeneration++;
+        }
+        context->retainedLayoutDimensions = context->layoutDimensions;
+        // A floating root positioned before the element it attaches to was placed against that element's box from the
+        // frame before, so laying out the same declarations again can still move it
+        bool settled = captureRetainedLayout;
+        for (int32_t i = 0; i < context->layoutElementTreeRoots.length && settled; ++i) {
+            Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, i);
+            settled = Clay__BoundingBoxEqual(root->parentBoundingBox, Clay__GetHashMapItem(root->parentId)->boundingBox)
+                && Clay__BoundingBoxEqual(root->clipBoundingBox, Clay__GetHashMapItem(root->clipElementId)->boundingBox);
+        }
+        context->previousDeclarationHash = settled ? context->declarationHash : 0;
+        context->previousDeclarationGeneration = context->retainedGeneration;
+    }
+}
+
+// If every element was declared exactly as in the last frame that was laid out, and nothing else that affects layout has
+// changed since, puts that frame's results back in place rather than laying it out again
+bool Clay__RepeatPreviousLayout(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    if (!context->retainedLayoutEnabled
+        || context->booleanWarnings.maxElementsExceeded
+        || !context->declarationHash
+        || context->declarationHash != context->previousDeclarationHash
+        || context->previousDeclarationGeneration != context->retainedGeneration
+        || context->retainedLayoutDimensions.width != context->layoutDimensions.width
+        || context->retainedLayoutDimensions.height != context->layoutDimensions.height) {
+        return false;
+    }
+    // Undo the swap in Clay_BeginLayout, the retained generation is left alone so last frame's data stays current
+    Clay__WrappedTextLineArray wrappedTextLines = context->previousWrappedTextLines;
+    context->previousWrappedTextLines = context->wrappedTextLines;
+    context->wrappedTextLines = wrappedTextLines;
+    Clay_RenderCommandArray renderCommands = context->previousRenderCommands;
+    context->previousRenderCommands = context->renderCommands;
+    context->renderCommands = renderCommands;
+    // Scroll containers and the debug view read final dimensions after layout
+    for (int32_t i = 0; i < context->layoutElements.length; ++i) {
+        Clay_LayoutElement *layoutElement = Clay_LayoutElementArray_Get(&context->layoutElements, i);
+        layoutElement->dimensions = layoutElement->retainedData->finalDimensions;
+    }
+    for (int32_t i = 0; i < context->aspectRatioElementIndexes.length; ++i) {
+        Clay_LayoutElement* aspectElement = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&context->aspectRatioElementIndexes, i));
+        aspectElement->dimensions.width = Clay__FindElementConfigWithType(aspectElement, CLAY__ELEMENT_CONFIG_TYPE_ASPECT).aspectRatioElementConfig->aspectRatio * aspectElement->dimensions.height;
+    }
+    for (int32_t i = 0; i < context->textElementData.length; ++i) {
+        Clay__TextElementData *textElementData = Clay__TextElementDataArray_Get(&context->textElementData, i);
+        Clay__RetainedElementData *retainedData = Clay_LayoutElementArray_Get(&context->layoutElements, textElementData->elementIndex)->retainedData;
+        textElementData->wrappedLines = CLAY__INIT(Clay__WrappedTextLineArraySlice) { .length = retainedData->wrappedLinesCount, .internalArray = &context->wrappedTextLines.internalArray[retainedData->wrappedLinesStart] };
+    }
+    return true;
+}
+
+bool Clay__PointIsInsideArea(Clay_Vector2 point, Clay_Vector2 min, Clay_Vector2 max) {
+    return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y;
+}
+
+// Flattens the last layout into pointer hit test entries. This is the walk Clay_SetPointerState used to make on every
+// call, with each element's subtree bounds gathered into its parent as the walk leaves it.
+void Clay__BuildPointerHitTest(Clay_Context *context) {
+    Clay__PointerHitTestEntryArray *entries = &context->pointerHitTestEntries;
+    entries->length = 0;
+    Clay__int32_tArray dfsBuffer = context->layoutElementChildrenBuffer;
+    // Parallel to dfsBuffer, the parent's entry until an element is visited, then its own
+    int32_t *entryStack = context->pointerHitTestEntryStack.internalArray;
+    for (int32_t rootIndex = context->layoutElementTreeRoots.length - 1; rootIndex >= 0; --rootIndex) {
         dfsBuffer.length = 0;
         Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex);
-        Clay_LayoutElement *rootElement = Clay_LayoutElementArray_Get(&context->layoutElements, (int)root->layoutElementIndex);
-        Clay_Vector2 rootPosition = CLAY__DEFAULT_STRUCT;
-        Clay_LayoutElementHashMapItem *parentHashMapItem = Clay__GetHashMapItem(root->parentId);
-        // Position root floating containers
-        if (Clay__ElementHasConfig(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING) && parentHashMapItem) {
-            Clay_FloatingElementConfig *config = Clay__FindElementConfigWithType(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig;
-            Clay_Dimensions rootDimensions = rootElement->dimensions;
-            Clay_BoundingBox parentBoundingBox = parentHashMapItem->boundingBox;
-            // Set X position
-            Clay_Vector2 targetAttachPosition = CLAY__DEFAULT_STRUCT;
-            switch (config->attachPoints.parent) {
-                case CLAY_ATTACH_POINT_LEFT_TOP:
-                case CLAY_ATTACH_POINT_LEFT_CENTER:
-                case CLAY_ATTACH_POINT_LEFT_BOTTOM: targetAttachPosition.x = parentBoundingBox.x; break;
-                case CLAY_ATTACH_POINT_CENTER_TOP:
-                case CLAY_ATTACH_POINT_CENTER_CENTER:
-                case CLAY_ATTACH_POINT_CENTER_BOTTOM: targetAttachPosition.x = parentBoundingBox.x + (parentBoundingBox.width / 2); break;
-                case CLAY_ATTACH_POINT_RIGHT_TOP:
-                case CLAY_ATTACH_POINT_RIGHT_CENTER:
-                case CLAY_ATTACH_POINT_RIGHT_BOTTOM: targetAttachPosition.x = parentBoundingBox.x + parentBoundingBox.width; break;
+        Clay__int32_tArray_Add(&dfsBuffer, (int32_t)root->layoutElementIndex);
+        context->treeNodeVisited.internalArray[0] = false;
+        entryStack[0] = -1;
+        while (dfsBuffer.length > 0) {
+            if (context->treeNodeVisited.internalArray[dfsBuffer.length - 1]) {
+                Clay__PointerHitTestEntry *entry = &entries->internalArray[entryStack[dfsBuffer.length - 1]];
+                entry->subtreeEnd = entries->length;
+                if (entry->parent != -1) {
+                    Clay__PointerHitTestEntry *parent = &entries->internalArray[entry->parent];
+                    parent->subtreeMin.x = CLAY__MIN(parent->subtreeMin.x, entry->subtreeMin.x);
+                    parent->subtreeMin.y = CLAY__MIN(parent->subtreeMin.y, entry->subtreeMin.y);
+                    parent->subtreeMax.x = CLAY__MAX(parent->subtreeMax.x, entry->subtreeMax.x);
+                    parent->subtreeMax.y = CLAY__MAX(parent->subtreeMax.y, entry->subtreeMax.y);
+                }
+                dfsBuffer.length--;
+                continue;
             }
-            switch (config->attachPoints.element) {
-                case CLAY_ATTACH_POINT_LEFT_TOP:
-                case CLAY_ATTACH_POINT_LEFT_CENTER:
-                case CLAY_ATTACH_POINT_LEFT_BOTTOM: break;
-                case CLAY_ATTACH_POINT_CENTER_TOP:
-                case CLAY_ATTACH_POINT_CENTER_CENTER:
-                case CLAY_ATTACH_POINT_CENTER_BOTTOM: targetAttachPosition.x -= (rootDimensions.width / 2); break;
-                case CLAY_ATTACH_POINT_RIGHT_TOP:
-                case CLAY_ATTACH_POINT_RIGHT_CENTER:
-                case CLAY_ATTACH_POINT_RIGHT_BOTTOM: targetAttachPosition.x -= rootDimensions.width; break;
+            context->treeNodeVisited.internalArray[dfsBuffer.length - 1] = true;
+            Clay_LayoutElement *currentElement = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&dfsBuffer, (int)dfsBuffer.length - 1));
+            Clay_LayoutElementHashMapItem *mapItem = Clay__GetHashMapItem(currentElement->id);
+            int32_t clipElementId = Clay__int32_tArray_GetValue(&context->layoutElementClipElementIds, (int32_t)(currentElement - context->layoutElements.internalArray));
+            // Filled in place, copying a whole entry in per element was the largest part of the build
+            Clay__PointerHitTestEntry *entry = &entries->internalArray[entries->length];
+            entry->parent = entryStack[dfsBuffer.length - 1];
+            entry->hashMapItemIndex = (int32_t)(mapItem - context->layoutElementsHashMapInternal.internalArray);
+            entry->rootIndex = rootIndex;
+            entryStack[dfsBuffer.length - 1] = entries->length++;
+            Clay_BoundingBox box = mapItem->boundingBox;
+            Clay_Vector2 min = { box.x - root->pointerOffset.x, box.y - root->pointerOffset.y };
+            Clay_Vector2 max = { min.x + box.width, min.y + box.height };
+            if (clipElementId != 0 && !context->externalScrollHandlingEnabled) {
+                Clay_BoundingBox clipBox = Clay__GetHashMapItem(clipElementId)->boundingBox;
+                min.x = CLAY__MAX(min.x, clipBox.x);
+                min.y = CLAY__MAX(min.y, clipBox.y);
+                max.x = CLAY__MIN(max.x, clipBox.x + clipBox.width);
+                max.y = CLAY__MIN(max.y, clipBox.y + clipBox.height);
             }
-            switch (config->attachPoints.parent) { // I know I could merge the x and y switch statements, but this is easier to read
-                case CLAY_ATTACH_POINT_LEFT_TOP:
-                case CLAY_ATTACH_POINT_RIGHT_TOP:
-                case CLAY_ATTACH_POINT_CENTER_TOP: targetAttachPosition.y = parentBoundingBox.y; break;
-                case CLAY_ATTACH_POINT_LEFT_CENTER:
-                case CLAY_ATTACH_POINT_CENTER_CENTER:
-                case CLAY_ATTACH_POINT_RIGHT_CENTER: targetAttachPosition.y = parentBoundingBox.y + (parentBoundingBox.height / 2); break;
-                case CLAY_ATTACH_POINT_LEFT_BOTTOM:
-                case CLAY_ATTACH_POINT_CENTER_BOTTOM:
-                case CLAY_ATTACH_POINT_RIGHT_BOTTOM: targetAttachPosition.y = parentBoundingBox.y + parentBoundingBox.height; break;
+            if (mapItem == &Clay_LayoutElementHashMapItem_DEFAULT || !(min.x <= max.x && min.y <= max.y)) {
+                entry->min = entry->subtreeMin = CLAY__INIT(Clay_Vector2) { CLAY__MAXFLOAT, CLAY__MAXFLOAT };
+                entry->max = entry->subtreeMax = CLAY__INIT(Clay_Vector2) { -CLAY__MAXFLOAT, -CLAY__MAXFLOAT };
+            } else {
+                entry->min = entry->subtreeMin = min;
+                entry->max = entry->subtreeMax = max;
             }
-            switch (config->attachPoints.element) {
-                case CLAY_ATTACH_POINT_LEFT_TOP:
-                case CLAY_ATTACH_POINT_RIGHT_TOP:
-                case CLAY_ATTACH_POINT_CENTER_TOP: break;
-                case CLAY_ATTACH_POINT_LEFT_CENTER:
-                case CLAY_ATTACH_POINT_CENTER_CENTER:
-                case CLAY_ATTACH_POINT_RIGHT_CENTER: targetAttachPosition.y -= (rootDimensions.height / 2); break;
-                case CLAY_ATTACH_POINT_LEFT_BOTTOM:
-                case CLAY_ATTACH_POINT_CENTER_BOTTOM:
-                case CLAY_ATTACH_POINT_RIGHT_BOTTOM: targetAttachPosition.y -= rootDimensions.height; break;
+            if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
+                continue;
             }
-            targetAttachPosition.x += config->offset.x;
-            targetAttachPosition.y += config->offset.y;
-            rootPosition = targetAttachPosition;
-        }
-        if (root->clipElementId) {
-            Clay_LayoutElementHashMapItem *clipHashMapItem = Clay__GetHashMapItem(root->clipElementId);
-            if (clipHashMapItem) {
-                // Floating elements that are attached to scrolling contents won't be correctly positioned if external scroll handling is enabled, fix here
-                if (context->externalScrollHandlingEnabled) {
-                    Clay_ClipElementConfig *clipConfig = Clay__FindElementConfigWithType(clipHashMapItem->layoutElement, CLAY__ELEMENT_CONFIG_TYPE_CLIP).clipElementConfig;
-                    if (clipConfig->horizontal) {
-                        rootPosition.x += clipConfig->childOffset.x;
-                    }
-                    if (clipConfig->vertical) {
-                        rootPosition.y += clipConfig->childOffset.y;
-                    }
-                }
-                Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand) {
-                    .boundingBox = clipHashMapItem->boundingBox,
-                    .userData = 0,
-                    .id = Clay__HashNumber(rootElement->id, rootElement->childrenOrTextContent.children.length + 10).id, // TODO need a better strategy for managing derived ids
-                    .zIndex = root->zIndex,
-                    .commandType = CLAY_RENDER_COMMAND_TYPE_SCISSOR_START,
-                });
+            for (int32_t i = currentElement->childrenOrTextContent.children.length - 1; i >= 0; --i) {
+                Clay__int32_tArray_Add(&dfsBuffer, currentElement->childrenOrTextContent.children.elements[i]);
+                context->treeNodeVisited.internalArray[dfsBuffer.length - 1] = false;
+                entryStack[dfsBuffer.length - 1] = entries->length - 1;
             }
         }
-        Clay__LayoutElementTreeNodeArray_Add(&dfsBuffer, CLAY__INIT(Clay__LayoutElementTreeNode) { .layoutElement = rootElement, .position = rootPosition, .nextChildOffset = { .x = (float)rootElement->layoutConfig->padding.left, .y = (float)rootElement->layoutConfig->padding.top } });
+    }
+}
 
+// Finds the elements under the pointer without building pointerHitTestEntries
+void Clay__WalkPointerOverIds(Clay_Context *context) {
+    Clay_Vector2 position = context->pointerInfo.position;
+    Clay__int32_tArray dfsBuffer = context->layoutElementChildrenBuffer;
+    for (int32_t rootIndex = context->layoutElementTreeRoots.length - 1; rootIndex >= 0; --rootIndex) {
+        dfsBuffer.length = 0;
+        Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex);
+        Clay__int32_tArray_Add(&dfsBuffer, (int32_t)root->layoutElementIndex);
         context->treeNodeVisited.internalArray[0] = false;
+        bool found = false;
         while (dfsBuffer.length > 0) {
-            Clay__LayoutElementTreeNode *currentElementTreeNode = Clay__LayoutElementTreeNodeArray_Get(&dfsBuffer, (int)dfsBuffer.length - 1);
-            Clay_LayoutElement *currentElement = currentElementTreeNode->layoutElement;
-            Clay_LayoutConfig *layoutConfig = currentElement->layoutConfig;
-            Clay_Vector2 scrollOffset = CLAY__DEFAULT_STRUCT;
-
-            // This will only be run a single time for each element in downwards DFS order
-            if (!context->treeNodeVisited.internalArray[dfsBuffer.length - 1]) {
-                context->treeNodeVisited.internalArray[dfsBuffer.length - 1] = true;
-
-                Clay_BoundingBox currentElementBoundingBox = { currentElementTreeNode->position.x, currentElementTreeNode->position.y, currentElement->dimensions.width, currentElement->dimensions.height };
-                if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING)) {
-                    Clay_FloatingElementConfig *floatingElementConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig;
-                    Clay_Dimensions expand = floatingElementConfig->expand;
-                    currentElementBoundingBox.x -= expand.width;
-                    currentElementBoundingBox.width += expand.width * 2;
-                    currentElementBoundingBox.y -= expand.height;
-                    currentElementBoundingBox.height += expand.height * 2;
-                }
-
-                Clay__ScrollContainerDataInternal *scrollContainerData = CLAY__NULL;
-                // Apply scroll offsets to container
-                if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_CLIP)) {
-                    Clay_ClipElementConfig *clipConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_CLIP).clipElementConfig;
-
-                    // This linear scan could theoretically be slow under very strange conditions, but I can't imagine a real UI with more than a few 10's of scroll containers
-                    for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
-                        Clay__ScrollContainerDataInternal *mapping = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
-                        if (mapping->layoutElement == currentElement) {
-                            scrollContainerData = mapping;
-                            mapping->boundingBox = currentElementBoundingBox;
-                            scrollOffset = clipConfig->childOffset;
-                            if (context->externalScrollHandlingEnabled) {
-                                scrollOffset = CLAY__INIT(Clay_Vector2) CLAY__DEFAULT_STRUCT;
-                            }
-                            break;
-                        }
-                    }
-                }
-
-                Clay_LayoutElementHashMapItem *hashMapItem = Clay__GetHashMapItem(currentElement->id);
-                if (hashMapItem) {
-                    hashMapItem->boundingBox = currentElementBoundingBox;
-                }
-
-                int32_t sortedConfigIndexes[20];
-                for (int32_t elementConfigIndex = 0; elementConfigIndex < currentElement->elementConfigs.length; ++elementConfigIndex) {
-                    sortedConfigIndexes[elementConfigIndex] = elementConfigIndex;
-                }
-                sortMax = currentElement->elementConfigs.length - 1;
-                while (sortMax > 0) { // todo dumb bubble sort
-                    for (int32_t i = 0; i < sortMax; ++i) {
-                        int32_t current = sortedConfigIndexes[i];
-                        int32_t next = sortedConfigIndexes[i + 1];
-                        Clay__ElementConfigType currentType = Clay__ElementConfigArraySlice_Get(&currentElement->elementConfigs, current)->type;
-                        Clay__ElementConfigType nextType = Clay__ElementConfigArraySlice_Get(&currentElement->elementConfigs, next)->type;
-                        if (nextType == CLAY__ELEMENT_CONFIG_TYPE_CLIP || currentType == CLAY__ELEMENT_CONFIG_TYPE_BORDER) {
-                            sortedConfigIndexes[i] = next;
-                            sortedConfigIndexes[i + 1] = current;
-                        }
-                    }
-                    sortMax--;
-                }
-
-                bool emitRectangle = false;
-                // Create the render commands for this element
-                Clay_SharedElementConfig *sharedConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SHARED).sharedElementConfig;
-                if (sharedConfig && sharedConfig->backgroundColor.a > 0) {
-                   emitRectangle = true;
-                }
-                else if (!sharedConfig) {
-                    emitRectangle = false;
-                    sharedConfig = &Clay_SharedElementConfig_DEFAULT;
-                }
-                for (int32_t elementConfigIndex = 0; elementConfigIndex < currentElement->elementConfigs.length; ++elementConfigIndex) {
-                    Clay_ElementConfig *elementConfig = Clay__ElementConfigArraySlice_Get(&currentElement->elementConfigs, sortedConfigIndexes[elementConfigIndex]);
-                    Clay_RenderCommand renderCommand = {
-                        .boundingBox = currentElementBoundingBox,
-                        .userData = sharedConfig->userData,
-                        .id = currentElement->id,
-                    };
-
-                    bool offscreen = Clay__ElementIsOffscreen(&currentElementBoundingBox);
-                    // Culling - Don't bother to generate render commands for rectangles entirely outside the screen - this won't stop their children from being rendered if they overflow
-                    bool shouldRender = !offscreen;
-                    switch (elementConfig->type) {
-                        case CLAY__ELEMENT_CONFIG_TYPE_ASPECT:
-                        case CLAY__ELEMENT_CONFIG_TYPE_FLOATING:
-                        case CLAY__ELEMENT_CONFIG_TYPE_SHARED:
-                        case CLAY__ELEMENT_CONFIG_TYPE_BORDER: {
-                            shouldRender = false;
-                            break;
-                        }
-                        case CLAY__ELEMENT_CONFIG_TYPE_CLIP: {
-                            renderCommand.commandType = CLAY_RENDER_COMMAND_TYPE_SCISSOR_START;
-                            renderCommand.renderData = CLAY__INIT(Clay_RenderData) {
-                                .clip = {
-                                    .horizontal = elementConfig->config.clipElementConfig->horizontal,
-                                    .vertical = elementConfig->config.clipElementConfig->vertical,
-                                }
-                            };
-                            break;
-                        }
-                        case CLAY__ELEMENT_CONFIG_TYPE_IMAGE: {
-                            renderCommand.commandType = CLAY_RENDER_COMMAND_TYPE_IMAGE;
-                            renderCommand.renderData = CLAY__INIT(Clay_RenderData) {
-                                .image = {
-                                    .backgroundColor = sharedConfig->backgroundColor,
-                                    .cornerRadius = sharedConfig->cornerRadius,
-                                    .imageData = elementConfig->config.imageElementConfig->imageData,
-                               }
-                            };
-                            emitRectangle = false;
-                            break;
-                        }
-                        case CLAY__ELEMENT_CONFIG_TYPE_TEXT: {
-                            if (!shouldRender) {
-                                break;
-                            }
-                            shouldRender = false;
-                            Clay_ElementConfigUnion configUnion = elementConfig->config;
-                            Clay_TextElementConfig *textElementConfig = configUnion.textElementConfig;
-                            float naturalLineHeight = currentElement->childrenOrTextContent.textElementData->preferredDimensions.height;
-                            float finalLineHeight = textElementConfig->lineHeight > 0 ? (float)textElementConfig->lineHeight : naturalLineHeight;
-                            float lineHeightOffset = (finalLineHeight - naturalLineHeight) / 2;
-                            float yPosition = lineHeightOffset;
-                            for (int32_t lineIndex = 0; lineIndex < currentElement->childrenOrTextContent.textElementData->wrappedLines.length; ++lineIndex) {
-                                Clay__WrappedTextLine *wrappedLine = Clay__WrappedTextLineArraySlice_Get(&currentElement->childrenOrTextContent.textElementData->wrappedLines, lineIndex);
-                                if (wrappedLine->line.length == 0) {
-                                    yPosition += finalLineHeight;
-                                    continue;
-                                }
-                                float offset = (currentElementBoundingBox.width - wrappedLine->dimensions.width);
-                                if (textElementConfig->textAlignment == CLAY_TEXT_ALIGN_LEFT) {
-                                    offset = 0;
-                                }
-                                if (textElementConfig->textAlignment == CLAY_TEXT_ALIGN_CENTER) {
-                                    offset /= 2;
-                                }
-                                Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand) {
-                                    .boundingBox = { currentElementBoundingBox.x + offset, currentElementBoundingBox.y + yPosition, wrappedLine->dimensions.width, wrappedLine->dimensions.height },
-                                    .renderData = { .text = {
-                                        .stringContents = CLAY__INIT(Clay_StringSlice) { .length = wrappedLine->line.length, .chars = wrappedLine->line.chars, .baseChars = currentElement->childrenOrTextContent.textElementData->text.chars },
-                                        .textColor = textElementConfig->textColor,
-                                        .fontId = textElementConfig->fontId,
-                                        .fontSize = textElementConfig->fontSize,
-                                        .letterSpacing = textElementConfig->letterSpacing,
-                                        .lineHeight = textElementConfig->lineHeight,
-                                    }},
-                                    .userData = textElementConfig->userData,
-                                    .id = Clay__HashNumber(lineIndex, currentElement->id).id,
-                                    .zIndex = root->zIndex,
-                                    .commandType = CLAY_RENDER_COMMAND_TYPE_TEXT,
-                                });
-                                yPosition += finalLineHeight;
-
-                                if (!context->disableCulling && (currentElementBoundingBox.y + yPosition > context->layoutDimensions.height)) {
-                                    break;
-                                }
-                            }
-                            break;
-                        }
-                        case CLAY__ELEMENT_CONFIG_TYPE_CUSTOM: {
-                            renderCommand.commandType = CLAY_RENDER_COMMAND_TYPE_CUSTOM;
-                            renderCommand.renderData = CLAY__INIT(Clay_RenderData) {
-                                .custom = {
-                                    .backgroundColor = sharedConfig->backgroundColor,
-                                    .cornerRadius = sharedConfig->cornerRadius,
-                                    .customData = elementConfig->config.customElementConfig->customData,
-                                }
-                            };
-                            emitRectangle = false;
-                            break;
-                        }
-                        default: break;
-                    }
-                    if (shouldRender) {
-                        Clay__AddRenderCommand(renderCommand);
-                    }
-                    if (offscreen) {
-                        // NOTE: You may be tempted to try an early return / continue if an element is off screen. Why bother calculating layout for its children, right?
-                        // Unfortunately, a FLOATING_CONTAINER may be defined that attaches to a child or grandchild of this element, which is large enough to still
-                        // be on screen, even if this element isn't. That depends on this element and it's children being laid out correctly (even if they are entirely off screen)
-                    }
-                }
-
-                if (emitRectangle) {
-                    Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand) {
-                        .boundingBox = currentElementBoundingBox,
-                        .renderData = { .rectangle = {
-                                .backgroundColor = sharedConfig->backgroundColor,
-                                .cornerRadius = sharedConfig->cornerRadius,
-                        }},
-                        .userData = sharedConfig->userData,
-                        .id = currentElement->id,
-                        .zIndex = root->zIndex,
-                        .commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE,
-                    });
-                }
-
-                // Setup initial on-axis alignment
-                if (!Clay__ElementHasConfig(currentElementTreeNode->layoutElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
-                    Clay_Dimensions contentSize = {0,0};
-                    if (layoutConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) {
-                        for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
-                            Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
-                            contentSize.width += childElement->dimensions.width;
-                            contentSize.height = CLAY__MAX(contentSize.height, childElement->dimensions.height);
-                        }
-                        contentSize.width += (float)(CLAY__MAX(currentElement->childrenOrTextContent.children.length - 1, 0) * layoutConfig->childGap);
-                        float extraSpace = currentElement->dimensions.width - (float)(layoutConfig->padding.left + layoutConfig->padding.right) - contentSize.width;
-                        switch (layoutConfig->childAlignment.x) {
-                            case CLAY_ALIGN_X_LEFT: extraSpace = 0; break;
-                            case CLAY_ALIGN_X_CENTER: extraSpace /= 2; break;
-                            default: break;
-                        }
-                        currentElementTreeNode->nextChildOffset.x += extraSpace;
-                        extraSpace = CLAY__MAX(0, extraSpace);
-                    } else {
-                        for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
-                            Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
-                            contentSize.width = CLAY__MAX(contentSize.width, childElement->dimensions.width);
-                            contentSize.height += childElement->dimensions.height;
-                        }
-                        contentSize.height += (float)(CLAY__MAX(currentElement->childrenOrTextContent.children.length - 1, 0) * layoutConfig->childGap);
-                        float extraSpace = currentElement->dimensions.height - (float)(layoutConfig->padding.top + layoutConfig->padding.bottom) - contentSize.height;
-                        switch (layoutConfig->childAlignment.y) {
-                            case CLAY_ALIGN_Y_TOP: extraSpace = 0; break;
-                            case CLAY_ALIGN_Y_CENTER: extraSpace /= 2; break;
-                            default: break;
-                        }
-                        extraSpace = CLAY__MAX(0, extraSpace);
-                        currentElementTreeNode->nextChildOffset.y += extraSpace;
-                    }
-
-                    if (scrollContainerData) {
-                        scrollContainerData->contentSize = CLAY__INIT(Clay_Dimensions) { contentSize.width + (float)(layoutConfig->padding.left + layoutConfig->padding.right), contentSize.height + (float)(layoutConfig->padding.top + layoutConfig->padding.bottom) };
-                    }
-                }
+            if (context->treeNodeVisited.internalArray[dfsBuffer.length - 1]) {
+                dfsBuffer.length--;
+                continue;
             }
-            else {
-                // DFS is returning upwards backwards
-                bool closeClipElement = false;
-                Clay_ClipElementConfig *clipConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_CLIP).clipElementConfig;
-                if (clipConfig) {
-                    closeClipElement = true;
-                    for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
-                        Clay__ScrollContainerDataInternal *mapping = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
-                        if (mapping->layoutElement == currentElement) {
-                            scrollOffset = clipConfig->childOffset;
-                            if (context->externalScrollHandlingEnabled) {
-                                scrollOffset = CLAY__INIT(Clay_Vector2) CLAY__DEFAULT_STRUCT;
-                            }
-                            break;
-                        }
-                    }
-                }
-
-                if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_BORDER)) {
-                    Clay_LayoutElementHashMapItem *currentElementData = Clay__GetHashMapItem(currentElement->id);
-                    Clay_BoundingBox currentElementBoundingBox = currentElementData->boundingBox;
-
-                    // Culling - Don't bother to generate render commands for rectangles entirely outside the screen - this won't stop their children from being rendered if they overflow
-                    if (!Clay__ElementIsOffscreen(&currentElementBoundingBox)) {
-                        Clay_SharedElementConfig *sharedConfig = Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SHARED) ? Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_SHARED).sharedElementConfig : &Clay_SharedElementConfig_DEFAULT;
-                        Clay_BorderElementConfig *borderConfig = Clay__FindElementConfigWithType(currentElement, CLAY__ELEMENT_CONFIG_TYPE_BORDER).borderElementConfig;
-                        Clay_RenderCommand renderCommand = {
-                                .boundingBox = currentElementBoundingBox,
-                                .renderData = { .border = {
-                                    .color = borderConfig->color,
-                                    .cornerRadius = sharedConfig->cornerRadius,
-                                    .width = borderConfig->width
-                                }},
-                                .userData = sharedConfig->userData,
-                                .id = Clay__HashNumber(currentElement->id, currentElement->childrenOrTextContent.children.length).id,
-                                .commandType = CLAY_RENDER_COMMAND_TYPE_BORDER,
-                        };
-                        Clay__AddRenderCommand(renderCommand);
-                        if (borderConfig->width.betweenChildren > 0 && borderConfig->color.a > 0) {
-                            float halfGap = layoutConfig->childGap / 2;
-                            Clay_Vector2 borderOffset = { (float)layoutConfig->padding.left - halfGap, (float)layoutConfig->padding.top - halfGap };
-                            if (layoutConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) {
-                                for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
-                                    Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
-                                    if (i > 0) {
-                                        Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand) {
-                                            .boundingBox = { currentElementBoundingBox.x + borderOffset.x + scrollOffset.x, currentElementBoundingBox.y + scrollOffset.y, (float)borderConfig->width.betweenChildren, currentElement->dimensions.height },
-                                            .renderData = { .rectangle = {
-                                                .backgroundColor = borderConfig->color,
-                                            } },
-                                            .userData = sharedConfig->userData,
-                                            .id = Clay__HashNumber(currentElement->id, currentElement->childrenOrTextContent.children.length + 1 + i).id,
-                                            .commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE,
-                                        });
-                                    }
-                                    borderOffset.x += (childElement->dimensions.width + (float)layoutConfig->childGap);
-                                }
-                            } else {
-                                for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
-                                    Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
-                                    if (i > 0) {
-                                        Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand) {
-                                            .boundingBox = { currentElementBoundingBox.x + scrollOffset.x, currentElementBoundingBox.y + borderOffset.y + scrollOffset.y, currentElement->dimensions.width, (float)borderConfig->width.betweenChildren },
-                                            .renderData = { .rectangle = {
-                                                    .backgroundColor = borderConfig->color,
-                                            } },
-                                            .userData = sharedConfig->userData,
-                                            .id = Clay__HashNumber(currentElement->id, currentElement->childrenOrTextContent.children.length + 1 + i).id,
-                                            .commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE,
-                                        });
-                                    }
-                                    borderOffset.y += (childElement->dimensions.height + (float)layoutConfig->childGap);
-                                }
-                            }
-                        }
+            context->treeNodeVisited.internalArray[dfsBuffer.length - 1] = true;
+            Clay_LayoutElement *currentElement = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&dfsBuffer, (int)dfsBuffer.length - 1));
+            Clay_LayoutElementHashMapItem *mapItem = Clay__GetHashMapItem(currentElement->id);
+            int32_t clipElementId = Clay__int32_tArray_GetValue(&context->layoutElementClipElementIds, (int32_t)(currentElement - context->layoutElements.internalArray));
+            if (mapItem != &Clay_LayoutElementHashMapItem_DEFAULT) {
+                Clay_BoundingBox elementBox = mapItem->boundingBox;
+                elementBox.x -= root->pointerOffset.x;
+                elementBox.y -= root->pointerOffset.y;
+                if ((Clay__PointIsInsideRect(position, elementBox)) && (clipElementId == 0 || (Clay__PointIsInsideRect(position, Clay__GetHashMapItem(clipElementId)->boundingBox)) || context->externalScrollHandlingEnabled)) {
+                    Clay__LayoutElementHashMapColdItem *mapColdItem = Clay__GetHashMapColdItem(mapItem);
+                    if (mapColdItem->onHoverFunction) {
+                        mapColdItem->onHoverFunction(mapColdItem->elementId, context->pointerInfo, mapColdItem->hoverFunctionUserData);
                     }
+                    Clay_ElementIdArray_Add(&context->pointerOverIds, mapColdItem->elementId);
+                    found = true;
                 }
-                // This exists because the scissor needs to end _after_ borders between elements
-                if (closeClipElement) {
-                    Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand) {
-                        .id = Clay__HashNumber(currentElement->id, rootElement->childrenOrTextContent.children.length + 11).id,
-                        .commandType = CLAY_RENDER_COMMAND_TYPE_SCISSOR_END,
-                    });
-                }
-
+            }
+            if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
                 dfsBuffer.length--;
                 continue;
             }
+            for (int32_t i = currentElement->childrenOrTextContent.children.length - 1; i >= 0; --i) {
+                Clay__int32_tArray_Add(&dfsBuffer, currentElement->childrenOrTextContent.children.elements[i]);
+                context->treeNodeVisited.internalArray[dfsBuffer.length - 1] = false;
+            }
+        }
 
-            // Add children to the DFS buffer
-            if (!Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
-                dfsBuffer.length += currentElement->childrenOrTextContent.children.length;
-                for (int32_t i = 0; i < currentElement->childrenOrTextContent.children.length; ++i) {
-                    Clay_LayoutElement *childElement = Clay_LayoutElementArray_Get(&context->layoutElements, currentElement->childrenOrTextContent.children.elements[i]);
-                    // Alignment along non layout axis
-                    if (layoutConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) {
-                        currentElementTreeNode->nextChildOffset.y = currentElement->layoutConfig->padding.top;
-                        float whiteSpaceAroundChild = currentElement->dimensions.height - (float)(layoutConfig->padding.top + layoutConfig->padding.bottom) - childElement->dimensions.height;
-                        switch (layoutConfig->childAlignment.y) {
-                            case CLAY_ALIGN_Y_TOP: break;
-                            case CLAY_ALIGN_Y_CENTER: currentElementTreeNode->nextChildOffset.y += whiteSpaceAroundChild / 2; break;
-                            case CLAY_ALIGN_Y_BOTTOM: currentElementTreeNode->nextChildOffset.y += whiteSpaceAroundChild; break;
-                        }
-                    } else {
-                        currentElementTreeNode->nextChildOffset.x = currentElement->layoutConfig->padding.left;
-                        float whiteSpaceAroundChild = currentElement->dimensions.width - (float)(layoutConfig->padding.left + layoutConfig->padding.right) - childElement->dimensions.width;
-                        switch (layoutConfig->childAlignment.x) {
-                            case CLAY_ALIGN_X_LEFT: break;
-                            case CLAY_ALIGN_X_CENTER: currentElementTreeNode->nextChildOffset.x += whiteSpaceAroundChild / 2; break;
-                            case CLAY_ALIGN_X_RIGHT: currentElementTreeNode->nextChildOffset.x += whiteSpaceAroundChild; break;
-                        }
-                    }
-
-                    Clay_Vector2 childPosition = {
-                        currentElementTreeNode->position.x + currentElementTreeNode->nextChildOffset.x + scrollOffset.x,
-                        currentElementTreeNode->position.y + currentElementTreeNode->nextChildOffset.y + scrollOffset.y,
-                    };
-
-                    // DFS buffer elements need to be added in reverse because stack traversal happens backwards
-                    uint32_t newNodeIndex = dfsBuffer.length - 1 - i;
-                    dfsBuffer.internalArray[newNodeIndex] = CLAY__INIT(Clay__LayoutElementTreeNode) {
-                        .layoutElement = childElement,
-                        .position = { childPosition.x, childPosition.y },
-                        .nextChildOffset = { .x = (float)childElement->layoutConfig->padding.left, .y = (float)childElement->layoutConfig->padding.top },
-                    };
-                    context->treeNodeVisited.internalArray[newNodeIndex] = false;
+        Clay_LayoutElement *rootElement = Clay_LayoutElementArray_Get(&context->layoutElements, root->layoutElementIndex);
+        if (found && Clay__ElementHasConfig(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING) &&
+                Clay__FindElementConfigWithType(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig->pointerCaptureMode == CLAY_POINTER_CAPTURE_MODE_CAPTURE) {
+            break;
+        }
+    }
+}
 
-                    // Update parent offsets
-                    if (layoutConfig->layoutDirection == CLAY_LEFT_TO_RIGHT) {
-                        currentElementTreeNode->nextChildOffset.x += childElement->dimensions.width + (float)layoutConfig->childGap;
-                    } else {
-                        currentElementTreeNode->nextChildOffset.y += childElement->dimensions.height + (float)layoutConfig->childGap;
-                    }
-                }
+// If the pointer has moved since pointerOverIds was last updated, finds the elements under it and calls their hover functions.
+// Clay_SetPointerState leaves this until something reads pointerOverIds, unless there are hover functions to call.
+void Clay__UpdatePointerOverIds(Clay_Context *context) {
+    if (!context->pointerOverIdsStale) {
+        return;
+    }
+    context->pointerOverIdsStale = false;
+    context->pointerOverIds.length = 0;
+    // Building the index costs about as much as one walk, so a layout that is only queried once never pays for it
+    context->pointerHitTestQueries++;
+    if (context->pointerHitTestQueries == 1) {
+        Clay__WalkPointerOverIds(context);
+        return;
+    } else if (context->pointerHitTestQueries == 2) {
+        Clay__BuildPointerHitTest(context);
+    }
+    Clay_Vector2 position = context->pointerInfo.position;
+    Clay__PointerHitTestEntryArray *entries = &context->pointerHitTestEntries;
+    int32_t previousRootIndex = -1;
+    for (int32_t i = 0; i < entries->length;) {
+        Clay__PointerHitTestEntry *entry = &entries->internalArray[i];
+        if (!Clay__PointIsInsideArea(position, entry->subtreeMin, entry->subtreeMax)) {
+            i = entry->subtreeEnd;
+            continue;
+        }
+        i++;
+        if (!Clay__PointIsInsideArea(position, entry->min, entry->max)) {
+            continue;
+        }
+        if (previousRootIndex != -1 && entry->rootIndex != previousRootIndex) {
+            // A floating root that captures the pointer hides everything beneath it
+            Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, previousRootIndex);
+            Clay_LayoutElement *rootElement = Clay_LayoutElementArray_Get(&context->layoutElements, root->layoutElementIndex);
+            if (Clay__ElementHasConfig(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING) &&
+                    Clay__FindElementConfigWithType(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig->pointerCaptureMode == CLAY_POINTER_CAPTURE_MODE_CAPTURE) {
+                break;
             }
         }
-
-        if (root->clipElementId) {
-            Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand) { .id = Clay__HashNumber(rootElement->id, rootElement->childrenOrTextContent.children.length + 11).id, .commandType = CLAY_RENDER_COMMAND_TYPE_SCISSOR_END });
+        previousRootIndex = entry->rootIndex;
+        Clay__LayoutElementHashMapColdItem *coldItem = &context->layoutElementsHashMapCold.internalArray[entry->hashMapItemIndex];
+        if (coldItem->onHoverFunction) {
+            coldItem->onHoverFunction(coldItem->elementId, context->pointerInfo, coldItem->hoverFunctionUserData);
         }
+        Clay_ElementIdArray_Add(&context->pointerOverIds, coldItem->elementId);
     }
 }
 
 CLAY_WASM_EXPORT("Clay_GetPointerOverIds")
 CLAY_DLL_EXPORT Clay_ElementIdArray Clay_GetPointerOverIds(void) {
-    return Clay_GetCurrentContext()->pointerOverIds;
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__UpdatePointerOverIds(context);
+    return context->pointerOverIds;
 }
 
 #pragma region DebugTools
@@ -3236,7 +5276,7 @@ Clay__RenderDebugLayoutData Clay__RenderDebugLayoutElementsList(int32_t initialR
                         .cornerRadius = CLAY_CORNER_RADIUS(4),
                         .border = { .color = CLAY__DEBUGVIEW_COLOR_3, .width = {1, 1, 1, 1, 0} },
                     }) {
-                        CLAY_TEXT((currentElementData && currentElementData->debugData->collapsed) ? CLAY_STRING("+") : CLAY_STRING("-"), CLAY_TEXT_CONFIG({ .textColor = CLAY__DEBUGVIEW_COLOR_4, .fontSize = 16 }));
+                        CLAY_TEXT((currentElementData && Clay__GetHashMapColdItem(currentElementData)->debugData->collapsed) ? CLAY_STRING("+") : CLAY_STRING("-"), CLAY_TEXT_CONFIG({ .textColor = CLAY__DEBUGVIEW_COLOR_4, .fontSize = 16 }));
                     }
                 } else { // Square dot for empty containers
                     CLAY_AUTO_ID({ .layout = { .sizing = {CLAY_SIZING_FIXED(16), CLAY_SIZING_FIXED(16)}, .childAlignment = { CLAY_ALIGN_X_CENTER, CLAY_ALIGN_Y_CENTER } } }) {
@@ -3245,7 +5285,7 @@ Clay__RenderDebugLayoutData Clay__RenderDebugLayoutElementsList(int32_t initialR
                 }
                 // Collisions and offscreen info
                 if (currentElementData) {
-                    if (currentElementData->debugData->collision) {
+                    if (Clay__GetHashMapColdItem(currentElementData)->debugData->collision) {
                         CLAY_AUTO_ID({ .layout = { .padding = { 8, 8, 2, 2 }}, .border = { .color = {177, 147, 8, 255}, .width = {1, 1, 1, 1, 0} } }) {
                             CLAY_TEXT(CLAY_STRING("Duplicate ID"), CLAY_TEXT_CONFIG({ .textColor = CLAY__DEBUGVIEW_COLOR_3, .fontSize = 16 }));
                         }
@@ -3312,7 +5352,7 @@ Clay__RenderDebugLayoutData Clay__RenderDebugLayoutElementsList(int32_t initialR
             }
 
             layoutData.rowCount++;
-            if (!(Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT) || (currentElementData && currentElementData->debugData->collapsed))) {
+            if (!(Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT) || (currentElementData && Clay__GetHashMapColdItem(currentElementData)->debugData->collapsed))) {
                 for (int32_t i = currentElement->childrenOrTextContent.children.length - 1; i >= 0; --i) {
                     Clay__int32_tArray_Add(&dfsBuffer, currentElement->childrenOrTextContent.children.elements[i]);
                     context->treeNodeVisited.internalArray[dfsBuffer.length - 1] = false; // TODO needs to be ranged checked
@@ -3322,12 +5362,12 @@ Clay__RenderDebugLayoutData Clay__RenderDebugLayoutElementsList(int32_t initialR
     }
 
     if (context->pointerInfo.state == CLAY_POINTER_DATA_PRESSED_THIS_FRAME) {
-        Clay_ElementId collapseButtonId = Clay__HashString(CLAY_STRING("Clay__DebugView_CollapseElement"), 0);
+        Clay_ElementId collapseButtonId = CLAY_ID("Clay__DebugView_CollapseElement");
         for (int32_t i = (int)context->pointerOverIds.length - 1; i >= 0; i--) {
             Clay_ElementId *elementId = Clay_ElementIdArray_Get(&context->pointerOverIds, i);
             if (elementId->baseId == collapseButtonId.baseId) {
-                Clay_LayoutElementHashMapItem *highlightedItem = Clay__GetHashMapItem(elementId->offset);
-                highlightedItem->debugData->collapsed = !highlightedItem->debugData->collapsed;
+                Clay__DebugElementData *highlightedDebugData = Clay__GetHashMapColdItem(Clay__GetHashMapItem(elementId->offset))->debugData;
+                highlightedDebugData->collapsed = !highlightedDebugData->collapsed;
                 break;
             }
         }
@@ -3425,7 +5465,8 @@ void HandleDebugViewCloseButtonInteraction(Clay_ElementId elementId, Clay_Pointe
 
 void Clay__RenderDebugView(void) {
     Clay_Context* context = Clay_GetCurrentContext();
-    Clay_ElementId closeButtonId = Clay__HashString(CLAY_STRING("Clay__DebugViewTopHeaderCloseButtonOuter"), 0);
+    Clay__UpdatePointerOverIds(context);
+    Clay_ElementId closeButtonId = CLAY_ID("Clay__DebugViewTopHeaderCloseButtonOuter");
     if (context->pointerInfo.state == CLAY_POINTER_DATA_PRESSED_THIS_FRAME) {
         for (int32_t i = 0; i < context->pointerOverIds.length; ++i) {
             Clay_ElementId *elementId = Clay_ElementIdArray_Get(&context->pointerOverIds, i);
@@ -3440,7 +5481,7 @@ void Clay__RenderDebugView(void) {
     uint32_t initialElementsLength = context->layoutElements.length;
     Clay_TextElementConfig *infoTextConfig = CLAY_TEXT_CONFIG({ .textColor = CLAY__DEBUGVIEW_COLOR_4, .fontSize = 16, .wrapMode = CLAY_TEXT_WRAP_NONE });
     Clay_TextElementConfig *infoTitleConfig = CLAY_TEXT_CONFIG({ .textColor = CLAY__DEBUGVIEW_COLOR_3, .fontSize = 16, .wrapMode = CLAY_TEXT_WRAP_NONE });
-    Clay_ElementId scrollId = Clay__HashString(CLAY_STRING("Clay__DebugViewOuterScrollPane"), 0);
+    Clay_ElementId scrollId = CLAY_ID("Clay__DebugViewOuterScrollPane");
     float scrollYOffset = 0;
     bool pointerInDebugView = context->pointerInfo.position.y < context->layoutDimensions.height - 300;
     for (int32_t i = 0; i < context->scrollContainerDatas.length; ++i) {
@@ -3483,7 +5524,7 @@ void Clay__RenderDebugView(void) {
         CLAY_AUTO_ID({ .layout = { .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_FIXED(1)} }, .backgroundColor = CLAY__DEBUGVIEW_COLOR_3 } ) {}
         CLAY(scrollId, { .layout = { .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)} }, .clip = { .horizontal = true, .vertical = true, .childOffset = Clay_GetScrollOffset() } }) {
             CLAY_AUTO_ID({ .layout = { .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)}, .layoutDirection = CLAY_TOP_TO_BOTTOM }, .backgroundColor = ((initialElementsLength + initialRootsLength) & 1) == 0 ? CLAY__DEBUGVIEW_COLOR_2 : CLAY__DEBUGVIEW_COLOR_1 }) {
-                Clay_ElementId panelContentsId = Clay__HashString(CLAY_STRING("Clay__DebugViewPaneOuter"), 0);
+                Clay_ElementId panelContentsId = CLAY_ID("Clay__DebugViewPaneOuter");
                 // Element list
                 CLAY(panelContentsId, { .layout = { .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)} }, .floating = { .zIndex = 32766, .pointerCaptureMode = CLAY_POINTER_CAPTURE_MODE_PASSTHROUGH, .attachTo = CLAY_ATTACH_TO_PARENT, .clipTo = CLAY_CLIP_TO_ATTACHED_PARENT } }) {
                     CLAY_AUTO_ID({ .layout = { .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0)}, .padding = { CLAY__DEBUGVIEW_OUTER_PADDING, CLAY__DEBUGVIEW_OUTER_PADDING, 0, 0 }, .layoutDirection = CLAY_TOP_TO_BOTTOM } }) {
@@ -3509,6 +5550,7 @@ void Clay__RenderDebugView(void) {
         CLAY_AUTO_ID({ .layout = { .sizing = {.width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(1)} }, .backgroundColor = CLAY__DEBUGVIEW_COLOR_3 }) {}
         if (context->debugSelectedElementId != 0) {
             Clay_LayoutElementHashMapItem *selectedItem = Clay__GetHashMapItem(context->debugSelectedElementId);
+            Clay__LayoutElementHashMapColdItem *selectedColdItem = Clay__GetHashMapColdItem(selectedItem);
             CLAY_AUTO_ID({
                 .layout = { .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_FIXED(300)}, .layoutDirection = CLAY_TOP_TO_BOTTOM },
                 .backgroundColor = CLAY__DEBUGVIEW_COLOR_2 ,
@@ -3518,11 +5560,11 @@ void Clay__RenderDebugView(void) {
                 CLAY_AUTO_ID({ .layout = { .sizing = {CLAY_SIZING_GROW(0), CLAY_SIZING_FIXED(CLAY__DEBUGVIEW_ROW_HEIGHT + 8)}, .padding = {CLAY__DEBUGVIEW_OUTER_PADDING, CLAY__DEBUGVIEW_OUTER_PADDING, 0, 0 }, .childAlignment = {.y = CLAY_ALIGN_Y_CENTER} } }) {
                     CLAY_TEXT(CLAY_STRING("Layout Config"), infoTextConfig);
                     CLAY_AUTO_ID({ .layout = { .sizing = { .width = CLAY_SIZING_GROW(0) } } }) {}
-                    if (selectedItem->elementId.stringId.length != 0) {
-                        CLAY_TEXT(selectedItem->elementId.stringId, infoTitleConfig);
-                        if (selectedItem->elementId.offset != 0) {
+                    if (selectedColdItem->elementId.stringId.length != 0) {
+                        CLAY_TEXT(selectedColdItem->elementId.stringId, infoTitleConfig);
+                        if (selectedColdItem->elementId.offset != 0) {
                             CLAY_TEXT(CLAY_STRING(" ("), infoTitleConfig);
-                            CLAY_TEXT(Clay__IntToString(selectedItem->elementId.offset), infoTitleConfig);
+                            CLAY_TEXT(Clay__IntToString(selectedColdItem->elementId.offset), infoTitleConfig);
                             CLAY_TEXT(CLAY_STRING(")"), infoTitleConfig);
                         }
                     }
@@ -3597,7 +5639,7 @@ void Clay__RenderDebugView(void) {
                 }
                 for (int32_t elementConfigIndex = 0; elementConfigIndex < selectedItem->layoutElement->elementConfigs.length; ++elementConfigIndex) {
                     Clay_ElementConfig *elementConfig = Clay__ElementConfigArraySlice_Get(&selectedItem->layoutElement->elementConfigs, elementConfigIndex);
-                    Clay__RenderDebugViewElementConfigHeader(selectedItem->elementId.stringId, elementConfig->type);
+                    Clay__RenderDebugViewElementConfigHeader(selectedColdItem->elementId.stringId, elementConfig->type);
                     switch (elementConfig->type) {
                         case CLAY__ELEMENT_CONFIG_TYPE_SHARED: {
                             Clay_SharedElementConfig *sharedConfig = elementConfig->config.sharedElementConfig;
@@ -3720,7 +5762,7 @@ void Clay__RenderDebugView(void) {
                                 // .parentId
                                 CLAY_TEXT(CLAY_STRING("Parent"), infoTitleConfig);
                                 Clay_LayoutElementHashMapItem *hashItem = Clay__GetHashMapItem(floatingConfig->parentId);
-                                CLAY_TEXT(hashItem->elementId.stringId, infoTextConfig);
+                                CLAY_TEXT(Clay__GetHashMapColdItem(hashItem)->elementId.stringId, infoTextConfig);
                                 // .attachPoints
                                 CLAY_TEXT(CLAY_STRING("Attach Points"), infoTitleConfig);
                                 CLAY_AUTO_ID({ .layout = { .layoutDirection = CLAY_LEFT_TO_RIGHT } }) {
@@ -3951,14 +5993,24 @@ Clay_Arena Clay_CreateArenaWithCapacityAndMemory(size_t capacity, void *memory)
 #ifndef CLAY_WASM
 void Clay_SetMeasureTextFunction(Clay_Dimensions (*measureTextFunction)(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData), void *userData) {
     Clay_Context* context = Clay_GetCurrentContext();
-    Clay__MeasureText = measureTextFunction;
+    context->measureTextFunction = measureTextFunction;
     context->measureTextUserData = userData;
 }
+void Clay_SetMeasureTextBatchFunction(void (*measureTextBatchFunction)(Clay_MeasureTextBatch *batch, Clay_TextElementConfig *config, void *userData), void *userData) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    context->measureTextBatchFunction = measureTextBatchFunction;
+    context->measureTextBatchUserData = userData;
+}
 void Clay_SetQueryScrollOffsetFunction(Clay_Vector2 (*queryScrollOffsetFunction)(uint32_t elementId, void *userData), void *userData) {
     Clay_Context* context = Clay_GetCurrentContext();
-    Clay__QueryScrollOffset = queryScrollOffsetFunction;
+    context->queryScrollOffsetFunction = queryScrollOffsetFunction;
     context->queryScrollOffsetUserData = userData;
 }
+void Clay_SetParallelForFunction(void (*parallelForFunction)(int32_t count, void (*task)(int32_t index, void *taskData), void *taskData, void *userData), void *userData) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    context->parallelForFunction = parallelForFunction;
+    context->parallelForUserData = userData;
+}
 #endif
 
 CLAY_WASM_EXPORT("Clay_SetLayoutDimensions")
@@ -3973,53 +6025,10 @@ void Clay_SetPointerState(Clay_Vector2 position, bool isPointerDown) {
         return;
     }
     context->pointerInfo.position = position;
-    context->pointerOverIds.length = 0;
-    Clay__int32_tArray dfsBuffer = context->layoutElementChildrenBuffer;
-    for (int32_t rootIndex = context->layoutElementTreeRoots.length - 1; rootIndex >= 0; --rootIndex) {
-        dfsBuffer.length = 0;
-        Clay__LayoutElementTreeRoot *root = Clay__LayoutElementTreeRootArray_Get(&context->layoutElementTreeRoots, rootIndex);
-        Clay__int32_tArray_Add(&dfsBuffer, (int32_t)root->layoutElementIndex);
-        context->treeNodeVisited.internalArray[0] = false;
-        bool found = false;
-        while (dfsBuffer.length > 0) {
-            if (context->treeNodeVisited.internalArray[dfsBuffer.length - 1]) {
-                dfsBuffer.length--;
-                continue;
-            }
-            context->treeNodeVisited.internalArray[dfsBuffer.length - 1] = true;
-            Clay_LayoutElement *currentElement = Clay_LayoutElementArray_Get(&context->layoutElements, Clay__int32_tArray_GetValue(&dfsBuffer, (int)dfsBuffer.length - 1));
-            Clay_LayoutElementHashMapItem *mapItem = Clay__GetHashMapItem(currentElement->id); // TODO think of a way around this, maybe the fact that it's essentially a binary tree limits the cost, but the worst case is not great
-            int32_t clipElementId = Clay__int32_tArray_GetValue(&context->layoutElementClipElementIds, (int32_t)(currentElement - context->layoutElements.internalArray));
-            Clay_LayoutElementHashMapItem *clipItem = Clay__GetHashMapItem(clipElementId);
-            if (mapItem) {
-                Clay_BoundingBox elementBox = mapItem->boundingBox;
-                elementBox.x -= root->pointerOffset.x;
-                elementBox.y -= root->pointerOffset.y;
-                if ((Clay__PointIsInsideRect(position, elementBox)) && (clipElementId == 0 || (Clay__PointIsInsideRect(position, clipItem->boundingBox)) || context->externalScrollHandlingEnabled)) {
-                    if (mapItem->onHoverFunction) {
-                        mapItem->onHoverFunction(mapItem->elementId, context->pointerInfo, mapItem->hoverFunctionUserData);
-                    }
-                    Clay_ElementIdArray_Add(&context->pointerOverIds, mapItem->elementId);
-                    found = true;
-                }
-                if (Clay__ElementHasConfig(currentElement, CLAY__ELEMENT_CONFIG_TYPE_TEXT)) {
-                    dfsBuffer.length--;
-                    continue;
-                }
-                for (int32_t i = currentElement->childrenOrTextContent.children.length - 1; i >= 0; --i) {
-                    Clay__int32_tArray_Add(&dfsBuffer, currentElement->childrenOrTextContent.children.elements[i]);
-                    context->treeNodeVisited.internalArray[dfsBuffer.length - 1] = false; // TODO needs to be ranged checked
-                }
-            } else {
-                dfsBuffer.length--;
-            }
-        }
-
-        Clay_LayoutElement *rootElement = Clay_LayoutElementArray_Get(&context->layoutElements, root->layoutElementIndex);
-        if (found && Clay__ElementHasConfig(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING) &&
-                Clay__FindElementConfigWithType(rootElement, CLAY__ELEMENT_CONFIG_TYPE_FLOATING).floatingElementConfig->pointerCaptureMode == CLAY_POINTER_CAPTURE_MODE_CAPTURE) {
-            break;
-        }
+    context->pointerOverIdsStale = true;
+    // Hover functions are called from here, and see the pointer state from before this update
+    if (context->hoverFunctionCount > 0) {
+        Clay__UpdatePointerOverIds(context);
     }
 
     if (isPointerDown) {
@@ -4052,13 +6061,22 @@ Clay_Context* Clay_Initialize(Clay_Arena arena, Clay_Dimensions layoutDimensions
         .maxMeasureTextCacheWordCount = oldContext ? oldContext->maxMeasureTextCacheWordCount : Clay__defaultMaxMeasureTextWordCacheCount,
         .errorHandler = errorHandler.errorHandlerFunction ? errorHandler : CLAY__INIT(Clay_ErrorHandler) { Clay__ErrorHandlerFunctionDefault, 0 },
         .layoutDimensions = layoutDimensions,
+        // New contexts keep the callbacks of the current one, as they did when the callbacks were global
+        .measureTextFunction = oldContext ? oldContext->measureTextFunction : NULL,
+        .measureTextBatchFunction = oldContext ? oldContext->measureTextBatchFunction : NULL,
+        .queryScrollOffsetFunction = oldContext ? oldContext->queryScrollOffsetFunction : NULL,
+        .parallelForFunction = oldContext ? oldContext->parallelForFunction : NULL,
+        .measureTextUserData = oldContext ? oldContext->measureTextUserData : NULL,
+        .measureTextBatchUserData = oldContext ? oldContext->measureTextBatchUserData : NULL,
+        .queryScrollOffsetUserData = oldContext ? oldContext->queryScrollOffsetUserData : NULL,
+        .parallelForUserData = oldContext ? oldContext->parallelForUserData : NULL,
         .internalArena = arena,
     };
     Clay_SetCurrentContext(context);
     Clay__InitializePersistentMemory(context);
     Clay__InitializeEphemeralMemory(context);
-    for (int32_t i = 0; i < context->layoutElementsHashMap.capacity; ++i) {
-        context->layoutElementsHashMap.internalArray[i] = -1;
+    for (int32_t i = 0; i < context->layoutElementsHashMapTags.capacity; ++i) {
+        context->layoutElementsHashMapTags.internalArray[i] = CLAY__HASH_MAP_EMPTY_TAG;
     }
     for (int32_t i = 0; i < context->measureTextHashMap.capacity; ++i) {
         context->measureTextHashMap.internalArray[i] = 0;
@@ -4098,9 +6116,93 @@ Clay_Vector2 Clay_GetScrollOffset(void) {
     return CLAY__INIT(Clay_Vector2) CLAY__DEFAULT_STRUCT;
 }
 
+// The position of an item along a virtual list, counting the gaps before it
+float Clay__VirtualListItemOffset(Clay_VirtualListConfig *config, int32_t itemIndex, float childGap) {
+    float offset = config->getItemOffset ? config->getItemOffset(itemIndex, config->userData) : config->itemSize * (float)itemIndex;
+    return offset + childGap * (float)itemIndex;
+}
+
+// Returns the first index in [low, high) where item (index + edge) starts at or after position, or high if there is none.
+// With edge == 1 this finds the first item that ends at or after position.
+int32_t Clay__VirtualListFindItem(Clay_VirtualListConfig *config, float childGap, int32_t low, int32_t high, int32_t edge, float position) {
+    while (low < high) {
+        int32_t middle = low + (high - low) / 2;
+        if (Clay__VirtualListItemOffset(config, middle + edge, childGap) - childGap * (float)edge >= position) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+// Fills the space of undeclared virtual list items. It grows across the list as items that fill the list do, so that the
+// content size across the list doesn't shrink when it's scrolled past its last item and no items are declared.
+void Clay__OpenVirtualListSpacer(bool vertical, float size) {
+    Clay_ElementDeclaration declaration = CLAY__DEFAULT_STRUCT;
+    if (vertical) {
+        declaration.layout.sizing.width = CLAY_SIZING_GROW(0);
+        declaration.layout.sizing.height = CLAY_SIZING_FIXED(size);
+    } else {
+        declaration.layout.sizing.width = CLAY_SIZING_FIXED(size);
+        declaration.layout.sizing.height = CLAY_SIZING_GROW(0);
+    }
+    Clay__OpenElement();
+    Clay__ConfigureOpenElementPtr(&declaration);
+    Clay__CloseElement();
+}
+
+CLAY_WASM_EXPORT("Clay_BeginVirtualList")
+Clay_VirtualListRange Clay_BeginVirtualList(Clay_VirtualListConfig config) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay_VirtualListRange range = { .trailingSize = -1 };
+    if (context->booleanWarnings.maxElementsExceeded || config.itemCount <= 0) {
+        return range;
+    }
+    Clay_LayoutElement *openLayoutElement = Clay__GetOpenLayoutElement();
+    Clay_LayoutConfig *layoutConfig = openLayoutElement->layoutConfig;
+    bool vertical = layoutConfig->layoutDirection == CLAY_TOP_TO_BOTTOM;
+    float childGap = (float)layoutConfig->childGap;
+    // Until the list has been laid out once, assume it could be as large as the whole layout
+    float visibleStart = 0;
+    float visibleSize = vertical ? context->layoutDimensions.height : context->layoutDimensions.width;
+    for (int32_t i = 0; i < context->scrollContainerDatas.length; i++) {
+        Clay__ScrollContainerDataInternal *mapping = Clay__ScrollContainerDataInternalArray_Get(&context->scrollContainerDatas, i);
+        if (mapping->layoutElement == openLayoutElement) {
+            visibleStart = vertical ? -mapping->scrollPosition.y - layoutConfig->padding.top : -mapping->scrollPosition.x - layoutConfig->padding.left;
+            float containerSize = vertical ? mapping->boundingBox.height : mapping->boundingBox.width;
+            if (containerSize > 0) {
+                visibleSize = containerSize;
+            }
+            break;
+        }
+    }
+    float visibleEnd = visibleStart + visibleSize + config.overscan;
+    visibleStart -= config.overscan;
+    range.startIndex = Clay__VirtualListFindItem(&config, childGap, 0, config.itemCount, 1, visibleStart);
+    range.endIndex = Clay__VirtualListFindItem(&config, childGap, range.startIndex, config.itemCount, 0, visibleEnd);
+    if (range.startIndex > 0) {
+        Clay__OpenVirtualListSpacer(vertical, Clay__VirtualListItemOffset(&config, range.startIndex, childGap) - childGap);
+    }
+    if (range.endIndex < config.itemCount) {
+        range.trailingSize = Clay__VirtualListItemOffset(&config, config.itemCount, childGap) - Clay__VirtualListItemOffset(&config, range.endIndex, childGap) - childGap;
+    }
+    return range;
+}
+
+CLAY_WASM_EXPORT("Clay_EndVirtualList")
+void Clay_EndVirtualList(Clay_VirtualListRange range) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    if (context->booleanWarnings.maxElementsExceeded || range.trailingSize < 0) {
+        return;
+    }
+    Clay__OpenVirtualListSpacer(Clay__GetOpenLayoutElement()->layoutConfig->layoutDirection == CLAY_TOP_TO_BOTTOM, range.trailingSize);
+}
+
 CLAY_WASM_EXPORT("Clay_UpdateScrollContainers")
 void Clay_UpdateScrollContainers(bool enableDragScrolling, Clay_Vector2 scrollDelta, float deltaTime) {
     Clay_Context* context = Clay_GetCurrentContext();
+    Clay__UpdatePointerOverIds(context);
     bool isPointerActive = enableDragScrolling && (context->pointerInfo.state == CLAY_POINTER_DATA_PRESSED || context->pointerInfo.state == CLAY_POINTER_DATA_PRESSED_THIS_FRAME);
     // Don't apply scroll events to ancestors of the inner element
     int32_t highestPriorityElementIndex = -1;
@@ -4215,8 +6317,22 @@ void Clay_UpdateScrollContainers(bool enableDragScrolling, Clay_Vector2 scrollDe
 CLAY_WASM_EXPORT("Clay_BeginLayout")
 void Clay_BeginLayout(void) {
     Clay_Context* context = Clay_GetCurrentContext();
+    if (context->retainedLayoutEnabled) { // Keep last frame's wrapped lines and render commands around to copy from
+        Clay__WrappedTextLineArray wrappedTextLines = context->previousWrappedTextLines;
+        context->previousWrappedTextLines = context->wrappedTextLines;
+        context->wrappedTextLines = wrappedTextLines;
+        Clay_RenderCommandArray renderCommands = context->previousRenderCommands;
+        context->previousRenderCommands = context->renderCommands;
+        context->renderCommands = renderCommands;
+    }
+    // The hit test index lives in ephemeral memory, so settle the pointer against last frame's layout first
+    Clay__UpdatePointerOverIds(context);
+    context->pointerHitTestQueries = 0;
+    context->hoverFunctionCount = 0;
     Clay__InitializeEphemeralMemory(context);
     context->generation++;
+    Clay__SweepMeasureTextCache(context);
+    context->declarationHash = 1;
     context->dynamicElementIndex = 0;
     // Set up the root container that covers the entire window
     Clay_Dimensions rootDimensions = {context->layoutDimensions.width, context->layoutDimensions.height};
@@ -4249,7 +6365,7 @@ Clay_RenderCommandArray Clay_EndLayout(void) {
         } else {
             message = CLAY_STRING("Clay Error: Layout elements exceeded Clay__maxElementCount");
         }
-        Clay__AddRenderCommand(CLAY__INIT(Clay_RenderCommand ) {
+        Clay__AddRenderCommand(&context->renderCommands, CLAY__INIT(Clay_RenderCommand ) {
             .boundingBox = { context->layoutDimensions.width / 2 - 59 * 4, context->layoutDimensions.height / 2, 0, 0 },
             .renderData = { .text = { .stringContents = CLAY__INIT(Clay_StringSlice) { .length = message.length, .chars = message.chars, .baseChars = message.chars }, .textColor = {255, 0, 0, 255}, .fontSize = 16 } },
             .commandType = CLAY_RENDER_COMMAND_TYPE_TEXT
@@ -4261,7 +6377,10 @@ Clay_RenderCommandArray Clay_EndLayout(void) {
                 .errorText = CLAY_STRING("There were still open layout elements when EndLayout was called. This results from an unequal number of calls to Clay__OpenElement and Clay__CloseElement."),
                 .userData = context->errorHandler.userData });
     }
-    Clay__CalculateFinalLayout();
+    if (!Clay__RepeatPreviousLayout()) {
+        Clay__CalculateFinalLayout();
+    }
+    context->pointerHitTestQueries = 0;
     return context->renderCommands;
 }
 
@@ -4285,6 +6404,7 @@ bool Clay_Hovered(void) {
     if (openLayoutElement->id == 0) {
         Clay__GenerateIdForAnonymousElement(openLayoutElement);
     }
+    Clay__UpdatePointerOverIds(context);
     for (int32_t i = 0; i < context->pointerOverIds.length; ++i) {
         if (Clay_ElementIdArray_Get(&context->pointerOverIds, i)->id == openLayoutElement->id) {
             return true;
@@ -4302,14 +6422,16 @@ void Clay_OnHover(void (*onHoverFunction)(Clay_ElementId elementId, Clay_Pointer
     if (openLayoutElement->id == 0) {
         Clay__GenerateIdForAnonymousElement(openLayoutElement);
     }
-    Clay_LayoutElementHashMapItem *hashMapItem = Clay__GetHashMapItem(openLayoutElement->id);
-    hashMapItem->onHoverFunction = onHoverFunction;
-    hashMapItem->hoverFunctionUserData = userData;
+    Clay__LayoutElementHashMapColdItem *coldItem = Clay__GetHashMapColdItem(Clay__GetHashMapItem(openLayoutElement->id));
+    coldItem->onHoverFunction = onHoverFunction;
+    coldItem->hoverFunctionUserData = userData;
+    context->hoverFunctionCount++;
 }
 
 CLAY_WASM_EXPORT("Clay_PointerOver")
 bool Clay_PointerOver(Clay_ElementId elementId) { // TODO return priority for separating multiple results
     Clay_Context* context = Clay_GetCurrentContext();
+    Clay__UpdatePointerOverIds(context);
     for (int32_t i = 0; i < context->pointerOverIds.length; ++i) {
         if (Clay_ElementIdArray_Get(&context->pointerOverIds, i)->id == elementId.id) {
             return true;
@@ -4369,12 +6491,22 @@ CLAY_WASM_EXPORT("Clay_SetCullingEnabled")
 void Clay_SetCullingEnabled(bool enabled) {
     Clay_Context* context = Clay_GetCurrentContext();
     context->disableCulling = !enabled;
+    context->retainedGeneration++;
+}
+
+CLAY_WASM_EXPORT("Clay_SetRetainedLayoutEnabled")
+void Clay_SetRetainedLayoutEnabled(bool enabled) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    context->retainedLayoutEnabled = enabled;
+    context->retainedGeneration++;
 }
 
 CLAY_WASM_EXPORT("Clay_SetExternalScrollHandlingEnabled")
 void Clay_SetExternalScrollHandlingEnabled(bool enabled) {
     Clay_Context* context = Clay_GetCurrentContext();
     context->externalScrollHandlingEnabled = enabled;
+    context->retainedGeneration++;
+    context->pointerHitTestQueries = 0;
 }
 
 CLAY_WASM_EXPORT("Clay_GetMaxElementCount")
@@ -4416,13 +6548,492 @@ void Clay_ResetMeasureTextCache(void) {
     context->measureTextHashMapInternal.length = 0;
     context->measureTextHashMapInternalFreeList.length = 0;
     context->measureTextHashMap.length = 0;
-    context->measuredWords.length = 0;
-    context->measuredWordsFreeList.length = 0;
+    context->measuredWordsTop = 0;
+    context->measuredWordsFreed = 0;
     
     for (int32_t i = 0; i < context->measureTextHashMap.capacity; ++i) {
         context->measureTextHashMap.internalArray[i] = 0;
     }
     context->measureTextHashMapInternal.length = 1; // Reserve the 0 value to mean "no next element"
+    context->measureTextCacheClockBucket = 0;
+    context->measureTextCacheSweepBucket = 0;
+    context->retainedGeneration++; // Measurements may have changed
+}
+
+CLAY_WASM_EXPORT("Clay_GetMeasureTextCacheStats")
+Clay_MeasureTextCacheStats Clay_GetMeasureTextCacheStats(void) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay_MeasureTextCacheStats stats = context->measureTextCacheStats;
+    stats.wordsUsed = context->measuredWordsTop - context->measuredWordsFreed;
+    stats.wordCapacity = context->measuredWordStartOffsets.capacity;
+    return stats;
+}
+
+// A saved measure text cache is a header, then its items, then all of their words in item order. Everything is a 32 or 64
+// bit field at a fixed offset, with words referring to their text by offset, so the data can be used from any address.
+// Reading the magic number back in the wrong byte order fails, as does a version from a different layout, and a checksum
+// of everything after the header catches files that were cut short or damaged.
+#define CLAY__MEASURE_TEXT_CACHE_FILE_MAGIC 0x434D4C43 // "CLMC"
+#define CLAY__MEASURE_TEXT_CACHE_FILE_VERSION 2
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fontKey;
+    uint64_t checksum;
+    int32_t itemCount;
+    int32_t wordCount;
+} Clay__MeasureTextCacheFileHeader;
+
+typedef struct {
+    uint32_t id;
+    int32_t textLength;
+    int32_t wordCount;
+    uint32_t containsNewlines;
+    Clay_Dimensions unwrappedDimensions;
+    float minWidth;
+    float spaceWidth;
+} Clay__MeasureTextCacheFileItem;
+
+typedef struct {
+    int32_t startOffset;
+    int32_t length;
+    float width;
+} Clay__MeasureTextCacheFileWord;
+
+// Saved data may be at any alignment, so it's copied a byte at a time
+void Clay__CopyBytes(void *destination, const void *source, int32_t length) {
+    for (int32_t i = 0; i < length; ++i) {
+        ((uint8_t *)destination)[i] = ((const uint8_t *)source)[i];
+    }
+}
+
+CLAY_WASM_EXPORT("Clay_SaveMeasureTextCache")
+int32_t Clay_SaveMeasureTextCache(void *buffer, int32_t bufferSize, uint64_t fontKey) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__MeasureTextCacheFileHeader header = { .magic = CLAY__MEASURE_TEXT_CACHE_FILE_MAGIC, .version = CLAY__MEASURE_TEXT_CACHE_FILE_VERSION, .fontKey = fontKey };
+    for (int32_t i = 1; i < context->measureTextHashMapInternal.length; ++i) {
+        Clay__MeasureTextCacheItem *item = &context->measureTextHashMapInternal.internalArray[i];
+        if (item->id != 0 && item->contentHashed) {
+            header.itemCount++;
+            header.wordCount += item->measuredWordsCount;
+        }
+    }
+    int32_t wordsOffset = (int32_t)sizeof(header) + header.itemCount * (int32_t)sizeof(Clay__MeasureTextCacheFileItem);
+    int32_t size = wordsOffset + header.wordCount * (int32_t)sizeof(Clay__MeasureTextCacheFileWord);
+    if (!buffer || size > bufferSize) {
+        return size;
+    }
+    uint8_t *itemData = (uint8_t *)buffer + sizeof(header);
+    uint8_t *wordData = (uint8_t *)buffer + wordsOffset;
+    for (int32_t i = 1; i < context->measureTextHashMapInternal.length; ++i) {
+        Clay__MeasureTextCacheItem *item = &context->measureTextHashMapInternal.internalArray[i];
+        if (item->id == 0 || !item->contentHashed) {
+            continue;
+        }
+        Clay__MeasureTextCacheFileItem fileItem = { item->id, item->textLength, item->measuredWordsCount, item->containsNewlines, item->unwrappedDimensions, item->minWidth, item->spaceWidth };
+        Clay__CopyBytes(itemData, &fileItem, sizeof(fileItem));
+        itemData += sizeof(fileItem);
+        for (int32_t j = item->measuredWordsStart; j < item->measuredWordsStart + item->measuredWordsCount; ++j) {
+            Clay__MeasureTextCacheFileWord fileWord = { context->measuredWordStartOffsets.internalArray[j], context->measuredWordLengths.internalArray[j], context->measuredWordWidths.internalArray[j] };
+            Clay__CopyBytes(wordData, &fileWord, sizeof(fileWord));
+            wordData += sizeof(fileWord);
+        }
+    }
+    header.checksum = Clay__HashData((uint8_t *)buffer + sizeof(header), (size_t)(size - (int32_t)sizeof(header)));
+    Clay__CopyBytes(buffer, &header, sizeof(header));
+    return size;
+}
+
+CLAY_WASM_EXPORT("Clay_LoadMeasureTextCache")
+int32_t Clay_LoadMeasureTextCache(const void *data, int32_t dataSize, uint64_t fontKey) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__MeasureTextCacheFileHeader header;
+    if (!data || dataSize < (int32_t)sizeof(header)) {
+        return 0;
+    }
+    Clay__CopyBytes(&header, data, sizeof(header));
+    if (header.magic != CLAY__MEASURE_TEXT_CACHE_FILE_MAGIC || header.version != CLAY__MEASURE_TEXT_CACHE_FILE_VERSION || header.fontKey != fontKey
+        || header.itemCount < 0 || header.wordCount < 0
+        || (int64_t)sizeof(header) + (int64_t)header.itemCount * (int64_t)sizeof(Clay__MeasureTextCacheFileItem) + (int64_t)header.wordCount * (int64_t)sizeof(Clay__MeasureTextCacheFileWord) > dataSize) {
+        return 0;
+    }
+    int32_t payloadSize = header.itemCount * (int32_t)sizeof(Clay__MeasureTextCacheFileItem) + header.wordCount * (int32_t)sizeof(Clay__MeasureTextCacheFileWord);
+    if (Clay__HashData((const uint8_t *)data + sizeof(header), (size_t)payloadSize) != header.checksum) {
+        return 0;
+    }
+    const uint8_t *itemData = (const uint8_t *)data + sizeof(header);
+    const uint8_t *wordData = itemData + header.itemCount * sizeof(Clay__MeasureTextCacheFileItem);
+    int32_t loaded = 0;
+    int32_t wordCount = 0;
+    for (int32_t i = 0; i < header.itemCount; ++i, itemData += sizeof(Clay__MeasureTextCacheFileItem)) {
+        Clay__MeasureTextCacheFileItem fileItem;
+        Clay__CopyBytes(&fileItem, itemData, sizeof(fileItem));
+        const uint8_t *itemWordData = wordData + wordCount * sizeof(Clay__MeasureTextCacheFileWord);
+        if (fileItem.wordCount < 0 || fileItem.wordCount > header.wordCount - wordCount) {
+            break;
+        }
+        wordCount += fileItem.wordCount;
+        // Loading only fills free space, it doesn't evict
+        int32_t freeWords = context->measuredWordStartOffsets.capacity - (context->measuredWordsTop - context->measuredWordsFreed);
+        if (fileItem.id == 0 || fileItem.wordCount > freeWords || !Clay__MeasureTextCacheHasSpace(context, true)) {
+            continue;
+        }
+        // Words with offsets outside the text would have wrapping read outside it
+        bool valid = true;
+        for (int32_t j = 0; j < fileItem.wordCount && valid; ++j) {
+            Clay__MeasureTextCacheFileWord fileWord;
+            Clay__CopyBytes(&fileWord, itemWordData + j * sizeof(fileWord), sizeof(fileWord));
+            valid = fileWord.startOffset >= 0 && fileWord.length >= 0 && fileWord.startOffset <= fileItem.textLength - fileWord.length;
+        }
+        uint32_t hashBucket = fileItem.id % Clay__MeasureTextCacheBucketCount(context);
+        for (int32_t elementIndex = context->measureTextHashMap.internalArray[hashBucket]; elementIndex != 0 && valid;) {
+            Clay__MeasureTextCacheItem *hashEntry = &context->measureTextHashMapInternal.internalArray[elementIndex];
+            valid = hashEntry->id != fileItem.id || hashEntry->textLength != fileItem.textLength;
+            elementIndex = hashEntry->nextIndex;
+        }
+        if (!valid) {
+            continue;
+        }
+        int32_t newItemIndex;
+        if (context->measureTextHashMapInternalFreeList.length > 0) {
+            newItemIndex = context->measureTextHashMapInternalFreeList.internalArray[--context->measureTextHashMapInternalFreeList.length];
+        } else {
+            newItemIndex = context->measureTextHashMapInternal.length++;
+        }
+        Clay__MeasureTextCacheItem *item = &context->measureTextHashMapInternal.internalArray[newItemIndex];
+        *item = CLAY__INIT(Clay__MeasureTextCacheItem) {
+            .unwrappedDimensions = fileItem.unwrappedDimensions,
+            .minWidth = fileItem.minWidth,
+            .spaceWidth = fileItem.spaceWidth,
+            .containsNewlines = fileItem.containsNewlines != 0,
+            .contentHashed = true,
+            .textLength = fileItem.textLength,
+            .id = fileItem.id,
+            .nextIndex = context->measureTextHashMap.internalArray[hashBucket],
+            .generation = context->generation,
+        };
+        for (int32_t j = 0; j < fileItem.wordCount; ++j) {
+            Clay__MeasureTextCacheFileWord fileWord;
+            Clay__CopyBytes(&fileWord, itemWordData + j * sizeof(fileWord), sizeof(fileWord));
+            Clay__AddMeasuredWord(context, item, newItemIndex, fileWord.startOffset, fileWord.length, fileWord.width);
+        }
+        context->measureTextHashMap.internalArray[hashBucket] = newItemIndex;
+        loaded++;
+    }
+    return loaded;
+}
+
+// Prewarmed text is a header, then for each text a record, its characters padded to 8 bytes, its word starts, word
+// lengths and word dimensions, with every part 8 byte aligned given an aligned buffer.
+#define CLAY__PREWARMED_TEXT_MAGIC 0x54575043 // "CPWT"
+// How many layouts a merged text is kept for without being shown
+#define CLAY__PREWARMED_TEXT_LAYOUTS 60
+
+typedef struct {
+    uint32_t magic;
+    int32_t count;
+    int32_t size;
+    int32_t padding;
+} Clay__PrewarmedTextHeader;
+
+typedef struct {
+    Clay_TextElementConfig config;
+    Clay_Dimensions spaceDimensions;
+    int32_t textLength;
+    int32_t wordCount;
+    int32_t recordSize;
+    bool measured;
+} Clay__PrewarmedTextRecord;
+
+int32_t Clay__CountWords(const char *chars, int32_t length) {
+    int32_t wordCount = 0;
+    for (int32_t start = 0; start <= length;) {
+        int32_t end = Clay__FindWordBoundary(chars, start, length);
+        wordCount += end > start;
+        start = end + 1;
+    }
+    return wordCount;
+}
+
+int32_t Clay__PrewarmedTextRecordSize(int32_t textLength, int32_t wordCount) {
+    return (int32_t)sizeof(Clay__PrewarmedTextRecord) + ((textLength + 7) & ~7) + wordCount * (int32_t)(sizeof(int32_t) * 2 + sizeof(Clay_Dimensions));
+}
+
+CLAY_WASM_EXPORT("Clay_PrewarmText")
+int32_t Clay_PrewarmText(const Clay_String *texts, const Clay_TextElementConfig *configs, int32_t count, void *buffer, int32_t bufferSize) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    int32_t size = (int32_t)sizeof(Clay__PrewarmedTextHeader);
+    for (int32_t i = 0; i < count; ++i) {
+        size += Clay__PrewarmedTextRecordSize(texts[i].length, Clay__CountWords(texts[i].chars, texts[i].length));
+    }
+    if (!buffer || size > bufferSize) {
+        return size;
+    }
+    *(Clay__PrewarmedTextHeader *)buffer = CLAY__INIT(Clay__PrewarmedTextHeader) { .magic = CLAY__PREWARMED_TEXT_MAGIC, .count = count, .size = size };
+    uint8_t *cursor = (uint8_t *)buffer + sizeof(Clay__PrewarmedTextHeader);
+    for (int32_t i = 0; i < count; ++i) {
+        Clay__PrewarmedTextRecord *record = (Clay__PrewarmedTextRecord *)cursor;
+        char *chars = (char *)(record + 1);
+        Clay__CopyBytes(chars, texts[i].chars, texts[i].length);
+        Clay_String text = { .length = texts[i].length, .chars = chars };
+        *record = CLAY__INIT(Clay__PrewarmedTextRecord) { .config = configs[i], .textLength = text.length, .wordCount = Clay__CountWords(chars, text.length) };
+        record->recordSize = Clay__PrewarmedTextRecordSize(text.length, record->wordCount);
+        int32_t *wordStarts = (int32_t *)(chars + ((text.length + 7) & ~7));
+        int32_t *wordLengths = wordStarts + record->wordCount;
+        Clay_MeasureTextBatch batch = {
+            .text = { .length = text.length, .chars = chars, .baseChars = chars },
+            .wordStarts = wordStarts,
+            .wordLengths = wordLengths,
+            .wordCount = record->wordCount,
+            .wordDimensions = (Clay_Dimensions *)(wordLengths + record->wordCount),
+        };
+        // Split the same way as Clay__MeasureTextBatched, which is the order Clay__MeasureTextCached takes the words in
+        int32_t wordIndex = 0;
+        for (int32_t start = 0; start <= text.length;) {
+            int32_t end = Clay__FindWordBoundary(chars, start, text.length);
+            if (end > start) {
+                wordStarts[wordIndex] = start;
+                wordLengths[wordIndex] = end - start;
+                batch.wordDimensions[wordIndex] = CLAY__INIT(Clay_Dimensions) CLAY__DEFAULT_STRUCT;
+                wordIndex++;
+            }
+            start = end + 1;
+        }
+        Clay__FontMetrics *fontMetrics = Clay__FindFontMetrics(context, &text, &record->config);
+        Clay_StringSlice space = { .length = 1, .chars = CLAY__SPACECHAR.chars, .baseChars = CLAY__SPACECHAR.chars };
+        if (fontMetrics) {
+            for (int32_t j = 0; j < batch.wordCount; ++j) {
+                batch.wordDimensions[j] = Clay__MeasureWordWithFontMetrics(fontMetrics, CLAY__INIT(Clay_StringSlice) { .length = batch.wordLengths[j], .chars = chars + batch.wordStarts[j], .baseChars = chars }, (float)record->config.letterSpacing);
+            }
+            batch.spaceDimensions = Clay__MeasureWordWithFontMetrics(fontMetrics, space, (float)record->config.letterSpacing);
+            record->measured = true;
+        } else if (context->measureTextBatchFunction) {
+            context->measureTextBatchFunction(&batch, &record->config, context->measureTextBatchUserData);
+            record->measured = true;
+        }
+        #ifndef CLAY_WASM
+        else if (context->measureTextFunction)
+        #else
+        else
+        #endif
+        {
+            for (int32_t j = 0; j < batch.wordCount; ++j) {
+                batch.wordDimensions[j] = Clay__MeasureText(CLAY__INIT(Clay_StringSlice) { .length = batch.wordLengths[j], .chars = chars + batch.wordStarts[j], .baseChars = chars }, &record->config, context->measureTextUserData);
+            }
+            batch.spaceDimensions = Clay__MeasureText(space, &record->config, context->measureTextUserData);
+            record->measured = true;
+        }
+        record->spaceDimensions = batch.spaceDimensions;
+        cursor += record->recordSize;
+    }
+    return size;
+}
+
+CLAY_WASM_EXPORT("Clay_MergePrewarmedText")
+int32_t Clay_MergePrewarmedText(const void *data, int32_t dataSize) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    const Clay__PrewarmedTextHeader *header = (const Clay__PrewarmedTextHeader *)data;
+    if (!data || dataSize < (int32_t)sizeof(Clay__PrewarmedTextHeader) || header->magic != CLAY__PREWARMED_TEXT_MAGIC || header->size > dataSize) {
+        return 0;
+    }
+    int32_t merged = 0;
+    const uint8_t *cursor = (const uint8_t *)data + sizeof(Clay__PrewarmedTextHeader);
+    const uint8_t *end = (const uint8_t *)data + header->size;
+    for (int32_t i = 0; i < header->count; ++i) {
+        // Checked one bound at a time, so that the record size it's compared with can't overflow
+        int32_t remaining = (int32_t)(end - cursor) - (int32_t)sizeof(Clay__PrewarmedTextRecord);
+        const Clay__PrewarmedTextRecord *record = (const Clay__PrewarmedTextRecord *)cursor;
+        if (remaining < 0 || record->textLength < 0 || record->textLength > remaining || record->wordCount < 0) {
+            break;
+        }
+        int32_t paddedTextLength = (int32_t)(((uint32_t)record->textLength + 7) & ~7u);
+        if (paddedTextLength > remaining || record->wordCount > (remaining - paddedTextLength) / (int32_t)(sizeof(int32_t) * 2 + sizeof(Clay_Dimensions))
+            || record->recordSize != Clay__PrewarmedTextRecordSize(record->textLength, record->wordCount)) {
+            break;
+        }
+        cursor += record->recordSize;
+        if (!record->measured) {
+            continue;
+        }
+        const char *chars = (const char *)(record + 1);
+        Clay_String text = { .length = record->textLength, .chars = chars };
+        Clay_TextElementConfig config = record->config;
+        const int32_t *wordStarts = (const int32_t *)(chars + ((text.length + 7) & ~7));
+        // Only read from, the batch just has the type a measure function fills in
+        Clay_MeasureTextBatch batch = {
+            .text = { .length = text.length, .chars = chars, .baseChars = chars },
+            .wordStarts = wordStarts,
+            .wordLengths = wordStarts + record->wordCount,
+            .wordCount = record->wordCount,
+            .wordDimensions = (Clay_Dimensions *)(wordStarts + record->wordCount * 2),
+            .spaceDimensions = record->spaceDimensions,
+        };
+        Clay__MeasureTextCacheItem *item = Clay__MeasureTextCachedWithBatch(&text, &config, &batch);
+        if (item != &Clay__MeasureTextCacheItem_DEFAULT) {
+            item->generation = context->generation + CLAY__PREWARMED_TEXT_LAYOUTS;
+            merged++;
+        }
+    }
+    return merged;
+}
+
+CLAY_WASM_EXPORT("Clay_SetFontMetrics")
+void Clay_SetFontMetrics(Clay_FontMetrics metrics) {
+    Clay_Context* context = Clay_GetCurrentContext();
+    Clay__FontMetrics fontMetrics = { .fontId = metrics.fontId, .fontSize = metrics.fontSize, .lineHeight = metrics.lineHeight };
+    bool remove = metrics.monospaceAdvance <= 0 && !metrics.advances;
+    if (metrics.monospaceAdvance > 0) {
+        fontMetrics.monospaceAdvance = metrics.monospaceAdvance;
+    } else if (metrics.advances) {
+        for (int32_t i = 0; i < 256; ++i) {
+            fontMetrics.advances[i] = metrics.advances[i];
+        }
+    }
+    int32_t index = 0;
+    while (index < context->fontMetrics.length && (context->fontMetrics.internalArray[index].fontId != metrics.fontId || context->fontMetrics.internalArray[index].fontSize != metrics.fontSize)) {
+        index++;
+    }
+    if (index == context->fontMetrics.length) {
+        if (remove || index == context->fontMetrics.capacity) {
+            return;
+        }
+        context->fontMetrics.length++;
+    } else if (remove) {
+        context->fontMetrics.internalArray[index] = context->fontMetrics.internalArray[--context->fontMetrics.length];
+        Clay_ResetMeasureTextCache();
+        return;
+    } else if (Clay__MemCmp((char *)&context->fontMetrics.internalArray[index], (char *)&fontMetrics, sizeof(fontMetrics))) {
+        return;
+    }
+    context->fontMetrics.internalArray[index] = fontMetrics;
+    Clay_ResetMeasureTextCache();
+}
+
+// Explicit context API --------------------
+
+// Runs statement with context current on the calling thread, then restores the previous current context
+#define CLAY__WITH_CONTEXT(context, statement) do { \
+    Clay_Context *previousContext = Clay__currentContext; \
+    Clay__currentContext = (context); \
+    statement; \
+    Clay__currentContext = previousContext; \
+} while (0)
+
+CLAY_WASM_EXPORT("Clay_SetLayoutDimensionsCtx")
+void Clay_SetLayoutDimensionsCtx(Clay_Context *context, Clay_Dimensions dimensions) {
+    context->layoutDimensions = dimensions;
+}
+
+CLAY_WASM_EXPORT("Clay_SetPointerStateCtx")
+void Clay_SetPointerStateCtx(Clay_Context *context, Clay_Vector2 position, bool isPointerDown) {
+    CLAY__WITH_CONTEXT(context, Clay_SetPointerState(position, isPointerDown));
+}
+
+CLAY_WASM_EXPORT("Clay_UpdateScrollContainersCtx")
+void Clay_UpdateScrollContainersCtx(Clay_Context *context, bool enableDragScrolling, Clay_Vector2 scrollDelta, float deltaTime) {
+    CLAY__WITH_CONTEXT(context, Clay_UpdateScrollContainers(enableDragScrolling, scrollDelta, deltaTime));
+}
+
+CLAY_WASM_EXPORT("Clay_BeginLayoutCtx")
+void Clay_BeginLayoutCtx(Clay_Context *context) {
+    Clay_SetCurrentContext(context);
+    Clay_BeginLayout();
+}
+
+CLAY_WASM_EXPORT("Clay_EndLayoutCtx")
+Clay_RenderCommandArray Clay_EndLayoutCtx(Clay_Context *context) {
+    Clay_RenderCommandArray renderCommands;
+    CLAY__WITH_CONTEXT(context, renderCommands = Clay_EndLayout());
+    return renderCommands;
+}
+
+CLAY_WASM_EXPORT("Clay_GetElementDataCtx")
+Clay_ElementData Clay_GetElementDataCtx(Clay_Context *context, Clay_ElementId id) {
+    Clay_ElementData data;
+    CLAY__WITH_CONTEXT(context, data = Clay_GetElementData(id));
+    return data;
+}
+
+CLAY_WASM_EXPORT("Clay_PointerOverCtx")
+bool Clay_PointerOverCtx(Clay_Context *context, Clay_ElementId elementId) {
+    bool over;
+    CLAY__WITH_CONTEXT(context, over = Clay_PointerOver(elementId));
+    return over;
+}
+
+CLAY_WASM_EXPORT("Clay_GetScrollContainerDataCtx")
+Clay_ScrollContainerData Clay_GetScrollContainerDataCtx(Clay_Context *context, Clay_ElementId id) {
+    Clay_ScrollContainerData data;
+    CLAY__WITH_CONTEXT(context, data = Clay_GetScrollContainerData(id));
+    return data;
+}
+
+#ifndef CLAY_WASM
+void Clay_SetMeasureTextFunctionCtx(Clay_Context *context, Clay_Dimensions (*measureTextFunction)(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData), void *userData) {
+    context->measureTextFunction = measureTextFunction;
+    context->measureTextUserData = userData;
+}
+
+void Clay_SetMeasureTextBatchFunctionCtx(Clay_Context *context, void (*measureTextBatchFunction)(Clay_MeasureTextBatch *batch, Clay_TextElementConfig *config, void *userData), void *userData) {
+    context->measureTextBatchFunction = measureTextBatchFunction;
+    context->measureTextBatchUserData = userData;
+}
+
+void Clay_SetQueryScrollOffsetFunctionCtx(Clay_Context *context, Clay_Vector2 (*queryScrollOffsetFunction)(uint32_t elementId, void *userData), void *userData) {
+    context->queryScrollOffsetFunction = queryScrollOffsetFunction;
+    context->queryScrollOffsetUserData = userData;
+}
+
+void Clay_SetParallelForFunctionCtx(Clay_Context *context, void (*parallelForFunction)(int32_t count, void (*task)(int32_t index, void *taskData), void *taskData, void *userData), void *userData) {
+    context->parallelForFunction = parallelForFunction;
+    context->parallelForUserData = userData;
+}
+#endif
+
+CLAY_WASM_EXPORT("Clay_SetFontMetricsCtx")
+void Clay_SetFontMetricsCtx(Clay_Context *context, Clay_FontMetrics metrics) {
+    CLAY__WITH_CONTEXT(context, Clay_SetFontMetrics(metrics));
+}
+
+CLAY_WASM_EXPORT("Clay_ResetMeasureTextCacheCtx")
+void Clay_ResetMeasureTextCacheCtx(Clay_Context *context) {
+    CLAY__WITH_CONTEXT(context, Clay_ResetMeasureTextCache());
+}
+
+CLAY_WASM_EXPORT("Clay_SaveMeasureTextCacheCtx")
+int32_t Clay_SaveMeasureTextCacheCtx(Clay_Context *context, void *buffer, int32_t bufferSize, uint64_t fontKey) {
+    int32_t size;
+    CLAY__WITH_CONTEXT(context, size = Clay_SaveMeasureTextCache(buffer, bufferSize, fontKey));
+    return size;
+}
+
+CLAY_WASM_EXPORT("Clay_LoadMeasureTextCacheCtx")
+int32_t Clay_LoadMeasureTextCacheCtx(Clay_Context *context, const void *data, int32_t dataSize, uint64_t fontKey) {
+    int32_t loaded;
+    CLAY__WITH_CONTEXT(context, loaded = Clay_LoadMeasureTextCache(data, dataSize, fontKey));
+    return loaded;
+}
+
+CLAY_WASM_EXPORT("Clay_PrewarmTextCtx")
+int32_t Clay_PrewarmTextCtx(Clay_Context *context, const Clay_String *texts, const Clay_TextElementConfig *configs, int32_t count, void *buffer, int32_t bufferSize) {
+    int32_t size;
+    CLAY__WITH_CONTEXT(context, size = Clay_PrewarmText(texts, configs, count, buffer, bufferSize));
+    return size;
+}
+
+CLAY_WASM_EXPORT("Clay_MergePrewarmedTextCtx")
+int32_t Clay_MergePrewarmedTextCtx(Clay_Context *context, const void *data, int32_t dataSize) {
+    int32_t merged;
+    CLAY__WITH_CONTEXT(context, merged = Clay_MergePrewarmedText(data, dataSize));
+    return merged;
+}
+
+CLAY_WASM_EXPORT("Clay_GetMeasureTextCacheStatsCtx")
+Clay_MeasureTextCacheStats Clay_GetMeasureTextCacheStatsCtx(Clay_Context *context) {
+    Clay_MeasureTextCacheStats stats;
+    CLAY__WITH_CONTEXT(context, stats = Clay_GetMeasureTextCacheStats());
+    return stats;
 }
 
 #endif // CLAY_IMPLEMENTATION
@@ -1,32 +1,81 @@
 /*
  * clay_bar.c
  *
- * Shaped top-right time display with no background.
+ * Shaped time display with no background, laid out with Clay.
  *
  * Compile:
- *   gcc -O2 -Wall -Wextra -std=c99 -o clay_bar clay_bar.c -lX11 -lcairo -lm
+ *   gcc -O2 -Wall -Wextra -std=c99 -pthread -o clay_bar clay_bar.c -lX11 -lXext -lcairo -lm
+ *
+ * Usage:
+ *   clay_bar [layout-file]
  *
  * Notes:
  * - Only uses XShape to make the window match text region.
- * - No background rectangle. Only text is visible.
+ * - No background rectangle unless the layout asks for one.
+ * - The layout file defaults to $XDG_CONFIG_HOME/clay_bar/layout (or
+ *   ~/.config/clay_bar/layout). It is reloaded whenever it is saved, and a
+ *   built-in layout is used while it doesn't exist.
+ * - CLAY_BAR_TRACE=1 prints a timeline of the startup phases to stderr.
+ *
+ * Layout file:
+ *   One directive per line and "#" to the end of a line is a comment. Values
+ *   with spaces are quoted, with \" and \\ as escapes. For example:
+ *
+ *     font  face="monospace" size=18 weight=bold
+ *     bar   anchor=top-right margin=7 padding=7,3
+ *     clock format="%a/%-d %I:%M:%S %p"
+ *     text  text=" | " color=#808080
+ *     clock tz="Asia/Tokyo" format="TYO %H:%M"
+ *
+ *   font   face=NAME size=N weight=bold|normal slant=normal|italic
+ *   bar    anchor=top-left|top|top-right|bottom-left|bottom|bottom-right
+ *          margin=N (from the side of the screen) padding=P gap=N
+ *          direction=row|column align=left|center|right width=W
+ *          background=COLOR refresh=SECONDS
+ *   clock  format=STRFTIME tz=NAME reserve=yes|no
+ *   text   text=STRING
+ *
+ *   clock and text are segments, placed in order, that also take color=COLOR
+ *   background=COLOR padding=P width=W align=left|center|right.
+ *   COLOR is #rrggbb or #rrggbbaa. P is N, H,V or L,R,T,B. W is one of fit,
+ *   grow, fit:MIN, grow:MIN:MAX, fixed:N or percent:N as in Clay's sizing.
+ *   A clock format is strftime() plus "%N" and "%1N".."%9N" for fractional
+ *   seconds as in date(1), e.g. "%H:%M:%S.%3N" with refresh=0.016. A clock
+ *   that reserves (the default) is never narrower than the widest text it can
+ *   render, so the window isn't resized in steady state.
  */
 
 #define _XOPEN_SOURCE 700
 #define _POSIX_C_SOURCE 200809L
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE /* tm_gmtoff, tm_zone */
+#endif
 
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
+#include <math.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <signal.h>
+#include <sys/inotify.h>
 
 #include <cairo/cairo.h>
 #include <cairo/cairo-xlib.h>
 
+#define CLAY_IMPLEMENTATION
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunknown-pragmas" /* clay.h's #pragma region */
+#include "clay.h"
+#pragma GCC diagnostic pop
+
 /* ---------- CONFIG ---------- */
+/* Defaults for whatever the layout file leaves out */
 static const char *FONT_FACE = "monospace";
 static const double FONT_SIZE = 18.0;
 static const int H_PADDING = 7;
@@ -34,6 +83,14 @@ static const int V_PADDING = 3;
 static const int FG_R = 220, FG_G = 220, FG_B = 220;
 static const double FG_A = 1.0;
 static const double REFRESH_INTERVAL = 0.1;
+/* Whether clocks reserve the widest width they can render to */
+static const int FIXED_WIDTH = 1;
+/* With a monospace font, repaint and re-shape only the characters that changed
+ * since the previous frame instead of the whole bar. */
+static const int GLYPH_CELLS = 1;
+/* Layout used while there is no layout file */
+static const char *DEFAULT_LAYOUT =
+    "clock format=\"%a/%-d %I:%M:%S %p\"\n";
 /* ---------------------------- */
 
 static Display *dpy = NULL;
@@ -45,24 +102,1104 @@ static int screen_w = 0, screen_h = 0;
 static cairo_surface_t *surf = NULL;
 static cairo_t *cr = NULL;
 
-static char timebuf[128] = {0};
+#define CLOCK_TEXT_MAX 64
 
 static int shape_available = 0;
 static Pixmap shape_pixmap = 0;
 
-/* Update time string */
-static void update_time(void) {
-    time_t t = time(NULL);
+static int cur_win_w = 0, cur_win_h = 0;
+
+static void *clay_memory = NULL;
+
+/* ---------- font ---------- */
+typedef struct {
+    char face[64];
+    double size;
+    int bold, italic;
+} font_spec;
+
+static font_spec font;                    /* font of the current layout */
+static cairo_surface_t *measure_surf = NULL;
+static cairo_t *measure_cr = NULL;        /* measures text for Clay and the cells */
+static cairo_font_extents_t font_extents;
+static double space_width = 0;
+static double mono_advance = 0;           /* glyph advance if the font is monospaced */
+static float glyph_advances[256];         /* per-byte advances for Clay, -1 where a byte isn't a glyph alone */
+
+static void set_font(cairo_t *c) {
+    cairo_select_font_face(c, font.face, font.italic ? CAIRO_FONT_SLANT_ITALIC : CAIRO_FONT_SLANT_NORMAL,
+                           font.bold ? CAIRO_FONT_WEIGHT_BOLD : CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(c, font.size);
+}
+
+static int same_font(const font_spec *a, const font_spec *b) {
+    return strcmp(a->face, b->face) == 0 && a->size == b->size && a->bold == b->bold && a->italic == b->italic;
+}
+
+/* Advance of len bytes of chars */
+static double measure_slice(const char *chars, size_t len) {
+    char stack[256];
+    char *s = len < sizeof(stack) ? stack : malloc(len + 1);
+    if (!s) return 0;
+    memcpy(s, chars, len);
+    s[len] = '\0';
+    cairo_text_extents_t te;
+    cairo_text_extents(measure_cr, s, &te);
+    if (s != stack) free(s);
+    return te.x_advance;
+}
+
+static Clay_Dimensions measure_text(Clay_StringSlice text, Clay_TextElementConfig *config, void *user_data) {
+    (void)config;
+    (void)user_data;
+    return (Clay_Dimensions){ (float)measure_slice(text.chars, (size_t)text.length), (float)font_extents.height };
+}
+
+/* Width Clay lays text out at: words measured on their own, joined by spaces */
+static double clay_text_width(const char *text) {
+    double w = 0;
+    const char *word = text;
+    for (const char *p = text;; ++p) {
+        if (*p != ' ' && *p != '\0') continue;
+        if (p > word) w += measure_slice(word, (size_t)(p - word));
+        if (*p == '\0') return w;
+        w += space_width;
+        word = p + 1;
+    }
+}
+
+/* Glyph advance if a few very differently shaped glyphs all share it, else 0 */
+static double detect_monospace(void) {
+    static const char probes[] = "0i1W:M ";
+    double adv = -1;
+    for (const char *p = probes; *p; ++p) {
+        double w = measure_slice(p, 1);
+        if (adv >= 0 && fabs(w - adv) > 1e-3) return 0;
+        adv = w;
+    }
+    return adv > 0 ? adv : 0;
+}
+
+static void free_glyph_cache(void);
+
+/* Switch measuring and drawing to spec */
+static void load_font(const font_spec *spec) {
+    font = *spec;
+    if (!measure_cr) {
+        measure_surf = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+        measure_cr = cairo_create(measure_surf);
+    }
+    set_font(measure_cr);
+    if (cr) set_font(cr);
+    cairo_font_extents(measure_cr, &font_extents);
+    space_width = measure_slice(" ", 1);
+    mono_advance = GLYPH_CELLS ? detect_monospace() : 0;
+    /* the toy text API doesn't kern, so a word's advance is the sum of its glyphs' */
+    for (int i = 0; i < 256; ++i) {
+        char ch = (char)i;
+        glyph_advances[i] = i >= 0x20 && i < 0x7f ? (float)measure_slice(&ch, 1) : -1;
+    }
+    free_glyph_cache();
+}
+
+/* Draw the printable ASCII glyphs once off screen. This gets the font's
+ * FreeType face loaded and its glyphs into cairo's cache ahead of the first
+ * frame and the glyph cells. */
+static void warm_glyphs(void) {
+    char ascii[96];
+    for (int i = 0; i < 95; ++i) ascii[i] = (char)(' ' + i);
+    ascii[95] = '\0';
+    int w = (int)ceil(measure_slice(ascii, 95)) + 1, h = (int)ceil(font_extents.height) + 1;
+    cairo_surface_t *s = cairo_image_surface_create(CAIRO_FORMAT_A8, w, h);
+    cairo_t *c = cairo_create(s);
+    set_font(c);
+    cairo_move_to(c, 0, font_extents.ascent);
+    cairo_show_text(c, ascii);
+    cairo_destroy(c);
+    cairo_surface_destroy(s);
+}
+
+/* ---------- time formatting ---------- */
+/* strftime() has no sub-second conversions, so substitute "%N" and "%1N".."%9N"
+ * with the leading digits of nsec first. "%s" is substituted too, as strftime()
+ * derives it from the process TZ rather than the zone tm was split in. */
+static void expand_format(char *out, size_t size, const char *fmt, time_t epoch, long nsec) {
+    size_t o = 0;
+    for (const char *p = fmt; *p && o + 2 < size; ++p) {
+        int digits = 0;
+        if (p[0] == '%' && p[1] == '%') {
+            out[o++] = *p++;
+        } else if (p[0] == '%' && p[1] == 's') {
+            int len = snprintf(out + o, size - o, "%lld", (long long)epoch);
+            o = len > 0 && (size_t)len < size - o ? o + (size_t)len : size - 1;
+            ++p;
+            continue;
+        } else if (p[0] == '%' && p[1] == 'N') {
+            digits = 9;
+            p += 1;
+        } else if (p[0] == '%' && p[1] >= '1' && p[1] <= '9' && p[2] == 'N') {
+            digits = p[1] - '0';
+            p += 2;
+        }
+        if (digits) {
+            long div = 100000000;
+            for (int d = 0; d < digits && o + 1 < size; ++d, div /= 10)
+                out[o++] = (char)('0' + nsec / div % 10);
+            continue;
+        }
+        out[o++] = *p;
+    }
+    out[o] = '\0';
+}
+
+static void format_time(char *buf, size_t size, const char *fmt, const struct tm *tm, time_t epoch, long nsec) {
+    char expanded[CLOCK_TEXT_MAX];
+    expand_format(expanded, sizeof(expanded), fmt, epoch, nsec);
+    if (strftime(buf, size, expanded, tm) == 0) buf[0] = '\0';
+}
+
+/* ---------- clock module ---------- */
+/* Each clock splits its time into broken-down form once per minute, or when its
+ * zone's UTC offset changes, and between those only patches the seconds and
+ * fractional digits in place. Zone rules are loaded once per offset period. */
+
+/* How far ahead a zone lookup searches for the next UTC offset change */
+#define ZONE_HORIZON (7 * 24 * 3600)
+#define CLOCK_MAX_PATCH 16
+
+typedef struct { int start, end; } text_range;
+
+typedef struct {
+    const char *tz, *format;
+    /* UTC offset, valid for [zone_from, zone_until) */
+    time_t zone_from, zone_until;
+    long gmtoff;
+    int isdst;
+    char zone[16];
+    /* local broken-down time at the start of the current minute */
+    time_t minute_start;
+    struct tm tm;
+    /* text positions of second digits (-1 tens, -2 ones) and fractional
+     * digits (1..9), or patchable == 0 to reformat every tick */
+    int patchable, npatch;
+    unsigned char patch_pos[CLOCK_MAX_PATCH];
+    signed char patch_role[CLOCK_MAX_PATCH];
+    char text[CLOCK_TEXT_MAX];
+    int len;
+    /* what the last update_clocks() did to text, see clock_update() */
+    int changed;
+    text_range change;
+    double widest; /* layout width of the widest text, < 0 until measured */
+} clock_state;
+
+static int same_zone(const clock_state *c, const struct tm *tm) {
+    return tm->tm_gmtoff == c->gmtoff && tm->tm_isdst == c->isdst &&
+           strcmp(tm->tm_zone ? tm->tm_zone : "", c->zone) == 0;
+}
+
+/* Cache the UTC offset at t and find when it next changes. The clock's TZ is
+ * switched in only for the duration of the lookup. */
+static void clock_load_zone(clock_state *c, time_t t) {
+    char *saved_tz = NULL;
+    if (c->tz) {
+        const char *old = getenv("TZ");
+        if (old) saved_tz = strdup(old);
+        setenv("TZ", c->tz, 1);
+        tzset();
+    }
+
     struct tm tm;
     localtime_r(&t, &tm);
-    strftime(timebuf, sizeof(timebuf), "%a/%-d %I:%M:%S %p ", &tm);
+    c->gmtoff = tm.tm_gmtoff;
+    c->isdst = tm.tm_isdst;
+    snprintf(c->zone, sizeof(c->zone), "%s", tm.tm_zone ? tm.tm_zone : "");
+
+    /* hourly steps to the first change, then bisect down to the second */
+    time_t lo = t, hi = t + ZONE_HORIZON;
+    for (time_t p = t + 3600; p < t + ZONE_HORIZON; p += 3600) {
+        localtime_r(&p, &tm);
+        if (!same_zone(c, &tm)) { hi = p; break; }
+        lo = p;
+    }
+    if (hi < t + ZONE_HORIZON) {
+        while (hi - lo > 1) {
+            time_t mid = lo + (hi - lo) / 2;
+            localtime_r(&mid, &tm);
+            if (same_zone(c, &tm)) lo = mid;
+            else hi = mid;
+        }
+    }
+    c->zone_from = t;
+    c->zone_until = hi;
+
+    if (c->tz) {
+        if (saved_tz) setenv("TZ", saved_tz, 1);
+        else unsetenv("TZ");
+        free(saved_tz);
+        tzset();
+    }
+}
+
+/* Local broken-down time for the minute containing t, from the cached offset */
+static void clock_split_minute(clock_state *c, time_t t) {
+    static const int month_days[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+    long long local = (long long)t + c->gmtoff;
+    long long days = local / 86400, rem = local % 86400;
+    if (rem < 0) { rem += 86400; --days; }
+
+    /* civil date from days since 1970-01-01 */
+    long long z = days + 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    int mday = (int)(doy - (153 * mp + 2) / 5 + 1);
+    int mon = (int)(mp < 10 ? mp + 3 : mp - 9);
+    long long year = yoe + era * 400 + (mon <= 2);
+    int leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+
+    memset(&c->tm, 0, sizeof(c->tm));
+    c->tm.tm_year = (int)(year - 1900);
+    c->tm.tm_mon = mon - 1;
+    c->tm.tm_mday = mday;
+    c->tm.tm_yday = month_days[mon - 1] + mday - 1 + (leap && mon > 2);
+    c->tm.tm_wday = (int)(((days % 7) + 11) % 7); /* 1970-01-01 was a Thursday */
+    c->tm.tm_hour = (int)(rem / 3600);
+    c->tm.tm_min = (int)(rem / 60 % 60);
+    c->tm.tm_isdst = c->isdst;
+    c->tm.tm_gmtoff = c->gmtoff;
+    c->tm.tm_zone = c->zone;
+    c->minute_start = t - (time_t)(rem % 60);
+}
+
+static void clock_format(const clock_state *c, char *buf, int sec, long nsec) {
+    struct tm tm = c->tm;
+    tm.tm_sec = sec;
+    format_time(buf, CLOCK_TEXT_MAX, c->format, &tm, c->minute_start + sec, nsec);
+}
+
+static void clock_patch(const clock_state *c, char *text, int sec, long nsec) {
+    static const long scale[10] = { 1, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1 };
+    for (int i = 0; i < c->npatch; ++i) {
+        int role = c->patch_role[i];
+        int digit = role == -1 ? sec / 10 : role == -2 ? sec % 10 : (int)(nsec / scale[role] % 10);
+        text[c->patch_pos[i]] = (char)('0' + digit);
+    }
+}
+
+/* Find where the second and fractional digits sit in this minute's text by
+ * formatting their extremes, then check patching reproduces strftime() on a
+ * few other values. Formats that don't (%s, %-S, ...) reformat every tick. */
+static void clock_find_digits(clock_state *c) {
+    char base[CLOCK_TEXT_MAX], secs[CLOCK_TEXT_MAX], frac[CLOCK_TEXT_MAX];
+    clock_format(c, base, 0, 0);
+    clock_format(c, secs, 59, 0);
+    clock_format(c, frac, 0, 999999999L);
+    c->patchable = 0;
+    c->npatch = 0;
+    size_t n = strlen(base);
+    if (strlen(secs) != n || strlen(frac) != n) return;
+
+    int frac_run = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int role = 0;
+        if (secs[i] != base[i]) {
+            if (frac[i] != base[i] || base[i] != '0') return;
+            if (secs[i] == '5') role = -1;
+            else if (secs[i] == '9') role = -2;
+            else return;
+        }
+        if (frac[i] != base[i]) {
+            if (base[i] != '0' || frac[i] != '9' || frac_run >= 9) return;
+            role = ++frac_run;
+        } else {
+            frac_run = 0;
+        }
+        if (!role) continue;
+        if (c->npatch == CLOCK_MAX_PATCH) return;
+        c->patch_pos[c->npatch] = (unsigned char)i;
+        c->patch_role[c->npatch] = (signed char)role;
+        ++c->npatch;
+    }
+
+    static const struct { int sec; long nsec; } checks[] = {
+        { 7, 123456789L }, { 38, 987654321L }, { 59, 50000000L },
+    };
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); ++i) {
+        char want[CLOCK_TEXT_MAX], got[CLOCK_TEXT_MAX];
+        clock_format(c, want, checks[i].sec, checks[i].nsec);
+        memcpy(got, base, n + 1);
+        clock_patch(c, got, checks[i].sec, checks[i].nsec);
+        if (strcmp(want, got) != 0) return;
+    }
+    c->patchable = 1;
+}
+
+static void clock_init(clock_state *c, const char *tz, const char *format) {
+    memset(c, 0, sizeof(*c));
+    c->tz = tz;
+    c->format = format;
+    c->zone_until = c->zone_from; /* forces a lookup on the first update */
+    c->widest = -1;
+}
+
+/* Bring the clock's text up to now. Returns 0 if it is unchanged, 1 if the
+ * span in *changed changed, 2 if its length changed. */
+static int clock_update(clock_state *c, const struct timespec *now, text_range *changed) {
+    time_t t = now->tv_sec;
+    int resplit = 0;
+    if (t < c->zone_from || t >= c->zone_until) {
+        clock_load_zone(c, t);
+        resplit = 1;
+    }
+    if (resplit || t < c->minute_start || t - c->minute_start >= 60) {
+        clock_split_minute(c, t);
+        clock_find_digits(c);
+        resplit = 1;
+    }
+    int sec = (int)(t - c->minute_start);
+
+    if (!resplit && c->patchable) {
+        int lo = CLOCK_TEXT_MAX, hi = -1;
+        char old[CLOCK_MAX_PATCH];
+        for (int i = 0; i < c->npatch; ++i) old[i] = c->text[c->patch_pos[i]];
+        clock_patch(c, c->text, sec, now->tv_nsec);
+        for (int i = 0; i < c->npatch; ++i) {
+            int pos = c->patch_pos[i];
+            if (old[i] == c->text[pos]) continue;
+            if (pos < lo) lo = pos;
+            if (pos + 1 > hi) hi = pos + 1;
+        }
+        if (hi < 0) return 0;
+        changed->start = lo;
+        changed->end = hi;
+        return 1;
+    }
+
+    char text[CLOCK_TEXT_MAX];
+    clock_format(c, text, sec, now->tv_nsec);
+    int len = (int)strlen(text);
+    if (len != c->len) {
+        memcpy(c->text, text, (size_t)len + 1);
+        c->len = len;
+        return 2;
+    }
+    int lo = 0, hi = len;
+    while (lo < len && text[lo] == c->text[lo]) ++lo;
+    if (lo == len) return 0;
+    while (hi > lo && text[hi - 1] == c->text[hi - 1]) --hi;
+    memcpy(c->text + lo, text + lo, (size_t)(hi - lo));
+    changed->start = lo;
+    changed->end = hi;
+    return 1;
+}
+
+/* Bring all clocks up to now. Returns nonzero if any of their texts changed. */
+static int update_clocks(clock_state *clocks, int n) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    int any = 0;
+    for (int i = 0; i < n; ++i) {
+        clocks[i].changed = clock_update(&clocks[i], &ts, &clocks[i].change);
+        any |= clocks[i].changed;
+    }
+    return any;
+}
+
+/* Layout width of a clock's text for sec/nsec in tm, or -1 if it rendered the
+ * same text as prev. The text is left in prev. */
+static double clock_width(const clock_state *clk, const struct tm *tm, long nsec, char *prev) {
+    char buf[CLOCK_TEXT_MAX];
+    format_time(buf, sizeof(buf), clk->format, tm, clk->minute_start + tm->tm_sec, nsec);
+    if (strcmp(buf, prev) == 0) return -1;
+    strcpy(prev, buf);
+    return clay_text_width(buf);
+}
+
+/* Widest text a clock can render to, written to out. Each time field and the
+ * fractional seconds are swept through their range on their own from the
+ * clock's current minute, then the widest value of every field is combined. */
+static void widest_clock_text(const clock_state *clk, char *out) {
+    static const struct { size_t offset; int lo, hi; } fields[] = {
+        { offsetof(struct tm, tm_wday), 0, 6 },
+        { offsetof(struct tm, tm_mday), 1, 31 },
+        { offsetof(struct tm, tm_mon), 0, 11 },
+        { offsetof(struct tm, tm_yday), 0, 365 },
+        { offsetof(struct tm, tm_hour), 0, 23 },
+        { offsetof(struct tm, tm_min), 0, 59 },
+        { offsetof(struct tm, tm_sec), 0, 60 },
+    };
+    struct tm base = clk->tm, widest = clk->tm;
+    long widest_nsec = 0;
+
+    char prev[CLOCK_TEXT_MAX];
+    double max_w = -1;
+    out[0] = '\0';
+    for (size_t i = 0; i <= sizeof(fields) / sizeof(fields[0]); ++i) {
+        int is_frac = i == sizeof(fields) / sizeof(fields[0]);
+        struct tm tm = base;
+        int *field = is_frac ? NULL : (int *)((char *)&tm + fields[i].offset);
+        int lo = is_frac ? 0 : fields[i].lo, hi = is_frac ? 9 : fields[i].hi;
+        double best = -1;
+        prev[0] = '\0';
+        for (int v = lo; v <= hi; ++v) {
+            if (field) *field = v;
+            double w = clock_width(clk, &tm, is_frac ? v * 111111111L : 0, prev);
+            if (w > best) {
+                best = w;
+                if (is_frac) widest_nsec = v * 111111111L;
+                else *(int *)((char *)&widest + fields[i].offset) = v;
+            }
+            if (w > max_w) {
+                max_w = w;
+                strcpy(out, prev);
+            }
+        }
+    }
+    prev[0] = '\0';
+    double w = clock_width(clk, &widest, widest_nsec, prev);
+    if (w > max_w) strcpy(out, prev);
+}
+/* ---------- layout ---------- */
+/* A layout file is compiled once into a flat array of ops that refer to text
+ * and clocks only by index, so it can be copied or freed as a block.
+ * replay_layout() turns the ops into Clay declarations every frame without
+ * looking at the source again. */
+
+#define MAX_SEGMENTS 64
+
+enum { OP_OPEN, OP_TEXT, OP_CLOSE };
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t reserve;        /* OP_OPEN: at least as wide as the clock's widest text */
+    uint16_t clock;         /* clock index + 1, or 0 */
+    uint32_t name;          /* OP_OPEN: pool offset of the element id's label, or NO_NAME */
+    uint32_t text, len;     /* OP_TEXT without a clock: span of the string pool */
+    Clay_LayoutConfig layout;
+    Clay_Color background;  /* OP_OPEN */
+    Clay_Color color;       /* OP_TEXT */
+} layout_op;
+
+#define NO_TZ UINT32_MAX
+#define NO_NAME UINT32_MAX
+
+/* A clock binding: pool offsets of its TZ name (NO_TZ for local) and format */
+typedef struct { uint32_t tz, format; } clock_binding;
+
+enum { ANCHOR_LEFT = 1, ANCHOR_RIGHT = 2, ANCHOR_BOTTOM = 4 };
+
+typedef struct {
+    layout_op *ops;
+    int nops, ops_cap;
+    char *pool;
+    uint32_t pool_len, pool_cap;
+    clock_binding *bindings;
+    int nclocks, bindings_cap;
+    clock_state *clocks;    /* bindings resolved by link_layout() */
+    font_spec font;
+    int anchor, margin;
+    double refresh;
+} bar_layout;
+
+static bar_layout *layout = NULL;
+#define BAR_NAME "clay_bar"
+static Clay_ElementId bar_id;
+
+static void free_layout(bar_layout *l) {
+    if (!l) return;
+    free(l->ops);
+    free(l->pool);
+    free(l->bindings);
+    free(l->clocks);
+    free(l);
+}
+
+static layout_op *add_op(bar_layout *l, uint8_t opcode) {
+    if (l->nops == l->ops_cap) {
+        int cap = l->ops_cap ? 2 * l->ops_cap : 16;
+        layout_op *ops = realloc(l->ops, (size_t)cap * sizeof(*ops));
+        if (!ops) return NULL;
+        l->ops = ops;
+        l->ops_cap = cap;
+    }
+    layout_op *op = &l->ops[l->nops++];
+    memset(op, 0, sizeof(*op));
+    op->opcode = opcode;
+    return op;
+}
+
+/* Copy s into the string pool, NUL-terminated. Returns its offset or UINT32_MAX. */
+static uint32_t add_string(bar_layout *l, const char *s) {
+    uint32_t len = (uint32_t)strlen(s);
+    if (l->pool_cap - l->pool_len <= len) {
+        uint32_t cap = l->pool_cap ? l->pool_cap : 256;
+        while (cap - l->pool_len <= len) cap *= 2;
+        char *pool = realloc(l->pool, cap);
+        if (!pool) return UINT32_MAX;
+        l->pool = pool;
+        l->pool_cap = cap;
+    }
+    uint32_t at = l->pool_len;
+    memcpy(l->pool + at, s, (size_t)len + 1);
+    l->pool_len += len + 1;
+    return at;
+}
+
+/* Next key or key=value of a directive line into key and value. Returns 0 at
+ * the end of the line, -1 on a syntax error. */
+static int next_pair(const char **p, char *key, size_t key_size, char *value, size_t value_size) {
+    const char *s = *p;
+    while (*s == ' ' || *s == '\t' || *s == '\r') ++s;
+    if (*s == '\0' || *s == '\n' || *s == '#') {
+        *p = s;
+        return 0;
+    }
+    size_t k = 0, v = 0;
+    while (*s && *s != '=' && *s != ' ' && *s != '\t' && *s != '\r' && *s != '\n') {
+        if (k + 1 >= key_size) return -1;
+        key[k++] = *s++;
+    }
+    key[k] = '\0';
+    if (*s == '=' && s[1] == '"') {
+        for (s += 2; *s != '"'; ++s) {
+            if (*s == '\0' || *s == '\n') return -1;
+            if (*s == '\\' && (s[1] == '"' || s[1] == '\\')) ++s;
+            if (v + 1 >= value_size) return -1;
+            value[v++] = *s;
+        }
+        ++s;
+    } else if (*s == '=') {
+        for (++s; *s && *s != ' ' && *s != '\t' && *s != '\r' && *s != '\n'; ++s) {
+            if (v + 1 >= value_size) return -1;
+            value[v++] = *s;
+        }
+    }
+    value[v] = '\0';
+    *p = s;
+    return 1;
+}
+
+static int parse_number(const char *v, double lo, double hi, double *out) {
+    char *end;
+    double d = strtod(v, &end);
+    if (end == v || *end || !(d >= lo && d <= hi)) return 0;
+    *out = d;
+    return 1;
+}
+
+static int parse_int(const char *v, int lo, int hi, int *out) {
+    double d;
+    if (!parse_number(v, lo, hi, &d) || d != floor(d)) return 0;
+    *out = (int)d;
+    return 1;
+}
+
+static int parse_flag(const char *v, int *out) {
+    if (strcmp(v, "yes") == 0 || strcmp(v, "true") == 0 || strcmp(v, "1") == 0) *out = 1;
+    else if (strcmp(v, "no") == 0 || strcmp(v, "false") == 0 || strcmp(v, "0") == 0) *out = 0;
+    else return 0;
+    return 1;
+}
+
+static int hex_digit(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+/* #rrggbb or #rrggbbaa */
+static int parse_color(const char *v, Clay_Color *out) {
+    size_t n = strlen(v);
+    if (v[0] != '#' || (n != 7 && n != 9)) return 0;
+    float c[4] = { 0, 0, 0, 255 };
+    for (size_t i = 0; i + 1 < n; i += 2) {
+        int hi = hex_digit(v[i + 1]), lo = hex_digit(v[i + 2]);
+        if (hi < 0 || lo < 0) return 0;
+        c[i / 2] = (float)(hi * 16 + lo);
+    }
+    *out = (Clay_Color){ c[0], c[1], c[2], c[3] };
+    return 1;
+}
+
+/* N, H,V or L,R,T,B */
+static int parse_padding(const char *v, Clay_Padding *out) {
+    int n[4], count = 0;
+    for (const char *p = v;; ++p) {
+        char part[16];
+        const char *comma = strchr(p, ',');
+        size_t len = comma ? (size_t)(comma - p) : strlen(p);
+        if (count == 4 || len >= sizeof(part)) return 0;
+        memcpy(part, p, len);
+        part[len] = '\0';
+        if (!parse_int(part, 0, UINT16_MAX, &n[count++])) return 0;
+        if (!comma) break;
+        p = comma;
+    }
+    if (count == 1) *out = (Clay_Padding){ (uint16_t)n[0], (uint16_t)n[0], (uint16_t)n[0], (uint16_t)n[0] };
+    else if (count == 2) *out = (Clay_Padding){ (uint16_t)n[0], (uint16_t)n[0], (uint16_t)n[1], (uint16_t)n[1] };
+    else if (count == 4) *out = (Clay_Padding){ (uint16_t)n[0], (uint16_t)n[1], (uint16_t)n[2], (uint16_t)n[3] };
+    else return 0;
+    return 1;
+}
+
+/* fit[:MIN[:MAX]], grow[:MIN[:MAX]], fixed:N or percent:N */
+static int parse_sizing(const char *v, Clay_SizingAxis *out) {
+    const char *colon = strchr(v, ':');
+    size_t len = colon ? (size_t)(colon - v) : strlen(v);
+    double arg[2] = { 0, 0 };
+    int nargs = 0;
+    for (const char *p = colon; p; ) {
+        char *end;
+        if (nargs == 2) return 0;
+        arg[nargs] = strtod(p + 1, &end);
+        if (end == p + 1 || !(arg[nargs] >= 0) || (*end && *end != ':')) return 0;
+        ++nargs;
+        p = *end ? end : NULL;
+    }
+
+    Clay_SizingAxis axis = { 0 };
+    if ((len == 3 && strncmp(v, "fit", 3) == 0) || (len == 4 && strncmp(v, "grow", 4) == 0)) {
+        if (nargs == 2 && arg[1] < arg[0]) return 0;
+        axis.type = len == 3 ? CLAY__SIZING_TYPE_FIT : CLAY__SIZING_TYPE_GROW;
+        axis.size.minMax.min = (float)arg[0];
+        axis.size.minMax.max = (float)arg[1];
+    } else if (len == 5 && strncmp(v, "fixed", 5) == 0 && nargs == 1) {
+        axis.type = CLAY__SIZING_TYPE_FIXED;
+        axis.size.minMax.min = axis.size.minMax.max = (float)arg[0];
+    } else if (len == 7 && strncmp(v, "percent", 7) == 0 && nargs == 1 && arg[0] <= 100) {
+        axis.type = CLAY__SIZING_TYPE_PERCENT;
+        axis.size.percent = (float)(arg[0] / 100);
+    } else {
+        return 0;
+    }
+    *out = axis;
+    return 1;
+}
+
+static int parse_align(const char *v, Clay_LayoutAlignmentX *out) {
+    if (strcmp(v, "left") == 0) *out = CLAY_ALIGN_X_LEFT;
+    else if (strcmp(v, "center") == 0) *out = CLAY_ALIGN_X_CENTER;
+    else if (strcmp(v, "right") == 0) *out = CLAY_ALIGN_X_RIGHT;
+    else return 0;
+    return 1;
+}
+
+static int parse_anchor(const char *v, int *out) {
+    static const struct { const char *name; int anchor; } anchors[] = {
+        { "top-left", ANCHOR_LEFT }, { "top", 0 }, { "top-right", ANCHOR_RIGHT },
+        { "bottom-left", ANCHOR_BOTTOM | ANCHOR_LEFT }, { "bottom", ANCHOR_BOTTOM },
+        { "bottom-right", ANCHOR_BOTTOM | ANCHOR_RIGHT },
+    };
+    for (size_t i = 0; i < sizeof(anchors) / sizeof(anchors[0]); ++i) {
+        if (strcmp(v, anchors[i].name) != 0) continue;
+        *out = anchors[i].anchor;
+        return 1;
+    }
+    return 0;
+}
+
+/* Apply one key of a font or bar directive. Returns 0 for a bad value, -1 for
+ * an unknown key. */
+static int compile_font_key(font_spec *f, const char *key, const char *v) {
+    if (strcmp(key, "face") == 0) {
+        if (!v[0] || strlen(v) >= sizeof(f->face)) return 0;
+        strcpy(f->face, v);
+        return 1;
+    }
+    if (strcmp(key, "size") == 0) return parse_number(v, 1, 512, &f->size);
+    if (strcmp(key, "weight") == 0) {
+        if (strcmp(v, "bold") != 0 && strcmp(v, "normal") != 0) return 0;
+        f->bold = v[0] == 'b';
+        return 1;
+    }
+    if (strcmp(key, "slant") == 0) {
+        if (strcmp(v, "italic") != 0 && strcmp(v, "normal") != 0) return 0;
+        f->italic = v[0] == 'i';
+        return 1;
+    }
+    return -1;
+}
+
+static int compile_bar_key(bar_layout *l, const char *key, const char *v) {
+    layout_op *bar = &l->ops[0];
+    int n;
+    if (strcmp(key, "anchor") == 0) return parse_anchor(v, &l->anchor);
+    if (strcmp(key, "margin") == 0) return parse_int(v, 0, 65535, &l->margin);
+    if (strcmp(key, "padding") == 0) return parse_padding(v, &bar->layout.padding);
+    if (strcmp(key, "gap") == 0) {
+        if (!parse_int(v, 0, UINT16_MAX, &n)) return 0;
+        bar->layout.childGap = (uint16_t)n;
+        return 1;
+    }
+    if (strcmp(key, "direction") == 0) {
+        if (strcmp(v, "row") == 0) bar->layout.layoutDirection = CLAY_LEFT_TO_RIGHT;
+        else if (strcmp(v, "column") == 0) bar->layout.layoutDirection = CLAY_TOP_TO_BOTTOM;
+        else return 0;
+        return 1;
+    }
+    if (strcmp(key, "align") == 0) return parse_align(v, &bar->layout.childAlignment.x);
+    if (strcmp(key, "width") == 0) return parse_sizing(v, &bar->layout.sizing.width);
+    if (strcmp(key, "background") == 0) return parse_color(v, &bar->background);
+    if (strcmp(key, "refresh") == 0) return parse_number(v, 0.001, 3600, &l->refresh);
+    return -1;
 }
 
+/* Compile a clock or text segment into an OPEN, TEXT, CLOSE triple */
+static int compile_segment(bar_layout *l, int is_clock, const char **p, char *err, size_t err_size) {
+    layout_op open = { .opcode = OP_OPEN, .reserve = is_clock && FIXED_WIDTH, .name = NO_NAME };
+    open.layout.childAlignment = (Clay_ChildAlignment){ CLAY_ALIGN_X_RIGHT, CLAY_ALIGN_Y_CENTER };
+    layout_op text = { .opcode = OP_TEXT };
+    text.color = (Clay_Color){ (float)FG_R, (float)FG_G, (float)FG_B, (float)(FG_A * 255) };
+    clock_binding binding = { NO_TZ, UINT32_MAX };
+    const char *directive = is_clock ? "clock" : "text";
+    int has_text = 0;
+
+    char key[16], v[256];
+    int r;
+    while ((r = next_pair(p, key, sizeof(key), v, sizeof(v))) > 0) {
+        int ok = -1, flag;
+        if (strcmp(key, "color") == 0) {
+            ok = parse_color(v, &text.color);
+        } else if (strcmp(key, "background") == 0) {
+            ok = parse_color(v, &open.background);
+        } else if (strcmp(key, "padding") == 0) {
+            ok = parse_padding(v, &open.layout.padding);
+        } else if (strcmp(key, "width") == 0) {
+            ok = parse_sizing(v, &open.layout.sizing.width);
+        } else if (strcmp(key, "align") == 0) {
+            ok = parse_align(v, &open.layout.childAlignment.x);
+        } else if (is_clock && strcmp(key, "tz") == 0) {
+            binding.tz = v[0] ? add_string(l, v) : NO_TZ;
+            ok = binding.tz != NO_TZ;
+        } else if (is_clock && strcmp(key, "format") == 0) {
+            binding.format = strlen(v) < CLOCK_TEXT_MAX ? add_string(l, v) : UINT32_MAX;
+            ok = binding.format != UINT32_MAX;
+        } else if (is_clock && strcmp(key, "reserve") == 0) {
+            ok = parse_flag(v, &flag);
+            open.reserve = (uint8_t)(ok && flag);
+        } else if (!is_clock && strcmp(key, "text") == 0) {
+            text.text = add_string(l, v);
+            text.len = (uint32_t)strlen(v);
+            ok = has_text = text.text != UINT32_MAX;
+        }
+        if (ok < 0) snprintf(err, err_size, "unknown %s key \"%s\"", directive, key);
+        else if (!ok) snprintf(err, err_size, "bad %s for %s: \"%s\"", key, directive, v);
+        if (ok <= 0) return 0;
+    }
+    if (r < 0) {
+        snprintf(err, err_size, "syntax error");
+        return 0;
+    }
+    if (is_clock ? binding.format == UINT32_MAX : !has_text) {
+        snprintf(err, err_size, "%s needs %s=", directive, is_clock ? "format" : "text");
+        return 0;
+    }
+    if (l->nops / 3 >= MAX_SEGMENTS) {
+        snprintf(err, err_size, "more than %d segments", MAX_SEGMENTS);
+        return 0;
+    }
+
+    if (is_clock) {
+        if (l->nclocks == l->bindings_cap) {
+            int cap = l->bindings_cap ? 2 * l->bindings_cap : 4;
+            clock_binding *b = realloc(l->bindings, (size_t)cap * sizeof(*b));
+            if (!b) goto oom;
+            l->bindings = b;
+            l->bindings_cap = cap;
+        }
+        l->bindings[l->nclocks++] = binding;
+        text.clock = (uint16_t)l->nclocks;
+        open.clock = text.clock;
+    }
+    layout_op *ops[3] = { add_op(l, OP_OPEN), add_op(l, OP_TEXT), add_op(l, OP_CLOSE) };
+    if (!ops[0] || !ops[1] || !ops[2]) goto oom;
+    *ops[0] = open;
+    *ops[1] = text;
+    return 1;
+oom:
+    snprintf(err, err_size, "out of memory");
+    return 0;
+}
+
+/* Compile the rest of a line after its directive */
+static void compile_line(bar_layout *l, const char *directive, const char **p, char *err, size_t err_size) {
+    int is_font = strcmp(directive, "font") == 0;
+    if (strcmp(directive, "clock") == 0 || strcmp(directive, "text") == 0) {
+        compile_segment(l, directive[0] == 'c', p, err, err_size);
+        return;
+    }
+    if (!is_font && strcmp(directive, "bar") != 0) {
+        snprintf(err, err_size, "unknown directive \"%s\"", directive);
+        return;
+    }
+    char key[16], v[256];
+    int r;
+    while ((r = next_pair(p, key, sizeof(key), v, sizeof(v))) > 0) {
+        int ok = is_font ? compile_font_key(&l->font, key, v) : compile_bar_key(l, key, v);
+        if (ok < 0) snprintf(err, err_size, "unknown %s key \"%s\"", directive, key);
+        else if (!ok) snprintf(err, err_size, "bad %s for %s: \"%s\"", key, directive, v);
+        if (ok <= 0) return;
+    }
+    if (r < 0) snprintf(err, err_size, "syntax error");
+}
+
+/* Compile layout source into l. On an error it is printed against name and 0
+ * is returned. */
+static int compile_layout(bar_layout *l, const char *src, const char *name) {
+    memset(l, 0, sizeof(*l));
+    snprintf(l->font.face, sizeof(l->font.face), "%s", FONT_FACE);
+    l->font.size = FONT_SIZE;
+    l->font.bold = 1;
+    l->anchor = ANCHOR_RIGHT;
+    l->margin = H_PADDING;
+    l->refresh = REFRESH_INTERVAL;
+
+    layout_op *bar = add_op(l, OP_OPEN);
+    if (!bar) return 0;
+    bar->name = add_string(l, BAR_NAME);
+    if (bar->name == NO_NAME) return 0;
+    bar->layout.padding = (Clay_Padding){ (uint16_t)H_PADDING, (uint16_t)H_PADDING, (uint16_t)V_PADDING, (uint16_t)V_PADDING };
+    bar->layout.childAlignment = (Clay_ChildAlignment){ CLAY_ALIGN_X_RIGHT, CLAY_ALIGN_Y_CENTER };
+
+    char err[160] = "";
+    int line = 0;
+    for (const char *p = src; *p && !err[0]; ++line) {
+        const char *eol = strchr(p, '\n');
+        const char *s = p;
+        char directive[16], v[256];
+        int r = next_pair(&s, directive, sizeof(directive), v, sizeof(v));
+        if (r < 0 || (r > 0 && v[0])) snprintf(err, sizeof(err), "syntax error");
+        else if (r > 0) compile_line(l, directive, &s, err, sizeof(err));
+        p = eol ? eol + 1 : p + strlen(p);
+    }
+    if (!err[0] && !add_op(l, OP_CLOSE)) snprintf(err, sizeof(err), "out of memory");
+    if (err[0]) {
+        fprintf(stderr, "clay_bar: %s:%d: %s\n", name, line, err);
+        return 0;
+    }
+    return 1;
+}
+
+/* Resolve l's clock bindings. Clocks identical to one in old (which may be
+ * NULL) take over its state, so their zone caches and reserved width survive
+ * a reload. Returns 0 if out of memory. */
+static int link_layout(bar_layout *l, const bar_layout *old, int keep_widths) {
+    l->clocks = calloc(l->nclocks ? (size_t)l->nclocks : 1, sizeof(clock_state));
+    if (!l->clocks) return 0;
+    for (int i = 0; i < l->nclocks; ++i) {
+        const char *tz = l->bindings[i].tz == NO_TZ ? NULL : l->pool + l->bindings[i].tz;
+        const char *format = l->pool + l->bindings[i].format;
+        clock_state *c = &l->clocks[i];
+        clock_init(c, tz, format);
+        for (int j = 0; old && j < old->nclocks; ++j) {
+            const clock_state *o = &old->clocks[j];
+            if (strcmp(o->format, format) != 0 || (o->tz && tz ? strcmp(o->tz, tz) != 0 : o->tz != tz)) continue;
+            *c = *o;
+            c->tz = tz;
+            c->format = format;
+            c->tm.tm_zone = c->zone;
+            if (!keep_widths) c->widest = -1;
+            break;
+        }
+    }
+    return 1;
+}
+
+/* Make reserving segments at least as wide as their clock's widest text. The
+ * clocks must have been updated at least once. */
+static void reserve_widths(bar_layout *l) {
+    for (int i = 0; i < l->nops; ++i) {
+        layout_op *op = &l->ops[i];
+        Clay_SizingAxis *w = &op->layout.sizing.width;
+        if (!op->reserve || !op->clock) continue;
+        if (w->type != CLAY__SIZING_TYPE_FIT && w->type != CLAY__SIZING_TYPE_GROW) continue;
+        clock_state *c = &l->clocks[op->clock - 1];
+        if (c->widest < 0) {
+            char text[CLOCK_TEXT_MAX];
+            widest_clock_text(c, text);
+            c->widest = ceil(clay_text_width(text));
+        }
+        float min = (float)c->widest + op->layout.padding.left + op->layout.padding.right;
+        if (min > w->size.minMax.min) w->size.minMax.min = min;
+        if (w->size.minMax.max > 0 && w->size.minMax.max < w->size.minMax.min) w->size.minMax.max = w->size.minMax.min;
+    }
+}
+
+/* Declare the text op to Clay */
+static void replay_text(const bar_layout *l, const layout_op *op) {
+    clock_state *c = op->clock ? &l->clocks[op->clock - 1] : NULL;
+    Clay_String text = c ? (Clay_String){ .length = c->len, .chars = c->text }
+                         : (Clay_String){ .isStaticallyAllocated = true, .length = (int32_t)op->len, .chars = l->pool + op->text };
+    CLAY_TEXT(text, CLAY_TEXT_CONFIG({ .userData = c, .textColor = op->color, .wrapMode = CLAY_TEXT_WRAP_NONE }));
+}
+
+static const layout_op *replay_element(const bar_layout *l, const layout_op *op);
+
+/* Declare the children of an element up to its OP_CLOSE, which is returned */
+static const layout_op *replay_children(const bar_layout *l, const layout_op *op) {
+    while (op->opcode != OP_CLOSE) {
+        if (op->opcode == OP_OPEN) {
+            op = replay_element(l, op);
+        } else {
+            replay_text(l, op);
+            ++op;
+        }
+    }
+    return op;
+}
+
+/* Declare the element opened by op and everything up to its OP_CLOSE. Returns
+ * the op after the OP_CLOSE. */
+static const layout_op *replay_element(const bar_layout *l, const layout_op *op) {
+    Clay_ElementDeclaration decl = { .layout = op->layout, .backgroundColor = op->background };
+    const layout_op *close = op;
+    if (op->name != NO_NAME) {
+        Clay_String name = { .isStaticallyAllocated = true, .length = (int32_t)strlen(l->pool + op->name), .chars = l->pool + op->name };
+        CLAY(CLAY_SID(name), decl) {
+            close = replay_children(l, op + 1);
+        }
+    } else {
+        CLAY_AUTO_ID(decl) {
+            close = replay_children(l, op + 1);
+        }
+    }
+    return close + 1;
+}
+
+/* Declare the layout to Clay */
+static void replay_layout(const bar_layout *l) {
+    for (const layout_op *op = l->ops, *end = l->ops + l->nops; op < end; )
+        op = replay_element(l, op);
+}
+
+/* ---------- layout file ---------- */
+static char *layout_path = NULL;
+static const char *layout_name = NULL; /* file name within the watched directory */
+static int layout_watch = -1;
+
+static char *default_layout_path(void) {
+    const char *xdg = getenv("XDG_CONFIG_HOME"), *home = getenv("HOME");
+    char path[4096];
+    if (xdg && xdg[0]) snprintf(path, sizeof(path), "%s/clay_bar/layout", xdg);
+    else if (home && home[0]) snprintf(path, sizeof(path), "%s/.config/clay_bar/layout", home);
+    else return NULL;
+    return strdup(path);
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    size_t len = 0, cap = 4096;
+    char *buf = malloc(cap);
+    while (buf) {
+        len += fread(buf + len, 1, cap - len - 1, f);
+        if (len < cap - 1) break;
+        char *bigger = realloc(buf, cap *= 2);
+        if (!bigger) { free(buf); buf = NULL; }
+        else buf = bigger;
+    }
+    if (buf && ferror(f)) { free(buf); buf = NULL; }
+    fclose(f);
+    if (buf) buf[len] = '\0';
+    return buf;
+}
+
+/* Compile the layout file, or the built-in layout if there is none, link it to
+ * the current layout and load its font. NULL if it doesn't compile. It makes
+ * no X or Clay calls and doesn't touch the environment. It reads layout_path
+ * and layout, and if the font changes load_font() rewrites the font globals:
+ * font, measure_surf, measure_cr, font_extents, space_width, mono_advance,
+ * glyph_advances and the glyph cache. Off the main thread, nothing else may
+ * use those until the thread is joined, see warm_up(). */
+static bar_layout *prepare_layout(void) {
+    char *src = layout_path ? read_file(layout_path) : NULL;
+    bar_layout *l = calloc(1, sizeof(*l));
+    int ok = l && compile_layout(l, src ? src : DEFAULT_LAYOUT, src ? layout_path : "built-in layout");
+    free(src);
+    int keep_font = ok && layout && same_font(&l->font, &font);
+    if (ok && !link_layout(l, layout, keep_font)) {
+        fprintf(stderr, "clay_bar: out of memory loading layout\n");
+        ok = 0;
+    }
+    if (!ok) {
+        free_layout(l);
+        return NULL;
+    }
+    if (!keep_font) load_font(&l->font);
+    return l;
+}
+
+/* Make a prepared layout the current one */
+static void activate_layout(bar_layout *l) {
+    /* cached measurements may point into the old string pool */
+    Clay_ResetMeasureTextCache();
+    /* so ASCII text, clocks included, is measured without calling back into cairo */
+    Clay_SetFontMetrics((Clay_FontMetrics){ .lineHeight = (float)font_extents.height, .advances = glyph_advances });
+    update_clocks(l->clocks, l->nclocks);
+    reserve_widths(l);
+    free_layout(layout);
+    layout = l;
+}
+
+/* Swap in the layout file. The current layout stays if it doesn't compile.
+ * Returns 0 then. */
+static int load_layout(void) {
+    bar_layout *l = prepare_layout();
+    if (!l) return 0;
+    activate_layout(l);
+    return 1;
+}
+
+/* Watch the layout file's directory, so saves that replace the file are seen
+ * as well as ones that write it in place */
+static void watch_layout(void) {
+    if (!layout_path) return;
+    char dir[4096];
+    const char *slash = strrchr(layout_path, '/');
+    if (slash) {
+        size_t len = slash == layout_path ? 1 : (size_t)(slash - layout_path);
+        if (len >= sizeof(dir)) return;
+        memcpy(dir, layout_path, len);
+        dir[len] = '\0';
+        layout_name = slash + 1;
+    } else {
+        strcpy(dir, ".");
+        layout_name = layout_path;
+    }
+    layout_watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (layout_watch < 0) return;
+    if (inotify_add_watch(layout_watch, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(layout_watch);
+        layout_watch = -1;
+    }
+}
+
+/* Whether the layout file was saved since the last call. Never blocks. */
+static int layout_changed(void) {
+    if (layout_watch < 0) return 0;
+    union { struct inotify_event ev; char bytes[4096]; } buf;
+    int changed = 0;
+    ssize_t n;
+    while ((n = read(layout_watch, &buf, sizeof(buf))) > 0) {
+        for (char *p = buf.bytes; p < buf.bytes + n;) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            if (ev->len && strcmp(ev->name, layout_name) == 0) changed = 1;
+            p += sizeof(*ev) + ev->len;
+        }
+    }
+    return changed;
+}
+
+/* ---------- drawing ---------- */
 /* Ensure Cairo surface matches window size */
 static void ensure_surface_size(int w, int h) {
     if (!surf) {
         surf = cairo_xlib_surface_create(dpy, barwin, DefaultVisual(dpy, screen_num), w, h);
         cr = cairo_create(surf);
+        set_font(cr);
     } else {
         cairo_xlib_surface_set_size(surf, w, h);
     }
@@ -93,8 +1230,59 @@ static Pixmap create_mask_from_a8(cairo_surface_t *mask_surf, int w, int h) {
     return pm;
 }
 
-/* Update shaped window mask for text only */
-static void update_shape_mask(int win_w, int win_h, const char *text) {
+static Clay_Color command_color(const Clay_RenderCommand *cmd) {
+    if (cmd->commandType == CLAY_RENDER_COMMAND_TYPE_RECTANGLE) return cmd->renderData.rectangle.backgroundColor;
+    if (cmd->commandType == CLAY_RENDER_COMMAND_TYPE_TEXT) return cmd->renderData.text.textColor;
+    return (Clay_Color){ 0, 0, 0, 0 };
+}
+
+static void set_source_color(cairo_t *c, Clay_Color color) {
+    cairo_set_source_rgba(c, color.r / 255.0, color.g / 255.0, color.b / 255.0, color.a / 255.0);
+}
+
+/* Whole pixels covered by a box. Rectangles are filled on these so they
+ * shape the window exactly. */
+static void box_pixels(const Clay_BoundingBox *b, int *x0, int *y0, int *x1, int *y1) {
+    *x0 = (int)floor(b->x);
+    *y0 = (int)floor(b->y);
+    *x1 = (int)ceil(b->x + b->width);
+    *y1 = (int)ceil(b->y + b->height);
+}
+
+static double text_baseline(const Clay_BoundingBox *b) {
+    return b->y + (b->height - font_extents.height) / 2.0 + font_extents.ascent;
+}
+
+/* Draw the render commands. For a shape mask everything visible is opaque. */
+static void draw_commands(cairo_t *c, Clay_RenderCommandArray *cmds, int mask) {
+    for (int i = 0; i < cmds->length; ++i) {
+        Clay_RenderCommand *cmd = Clay_RenderCommandArray_Get(cmds, i);
+        Clay_Color color = command_color(cmd);
+        if (color.a <= 0) continue;
+        if (mask) color = (Clay_Color){ 255, 255, 255, 255 };
+        set_source_color(c, color);
+
+        if (cmd->commandType == CLAY_RENDER_COMMAND_TYPE_RECTANGLE) {
+            int x0, y0, x1, y1;
+            box_pixels(&cmd->boundingBox, &x0, &y0, &x1, &y1);
+            cairo_rectangle(c, x0, y0, x1 - x0, y1 - y0);
+            cairo_fill(c);
+        } else if (cmd->commandType == CLAY_RENDER_COMMAND_TYPE_TEXT) {
+            Clay_StringSlice text = cmd->renderData.text.stringContents;
+            char stack[256];
+            char *s = (size_t)text.length < sizeof(stack) ? stack : malloc((size_t)text.length + 1);
+            if (!s) continue;
+            memcpy(s, text.chars, (size_t)text.length);
+            s[text.length] = '\0';
+            cairo_move_to(c, cmd->boundingBox.x, text_baseline(&cmd->boundingBox));
+            cairo_show_text(c, s);
+            if (s != stack) free(s);
+        }
+    }
+}
+
+/* Update shaped window mask to what the commands draw */
+static void update_shape_mask(int win_w, int win_h, Clay_RenderCommandArray *cmds) {
     if (!shape_available) return;
 
     cairo_surface_t *mask_surf = cairo_image_surface_create(CAIRO_FORMAT_A8, win_w, win_h);
@@ -106,17 +1294,8 @@ static void update_shape_mask(int win_w, int win_h, const char *text) {
     cairo_set_operator(mask_cr, CAIRO_OPERATOR_OVER);
 
     /* draw text into mask */
-    cairo_select_font_face(mask_cr, FONT_FACE, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-    cairo_set_font_size(mask_cr, FONT_SIZE);
-    cairo_font_extents_t fe;
-    cairo_font_extents(mask_cr, &fe);
-    cairo_text_extents_t te;
-    cairo_text_extents(mask_cr, text, &te);
-    double x = H_PADDING - te.x_bearing;
-    double y = (win_h - fe.height) / 2.0 + fe.ascent;
-    cairo_set_source_rgba(mask_cr, 1.0, 1.0, 1.0, 1.0);
-    cairo_move_to(mask_cr, x, y);
-    cairo_show_text(mask_cr, text);
+    set_font(mask_cr);
+    draw_commands(mask_cr, cmds, 1);
 
     cairo_surface_flush(mask_surf);
 
@@ -131,48 +1310,354 @@ static void update_shape_mask(int win_w, int win_h, const char *text) {
     cairo_surface_destroy(mask_surf);
 }
 
-/* Render text only */
-static void render_now(void) {
-    if (!cr || !surf || !barwin) return;
+/* ---------- glyph cells ---------- */
+/* With a monospace font every text command is a row of fixed cells. Each glyph
+ * is rasterized once per cell position and then blitted when that cell
+ * changes, as long as the frame lays out exactly like the one on screen. */
+
+#define MAX_CELLS 256
+
+typedef struct {
+    int ready;
+    cairo_surface_t *alpha; /* glyph coverage at its cell's subpixel position */
+    Pixmap bits;            /* the same coverage as a 1-bit shape */
+    int x, y, w, h;         /* window rectangle of both, w == 0 if no ink */
+} glyph_cell;
+
+/* A render command as the window shows it */
+typedef struct {
+    Clay_RenderCommandType type;
+    Clay_BoundingBox box;
+    Clay_Color color;
+    int text, len;          /* TEXT: its cells in shown_text */
+} shown_cmd;
+
+static glyph_cell *glyph_cache[MAX_CELLS]; /* [cell][ascii], rows allocated on use */
+static shown_cmd *shown = NULL;
+static int nshown = -1, shown_cap = 0;
+static char shown_text[MAX_CELLS];
+static int cells_valid = 0;
+
+static void free_glyph_cache(void) {
+    for (size_t i = 0; i < MAX_CELLS; ++i) {
+        if (!glyph_cache[i]) continue;
+        for (int c = 0; c < 128; ++c) {
+            if (glyph_cache[i][c].alpha) cairo_surface_destroy(glyph_cache[i][c].alpha);
+            if (glyph_cache[i][c].bits) XFreePixmap(dpy, glyph_cache[i][c].bits);
+        }
+        free(glyph_cache[i]);
+        glyph_cache[i] = NULL;
+    }
+}
+
+/* Whether cmds lay out exactly like the frame on screen, so only the glyphs in
+ * its cells can differ */
+static int same_frame(Clay_RenderCommandArray *cmds) {
+    if (cmds->length != nshown) return 0;
+    for (int i = 0; i < nshown; ++i) {
+        Clay_RenderCommand *cmd = Clay_RenderCommandArray_Get(cmds, i);
+        const shown_cmd *s = &shown[i];
+        Clay_Color color = command_color(cmd);
+        if (cmd->commandType != s->type || memcmp(&cmd->boundingBox, &s->box, sizeof(s->box)) != 0 ||
+            memcmp(&color, &s->color, sizeof(color)) != 0)
+            return 0;
+        if (s->type == CLAY_RENDER_COMMAND_TYPE_TEXT && cmd->renderData.text.stringContents.length != s->len) return 0;
+    }
+    return 1;
+}
+
+/* Remember the frame just drawn in full. Later frames can go through the
+ * cells if every text in it is ASCII sitting on the monospace grid. */
+static void remember_frame(Clay_RenderCommandArray *cmds) {
+    /* cached glyphs are rasterized at their cells' positions */
+    if (!same_frame(cmds)) free_glyph_cache();
+    nshown = -1;
+    cells_valid = 0;
+    if (mono_advance <= 0) return;
+    if (cmds->length > shown_cap) {
+        shown_cmd *s = realloc(shown, (size_t)cmds->length * sizeof(*s));
+        if (!s) return;
+        shown = s;
+        shown_cap = cmds->length;
+    }
+
+    int pos = 0;
+    for (int i = 0; i < cmds->length; ++i) {
+        Clay_RenderCommand *cmd = Clay_RenderCommandArray_Get(cmds, i);
+        shown_cmd *s = &shown[i];
+        s->type = cmd->commandType;
+        s->box = cmd->boundingBox;
+        s->color = command_color(cmd);
+        s->text = pos;
+        s->len = 0;
+        if (s->type == CLAY_RENDER_COMMAND_TYPE_TEXT) {
+            Clay_StringSlice text = cmd->renderData.text.stringContents;
+            if (text.length > MAX_CELLS - pos || fabs(s->box.width - text.length * mono_advance) > 0.5) return;
+            for (int k = 0; k < text.length; ++k)
+                if ((unsigned char)text.chars[k] >= 128) return;
+            memcpy(shown_text + pos, text.chars, (size_t)text.length);
+            s->len = text.length;
+            pos += text.length;
+        } else if (s->type != CLAY_RENDER_COMMAND_TYPE_RECTANGLE) {
+            return;
+        }
+    }
+    nshown = cmds->length;
+    cells_valid = 1;
+}
+
+/* Left edge of cell k of a row. The outer edges are the row's box. */
+static int cell_left(const shown_cmd *s, int k) {
+    if (k <= 0) return (int)floor(s->box.x);
+    if (k >= s->len) return (int)ceil(s->box.x + s->box.width);
+    return (int)floor(s->box.x + k * mono_advance);
+}
+
+/* Cached rendering of ch in cell k of a row, NULL on failure */
+static glyph_cell *get_glyph(const shown_cmd *s, int k, unsigned char ch) {
+    int i = s->text + k;
+    if (ch >= 128) return NULL;
+    if (!glyph_cache[i] && !(glyph_cache[i] = calloc(128, sizeof(glyph_cell)))) return NULL;
+    glyph_cell *g = &glyph_cache[i][ch];
+    if (g->ready) return g;
+    g->ready = 1;
 
-    cairo_select_font_face(cr, FONT_FACE, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-    cairo_set_font_size(cr, FONT_SIZE);
+    char str[2] = { (char)ch, '\0' };
+    double gx = s->box.x + k * mono_advance;
     cairo_text_extents_t te;
-    cairo_text_extents(cr, timebuf, &te);
-    cairo_font_extents_t fe;
-    cairo_font_extents(cr, &fe);
+    cairo_text_extents(measure_cr, str, &te);
+    if (te.width <= 0 || te.height <= 0) return g;
+
+    /* a pixel of slack on each side for antialiasing */
+    int x1, y1;
+    box_pixels(&s->box, &g->x, &g->y, &x1, &y1);
+    g->x = (int)floor(gx + te.x_bearing) - 1;
+    g->w = (int)ceil(gx + te.x_bearing + te.width) + 1 - g->x;
+    g->h = y1 - g->y;
+    g->alpha = cairo_image_surface_create(CAIRO_FORMAT_A8, g->w, g->h);
+    cairo_t *gc = cairo_create(g->alpha);
+    set_font(gc);
+    cairo_set_source_rgba(gc, 1.0, 1.0, 1.0, 1.0);
+    cairo_move_to(gc, gx - g->x, text_baseline(&s->box) - g->y);
+    cairo_show_text(gc, str);
+    cairo_destroy(gc);
+    cairo_surface_flush(g->alpha);
+    if (shape_available) g->bits = create_mask_from_a8(g->alpha, g->w, g->h);
+    return g;
+}
+
+static int overlaps(int a0, int a1, int b0, int b1) {
+    return a0 < b1 && b0 < a1;
+}
+
+/* Repaint and re-shape only the cells whose character differs from what the
+ * window shows. Returns 0 if the frame needs a full redraw instead. */
+static int redraw_cells(Clay_RenderCommandArray *cmds) {
+    if (!cells_valid || !same_frame(cmds)) return 0;
+
+    /* pixel runs covering every changed cell and the old and new ink in it */
+    XRectangle runs[MAX_CELLS];
+    int nruns = 0;
+    for (int r = 0; r < nshown; ++r) {
+        const shown_cmd *s = &shown[r];
+        if (s->type != CLAY_RENDER_COMMAND_TYPE_TEXT) continue;
+        Clay_RenderCommand *cmd = Clay_RenderCommandArray_Get(cmds, r);
+        const char *text = cmd->renderData.text.stringContents.chars;
+        const clock_state *clk = cmd->userData;
+        int lo = 0, hi = s->len, row_run = -1;
+        /* a clock knows which of its characters the last update touched */
+        if (clk && clk->changed == 0) continue;
+        if (clk && clk->changed == 1 && text == clk->text) {
+            lo = clk->change.start;
+            hi = clk->change.end < s->len ? clk->change.end : s->len;
+        }
+        for (int k = lo; k < hi; ++k) {
+            unsigned char was = (unsigned char)shown_text[s->text + k], now = (unsigned char)text[k];
+            if (was == now) continue;
+            glyph_cell *gw = get_glyph(s, k, was), *gn = get_glyph(s, k, now);
+            if (!gw || !gn) return 0;
+            int x0 = cell_left(s, k), x1 = cell_left(s, k + 1), y0, y1, bx0, bx1;
+            box_pixels(&s->box, &bx0, &y0, &bx1, &y1);
+            if (gw->w) { if (gw->x < x0) x0 = gw->x; if (gw->x + gw->w > x1) x1 = gw->x + gw->w; }
+            if (gn->w) { if (gn->x < x0) x0 = gn->x; if (gn->x + gn->w > x1) x1 = gn->x + gn->w; }
+            if (row_run >= 0 && runs[row_run].x + runs[row_run].width >= x0) {
+                int rx0 = runs[row_run].x < x0 ? runs[row_run].x : x0;
+                int rx1 = runs[row_run].x + runs[row_run].width;
+                if (x1 > rx1) rx1 = x1;
+                runs[row_run].x = (short)rx0;
+                runs[row_run].width = (unsigned short)(rx1 - rx0);
+                continue;
+            }
+            row_run = nruns++;
+            runs[row_run] = (XRectangle){ (short)x0, (short)y0, (unsigned short)(x1 - x0), (unsigned short)(y1 - y0) };
+        }
+    }
+    if (!nruns) return 1;
+
+    /* repaint each run from every command that reaches into it */
+    char drawn[MAX_CELLS] = {0};
+    for (int i = 0; i < nruns; ++i) {
+        int x0 = runs[i].x, x1 = x0 + runs[i].width, y0 = runs[i].y, y1 = y0 + runs[i].height;
+        cairo_save(cr);
+        cairo_rectangle(cr, x0, y0, x1 - x0, y1 - y0);
+        cairo_clip(cr);
+        cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+        cairo_paint(cr);
+        cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+        for (int m = 0; m < nshown; ++m) {
+            const shown_cmd *s = &shown[m];
+            int bx0, by0, bx1, by1;
+            box_pixels(&s->box, &bx0, &by0, &bx1, &by1);
+            if (s->color.a <= 0 || !overlaps(by0, by1, y0, y1)) continue;
+            set_source_color(cr, s->color);
+            if (s->type == CLAY_RENDER_COMMAND_TYPE_RECTANGLE) {
+                if (!overlaps(bx0, bx1, x0, x1)) continue;
+                cairo_rectangle(cr, bx0, by0, bx1 - bx0, by1 - by0);
+                cairo_fill(cr);
+                continue;
+            }
+            const char *text = Clay_RenderCommandArray_Get(cmds, m)->renderData.text.stringContents.chars;
+            for (int k = 0; k < s->len; ++k) {
+                glyph_cell *g = get_glyph(s, k, (unsigned char)text[k]);
+                if (!g) { cairo_restore(cr); return 0; }
+                if (!g->w || !overlaps(g->x, g->x + g->w, x0, x1)) continue;
+                cairo_mask_surface(cr, g->alpha, g->x, g->y);
+                drawn[s->text + k] = 1;
+            }
+        }
+        cairo_restore(cr);
+    }
 
-    int text_w = (int)(te.width + 0.5);
-    int win_w = text_w + 2 * H_PADDING;
-    int win_h = (int)(fe.height + 0.5) + 2 * V_PADDING;
+    if (shape_available) {
+        /* cut the runs out of the shape, then add back everything drawn into them */
+        XShapeCombineRectangles(dpy, barwin, ShapeBounding, 0, 0, runs, nruns, ShapeSubtract, Unsorted);
+        for (int m = 0; m < nshown; ++m) {
+            const shown_cmd *s = &shown[m];
+            if (s->color.a <= 0) continue;
+            if (s->type == CLAY_RENDER_COMMAND_TYPE_RECTANGLE) {
+                int bx0, by0, bx1, by1;
+                box_pixels(&s->box, &bx0, &by0, &bx1, &by1);
+                for (int i = 0; i < nruns; ++i) {
+                    int x0 = runs[i].x > bx0 ? runs[i].x : bx0, x1 = runs[i].x + runs[i].width < bx1 ? runs[i].x + runs[i].width : bx1;
+                    int y0 = runs[i].y > by0 ? runs[i].y : by0, y1 = runs[i].y + runs[i].height < by1 ? runs[i].y + runs[i].height : by1;
+                    if (x0 >= x1 || y0 >= y1) continue;
+                    XRectangle rect = { (short)x0, (short)y0, (unsigned short)(x1 - x0), (unsigned short)(y1 - y0) };
+                    XShapeCombineRectangles(dpy, barwin, ShapeBounding, 0, 0, &rect, 1, ShapeUnion, Unsorted);
+                }
+                continue;
+            }
+            const char *text = Clay_RenderCommandArray_Get(cmds, m)->renderData.text.stringContents.chars;
+            for (int k = 0; k < s->len; ++k) {
+                glyph_cell *g = drawn[s->text + k] ? get_glyph(s, k, (unsigned char)text[k]) : NULL;
+                if (g && g->bits) XShapeCombineMask(dpy, barwin, ShapeBounding, g->x, g->y, g->bits, ShapeUnion);
+            }
+        }
+    }
+
+    for (int m = 0; m < nshown; ++m) {
+        if (shown[m].type != CLAY_RENDER_COMMAND_TYPE_TEXT) continue;
+        memcpy(shown_text + shown[m].text, Clay_RenderCommandArray_Get(cmds, m)->renderData.text.stringContents.chars, (size_t)shown[m].len);
+    }
+    cairo_surface_flush(surf);
+    XFlush(dpy);
+    return 1;
+}
+
+/* Lay out and draw the bar */
+static void render_now(void) {
+    if (!cr || !surf || !barwin || !layout) return;
+
+    Clay_BeginLayout();
+    replay_layout(layout);
+    Clay_RenderCommandArray cmds = Clay_EndLayout();
+
+    Clay_BoundingBox bar = Clay_GetElementData(bar_id).boundingBox;
+    int win_w = (int)ceil(bar.width), win_h = (int)ceil(bar.height);
+    if (win_w < 1) win_w = 1;
     if (win_h < 1) win_h = 1;
 
-    XWindowAttributes wattr;
-    XGetWindowAttributes(dpy, barwin, &wattr);
-    if ((int)wattr.width != win_w || (int)wattr.height != win_h) {
-        XMoveResizeWindow(dpy, barwin, screen_w - win_w - H_PADDING, 0, win_w, win_h);
+    if (cur_win_w != win_w || cur_win_h != win_h) {
+        int x = layout->anchor & ANCHOR_LEFT ? layout->margin
+              : layout->anchor & ANCHOR_RIGHT ? screen_w - win_w - layout->margin
+              : (screen_w - win_w) / 2;
+        int y = layout->anchor & ANCHOR_BOTTOM ? screen_h - win_h : 0;
+        XMoveResizeWindow(dpy, barwin, x, y, win_w, win_h);
         ensure_surface_size(win_w, win_h);
+        cur_win_w = win_w;
+        cur_win_h = win_h;
+        cells_valid = 0;
     }
 
-    update_shape_mask(win_w, win_h, timebuf);
+    if (redraw_cells(&cmds)) return;
+
+    update_shape_mask(win_w, win_h, &cmds);
 
     /* clear surface */
     cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
     cairo_paint(cr);
     cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
 
-    double y = (win_h - fe.height) / 2.0 + fe.ascent;
-    double x = H_PADDING - te.x_bearing;
-    cairo_set_source_rgba(cr, FG_R/255.0, FG_G/255.0, FG_B/255.0, FG_A);
-    cairo_move_to(cr, x, y);
-    cairo_show_text(cr, timebuf);
+    draw_commands(cr, &cmds, 0);
 
     cairo_surface_flush(surf);
     XFlush(dpy);
+
+    remember_frame(&cmds);
+}
+
+/* ---------- startup ---------- */
+/* The window is created and mapped while a helper thread resolves the font
+ * and compiles the layout, which is most of the time before the first frame
+ * on a cold start. The thread makes no Xlib calls, and the clocks' first
+ * update (which switches TZ with setenv()) waits until it has been joined.
+ * Until pthread_join() the thread owns startup_layout, layout_path (which it
+ * clears for a moment to fall back to the built-in layout) and the font
+ * globals prepare_layout() lists; the main thread only sets up X meanwhile.
+ * Target: the first frame on screen within 20 ms of main() with a warm
+ * fontconfig cache. CLAY_BAR_TRACE=1 prints the timeline to stderr. */
+
+static int trace_startup = 0;
+static struct timespec startup_time;
+static bar_layout *startup_layout = NULL;
+
+static void trace(const char *phase) {
+    if (!trace_startup) return;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double ms = (now.tv_sec - startup_time.tv_sec) * 1e3 + (now.tv_nsec - startup_time.tv_nsec) / 1e6;
+    fprintf(stderr, "clay_bar: %7.2f ms  %s\n", ms, phase);
+}
+
+static void *warm_up(void *arg) {
+    (void)arg;
+    startup_layout = prepare_layout();
+    if (!startup_layout && layout_path) {
+        /* a broken layout file gets the built-in bar until it is fixed */
+        char *path = layout_path;
+        layout_path = NULL;
+        startup_layout = prepare_layout();
+        layout_path = path;
+    }
+    trace("layout compiled, font loaded");
+    if (startup_layout) warm_glyphs();
+    trace("glyphs warm");
+    return NULL;
+}
+
+static void clay_error(Clay_ErrorData error) {
+    fprintf(stderr, "clay_bar: %.*s\n", (int)error.errorText.length, error.errorText.chars);
 }
 
 /* cleanup */
 static void cleanup(void) {
+    free_glyph_cache();
+    free(shown);
+    free_layout(layout);
+    free(layout_path);
+    if (layout_watch >= 0) close(layout_watch);
+    if (measure_cr) cairo_destroy(measure_cr);
+    if (measure_surf) cairo_surface_destroy(measure_surf);
+    free(clay_memory);
     if (shape_pixmap) XFreePixmap(dpy, shape_pixmap);
     if (cr) cairo_destroy(cr);
     if (surf) cairo_surface_destroy(surf);
@@ -181,18 +1666,48 @@ static void cleanup(void) {
 }
 
 /* main */
-int main(void) {
+int main(int argc, char **argv) {
+    clock_gettime(CLOCK_MONOTONIC, &startup_time);
+    const char *trace_env = getenv("CLAY_BAR_TRACE");
+    trace_startup = trace_env && trace_env[0] && strcmp(trace_env, "0") != 0;
+    trace("start");
+
     /* ignore SIGCHLD */
     struct sigaction sa = {0};
     sa.sa_handler = SIG_IGN;
     sa.sa_flags = SA_NOCLDSTOP | SA_RESTART;
     sigaction(SIGCHLD, &sa, NULL);
 
+    /* layout engine, sized for a bar rather than an application */
+    Clay_SetMaxElementCount(4 * MAX_SEGMENTS);
+    uint32_t clay_size = Clay_MinMemorySize();
+    clay_memory = malloc(clay_size);
+    if (!clay_memory) {
+        fprintf(stderr, "clay_bar: out of memory\n");
+        return 1;
+    }
+    Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(clay_size, clay_memory),
+                    (Clay_Dimensions){ 0, 0 }, (Clay_ErrorHandler){ clay_error, NULL });
+    Clay_SetMeasureTextFunction(measure_text, NULL);
+    /* most redraws are of an unchanged bar, or one where only a clock ticked */
+    Clay_SetRetainedLayoutEnabled(true);
+    bar_id = CLAY_ID(BAR_NAME);
+
+    /* fonts and layout on a helper thread while X is set up */
+    layout_path = argc > 1 ? strdup(argv[1]) : default_layout_path();
+    pthread_t warm_thread;
+    int threaded = pthread_create(&warm_thread, NULL, warm_up, NULL) == 0;
+    if (!threaded) warm_up(NULL);
+
     dpy = XOpenDisplay(NULL);
     if (!dpy) {
         fprintf(stderr, "clay_bar: failed to open display\n");
+        if (threaded) pthread_join(warm_thread, NULL);
+        free_layout(startup_layout);
+        cleanup();
         return 1;
     }
+    trace("display open");
 
     int shape_event_base, shape_error_base;
     shape_available = XShapeQueryExtension(dpy, &shape_event_base, &shape_error_base);
@@ -201,6 +1716,7 @@ int main(void) {
     rootwin = RootWindow(dpy, screen_num);
     screen_w = DisplayWidth(dpy, screen_num);
     screen_h = DisplayHeight(dpy, screen_num);
+    Clay_SetLayoutDimensions((Clay_Dimensions){ (float)screen_w, (float)screen_h });
 
     /* create simple override-redirect window */
     XSetWindowAttributes at;
@@ -211,13 +1727,31 @@ int main(void) {
                             DefaultDepth(dpy, screen_num),
                             InputOutput, DefaultVisual(dpy, screen_num),
                             CWOverrideRedirect | CWBackPixmap | CWEventMask, &at);
+    /* nothing shows until the first frame sets the real shape */
+    if (shape_available) XShapeCombineRectangles(dpy, barwin, ShapeBounding, 0, 0, NULL, 0, ShapeSet, Unsorted);
     XMapWindow(dpy, barwin);
     XRaiseWindow(dpy, barwin);
+    XFlush(dpy);
+    trace("window mapped");
 
-    /* initial time and surface */
-    update_time();
+    if (threaded) pthread_join(warm_thread, NULL);
+    if (!startup_layout) {
+        /* even the built-in layout failed to load */
+        fprintf(stderr, "clay_bar: no layout to show\n");
+        cleanup();
+        return 1;
+    }
+    activate_layout(startup_layout);
+    watch_layout();
+    trace("clocks ready");
+
+    /* initial surface */
     ensure_surface_size(200, 50);
     render_now();
+    if (trace_startup) {
+        XSync(dpy, False);
+        trace("first frame on screen");
+    }
 
     /* main loop */
     struct timespec last;
@@ -227,26 +1761,42 @@ int main(void) {
     for (;;) {
         while (XPending(dpy)) {
             XNextEvent(dpy, &ev);
-            if (ev.type == Expose) render_now();
-            else if (ev.type == ConfigureNotify) {
+            if (ev.type == Expose) {
+                cells_valid = 0;
+                render_now();
+            } else if (ev.type == ConfigureNotify) {
                 XConfigureEvent *ce = &ev.xconfigure;
                 if (ce->width > 0 && ce->height > 0) {
+                    /* render_now() puts the window back if someone else resized it */
+                    cur_win_w = ce->width;
+                    cur_win_h = ce->height;
+                    cells_valid = 0;
                     ensure_surface_size(ce->width, ce->height);
                     render_now();
                 }
             }
         }
 
+        if (layout_changed() && load_layout()) {
+            /* the anchor may have moved */
+            cur_win_w = cur_win_h = 0;
+            render_now();
+        }
+
         struct timespec now;
         clock_gettime(CLOCK_MONOTONIC, &now);
         double elapsed = (now.tv_sec - last.tv_sec) + (now.tv_nsec - last.tv_nsec) / 1e9;
-        if (elapsed >= REFRESH_INTERVAL) {
+        if (elapsed >= layout->refresh) {
             last = now;
-            update_time();
-            render_now();
+            /* nothing to draw until some clock's text changes */
+            if (update_clocks(layout->clocks, layout->nclocks)) render_now();
+            elapsed = 0;
         }
 
-        usleep(10000);
+        /* wake up in time for the next tick at high refresh rates */
+        double wait = layout->refresh - elapsed;
+        if (wait > 0.01) wait = 0.01;
+        if (wait > 0) usleep((useconds_t)(wait * 1e6));
     }
 
     cleanup();
@@ -0,0 +1,149 @@
+// A deterministic UI shared by the tests and benchmarks. It covers wrapped and unwrapped text, static and dynamic strings,
+// grow, fit, fixed and percent sizing with min/max limits, a row that has to be compressed, scroll clipping, borders,
+// images, aspect ratios and chained floating elements. Scene_Declare varies a status line every frame and the sidebar
+// width every fourth frame, so retained layout sees both changed and unchanged subtrees.
+
+#include <stdio.h>
+#include <string.h>
+
+#define SCENE_WIDTH 1280
+#define SCENE_HEIGHT 720
+
+typedef struct {
+    char status[64];
+    char counters[8][32];
+} Scene_Strings;
+
+static const char *Scene_paragraphs[] = {
+    "The quick brown fox jumps over the lazy dog while the layout engine wraps this paragraph across several lines.",
+    "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.",
+    "Short line.",
+    "A line with\nexplicit newlines\nthat break it into three.",
+    "Supercalifragilisticexpialidocious-words-that-are-too-long-to-wrap-anywhere stay on one line and overflow.",
+};
+
+// Advances depend on the character so that words of the same length measure differently
+static inline Clay_Dimensions Scene_MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
+    (void)userData;
+    float width = 0;
+    for (int32_t i = 0; i < text.length; i++) {
+        width += (4 + (unsigned char)text.chars[i] % 5) * config->fontSize / 16.0f + config->letterSpacing;
+    }
+    return (Clay_Dimensions) { width, config->lineHeight ? config->lineHeight : config->fontSize };
+}
+
+static inline void Scene_Declare(int frame, Scene_Strings *strings) {
+    snprintf(strings->status, sizeof(strings->status), "Frame %d, %d items selected", frame, frame % 7);
+    for (int i = 0; i < 8; i++) {
+        snprintf(strings->counters[i], sizeof(strings->counters[i]), "%d", (frame / 4 + i) * 37 % 1000);
+    }
+    Clay_String status = { .length = (int32_t)strlen(strings->status), .chars = strings->status };
+    float sidebarWidth = 220 + (frame / 4 % 3) * 25;
+
+    CLAY(CLAY_ID("Root"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM, .padding = CLAY_PADDING_ALL(8), .childGap = 8 }, .backgroundColor = { 20, 20, 30, 255 } }) {
+        CLAY(CLAY_ID("Header"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_FIT(40, 60) }, .padding = { 12, 12, 6, 6 }, .childGap = 16, .childAlignment = { .y = CLAY_ALIGN_Y_CENTER } }, .backgroundColor = { 40, 40, 60, 255 }, .cornerRadius = CLAY_CORNER_RADIUS(6) }) {
+            CLAY_TEXT(CLAY_STRING("Clay Scene"), CLAY_TEXT_CONFIG({ .fontSize = 24, .textColor = { 255, 255, 255, 255 } }));
+            CLAY_AUTO_ID({ .layout = { .sizing = { CLAY_SIZING_GROW(0) } } }) {}
+            CLAY_TEXT(status, CLAY_TEXT_CONFIG({ .fontSize = 14, .textColor = { 200, 200, 200, 255 }, .wrapMode = CLAY_TEXT_WRAP_NONE }));
+            CLAY(CLAY_ID("HeaderImage"), { .layout = { .sizing = { CLAY_SIZING_FIXED(32), CLAY_SIZING_FIXED(32) } }, .image = { .imageData = strings }, .aspectRatio = { 1 } }) {}
+        }
+        CLAY(CLAY_ID("Body"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .childGap = 8 } }) {
+            CLAY(CLAY_ID("Sidebar"), { .layout = { .sizing = { CLAY_SIZING_FIXED(sidebarWidth), CLAY_SIZING_GROW(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM, .padding = CLAY_PADDING_ALL(6), .childGap = 4 }, .backgroundColor = { 30, 30, 45, 255 }, .border = { .color = { 90, 90, 120, 255 }, .width = { 1, 1, 1, 1, 0 } } }) {
+                for (int i = 0; i < 12; i++) {
+                    CLAY(CLAY_IDI("SidebarItem", i), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_FIT(24) }, .padding = { 8, 8, 4, 4 }, .childGap = 6 }, .backgroundColor = { (float)(50 + i * 10), 50, 70, 255 } }) {
+                        CLAY_TEXT(i % 3 == 0 ? CLAY_STRING("Inbox with a rather long label") : CLAY_STRING("Drafts"), CLAY_TEXT_CONFIG({ .fontSize = 14, .textColor = { 230, 230, 230, 255 } }));
+                        CLAY_AUTO_ID({ .layout = { .sizing = { CLAY_SIZING_GROW(0) } } }) {}
+                        if (i < 8) {
+                            Clay_String counter = { .length = (int32_t)strlen(strings->counters[i]), .chars = strings->counters[i] };
+                            CLAY_TEXT(counter, CLAY_TEXT_CONFIG({ .fontSize = 12, .textColor = { 180, 180, 255, 255 } }));
+                        }
+                    }
+                }
+                CLAY(CLAY_ID("SidebarTooltip"), { .layout = { .sizing = { CLAY_SIZING_FIT(0, 180) }, .padding = CLAY_PADDING_ALL(4) }, .backgroundColor = { 0, 0, 0, 220 }, .floating = { .attachTo = CLAY_ATTACH_TO_ELEMENT_WITH_ID, .parentId = CLAY_IDI("SidebarItem", 3).id, .attachPoints = { .element = CLAY_ATTACH_POINT_LEFT_CENTER, .parent = CLAY_ATTACH_POINT_RIGHT_CENTER }, .offset = { 4, 0 }, .zIndex = 5 } }) {
+                    CLAY_TEXT(CLAY_STRING("A tooltip long enough to wrap onto a second line"), CLAY_TEXT_CONFIG({ .fontSize = 12, .textColor = { 255, 255, 255, 255 } }));
+                }
+            }
+            CLAY(CLAY_ID("Content"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM, .padding = CLAY_PADDING_ALL(10), .childGap = 10 }, .backgroundColor = { 25, 25, 35, 255 }, .clip = { .vertical = true, .childOffset = { 0, (float)-(frame % 5) * 7 } } }) {
+                CLAY(CLAY_ID("Toolbar"), { .layout = { .sizing = { CLAY_SIZING_PERCENT(0.9f), CLAY_SIZING_FIT(0) }, .childGap = 4 } }) {
+                    for (int i = 0; i < 9; i++) {
+                        if (i % 3 == 2) {
+                            CLAY(CLAY_IDI("ToolbarGrow", i), { .layout = { .sizing = { CLAY_SIZING_GROW((float)(10 * i), (float)(60 + 20 * i)), CLAY_SIZING_FIXED(24) } }, .backgroundColor = { 80, 120, (float)(20 * i), 255 } }) {}
+                        } else {
+                            CLAY(CLAY_IDI("ToolbarButton", i), { .layout = { .sizing = { CLAY_SIZING_FIT((float)(5 * i)), CLAY_SIZING_FIT(0) }, .padding = { 6, 6, 3, 3 } }, .backgroundColor = { 60, 60, 90, 255 }, .border = { .color = { 120, 120, 160, 255 }, .width = CLAY_BORDER_OUTSIDE(1) } }) {
+                                CLAY_TEXT(CLAY_STRING("Button label that is wide"), CLAY_TEXT_CONFIG({ .fontSize = 13, .letterSpacing = (uint16_t)(i % 2), .textColor = { 255, 255, 255, 255 } }));
+                            }
+                        }
+                    }
+                }
+                for (int i = 0; i < 10; i++) {
+                    CLAY(CLAY_IDI("Card", i), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_FIT(0) }, .layoutDirection = i % 2 ? CLAY_LEFT_TO_RIGHT : CLAY_TOP_TO_BOTTOM, .padding = CLAY_PADDING_ALL(8), .childGap = 6 }, .backgroundColor = { 45, 45, 65, 255 }, .cornerRadius = CLAY_CORNER_RADIUS(4), .border = { .color = { 100, 100, 140, 255 }, .width = { .betweenChildren = (uint16_t)(i % 3) } } }) {
+                        CLAY_TEXT(CLAY_STRING("Card title"), CLAY_TEXT_CONFIG({ .fontSize = 18, .textColor = { 255, 255, 255, 255 } }));
+                        const char *paragraph = Scene_paragraphs[i % 5];
+                        Clay_String text = { .isStaticallyAllocated = true, .length = (int32_t)strlen(paragraph), .chars = paragraph };
+                        CLAY_TEXT(text, CLAY_TEXT_CONFIG({ .fontSize = (uint16_t)(12 + i % 4), .lineHeight = (uint16_t)(i % 2 ? 0 : 20), .letterSpacing = (uint16_t)(i % 3 == 1), .textColor = { 210, 210, 210, 255 }, .wrapMode = i == 9 ? CLAY_TEXT_WRAP_NEWLINES : CLAY_TEXT_WRAP_WORDS }));
+                        if (i % 4 == 0) {
+                            CLAY(CLAY_IDI("CardThumb", i), { .layout = { .sizing = { CLAY_SIZING_GROW(40, 120) } }, .aspectRatio = { 16.0f / 9.0f }, .image = { .imageData = strings } }) {}
+                        }
+                    }
+                }
+            }
+        }
+        CLAY(CLAY_ID("Footer"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_FIXED(28) }, .padding = { 8, 8, 4, 4 }, .childAlignment = { .x = CLAY_ALIGN_X_RIGHT, .y = CLAY_ALIGN_Y_CENTER } }, .backgroundColor = { 40, 40, 60, 255 } }) {
+            CLAY_TEXT(CLAY_STRING("Ready"), CLAY_TEXT_CONFIG({ .fontSize = 14, .textColor = { 150, 255, 150, 255 } }));
+        }
+        CLAY(CLAY_ID("Menu"), { .layout = { .sizing = { CLAY_SIZING_FIXED(200), CLAY_SIZING_FIT(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM, .padding = CLAY_PADDING_ALL(4) }, .backgroundColor = { 50, 50, 50, 255 }, .floating = { .attachTo = CLAY_ATTACH_TO_ELEMENT_WITH_ID, .parentId = CLAY_ID("Header").id, .attachPoints = { .parent = CLAY_ATTACH_POINT_LEFT_BOTTOM }, .offset = { 20, 2 }, .zIndex = 10 } }) {
+            for (int i = 0; i < 4; i++) {
+                CLAY(CLAY_IDI("MenuItem", i), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_FIXED(22) }, .padding = { 6, 6, 2, 2 } } }) {
+                    CLAY_TEXT(CLAY_STRING("Menu item"), CLAY_TEXT_CONFIG({ .fontSize = 14, .textColor = { 255, 255, 255, 255 } }));
+                }
+            }
+            CLAY(CLAY_ID("Submenu"), { .layout = { .sizing = { CLAY_SIZING_FIXED(150), CLAY_SIZING_FIT(0) }, .padding = CLAY_PADDING_ALL(4) }, .backgroundColor = { 70, 70, 70, 255 }, .floating = { .attachTo = CLAY_ATTACH_TO_ELEMENT_WITH_ID, .parentId = CLAY_IDI("MenuItem", 2).id, .attachPoints = { .parent = CLAY_ATTACH_POINT_RIGHT_TOP }, .zIndex = 11 } }) {
+                CLAY_TEXT(CLAY_STRING("Nested floating submenu"), CLAY_TEXT_CONFIG({ .fontSize = 13, .textColor = { 255, 255, 255, 255 } }));
+            }
+        }
+        CLAY(CLAY_ID("Toast"), { .layout = { .sizing = { CLAY_SIZING_FIT(0, 300) }, .padding = CLAY_PADDING_ALL(8) }, .backgroundColor = { 30, 90, 30, 240 }, .floating = { .attachTo = CLAY_ATTACH_TO_ROOT, .attachPoints = { .element = CLAY_ATTACH_POINT_RIGHT_BOTTOM, .parent = CLAY_ATTACH_POINT_RIGHT_BOTTOM }, .offset = { -16, -40 }, .zIndex = 20 } }) {
+            CLAY_TEXT(CLAY_STRING("Saved. This toast wraps when the text is wider than three hundred pixels."), CLAY_TEXT_CONFIG({ .fontSize = 14, .textColor = { 255, 255, 255, 255 } }));
+        }
+    }
+}
+
+// Writes every render command as a line of text
+static inline void Scene_PrintRenderCommands(FILE *file, Clay_RenderCommandArray commands) {
+    for (int32_t i = 0; i < commands.length; i++) {
+        Clay_RenderCommand *command = &commands.internalArray[i];
+        Clay_BoundingBox box = command->boundingBox;
+        fprintf(file, "%d id=%u z=%d box=%.2f,%.2f,%.2f,%.2f", command->commandType, command->id, command->zIndex, box.x, box.y, box.width, box.height);
+        if (command->commandType == CLAY_RENDER_COMMAND_TYPE_TEXT) {
+            Clay_TextRenderData *text = &command->renderData.text;
+            fprintf(file, " size=%d \"%.*s\"", text->fontSize, text->stringContents.length, text->stringContents.chars);
+        } else if (command->commandType == CLAY_RENDER_COMMAND_TYPE_RECTANGLE) {
+            Clay_Color color = command->renderData.rectangle.backgroundColor;
+            fprintf(file, " color=%.0f,%.0f,%.0f,%.0f", color.r, color.g, color.b, color.a);
+        } else if (command->commandType == CLAY_RENDER_COMMAND_TYPE_BORDER) {
+            Clay_BorderWidth width = command->renderData.border.width;
+            fprintf(file, " width=%d,%d,%d,%d,%d", width.left, width.right, width.top, width.bottom, width.betweenChildren);
+        }
+        fprintf(file, "\n");
+    }
+}
+
+// FNV-1a over the same fields Scene_PrintRenderCommands writes
+static inline uint64_t Scene_HashRenderCommands(Clay_RenderCommandArray commands) {
+    char line[512];
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int32_t i = 0; i < commands.length; i++) {
+        Clay_RenderCommand *command = &commands.internalArray[i];
+        Clay_BoundingBox box = command->boundingBox;
+        int length = snprintf(line, sizeof(line), "%d %u %d %.2f %.2f %.2f %.2f", command->commandType, command->id, command->zIndex, box.x, box.y, box.width, box.height);
+        if (command->commandType == CLAY_RENDER_COMMAND_TYPE_TEXT) {
+            Clay_StringSlice text = command->renderData.text.stringContents;
+            for (int32_t j = 0; j < text.length; j++) {
+                hash = (hash ^ (uint8_t)text.chars[j]) * 0x100000001b3ULL;
+            }
+        }
+        for (int j = 0; j < length; j++) {
+            hash = (hash ^ (uint8_t)line[j]) * 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,88 @@
+// The grow and compress loops from before the sizing block, on plain arrays, shared by test_sizing, which checks
+// Clay__SizingBlock_Distribute against them, and bench_sizing, which times the two side by side. Include it after clay.h.
+
+#include <stdint.h>
+
+// Rows leave the active set by swapping the last active row into their place, as Clay__int32_tArray_RemoveSwapback did.
+// rows is scratch space for length indexes. The old loops kept going forever once a pass changed nothing, which this
+// stops at instead.
+static inline void SizingReference_Distribute(float *sizes, const float *minSizes, const float *maxSizes, int32_t *rows, int32_t length, float sizeToDistribute) {
+    for (int32_t i = 0; i < length; i++) {
+        rows[i] = i;
+    }
+    if (sizeToDistribute < 0) {
+        bool changed = true;
+        while (sizeToDistribute < -CLAY__EPSILON && length > 0 && changed) {
+            changed = false;
+            float largest = 0;
+            float secondLargest = 0;
+            float widthToAdd = sizeToDistribute;
+            for (int32_t i = 0; i < length; i++) {
+                float childSize = sizes[rows[i]];
+                if (Clay__FloatEqual(childSize, largest)) { continue; }
+                if (childSize > largest) {
+                    secondLargest = largest;
+                    largest = childSize;
+                }
+                if (childSize < largest) {
+                    secondLargest = CLAY__MAX(secondLargest, childSize);
+                    widthToAdd = secondLargest - largest;
+                }
+            }
+            widthToAdd = CLAY__MAX(widthToAdd, sizeToDistribute / (float)length);
+            for (int32_t i = 0; i < length; i++) {
+                float *childSize = &sizes[rows[i]];
+                float previousWidth = *childSize;
+                if (Clay__FloatEqual(*childSize, largest)) {
+                    *childSize += widthToAdd;
+                    bool reachedMin = *childSize <= minSizes[rows[i]];
+                    if (reachedMin) {
+                        *childSize = minSizes[rows[i]];
+                    }
+                    sizeToDistribute -= (*childSize - previousWidth);
+                    changed = changed || reachedMin || *childSize != previousWidth;
+                    if (reachedMin) {
+                        rows[i--] = rows[--length];
+                    }
+                }
+            }
+        }
+    } else {
+        bool changed = true;
+        while (sizeToDistribute > CLAY__EPSILON && length > 0 && changed) {
+            changed = false;
+            float smallest = CLAY__MAXFLOAT;
+            float secondSmallest = CLAY__MAXFLOAT;
+            float widthToAdd = sizeToDistribute;
+            for (int32_t i = 0; i < length; i++) {
+                float childSize = sizes[rows[i]];
+                if (Clay__FloatEqual(childSize, smallest)) { continue; }
+                if (childSize < smallest) {
+                    secondSmallest = smallest;
+                    smallest = childSize;
+                }
+                if (childSize > smallest) {
+                    secondSmallest = CLAY__MIN(secondSmallest, childSize);
+                    widthToAdd = secondSmallest - smallest;
+                }
+            }
+            widthToAdd = CLAY__MIN(widthToAdd, sizeToDistribute / (float)length);
+            for (int32_t i = 0; i < length; i++) {
+                float *childSize = &sizes[rows[i]];
+                float previousWidth = *childSize;
+                if (Clay__FloatEqual(*childSize, smallest)) {
+                    *childSize += widthToAdd;
+                    bool reachedMax = *childSize >= maxSizes[rows[i]];
+                    if (reachedMax) {
+                        *childSize = maxSizes[rows[i]];
+                    }
+                    sizeToDistribute -= (*childSize - previousWidth);
+                    changed = changed || reachedMax || *childSize != previousWidth;
+                    if (reachedMax) {
+                        rows[i--] = rows[--length];
+                    }
+                }
+            }
+        }
+    }
+}
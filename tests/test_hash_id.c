@@ -0,0 +1,87 @@
+// Checks that CLAY_ID and CLAY_IDI, which hash their literal's characters ahead of time, give the same id and baseId as
+// Clay__HashString and Clay__HashStringWithOffset hashing the same characters at runtime, for an empty label, a label
+// of UTF-8 beyond ASCII, one too long for the C hash loop to be fully unrolled, and ordinary ones. test_hash_id.cpp
+// builds this file as C++ too, where the literals are hashed by a consteval function.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LONG_LABEL "A label much longer than one hundred and twenty eight bytes, so that the hash of its characters can't come from " \
+    "a fully unrolled loop and has to be folded or looped over some other way"
+
+#define LABELS(X) \
+    X("") \
+    X("Sidebar") \
+    X("SidebarItem") \
+    X("h\xc3\xa9llo w\xc3\xb6rld \xe2\x9c\x93 \xf0\x9f\x98\x80") \
+    X(LONG_LABEL)
+
+#ifdef __cplusplus
+// Doesn't compile unless the literal's characters are hashed at compile time
+static_assert(CLAY__HASH_STRING_LITERAL(LONG_LABEL) != CLAY__HASH_STRING_LITERAL(""), "the long label hashed to the empty label's hash");
+#endif
+
+static const uint32_t offsets[] = { 0, 1, 7, 1000, 0xffffffffu };
+#define OFFSET_COUNT (sizeof(offsets) / sizeof(offsets[0]))
+
+static int CheckId(const char *macro, Clay_String label, uint32_t offset, Clay_ElementId actual, Clay_ElementId expected) {
+    if (actual.id != expected.id || actual.baseId != expected.baseId || actual.offset != expected.offset
+        || actual.stringId.length != label.length || memcmp(actual.stringId.chars, label.chars, (size_t)label.length) != 0) {
+        fprintf(stderr, "test_hash_id: %s of \"%.*s\" at offset %u gave id %u and baseId %u, expected id %u and baseId %u\n",
+            macro, label.length, label.chars, offset, actual.id, actual.baseId, expected.id, expected.baseId);
+        return 1;
+    }
+    return 0;
+}
+
+// The characters are copied to the heap so that the runtime hash reads them from memory rather than from the literal
+static int CheckLabel(Clay_String label, Clay_ElementId id, const Clay_ElementId *indexedIds) {
+    char *copy = (char *)malloc((size_t)label.length + 1);
+    memcpy(copy, label.chars, (size_t)label.length + 1);
+    Clay_String runtime = CLAY__INIT(Clay_String) { .length = label.length, .chars = copy };
+    int failures = 0;
+    Clay_ElementId expected = Clay__HashString(runtime, 0);
+    expected.stringId = label;
+    failures += CheckId("CLAY_ID", label, 0, id, expected);
+    for (size_t i = 0; i < OFFSET_COUNT; i++) {
+        expected = Clay__HashStringWithOffset(runtime, offsets[i], 0);
+        expected.stringId = label;
+        failures += CheckId("CLAY_IDI", label, offsets[i], indexedIds[i], expected);
+    }
+    free(copy);
+    return failures;
+}
+
+#define CHECK_LABEL(label) { \
+    Clay_ElementId indexedIds[OFFSET_COUNT]; \
+    for (size_t i = 0; i < OFFSET_COUNT; i++) { \
+        indexedIds[i] = CLAY_IDI(label, offsets[i]); \
+    } \
+    Clay_ElementId id = CLAY_ID(label); \
+    failures += CheckLabel(id.stringId, id, indexedIds); \
+    labelCount++; \
+}
+
+int main(void) {
+    int failures = 0;
+    int labelCount = 0;
+    LABELS(CHECK_LABEL)
+    if (sizeof(LONG_LABEL) <= 129) {
+        fprintf(stderr, "test_hash_id: the long label is only %d bytes\n", (int)sizeof(LONG_LABEL) - 1);
+        failures++;
+    }
+    if (failures) {
+        fprintf(stderr, "test_hash_id: FAILED\n");
+        return 1;
+    }
+#ifdef __cplusplus
+    printf("test_hash_id: CLAY_ID and CLAY_IDI hashed %d labels at compile time in C++ as they are at runtime\n", labelCount);
+#else
+    printf("test_hash_id: CLAY_ID and CLAY_IDI hashed %d labels in C as they are at runtime\n", labelCount);
+#endif
+    return 0;
+}
@@ -0,0 +1,3 @@
+// Builds test_hash_id.c as C++, where CLAY_ID and CLAY_IDI hash their literals with a consteval function
+
+#include "test_hash_id.c"
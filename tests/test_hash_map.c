@@ -0,0 +1,164 @@
+// Checks the element hash map: every one of thousands of ids finds its own element, elements declared in an earlier
+// frame can still be looked up, an id declared more than once in a frame reports a duplicate each extra time but not
+// the frame after, and once the map is full, ids already in it keep being refreshed and reporting duplicates while new
+// ones are left out without disturbing anything else.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MANY_COUNT 20000
+#define ITEM_COUNT 100
+#define FULL_MAX_ELEMENT_COUNT 256
+#define FRESH_PER_FRAME 40
+#define FULL_FRAME_COUNT 12
+
+static int duplicateCount;
+static int otherErrorCount;
+
+static void HandleError(Clay_ErrorData error) {
+    if (error.errorType == CLAY_ERROR_TYPE_DUPLICATE_ID) {
+        duplicateCount++;
+        return;
+    }
+    fprintf(stderr, "test_hash_map: clay error: %.*s\n", error.errorText.length, error.errorText.chars);
+    otherErrorCount++;
+}
+
+static void *CreateContext(int32_t maxElementCount) {
+    Clay_SetMaxElementCount(maxElementCount);
+    uint32_t size = Clay_MinMemorySize();
+    void *memory = malloc(size);
+    Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, memory), (Clay_Dimensions) { 1024, 768 }, (Clay_ErrorHandler) { HandleError, NULL });
+    return memory;
+}
+
+// Rows of a fixed height in a column, so that an element's y says which row and which frame its bounding box came from
+static void DeclareRow(Clay_ElementId id) {
+    CLAY(id, { .layout = { .sizing = { CLAY_SIZING_FIXED(100), CLAY_SIZING_FIXED(1) } } }) {}
+}
+
+static int ExpectElement(const char *name, Clay_ElementId id, bool found, float y) {
+    Clay_ElementData data = Clay_GetElementData(id);
+    if (data.found != found || (found && data.boundingBox.y != y)) {
+        fprintf(stderr, "test_hash_map: %s was %s at y %g, expected %s at y %g\n", name, data.found ? "found" : "not found", data.boundingBox.y, found ? "found" : "not found", y);
+        return 1;
+    }
+    return 0;
+}
+
+static int ExpectDuplicates(const char *name, int expected) {
+    if (duplicateCount != expected) {
+        fprintf(stderr, "test_hash_map: %s reported %d duplicate ids, expected %d\n", name, duplicateCount, expected);
+        duplicateCount = 0;
+        return 1;
+    }
+    duplicateCount = 0;
+    return 0;
+}
+
+// Enough ids that most of them share a tag with others in the same probe group
+static int CheckManyIds(void) {
+    int failures = 0;
+    void *memory = CreateContext(MANY_COUNT + 16);
+    Clay_SetLayoutDimensions((Clay_Dimensions) { 1024, MANY_COUNT });
+    Clay_BeginLayout();
+    CLAY(CLAY_ID("Column"), { .layout = { .layoutDirection = CLAY_TOP_TO_BOTTOM } }) {
+        for (int i = 0; i < MANY_COUNT; i++) {
+            DeclareRow(CLAY_IDI("Many", i));
+        }
+    }
+    Clay_EndLayout();
+    for (int i = 0; i < MANY_COUNT && failures < 10; i++) {
+        failures += ExpectElement("one of many ids", CLAY_IDI("Many", i), true, (float)i);
+    }
+    failures += ExpectElement("an id that was never declared", CLAY_IDI("Many", MANY_COUNT), false, 0);
+    Clay_SetCurrentContext(NULL);
+    free(memory);
+    return failures;
+}
+
+// The first frame declares every item, the second only half of them and shifted down, the third all of them again
+static void DeclareItems(int frame) {
+    Clay_BeginLayout();
+    CLAY(CLAY_ID("Column"), { .layout = { .layoutDirection = CLAY_TOP_TO_BOTTOM, .padding = { .top = (uint16_t)(frame * 1000) } } }) {
+        for (int i = 0; i < (frame == 1 ? ITEM_COUNT / 2 : ITEM_COUNT); i++) {
+            DeclareRow(CLAY_IDI("Item", i));
+        }
+        DeclareRow(CLAY_ID("Twin"));
+        for (int repeat = 0; repeat < (frame == 1 ? 2 : 0); repeat++) {
+            DeclareRow(CLAY_ID("Twin"));
+            DeclareRow(CLAY_ID("Triplet"));
+        }
+    }
+    Clay_EndLayout();
+}
+
+static int CheckEarlierFramesAndDuplicates(void) {
+    int failures = 0;
+    void *memory = CreateContext(1024);
+    DeclareItems(0);
+    failures += ExpectDuplicates("declaring every id once", 0);
+    DeclareItems(1);
+    // Twin is declared three times and Triplet twice
+    failures += ExpectDuplicates("declaring ids more than once", 3);
+    failures += ExpectElement("an item declared this frame", CLAY_IDI("Item", 10), true, 1010);
+    failures += ExpectElement("an item only declared in the frame before", CLAY_IDI("Item", 75), true, 75);
+    failures += ExpectElement("an id that was never declared", CLAY_ID("Never"), false, 0);
+    DeclareItems(2);
+    failures += ExpectDuplicates("declaring once ids that were duplicated the frame before", 0);
+    failures += ExpectElement("an item declared again after a frame away", CLAY_IDI("Item", 75), true, 2075);
+    Clay_SetCurrentContext(NULL);
+    free(memory);
+    return failures;
+}
+
+// Each frame declares ids no frame has before, so the map fills up after a few frames. Stable is declared every frame
+// and moves down a row each time.
+static void DeclareFresh(int frame, bool duplicateStable) {
+    Clay_BeginLayout();
+    CLAY(CLAY_ID("Column"), { .layout = { .layoutDirection = CLAY_TOP_TO_BOTTOM, .padding = { .top = (uint16_t)frame } } }) {
+        DeclareRow(CLAY_ID("Stable"));
+        for (int i = 0; i < FRESH_PER_FRAME; i++) {
+            DeclareRow(CLAY_IDI("Fresh", frame * FRESH_PER_FRAME + i));
+        }
+        if (duplicateStable) {
+            DeclareRow(CLAY_ID("Stable"));
+        }
+    }
+    Clay_EndLayout();
+}
+
+static int CheckFullTable(void) {
+    int failures = 0;
+    void *memory = CreateContext(FULL_MAX_ELEMENT_COUNT);
+    for (int frame = 0; frame < FULL_FRAME_COUNT; frame++) {
+        bool duplicateStable = frame == FULL_FRAME_COUNT - 1;
+        DeclareFresh(frame, duplicateStable);
+        // An id declared twice gets the bounding box of the last element declared with it, below the fresh ones
+        failures += ExpectElement("an id declared every frame", CLAY_ID("Stable"), true, (float)frame + (duplicateStable ? 1 + FRESH_PER_FRAME : 0));
+    }
+    failures += ExpectDuplicates("declaring an id twice in a full map", 1);
+    failures += ExpectElement("an id added before the map filled up", CLAY_IDI("Fresh", 0), true, 1);
+    int32_t lastFrameFresh = (FULL_FRAME_COUNT - 1) * FRESH_PER_FRAME;
+    failures += ExpectElement("an id declared after the map filled up", CLAY_IDI("Fresh", lastFrameFresh), false, 0);
+    failures += ExpectElement("an id that was never declared", CLAY_ID("Never"), false, 0);
+    Clay_SetCurrentContext(NULL);
+    free(memory);
+    return failures;
+}
+
+int main(void) {
+    int failures = CheckManyIds();
+    failures += CheckEarlierFramesAndDuplicates();
+    failures += CheckFullTable();
+    failures += otherErrorCount > 0;
+    if (failures) {
+        fprintf(stderr, "test_hash_map: FAILED\n");
+        return 1;
+    }
+    printf("test_hash_map: %d ids found their own elements, earlier frames' ids were found and duplicates were reported, with room and when full\n", MANY_COUNT);
+    return 0;
+}
@@ -0,0 +1,237 @@
+// Checks the string hash used by the text measurement cache: the scalar, SIMD and AVX2 paths for long strings must give
+// the same hash, strings like the ones UIs show mustn't collide more often than random 32 bit hashes would, and flipping
+// any bit of the input must flip each bit of the hash about half the time.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SET_SIZE 200000
+#define MAX_STRING_LENGTH 320
+#define AVALANCHE_TRIALS 1000
+#define MAX_AVALANCHE_BIAS 0.1
+
+typedef struct {
+    char *chars;
+    int32_t length;
+} String;
+
+static String strings[SET_SIZE];
+static int32_t stringCount;
+static char pool[SET_SIZE * MAX_STRING_LENGTH];
+static size_t poolUsed;
+static uint64_t randomState = 88172645463325252ULL;
+
+static uint64_t NextRandom(void) {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return randomState;
+}
+
+static void AddString(const char *chars, int32_t length) {
+    memcpy(pool + poolUsed, chars, (size_t)length);
+    strings[stringCount++] = (String) { pool + poolUsed, length };
+    poolUsed += (size_t)length;
+}
+
+static int CompareStrings(const void *a, const void *b) {
+    const String *x = (const String *)a, *y = (const String *)b;
+    int order = memcmp(x->chars, y->chars, (size_t)(x->length < y->length ? x->length : y->length));
+    return order ? order : (x->length > y->length) - (x->length < y->length);
+}
+
+static int CompareHashes(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// The hash as the measure cache folds it into 32 bits, see Clay__HashStringContentsWithConfig
+static uint32_t CacheHash(String string) {
+    uint64_t hash = Clay__HashData((const uint8_t *)string.chars, (size_t)string.length);
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+// Counts collisions among the distinct strings added since the last call. 64 bit collisions would be a bug. 32 bit ones
+// are expected about n^2 / 2^33 times, and more than four times that plus a few means the hash is missing something.
+static int CheckCollisions(const char *name) {
+    qsort(strings, (size_t)stringCount, sizeof(String), CompareStrings);
+    int32_t distinct = 0;
+    for (int32_t i = 0; i < stringCount; i++) {
+        if (i == 0 || CompareStrings(&strings[i], &strings[distinct - 1]) != 0) {
+            strings[distinct++] = strings[i];
+        }
+    }
+    uint64_t *hashes64 = malloc((size_t)distinct * sizeof(uint64_t));
+    uint64_t *hashes32 = malloc((size_t)distinct * sizeof(uint64_t));
+    for (int32_t i = 0; i < distinct; i++) {
+        hashes64[i] = Clay__HashData((const uint8_t *)strings[i].chars, (size_t)strings[i].length);
+        hashes32[i] = CacheHash(strings[i]);
+    }
+    qsort(hashes64, (size_t)distinct, sizeof(uint64_t), CompareHashes);
+    qsort(hashes32, (size_t)distinct, sizeof(uint64_t), CompareHashes);
+    int32_t collisions64 = 0, collisions32 = 0;
+    for (int32_t i = 1; i < distinct; i++) {
+        collisions64 += hashes64[i] == hashes64[i - 1];
+        collisions32 += hashes32[i] == hashes32[i - 1];
+    }
+    free(hashes64);
+    free(hashes32);
+    double expected = (double)distinct * (distinct - 1) / 2 / 4294967296.0;
+    stringCount = 0;
+    poolUsed = 0;
+    if (collisions64 > 0 || collisions32 > expected * 4 + 4) {
+        fprintf(stderr, "test_hash_quality: of %d %s, %d collide in 64 bits and %d in 32 bits, expected about %.1f\n", distinct, name, collisions64, collisions32, expected);
+        return 1;
+    }
+    return 0;
+}
+
+static int CheckRealisticStrings(void) {
+    int failures = 0;
+    char text[MAX_STRING_LENGTH];
+    for (int i = 0; i < SET_SIZE; i++) {
+        AddString(text, snprintf(text, sizeof(text), "Item %d", i));
+    }
+    failures += CheckCollisions("list items");
+    for (int i = 0; i < SET_SIZE; i++) {
+        AddString(text, snprintf(text, sizeof(text), "FPS: %d.%02d  Frame %d ms", i % 240, i % 100, i / 240));
+    }
+    failures += CheckCollisions("frame counters");
+    for (int i = 0; i < SET_SIZE; i++) {
+        AddString(text, snprintf(text, sizeof(text), "%02d:%02d:%02d.%03d", i / 3600000 % 24, i / 60000 % 60, i / 1000 % 60, i % 1000));
+    }
+    failures += CheckCollisions("timestamps");
+    for (int i = 0; i < SET_SIZE; i++) {
+        AddString(text, snprintf(text, sizeof(text), "/home/user/projects/clay/src/module_%d/file_%d.c:%d", i % 97, i % 1013, i % 4001));
+    }
+    failures += CheckCollisions("file paths");
+    for (int i = 0; i < SET_SIZE; i++) {
+        AddString(text, snprintf(text, sizeof(text), "%d", i));
+    }
+    failures += CheckCollisions("numbers");
+    // Short runs of a few letters and spaces, as a paragraph is split into words
+    for (int i = 0; i < SET_SIZE; i++) {
+        int32_t length = 1 + i % 8;
+        for (int32_t k = 0; k < length; k++) {
+            int letter = i >> (k * 3) & 7;
+            text[k] = letter ? (char)('a' + letter) : ' ';
+        }
+        AddString(text, length);
+    }
+    failures += CheckCollisions("short words");
+    // Paragraphs long enough to take the SIMD path, each with one character changed
+    const char *paragraph = "The quick brown fox jumps over the lazy dog while the layout engine wraps this paragraph of text across several lines of a scroll container. ";
+    int32_t paragraphLength = (int32_t)strlen(paragraph);
+    for (int i = 0; i < SET_SIZE; i++) {
+        memcpy(text, paragraph, (size_t)paragraphLength);
+        memcpy(text + paragraphLength, paragraph, (size_t)paragraphLength);
+        text[i % (paragraphLength * 2)] = (char)('A' + i / (paragraphLength * 2) % 58);
+        AddString(text, paragraphLength * 2);
+    }
+    failures += CheckCollisions("edited paragraphs");
+    for (int i = 0; i < SET_SIZE; i++) {
+        int32_t length = (int32_t)(NextRandom() % 48);
+        for (int32_t k = 0; k < length; k++) {
+            text[k] = NextRandom() % 2 ? 'a' : 'b';
+        }
+        AddString(text, length);
+    }
+    failures += CheckCollisions("strings of two letters");
+    for (int i = 0; i < SET_SIZE; i++) {
+        int32_t length = 100 + (int32_t)(NextRandom() % 200);
+        for (int32_t k = 0; k < length; k++) {
+            text[k] = k % 7 == 3 && NextRandom() % 2 ? 'b' : 'a';
+        }
+        AddString(text, length);
+    }
+    failures += CheckCollisions("long strings differing in a few places");
+    return failures;
+}
+
+// Lengths either side of each change of path: short, medium and striped
+static int CheckAvalanche(void) {
+    static const int32_t lengths[] = { 3, 8, 16, 17, 33, 64, 128, 129, 200 };
+    static int32_t flips[200 * 8][64];
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        int32_t length = lengths[i];
+        memset(flips, 0, sizeof(flips));
+        for (int trial = 0; trial < AVALANCHE_TRIALS; trial++) {
+            uint8_t data[200];
+            for (int32_t k = 0; k < length; k++) {
+                data[k] = (uint8_t)NextRandom();
+            }
+            uint64_t hash = Clay__HashData(data, (size_t)length);
+            for (int32_t bit = 0; bit < length * 8; bit++) {
+                data[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+                uint64_t flipped = Clay__HashData(data, (size_t)length) ^ hash;
+                data[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+                for (int output = 0; output < 64; output++) {
+                    flips[bit][output] += (int32_t)(flipped >> output & 1);
+                }
+            }
+        }
+        double worst = 0;
+        for (int32_t bit = 0; bit < length * 8; bit++) {
+            for (int output = 0; output < 64; output++) {
+                double bias = (double)flips[bit][output] / AVALANCHE_TRIALS - 0.5;
+                worst = bias < -worst ? -bias : bias > worst ? bias : worst;
+            }
+        }
+        if (worst > MAX_AVALANCHE_BIAS) {
+            fprintf(stderr, "test_hash_quality: at length %d an output bit flips with a bias of %.3f\n", length, worst);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// Every length the striped paths take, at every alignment
+static int CheckPathsMatch(void) {
+    int failures = 0;
+    static uint8_t data[1200];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)NextRandom();
+    }
+    for (size_t length = CLAY__HASH_MEDIUM_MAX + 1; length <= 1100; length++) {
+        for (size_t offset = 0; offset < 8; offset++) {
+            uint64_t scalar[4] = { 1, 2, 3, 4 };
+            Clay__HashAccumulateScalar(scalar, data + offset, length);
+#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64) || defined(__aarch64__))
+            uint64_t simd[4] = { 1, 2, 3, 4 };
+            Clay__HashAccumulateSIMD(simd, data + offset, length);
+            if (memcmp(scalar, simd, sizeof(scalar)) != 0) {
+                fprintf(stderr, "test_hash_quality: the SIMD hash differs from the scalar one at length %zu\n", length);
+                return failures + 1;
+            }
+#endif
+#if !defined(CLAY_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64))
+            if (Clay__HashDataUseAVX2()) {
+                uint64_t avx2[4] = { 1, 2, 3, 4 };
+                Clay__HashAccumulateAVX2(avx2, data + offset, length);
+                if (memcmp(scalar, avx2, sizeof(scalar)) != 0) {
+                    fprintf(stderr, "test_hash_quality: the AVX2 hash differs from the scalar one at length %zu\n", length);
+                    return failures + 1;
+                }
+            }
+#endif
+        }
+    }
+    return failures;
+}
+
+int main(void) {
+    int failures = CheckPathsMatch();
+    failures += CheckRealisticStrings();
+    failures += CheckAvalanche();
+    if (failures) {
+        fprintf(stderr, "test_hash_quality: FAILED\n");
+        return 1;
+    }
+    printf("test_hash_quality: every hashing path agreed, realistic strings collided no more than random and every bit avalanched\n");
+    return 0;
+}
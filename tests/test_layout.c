@@ -0,0 +1,190 @@
+// Lays out the scene and checks the render commands against tests/golden/scene.txt, then checks that laying out floating
+// roots in parallel and retained layout both produce the same render commands as a serial layout. Run with UPDATE_GOLDEN=1
+// to rewrite the golden file after an intended change to the layout.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+#include "scene.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAME_COUNT 8
+#define GOLDEN_PATH "tests/golden/scene.txt"
+#define WORKER_COUNT 4
+
+typedef struct {
+    char *text;
+    size_t length;
+} FrameOutput;
+
+static int errorCount;
+
+static void HandleError(Clay_ErrorData error) {
+    fprintf(stderr, "test_layout: clay error: %.*s\n", error.errorText.length, error.errorText.chars);
+    errorCount++;
+}
+
+typedef struct {
+    void (*task)(int32_t index, void *taskData);
+    void *taskData;
+    int32_t count;
+    int32_t next;
+} ParallelFor;
+
+static int parallelTaskCount;
+
+static void *RunTasks(void *userData) {
+    ParallelFor *parallelFor = (ParallelFor *)userData;
+    int32_t index;
+    while ((index = __atomic_fetch_add(&parallelFor->next, 1, __ATOMIC_RELAXED)) < parallelFor->count) {
+        parallelFor->task(index, parallelFor->taskData);
+    }
+    return NULL;
+}
+
+// Starts a few threads for every call, which is slow but is all the test needs
+static void RunParallelFor(int32_t count, void (*task)(int32_t index, void *taskData), void *taskData, void *userData) {
+    (void)userData;
+    ParallelFor parallelFor = { task, taskData, count, 0 };
+    pthread_t threads[WORKER_COUNT];
+    for (int i = 0; i < WORKER_COUNT; i++) {
+        pthread_create(&threads[i], NULL, RunTasks, &parallelFor);
+    }
+    RunTasks(&parallelFor);
+    for (int i = 0; i < WORKER_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    parallelTaskCount += count;
+}
+
+typedef struct {
+    Clay_Context *context;
+    void *memory;
+} TestContext;
+
+static TestContext CreateContext(void) {
+    uint32_t size = Clay_MinMemorySize();
+    TestContext test = { .memory = malloc(size) };
+    test.context = Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, test.memory), (Clay_Dimensions) { SCENE_WIDTH, SCENE_HEIGHT }, (Clay_ErrorHandler) { HandleError, NULL });
+    Clay_SetMeasureTextFunction(Scene_MeasureText, NULL);
+    return test;
+}
+
+static FrameOutput PrintFrame(Clay_RenderCommandArray commands) {
+    FrameOutput output;
+    FILE *file = open_memstream(&output.text, &output.length);
+    Scene_PrintRenderCommands(file, commands);
+    fclose(file);
+    return output;
+}
+
+static Clay_RenderCommandArray LayoutFrame(Clay_Context *context, int frame, Scene_Strings *strings) {
+    Clay_SetCurrentContext(context);
+    Clay_SetPointerState((Clay_Vector2) { (float)(frame * 37 % SCENE_WIDTH), (float)(frame * 53 % SCENE_HEIGHT) }, frame % 2);
+    Clay_BeginLayout();
+    Scene_Declare(frame, strings);
+    return Clay_EndLayout();
+}
+
+static bool SameOutput(FrameOutput a, FrameOutput b) {
+    return a.length == b.length && memcmp(a.text, b.text, a.length) == 0;
+}
+
+static int CheckGolden(FrameOutput *frames) {
+    FrameOutput all = {0};
+    FILE *file = open_memstream(&all.text, &all.length);
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        fprintf(file, "frame %d\n", frame);
+        fwrite(frames[frame].text, 1, frames[frame].length, file);
+    }
+    fclose(file);
+    int failures = 0;
+    if (getenv("UPDATE_GOLDEN")) {
+        FILE *golden = fopen(GOLDEN_PATH, "wb");
+        if (!golden || fwrite(all.text, 1, all.length, golden) != all.length) {
+            fprintf(stderr, "test_layout: couldn't write %s\n", GOLDEN_PATH);
+            failures++;
+        }
+        if (golden) {
+            fclose(golden);
+        }
+    } else {
+        FrameOutput expected = {0};
+        FILE *golden = fopen(GOLDEN_PATH, "rb");
+        if (golden) {
+            fseek(golden, 0, SEEK_END);
+            expected.length = (size_t)ftell(golden);
+            fseek(golden, 0, SEEK_SET);
+            expected.text = malloc(expected.length);
+            expected.length = fread(expected.text, 1, expected.length, golden);
+            fclose(golden);
+        }
+        if (!SameOutput(expected, all)) {
+            fprintf(stderr, "test_layout: render commands differ from %s, diff against UPDATE_GOLDEN=1 output to see how\n", GOLDEN_PATH);
+            failures++;
+        }
+        free(expected.text);
+    }
+    free(all.text);
+    return failures;
+}
+
+int main(void) {
+    int failures = 0;
+    Scene_Strings strings;
+    FrameOutput serial[FRAME_COUNT];
+    TestContext serialContext = CreateContext();
+    TestContext parallelContext = CreateContext();
+    Clay_SetParallelForFunction(RunParallelFor, NULL);
+    TestContext retainedContext = CreateContext();
+    Clay_SetRetainedLayoutEnabled(true);
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        serial[frame] = PrintFrame(LayoutFrame(serialContext.context, frame, &strings));
+        FrameOutput parallel = PrintFrame(LayoutFrame(parallelContext.context, frame, &strings));
+        if (!SameOutput(serial[frame], parallel)) {
+            fprintf(stderr, "test_layout: frame %d differs when floating roots are laid out in parallel\n", frame);
+            failures++;
+        }
+        free(parallel.text);
+        // Each frame is declared twice. The second declaration is the same as the frame before, so its render commands
+        // should be handed back without laying out again.
+        Clay_RenderCommand *firstCommands = NULL;
+        for (int repeat = 0; repeat < 2; repeat++) {
+            Clay_RenderCommandArray commands = LayoutFrame(retainedContext.context, frame, &strings);
+            if (repeat == 0) {
+                firstCommands = commands.internalArray;
+            } else if (commands.internalArray != firstCommands) {
+                fprintf(stderr, "test_layout: frame %d was laid out again although nothing changed\n", frame);
+                failures++;
+            }
+            FrameOutput retained = PrintFrame(commands);
+            if (!SameOutput(serial[frame], retained)) {
+                fprintf(stderr, "test_layout: frame %d differs with retained layout enabled (%s declaration)\n", frame, repeat ? "repeated" : "first");
+                failures++;
+            }
+            free(retained.text);
+        }
+    }
+    if (parallelTaskCount == 0) {
+        fprintf(stderr, "test_layout: the parallel for function was never called\n");
+        failures++;
+    }
+    failures += CheckGolden(serial);
+    failures += errorCount > 0;
+
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        free(serial[frame].text);
+    }
+    free(serialContext.memory);
+    free(parallelContext.memory);
+    free(retainedContext.memory);
+    if (failures) {
+        fprintf(stderr, "test_layout: FAILED\n");
+        return 1;
+    }
+    printf("test_layout: %d frames matched the golden file, in parallel and with retained layout\n", FRAME_COUNT);
+    return 0;
+}
@@ -0,0 +1,169 @@
+// Checks the bounded text measurement cache: the hit, miss and eviction counters from Clay_GetMeasureTextCacheStats follow
+// what a small cache has to do as text comes and goes, and a cache of 512 words that keeps evicting lays out the scene
+// and a stream of changing paragraphs exactly as a cache big enough to hold all of it does.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+#include "scene.h"
+
+#include <stdlib.h>
+
+#define SMALL_WORD_COUNT 512
+#define TEXTS_PER_FRAME 10
+#define FRESH_FRAME_COUNT 12
+#define SENTENCE_COUNT 200
+#define PARAGRAPHS_PER_FRAME 40
+#define FRAME_COUNT 40
+
+static int errorCount;
+static int measureCount;
+
+static void HandleError(Clay_ErrorData error) {
+    fprintf(stderr, "test_measure_cache: clay error: %.*s\n", error.errorText.length, error.errorText.chars);
+    errorCount++;
+}
+
+static Clay_Dimensions MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
+    measureCount++;
+    return Scene_MeasureText(text, config, userData);
+}
+
+typedef struct {
+    Clay_Context *context;
+    void *memory;
+} TestContext;
+
+static TestContext CreateContext(int32_t maxWordCount) {
+    Clay_SetMaxMeasureTextCacheWordCount(maxWordCount);
+    uint32_t size = Clay_MinMemorySize();
+    TestContext test = { .memory = malloc(size) };
+    test.context = Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, test.memory), (Clay_Dimensions) { SCENE_WIDTH, SCENE_HEIGHT }, (Clay_ErrorHandler) { HandleError, NULL });
+    Clay_SetMeasureTextFunction(MeasureText, NULL);
+    return test;
+}
+
+static void DestroyContext(TestContext test) {
+    Clay_SetCurrentContext(NULL);
+    free(test.memory);
+}
+
+// Eight words of text that only the texts with the same number share
+static void DeclareTexts(int first) {
+    static char texts[TEXTS_PER_FRAME][64];
+    Clay_BeginLayout();
+    CLAY(CLAY_ID("Column"), { .layout = { .layoutDirection = CLAY_TOP_TO_BOTTOM } }) {
+        for (int i = 0; i < TEXTS_PER_FRAME; i++) {
+            int length = snprintf(texts[i], sizeof(texts[i]), "text number %d is eight words long here", first + i);
+            CLAY_TEXT(((Clay_String) { .length = length, .chars = texts[i] }), CLAY_TEXT_CONFIG({ .fontSize = 12 }));
+        }
+    }
+    Clay_EndLayout();
+}
+
+static int ExpectStats(const char *name, Clay_MeasureTextCacheStats before, uint64_t hits, uint64_t misses, bool evicted) {
+    Clay_MeasureTextCacheStats stats = Clay_GetMeasureTextCacheStats();
+    if (stats.hits - before.hits != hits || stats.misses - before.misses != misses || (stats.evictions > before.evictions) != evicted
+        || stats.wordsUsed > stats.wordCapacity || stats.wordCapacity != SMALL_WORD_COUNT) {
+        fprintf(stderr, "test_measure_cache: %s gave %llu hits, %llu misses and %llu evictions with %d of %d words used, expected %llu hits, %llu misses and %s\n",
+            name, (unsigned long long)(stats.hits - before.hits), (unsigned long long)(stats.misses - before.misses), (unsigned long long)(stats.evictions - before.evictions),
+            stats.wordsUsed, stats.wordCapacity, (unsigned long long)hits, (unsigned long long)misses, evicted ? "some evictions" : "none");
+        return 1;
+    }
+    return 0;
+}
+
+static int CheckEviction(void) {
+    int failures = 0;
+    TestContext test = CreateContext(SMALL_WORD_COUNT);
+    Clay_MeasureTextCacheStats before = Clay_GetMeasureTextCacheStats();
+    DeclareTexts(0);
+    failures += ExpectStats("the first layout", before, 0, TEXTS_PER_FRAME, false);
+    before = Clay_GetMeasureTextCacheStats();
+    measureCount = 0;
+    DeclareTexts(0);
+    failures += ExpectStats("the same layout again", before, TEXTS_PER_FRAME, 0, false);
+    if (measureCount > 0) {
+        fprintf(stderr, "test_measure_cache: text was measured %d times in a layout the cache had already measured\n", measureCount);
+        failures++;
+    }
+    // Eighty new words a frame fill the cache after a few frames, after which each frame has to evict to make room
+    before = Clay_GetMeasureTextCacheStats();
+    for (int frame = 1; frame <= FRESH_FRAME_COUNT; frame++) {
+        DeclareTexts(frame * TEXTS_PER_FRAME);
+    }
+    failures += ExpectStats("layouts of new text", before, 0, FRESH_FRAME_COUNT * TEXTS_PER_FRAME, true);
+    before = Clay_GetMeasureTextCacheStats();
+    DeclareTexts(0);
+    failures += ExpectStats("the first layout's text after it was evicted", before, 0, TEXTS_PER_FRAME, true);
+    DestroyContext(test);
+    return failures;
+}
+
+static char sentences[SENTENCE_COUNT][160];
+
+// Paragraphs from a pool, some kept from the frame before and some new, wrapped in columns whose widths change each frame
+static void DeclareParagraphs(int frame) {
+    CLAY(CLAY_ID("Paragraphs"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .childGap = 4 } }) {
+        for (int column = 0; column < 4; column++) {
+            CLAY(CLAY_IDI("ParagraphColumn", column), { .layout = { .sizing = { CLAY_SIZING_FIXED((float)(140 + (frame + column) % 5 * 40)), CLAY_SIZING_FIT(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM, .childGap = 2 } }) {
+                for (int i = column; i < PARAGRAPHS_PER_FRAME; i += 4) {
+                    char *sentence = sentences[(frame / 3 * 7 + i * 13 + (i % 3 == 0 ? frame * 11 : 0)) % SENTENCE_COUNT];
+                    CLAY_TEXT(((Clay_String) { .length = (int32_t)strlen(sentence), .chars = sentence }), CLAY_TEXT_CONFIG({ .fontSize = (uint16_t)(10 + i % 3 * 2) }));
+                }
+            }
+        }
+    }
+}
+
+static uint64_t LayoutFrame(Clay_Context *context, int frame, Scene_Strings *strings, bool paragraphs) {
+    Clay_SetCurrentContext(context);
+    Clay_BeginLayout();
+    if (paragraphs) {
+        DeclareParagraphs(frame);
+    } else {
+        Scene_Declare(frame, strings);
+    }
+    return Scene_HashRenderCommands(Clay_EndLayout());
+}
+
+static int CheckSmallCacheMatches(void) {
+    int failures = 0;
+    for (int i = 0; i < SENTENCE_COUNT; i++) {
+        int length = 0;
+        for (int word = 0; word < 4 + i % 13; word++) {
+            length += snprintf(sentences[i] + length, sizeof(sentences[i]) - (size_t)length, word ? " w%d-%d" : "s%d-%d", i, word);
+        }
+    }
+    TestContext small = CreateContext(SMALL_WORD_COUNT);
+    TestContext large = CreateContext(Clay__defaultMaxMeasureTextWordCacheCount * 4);
+    Scene_Strings strings;
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        for (int paragraphs = 0; paragraphs < 2; paragraphs++) {
+            uint64_t expected = LayoutFrame(large.context, frame, &strings, paragraphs);
+            if (LayoutFrame(small.context, frame, &strings, paragraphs) != expected) {
+                fprintf(stderr, "test_measure_cache: frame %d of the %s differs with a %d word cache\n", frame, paragraphs ? "paragraphs" : "scene", SMALL_WORD_COUNT);
+                failures++;
+            }
+        }
+    }
+    Clay_SetCurrentContext(small.context);
+    if (Clay_GetMeasureTextCacheStats().evictions == 0) {
+        fprintf(stderr, "test_measure_cache: the %d word cache never had to evict anything\n", SMALL_WORD_COUNT);
+        failures++;
+    }
+    DestroyContext(small);
+    free(large.memory);
+    return failures;
+}
+
+int main(void) {
+    int failures = CheckEviction();
+    failures += CheckSmallCacheMatches();
+    failures += errorCount > 0;
+    if (failures) {
+        fprintf(stderr, "test_measure_cache: FAILED\n");
+        return 1;
+    }
+    printf("test_measure_cache: the cache counted its hits, misses and evictions, and %d words laid out %d frames as an unbounded cache did\n", SMALL_WORD_COUNT, FRAME_COUNT);
+    return 0;
+}
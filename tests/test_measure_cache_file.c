@@ -0,0 +1,123 @@
+// Checks Clay_SaveMeasureTextCache and Clay_LoadMeasureTextCache: measurements saved from one context and loaded into a
+// fresh one, at any alignment, lay out the same text without measuring it again, while data that was cut short, has any
+// single byte changed or was saved with another fontKey loads nothing.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+#include "scene.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TEXT_COUNT 12
+#define FONT_KEY 0x5eedf00dcafe1234ull
+
+static int errorCount;
+static int measureCount;
+
+static void HandleError(Clay_ErrorData error) {
+    fprintf(stderr, "test_measure_cache_file: clay error: %.*s\n", error.errorText.length, error.errorText.chars);
+    errorCount++;
+}
+
+static Clay_Dimensions MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
+    measureCount++;
+    return Scene_MeasureText(text, config, userData);
+}
+
+static void *CreateContext(void) {
+    uint32_t size = Clay_MinMemorySize();
+    void *memory = malloc(size);
+    Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, memory), (Clay_Dimensions) { SCENE_WIDTH, SCENE_HEIGHT }, (Clay_ErrorHandler) { HandleError, NULL });
+    Clay_SetMeasureTextFunction(MeasureText, NULL);
+    return memory;
+}
+
+static void DestroyContext(void *memory) {
+    Clay_SetCurrentContext(NULL);
+    free(memory);
+}
+
+// Dynamic texts of a few lengths and font sizes, some with newlines, wrapped in a column narrow enough to split most of them
+static uint64_t Layout(void) {
+    static char texts[TEXT_COUNT][128];
+    Clay_BeginLayout();
+    CLAY(CLAY_ID("Column"), { .layout = { .sizing = { CLAY_SIZING_FIXED(180), CLAY_SIZING_FIT(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM, .childGap = 2 } }) {
+        for (int i = 0; i < TEXT_COUNT; i++) {
+            int length = snprintf(texts[i], sizeof(texts[i]), i % 4 == 3 ? "saved text %d\nafter a newline" : "saved text %d with %d more words after it", i, i % 7);
+            for (int word = 0; word < i % 7; word++) {
+                length += snprintf(texts[i] + length, sizeof(texts[i]) - (size_t)length, " w%d", word);
+            }
+            CLAY_TEXT(((Clay_String) { .length = length, .chars = texts[i] }), CLAY_TEXT_CONFIG({ .fontSize = (uint16_t)(10 + i % 3 * 4) }));
+        }
+    }
+    return Scene_HashRenderCommands(Clay_EndLayout());
+}
+
+static int ExpectRejected(const char *name, const void *data, int32_t dataSize, uint64_t fontKey) {
+    Clay_ResetMeasureTextCache();
+    int32_t loaded = Clay_LoadMeasureTextCache(data, dataSize, fontKey);
+    int32_t wordsUsed = Clay_GetMeasureTextCacheStats().wordsUsed;
+    if (loaded != 0 || wordsUsed != 0) {
+        fprintf(stderr, "test_measure_cache_file: %s loaded %d texts and %d words\n", name, loaded, wordsUsed);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+    void *saving = CreateContext();
+    uint64_t expected = Layout();
+    int32_t size = Clay_SaveMeasureTextCache(NULL, 0, FONT_KEY);
+    // One byte extra so that the data can also be loaded from an odd address
+    uint8_t *data = malloc((size_t)size + 1);
+    if (Clay_SaveMeasureTextCache(data, size - 1, FONT_KEY) != size || Clay_SaveMeasureTextCache(data, size, FONT_KEY) != size) {
+        fprintf(stderr, "test_measure_cache_file: saving gave a different size from the one it asked for\n");
+        failures++;
+    }
+    DestroyContext(saving);
+
+    void *loading = CreateContext();
+    for (int offset = 0; offset < 2; offset++) {
+        if (offset > 0) {
+            memmove(data + offset, data, (size_t)size);
+        }
+        Clay_ResetMeasureTextCache();
+        int32_t loaded = Clay_LoadMeasureTextCache(data + offset, size, FONT_KEY);
+        measureCount = 0;
+        uint64_t actual = Layout();
+        if (loaded != TEXT_COUNT || measureCount != 0 || actual != expected) {
+            fprintf(stderr, "test_measure_cache_file: loading from offset %d loaded %d of %d texts, then measured %d words and laid them out %s\n",
+                offset, loaded, TEXT_COUNT, measureCount, actual == expected ? "the same" : "differently");
+            failures++;
+        }
+    }
+    memmove(data, data + 1, (size_t)size);
+
+    failures += ExpectRejected("no data", NULL, size, FONT_KEY);
+    failures += ExpectRejected("data cut short by a byte", data, size - 1, FONT_KEY);
+    failures += ExpectRejected("only the header", data, (int32_t)sizeof(Clay__MeasureTextCacheFileHeader), FONT_KEY);
+    failures += ExpectRejected("another fontKey", data, size, FONT_KEY ^ 1);
+    uint8_t *corrupt = malloc((size_t)size);
+    for (int32_t i = 0; i < size && failures < 10; i++) {
+        for (int bit = 0; bit < 8; bit += 7) {
+            memcpy(corrupt, data, (size_t)size);
+            corrupt[i] ^= (uint8_t)(1 << bit);
+            char name[64];
+            snprintf(name, sizeof(name), "data with bit %d of byte %d of %d flipped", bit, i, size);
+            failures += ExpectRejected(name, corrupt, size, FONT_KEY);
+        }
+    }
+    failures += errorCount > 0;
+
+    free(corrupt);
+    free(data);
+    DestroyContext(loading);
+    if (failures) {
+        fprintf(stderr, "test_measure_cache_file: FAILED\n");
+        return 1;
+    }
+    printf("test_measure_cache_file: %d saved texts laid out again without measuring, and every damaged copy of the %d bytes was rejected\n", TEXT_COUNT, size);
+    return 0;
+}
@@ -0,0 +1,155 @@
+// Checks that Clay_MergePrewarmedText only merges records that lie wholly within the data it's given, and that merged
+// texts stay cached while the clock hand has to evict other text to make room.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PREWARMED_COUNT 4
+#define FRAME_COUNT 30
+#define TEXTS_PER_FRAME 40
+
+static const char *prewarmedChars[PREWARMED_COUNT] = {
+    "the next page of the list",
+    "items that are about to scroll into view",
+    "a tooltip",
+    "one more line of prewarmed text\nwith a newline",
+};
+
+static int prewarmedMeasureCount;
+static int errorCount;
+
+static bool IsPrewarmedText(const char *chars) {
+    for (int i = 0; i < PREWARMED_COUNT; i++) {
+        if (chars >= prewarmedChars[i] && chars < prewarmedChars[i] + strlen(prewarmedChars[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static Clay_Dimensions MeasureText(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
+    (void)userData;
+    prewarmedMeasureCount += IsPrewarmedText(text.baseChars);
+    return (Clay_Dimensions) { (float)text.length * (float)config->fontSize * 0.5f, (float)config->fontSize };
+}
+
+static void HandleError(Clay_ErrorData error) {
+    fprintf(stderr, "test_prewarm: clay error: %.*s\n", error.errorText.length, error.errorText.chars);
+    errorCount++;
+}
+
+static Clay_TextElementConfig textConfig = { .fontSize = 12, .textColor = { 220, 220, 220, 255 } };
+
+static Clay_String PrewarmedString(int i) {
+    return (Clay_String) { .length = (int32_t)strlen(prewarmedChars[i]), .chars = prewarmedChars[i] };
+}
+
+// Ten words of text that no other frame shows, so that every frame needs its own room in the cache
+static void DeclareFreshText(int frame, int i) {
+    static char texts[TEXTS_PER_FRAME][96];
+    int length = snprintf(texts[i], sizeof(texts[i]), "frame %d text %d with a few more words to fill it", frame, i);
+    CLAY_TEXT(((Clay_String) { .length = length, .chars = texts[i] }), CLAY_TEXT_CONFIG(textConfig));
+}
+
+static void Layout(int frame, bool showPrewarmed) {
+    Clay_BeginLayout();
+    CLAY(CLAY_ID("Root"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .layoutDirection = CLAY_TOP_TO_BOTTOM } }) {
+        for (int i = 0; i < TEXTS_PER_FRAME && !showPrewarmed; i++) {
+            DeclareFreshText(frame, i);
+        }
+        for (int i = 0; i < PREWARMED_COUNT && showPrewarmed; i++) {
+            CLAY_TEXT(PrewarmedString(i), CLAY_TEXT_CONFIG(textConfig));
+        }
+    }
+    Clay_EndLayout();
+}
+
+static int ExpectMerged(const char *name, const void *data, int32_t dataSize, int32_t expected) {
+    Clay_ResetMeasureTextCache();
+    int32_t merged = Clay_MergePrewarmedText(data, dataSize);
+    if (merged != expected) {
+        fprintf(stderr, "test_prewarm: %s merged %d texts, expected %d\n", name, merged, expected);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+    // 32 buckets and room for a bit over two frames of fresh text
+    Clay_SetMaxMeasureTextCacheWordCount(1024);
+    uint32_t size = Clay_MinMemorySize();
+    void *memory = malloc(size);
+    Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, memory), (Clay_Dimensions) { 1024, 768 }, (Clay_ErrorHandler) { HandleError, NULL });
+    Clay_SetMeasureTextFunction(MeasureText, NULL);
+
+    Clay_String texts[PREWARMED_COUNT];
+    Clay_TextElementConfig configs[PREWARMED_COUNT];
+    for (int i = 0; i < PREWARMED_COUNT; i++) {
+        texts[i] = PrewarmedString(i);
+        configs[i] = textConfig;
+    }
+    int32_t dataSize = Clay_PrewarmText(texts, configs, PREWARMED_COUNT, NULL, 0);
+    uint8_t *data = malloc((size_t)dataSize);
+    Clay_PrewarmText(texts, configs, PREWARMED_COUNT, data, dataSize);
+    uint8_t *corrupt = malloc((size_t)dataSize);
+    Clay__PrewarmedTextHeader *header = (Clay__PrewarmedTextHeader *)corrupt;
+    Clay__PrewarmedTextRecord *firstRecord = (Clay__PrewarmedTextRecord *)(corrupt + sizeof(Clay__PrewarmedTextHeader));
+    int32_t lastRecordSize = Clay__PrewarmedTextRecordSize(texts[PREWARMED_COUNT - 1].length, Clay__CountWords(texts[PREWARMED_COUNT - 1].chars, texts[PREWARMED_COUNT - 1].length));
+
+    failures += ExpectMerged("intact data", data, dataSize, PREWARMED_COUNT);
+    failures += ExpectMerged("data cut short", data, dataSize - 1, 0);
+    memcpy(corrupt, data, (size_t)dataSize);
+    header->size -= lastRecordSize;
+    failures += ExpectMerged("a header size without the last record", corrupt, dataSize, PREWARMED_COUNT - 1);
+    memcpy(corrupt, data, (size_t)dataSize);
+    header->count += 1000;
+    failures += ExpectMerged("a count past the end", corrupt, dataSize, PREWARMED_COUNT);
+    memcpy(corrupt, data, (size_t)dataSize);
+    firstRecord->recordSize = 0x7ffffff8;
+    failures += ExpectMerged("a huge record size", corrupt, dataSize, 0);
+    memcpy(corrupt, data, (size_t)dataSize);
+    firstRecord->textLength = 0x7fffffff;
+    failures += ExpectMerged("a huge text length", corrupt, dataSize, 0);
+    memcpy(corrupt, data, (size_t)dataSize);
+    // Sixteen bytes a word wraps the record size around to what it would be with no words at all
+    firstRecord->wordCount = 0x10000000;
+    firstRecord->recordSize = Clay__PrewarmedTextRecordSize(firstRecord->textLength, 0);
+    failures += ExpectMerged("a word count that overflows the record size", corrupt, dataSize, 0);
+    memcpy(corrupt, data, (size_t)dataSize);
+    firstRecord->wordCount = -1;
+    failures += ExpectMerged("a negative word count", corrupt, dataSize, 0);
+
+    // Each frame shows new text, so the clock hand has to evict the last frame's to make room, but not the prewarmed texts
+    Clay_ResetMeasureTextCache();
+    Clay_MergePrewarmedText(data, dataSize);
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        Layout(frame, false);
+    }
+    if (Clay_GetMeasureTextCacheStats().evictions == 0) {
+        fprintf(stderr, "test_prewarm: the cache never had to evict anything\n");
+        failures++;
+    }
+    prewarmedMeasureCount = 0;
+    Layout(FRAME_COUNT, true);
+    if (prewarmedMeasureCount > 0) {
+        fprintf(stderr, "test_prewarm: %d words of prewarmed text were measured again after %d layouts\n", prewarmedMeasureCount, FRAME_COUNT);
+        failures++;
+    }
+    failures += errorCount > 0;
+
+    Clay_SetCurrentContext(NULL);
+    free(corrupt);
+    free(data);
+    free(memory);
+    if (failures) {
+        fprintf(stderr, "test_prewarm: FAILED\n");
+        return 1;
+    }
+    printf("test_prewarm: corrupt data was rejected and prewarmed texts survived %d layouts of eviction\n", FRAME_COUNT);
+    return 0;
+}
@@ -0,0 +1,213 @@
+// Checks that Clay__SizingBlock_Distribute gives exactly the sizes the step by step loop it replaced did, on random rows
+// that include rows which already start past their limit (below their min size when compressing, above their max size
+// when growing), rows long enough to take its faster path and sizes picked to sit within CLAY__EPSILON of each other.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+#include "sizing_reference.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ROWS 300
+#define CASE_COUNT 40000
+#define SUBTRACTION_COUNT 200000
+
+typedef struct {
+    int32_t length;
+    float sizes[MAX_ROWS];
+    float minSizes[MAX_ROWS];
+    float maxSizes[MAX_ROWS];
+    float sizeToDistribute;
+} SizingCase;
+
+static uint32_t randomState = 12345;
+
+static uint32_t NextRandom(void) {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static float RandomFloat(float max) {
+    return (float)(NextRandom() % 100000) / 100000.0f * max;
+}
+
+static void DistributeReference(const SizingCase *test, float *out) {
+    int32_t rows[MAX_ROWS];
+    memcpy(out, test->sizes, (size_t)test->length * sizeof(float));
+    SizingReference_Distribute(out, test->minSizes, test->maxSizes, rows, test->length, test->sizeToDistribute);
+}
+
+// With levelPasses < 0 this is Clay__SizingBlock_Distribute. Otherwise Clay__SizingBlock_DistributeLevel takes over after
+// that many passes of Clay__SizingBlock_Step, however long the block is, so that every case takes its faster path from
+// wherever the buffer has got to by then.
+static void DistributeBlock(const SizingCase *test, float *out, int32_t levelPasses) {
+    float minSizes[MAX_ROWS], maxSizes[MAX_ROWS];
+    int32_t order[MAX_ROWS], buffer[MAX_ROWS], positions[MAX_ROWS], limitOrder[MAX_ROWS];
+    uint32_t bits[MAX_ROWS];
+    for (int32_t i = 0; i < test->length; i++) {
+        out[i] = test->sizes[i];
+        minSizes[i] = test->minSizes[i];
+        maxSizes[i] = test->maxSizes[i];
+    }
+    Clay__SizingBlock block = { .sizes = out, .minSizes = minSizes, .maxSizes = maxSizes, .order = order, .buffer = buffer,
+        .positions = positions, .limitOrder = limitOrder, .bits = bits, .length = test->length };
+    if (levelPasses < 0) {
+        Clay__SizingBlock_Distribute(&block, test->sizeToDistribute);
+        return;
+    }
+    float sign = test->sizeToDistribute > 0 ? 1 : -1;
+    float remaining = test->sizeToDistribute * sign;
+    int32_t length = test->length;
+    for (int32_t row = 0; row < length; row++) {
+        buffer[row] = row;
+    }
+    for (int32_t pass = 0; remaining > CLAY__EPSILON && length > 0; pass++) {
+        if (pass == levelPasses) {
+            Clay__SizingBlock_DistributeLevel(&block, sign > 0 ? maxSizes : minSizes, sign, &length, &remaining);
+        } else if (!Clay__SizingBlock_Step(&block, sign > 0 ? maxSizes : minSizes, sign, &length, &remaining)) {
+            break;
+        }
+    }
+}
+
+static int CheckCase(const char *name, const SizingCase *test, int32_t levelPasses) {
+    float expected[MAX_ROWS], actual[MAX_ROWS];
+    DistributeReference(test, expected);
+    DistributeBlock(test, actual, levelPasses);
+    if (memcmp(expected, actual, (size_t)test->length * sizeof(float)) == 0) {
+        return 0;
+    }
+    int32_t i = 0;
+    while (memcmp(&expected[i], &actual[i], sizeof(float)) == 0) {
+        i++;
+    }
+    fprintf(stderr, "test_sizing: %s, level after %d passes: row %d of %d is %.9g, expected %.9g (size %.9g, min %.9g, max %.9g, distributing %.9g)\n",
+        name, levelPasses, i, test->length, actual[i], expected[i], test->sizes[i], test->minSizes[i], test->maxSizes[i], test->sizeToDistribute);
+    return 1;
+}
+
+static float Total(const float *sizes, int32_t length) {
+    float total = 0;
+    for (int32_t i = 0; i < length; i++) {
+        total += sizes[i];
+    }
+    return total;
+}
+
+// A size from one of a few kinds: any hundred-thousandth of up to 300, whole and half pixels like most UIs have, or a
+// size within a few thousandths of base, or a few floats away from it, so that rows sit within CLAY__EPSILON of each other
+static float RandomSize(int kind, float base) {
+    switch (kind) {
+        case 0: return RandomFloat(300);
+        case 1: return (float)(NextRandom() % 600) * 0.5f;
+        case 2: return base + (float)(NextRandom() % 5) * 0.004f;
+        default: return base + (float)(NextRandom() % 4) * base * 1.2e-7f;
+    }
+}
+
+static int CompareAscending(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static void RandomCase(SizingCase *test) {
+    // Clay__SizingBlock_Distribute only takes its faster path on rows of CLAY__SIZING_BLOCK_LEVEL_MIN_LENGTH or more
+    test->length = 1 + (int32_t)(NextRandom() % (NextRandom() % 2 == 0 ? MAX_ROWS : 48));
+    bool grow = NextRandom() % 2;
+    int kind = (int)(NextRandom() % 4);
+    float base = RandomSize((int)(NextRandom() % 2), 0);
+    float sharedLimit = RandomFloat(300);
+    for (int32_t i = 0; i < test->length; i++) {
+        // Repeat earlier sizes now and then, so that rows start out level with each other
+        test->sizes[i] = i > 0 && NextRandom() % 4 == 0 ? test->sizes[NextRandom() % i] : RandomSize(kind, kind >= 2 && NextRandom() % 2 ? base : RandomSize(1, 0));
+    }
+    // Sorted rows put every row the level hasn't reached on one side of the rows that are moving
+    switch (NextRandom() % 4) {
+        case 0: qsort(test->sizes, (size_t)test->length, sizeof(float), CompareAscending); break;
+        case 1: {
+            qsort(test->sizes, (size_t)test->length, sizeof(float), CompareAscending);
+            for (int32_t i = 0; i < test->length / 2; i++) {
+                float swap = test->sizes[i];
+                test->sizes[i] = test->sizes[test->length - 1 - i];
+                test->sizes[test->length - 1 - i] = swap;
+            }
+            break;
+        }
+        default: break;
+    }
+    for (int32_t i = 0; i < test->length; i++) {
+        float size = test->sizes[i];
+        switch (NextRandom() % 5) {
+            case 0: test->minSizes[i] = size + RandomFloat(150); break; // Starts below its min size
+            case 1: test->minSizes[i] = size; break;
+            case 2: test->minSizes[i] = sharedLimit; break;
+            default: test->minSizes[i] = RandomFloat(size); break;
+        }
+        switch (NextRandom() % 5) {
+            case 0: test->maxSizes[i] = RandomFloat(size); break; // Starts above its max size
+            case 1: test->maxSizes[i] = CLAY__MAXFLOAT; break;
+            case 2: test->maxSizes[i] = sharedLimit; break;
+            default: test->maxSizes[i] = size + RandomFloat(300); break;
+        }
+        if (test->maxSizes[i] < test->minSizes[i]) {
+            float swap = test->maxSizes[i];
+            test->maxSizes[i] = test->minSizes[i];
+            test->minSizes[i] = swap;
+        }
+    }
+    float total = Total(test->sizes, test->length);
+    float amount = NextRandom() % 8 == 0 ? RandomFloat(0.1f) : RandomFloat(grow ? total + 100 : total);
+    test->sizeToDistribute = grow ? amount + CLAY__EPSILON * 1.5f : -(amount + CLAY__EPSILON * 1.5f);
+}
+
+// Clay__SubtractRepeated against a loop, with amounts that often end exactly half way between two quanta of value
+static int CheckSubtractRepeated(void) {
+    for (int i = 0; i < SUBTRACTION_COUNT; i++) {
+        float value = RandomFloat(1000) * (NextRandom() % 4 == 0 ? -1.0f : 1.0f) + (NextRandom() % 8 == 0 ? 1e-3f : 0);
+        float amount;
+        switch (NextRandom() % 3) {
+            case 0: amount = RandomFloat(value < 0 ? -value : value) / (float)(1 + NextRandom() % 500); break;
+            case 1: amount = (float)(NextRandom() % 64) * 0.5f * 6.103515625e-05f; break; // Multiples of half the quantum at 1024
+            default: amount = RandomFloat(0.01f); break;
+        }
+        amount = NextRandom() % 5 == 0 ? -amount : amount;
+        int32_t count = (int32_t)(NextRandom() % 3000);
+        float expected = value;
+        for (int32_t step = 0; step < count; step++) {
+            expected -= amount;
+        }
+        float actual = Clay__SubtractRepeated(value, amount, count);
+        if (memcmp(&expected, &actual, sizeof(float)) != 0) {
+            fprintf(stderr, "test_sizing: subtracting %.9g from %.9g %d times gave %.9g, expected %.9g\n", amount, value, count, actual, expected);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    int failures = CheckSubtractRepeated();
+    SizingCase belowMin = { .length = 2, .sizes = { 208, 82.6667f }, .minSizes = { 4, 139 }, .maxSizes = { CLAY__MAXFLOAT, CLAY__MAXFLOAT }, .sizeToDistribute = -147.6667f };
+    failures += CheckCase("row below its min size", &belowMin, -1) + CheckCase("row below its min size", &belowMin, 0);
+    SizingCase aboveMax = { .length = 3, .sizes = { 10, 50, 120 }, .minSizes = { 0, 0, 0 }, .maxSizes = { 100, 40, CLAY__MAXFLOAT }, .sizeToDistribute = 60 };
+    failures += CheckCase("row above its max size", &aboveMax, -1) + CheckCase("row above its max size", &aboveMax, 0);
+
+    for (int i = 0; i < CASE_COUNT && failures < 10; i++) {
+        SizingCase test;
+        RandomCase(&test);
+        char name[32];
+        snprintf(name, sizeof(name), "random case %d", i);
+        failures += CheckCase(name, &test, -1);
+        failures += CheckCase(name, &test, NextRandom() % 2 ? 0 : (int32_t)(NextRandom() % 24));
+    }
+    if (failures) {
+        fprintf(stderr, "test_sizing: FAILED\n");
+        return 1;
+    }
+    printf("test_sizing: %d random cases gave the same sizes as the reference loop, to the bit\n", CASE_COUNT);
+    return 0;
+}
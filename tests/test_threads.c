@@ -0,0 +1,78 @@
+// Lays out the same frames on several threads at once, each with its own context, and checks that every thread's render
+// commands match a single threaded run. Build with -fsanitize=thread to check for shared state between contexts.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+#include "scene.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#define THREAD_COUNT 8
+#define FRAME_COUNT 40
+
+typedef struct {
+    uint64_t hashes[FRAME_COUNT];
+    int32_t lengths[FRAME_COUNT];
+    int errors;
+} LayoutRun;
+
+static void HandleError(Clay_ErrorData error) {
+    LayoutRun *run = (LayoutRun *)error.userData;
+    run->errors++;
+}
+
+// Initializes a context on the calling thread and lays out every frame with the explicit context API
+static void *RunLayout(void *userData) {
+    LayoutRun *run = (LayoutRun *)userData;
+    uint32_t size = Clay_MinMemorySize();
+    void *memory = malloc(size);
+    Clay_Context *context = Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, memory), (Clay_Dimensions) { SCENE_WIDTH, SCENE_HEIGHT }, (Clay_ErrorHandler) { HandleError, run });
+    Clay_SetMeasureTextFunctionCtx(context, Scene_MeasureText, NULL);
+    Scene_Strings strings;
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        Clay_SetPointerStateCtx(context, (Clay_Vector2) { (float)(frame * 37 % SCENE_WIDTH), (float)(frame * 53 % SCENE_HEIGHT) }, frame % 2);
+        Clay_BeginLayoutCtx(context);
+        Scene_Declare(frame, &strings);
+        Clay_RenderCommandArray commands = Clay_EndLayoutCtx(context);
+        run->hashes[frame] = Scene_HashRenderCommands(commands);
+        run->lengths[frame] = commands.length;
+    }
+    free(memory);
+    return NULL;
+}
+
+int main(void) {
+    static LayoutRun expected;
+    RunLayout(&expected);
+
+    static LayoutRun runs[THREAD_COUNT];
+    pthread_t threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        if (pthread_create(&threads[i], NULL, RunLayout, &runs[i]) != 0) {
+            fprintf(stderr, "test_threads: couldn't start thread %d\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    int failures = expected.errors > 0;
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        failures += runs[i].errors > 0;
+        for (int frame = 0; frame < FRAME_COUNT; frame++) {
+            if (runs[i].hashes[frame] != expected.hashes[frame] || runs[i].lengths[frame] != expected.lengths[frame]) {
+                fprintf(stderr, "test_threads: thread %d frame %d differs from the single threaded run\n", i, frame);
+                failures++;
+                break;
+            }
+        }
+    }
+    if (failures) {
+        fprintf(stderr, "test_threads: FAILED\n");
+        return 1;
+    }
+    printf("test_threads: %d contexts on %d threads matched for %d frames\n", THREAD_COUNT, THREAD_COUNT, FRAME_COUNT);
+    return 0;
+}
@@ -0,0 +1,172 @@
+// Checks CLAY_VIRTUAL_LIST against declaring the whole list: with fixed item sizes and with sizes from getItemOffset, with
+// and without childGap, overscan and padding, down and across, a list scrolled to its start, its middle, its end and
+// past its end gives the same render commands and the same scroll content size as the list with every item declared.
+
+#define CLAY_IMPLEMENTATION
+#include "../clay.h"
+#include "scene.h"
+
+#include <stdlib.h>
+
+#define ITEM_COUNT 2000
+#define WIDTH 400
+#define HEIGHT 500
+
+typedef struct {
+    const char *name;
+    bool vertical;
+    bool variableSizes;
+    uint16_t childGap;
+    uint16_t padding;
+    float overscan;
+} ListCase;
+
+static const ListCase cases[] = {
+    { "fixed sizes", true, false, 0, 0, 0 },
+    { "fixed sizes with childGap and padding", true, false, 3, 8, 0 },
+    { "fixed sizes with overscan", true, false, 3, 0, 60 },
+    { "getItemOffset", true, true, 0, 0, 0 },
+    { "getItemOffset with childGap, padding and overscan", true, true, 5, 6, 45 },
+    { "fixed sizes across", false, false, 2, 4, 30 },
+    { "getItemOffset across", false, true, 4, 0, 0 },
+};
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+static float itemOffsets[ITEM_COUNT + 1];
+static int errorCount;
+
+static void HandleError(Clay_ErrorData error) {
+    fprintf(stderr, "test_virtual_list: clay error: %.*s\n", error.errorText.length, error.errorText.chars);
+    errorCount++;
+}
+
+static float GetItemOffset(int32_t itemIndex, void *userData) {
+    (void)userData;
+    return itemOffsets[itemIndex];
+}
+
+static float ItemSize(const ListCase *list, int32_t i) {
+    return list->variableSizes ? itemOffsets[i + 1] - itemOffsets[i] : 23;
+}
+
+static void DeclareItem(const ListCase *list, int32_t i) {
+    Clay_SizingAxis size = CLAY_SIZING_FIXED(ItemSize(list, i));
+    Clay_LayoutConfig layout = { .sizing = { list->vertical ? CLAY_SIZING_GROW(0) : size, list->vertical ? size : CLAY_SIZING_GROW(0) } };
+    CLAY(CLAY_IDI("Item", i), { .layout = layout, .backgroundColor = { (float)(i % 200), 80, 80, 255 } }) {
+        CLAY_TEXT(CLAY_STRING("Item"), CLAY_TEXT_CONFIG({ .fontSize = 12 }));
+    }
+}
+
+// Clay doesn't cull background rectangles that are off screen, so the whole list has rectangles for every item while the
+// virtual list only has them for the items it declared. Only the commands that reach the screen are compared.
+static uint64_t HashOnscreenCommands(Clay_RenderCommandArray commands) {
+    Clay_RenderCommandArray onscreen = commands;
+    onscreen.length = 0;
+    for (int32_t i = 0; i < commands.length; i++) {
+        if (!Clay__ElementIsOffscreen(&commands.internalArray[i].boundingBox)) {
+            onscreen.internalArray[onscreen.length++] = commands.internalArray[i];
+        }
+    }
+    return Scene_HashRenderCommands(onscreen);
+}
+
+// Returns how many items were declared
+static int32_t Layout(const ListCase *list, bool virtualList, uint64_t *hash) {
+    int32_t declared = 0;
+    Clay_BeginLayout();
+    CLAY(CLAY_ID("List"), { .layout = { .sizing = { CLAY_SIZING_GROW(0), CLAY_SIZING_GROW(0) }, .padding = CLAY_PADDING_ALL(list->padding), .childGap = list->childGap,
+        .layoutDirection = list->vertical ? CLAY_TOP_TO_BOTTOM : CLAY_LEFT_TO_RIGHT }, .clip = { .horizontal = !list->vertical, .vertical = list->vertical, .childOffset = Clay_GetScrollOffset() } }) {
+        if (virtualList) {
+            CLAY_VIRTUAL_LIST(items, { .itemCount = ITEM_COUNT, .itemSize = list->variableSizes ? 0 : 23, .getItemOffset = list->variableSizes ? GetItemOffset : NULL, .overscan = list->overscan }) {
+                for (int32_t i = items.startIndex; i < items.endIndex; i++) {
+                    DeclareItem(list, i);
+                    declared++;
+                }
+            }
+        } else {
+            for (int32_t i = 0; i < ITEM_COUNT; i++) {
+                DeclareItem(list, i);
+                declared++;
+            }
+        }
+    }
+    *hash = HashOnscreenCommands(Clay_EndLayout());
+    return declared;
+}
+
+static void *CreateContext(void) {
+    Clay_SetMaxElementCount(3 * ITEM_COUNT);
+    uint32_t size = Clay_MinMemorySize();
+    void *memory = malloc(size);
+    Clay_Initialize(Clay_CreateArenaWithCapacityAndMemory(size, memory), (Clay_Dimensions) { WIDTH, HEIGHT }, (Clay_ErrorHandler) { HandleError, NULL });
+    Clay_SetMeasureTextFunction(Scene_MeasureText, NULL);
+    return memory;
+}
+
+static void SetScroll(Clay_Context *context, const ListCase *list, float scroll) {
+    Clay_SetCurrentContext(context);
+    Clay_Vector2 *position = Clay_GetScrollContainerData(CLAY_ID("List")).scrollPosition;
+    *position = list->vertical ? (Clay_Vector2) { 0, -scroll } : (Clay_Vector2) { -scroll, 0 };
+}
+
+static int CheckCase(const ListCase *list, Clay_Context *full, Clay_Context *virtualList) {
+    int failures = 0;
+    float contentSize = 0;
+    uint64_t fullHash, virtualHash;
+    Clay_SetCurrentContext(full);
+    Layout(list, false, &fullHash);
+    Clay_SetCurrentContext(virtualList);
+    Layout(list, true, &virtualHash);
+    for (int32_t i = 0; i < ITEM_COUNT; i++) {
+        contentSize += ItemSize(list, i) + (i > 0 ? list->childGap : 0);
+    }
+    float visibleSize = list->vertical ? HEIGHT : WIDTH;
+    // Fractions of a pixel keep the edges of the visible area off the edges of items
+    const char *scrollNames[] = { "the start", "the middle", "the end", "past the end" };
+    float scrolls[] = { 0, contentSize / 2 + 0.37f, contentSize + list->padding * 2 - visibleSize, contentSize + 250.5f };
+    for (int s = 0; s < 4; s++) {
+        SetScroll(full, list, scrolls[s]);
+        SetScroll(virtualList, list, scrolls[s]);
+        Clay_SetCurrentContext(full);
+        Layout(list, false, &fullHash);
+        Clay_Dimensions fullContent = Clay_GetScrollContainerData(CLAY_ID("List")).contentDimensions;
+        Clay_SetCurrentContext(virtualList);
+        int32_t declared = Layout(list, true, &virtualHash);
+        Clay_Dimensions virtualContent = Clay_GetScrollContainerData(CLAY_ID("List")).contentDimensions;
+        if (virtualHash != fullHash || virtualContent.width != fullContent.width || virtualContent.height != fullContent.height) {
+            fprintf(stderr, "test_virtual_list: %s scrolled to %s gave %s render commands and content of %gx%g, expected %gx%g\n", list->name, scrollNames[s],
+                virtualHash == fullHash ? "the same" : "different", virtualContent.width, virtualContent.height, fullContent.width, fullContent.height);
+            failures++;
+        }
+        if (declared > ITEM_COUNT / 10) {
+            fprintf(stderr, "test_virtual_list: %s scrolled to %s declared %d of %d items\n", list->name, scrollNames[s], declared, ITEM_COUNT);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main(void) {
+    int failures = 0;
+    for (int32_t i = 0; i < ITEM_COUNT; i++) {
+        itemOffsets[i + 1] = itemOffsets[i] + (float)(10 + (i * 7) % 31) + (i % 5 == 0 ? 0.5f : 0);
+    }
+    void *fullMemory = CreateContext();
+    Clay_Context *full = Clay_GetCurrentContext();
+    void *virtualMemory = CreateContext();
+    Clay_Context *virtualList = Clay_GetCurrentContext();
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        failures += CheckCase(&cases[i], full, virtualList);
+    }
+    failures += errorCount > 0;
+
+    Clay_SetCurrentContext(NULL);
+    free(fullMemory);
+    free(virtualMemory);
+    if (failures) {
+        fprintf(stderr, "test_virtual_list: FAILED\n");
+        return 1;
+    }
+    printf("test_virtual_list: %d lists of %d items laid out as the whole list did at 4 scroll positions\n", (int)CASE_COUNT, ITEM_COUNT);
+    return 0;
+}